@@ -0,0 +1,169 @@
+/*
+mVMC - A numerical solver package for a wide range of quantum lattice models based on many-variable Variational Monte Carlo method
+Copyright (C) 2016 The University of Tokyo, All rights reserved.
+
+This program is developed based on the mVMC-mini program
+(https://github.com/fiber-miniapp/mVMC-mini)
+which follows "The BSD 3-Clause License".
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details. 
+
+You should have received a copy of the GNU General Public License 
+along with this program. If not, see http://www.gnu.org/licenses/. 
+*/
+/*-------------------------------------------------------------
+ * Variational Monte Carlo
+ * autocorrelation of the local energy along the Markov chains
+ *-------------------------------------------------------------*/
+#include "global.h"
+#include "autocorr.h"
+#include "splitloop.h"
+#ifndef _SRC_AUTOCORR
+#define _SRC_AUTOCORR
+
+#define D_AutoCorrMaxLag 1000 /* the maximum lag of the autocorrelation function [samples] */
+#define D_AutoCorrWindow 6.0 /* the window M of the estimator is the smallest M >= D_AutoCorrWindow*tau */
+
+/* The samples SampleLocEnergy[sampleStart:sampleEnd] of a Markov chain are
+   accumulated into buf:
+     buf[t]           += sum_i (e_i-m)(e_{i+t}-m)   (t=0,...,maxLag)
+     buf[maxLag+1+t]  += the number of the pairs
+     buf[2*maxLag+2:] += the sums for the Geweke diagnostic:
+                         n, sum e, sum e^2 of the first 10% and the last 50% */
+void accumulateAutoCorr(const int sampleStart, const int sampleEnd, const int maxLag, double *buf);
+
+void accumulateAutoCorr(const int sampleStart, const int sampleEnd, const int maxLag, double *buf) {
+  const double *e = SampleLocEnergy + sampleStart;
+  const int n = sampleEnd-sampleStart;
+  const int nA = n/10;
+  const int nB = n/2;
+  double *cov = buf;
+  double *nPair = buf + maxLag+1;
+  double *geweke = buf + 2*maxLag+2;
+  double m=0.0,c;
+  int i,t;
+
+  if(n<2) return;
+  for(i=0;i<n;i++) m += e[i];
+  m /= (double)n;
+
+#pragma omp parallel for default(shared) private(t,i,c)
+  for(t=0;t<=maxLag;t++) {
+    if(t>=n) continue;
+    c = 0.0;
+    for(i=0;i<n-t;i++) c += (e[i]-m)*(e[i+t]-m);
+    cov[t] += c;
+    nPair[t] += (double)(n-t);
+  }
+
+  for(i=0;i<nA;i++) {
+    geweke[1] += e[i];
+    geweke[2] += e[i]*e[i];
+  }
+  geweke[0] += (double)nA;
+  for(i=n-nB;i<n;i++) {
+    geweke[4] += e[i];
+    geweke[5] += e[i]*e[i];
+  }
+  geweke[3] += (double)nB;
+  return;
+}
+
+/* Estimate the integrated autocorrelation time tau of the local energy in units
+   of the sampling interval, the effective sample size and the Geweke z-score
+   comparing the first 10% with the last 50% of each Markov chain.
+   The results are written to zvo_autocorr.dat. If NVMCAutoCorr=2,
+   NVMCInterval is scaled by tau/DVMCAutoCorrTarget for the next sampling. */
+void CalculateAutoCorr(const int step, MPI_Comm comm_parent, MPI_Comm comm_child1) {
+  const int nChain = (NVMCWalker>1) ? NVMCWalker : 1;
+  int maxLag = NVMCSample/nChain/2;
+  int rank0,size0,rank1,size1;
+  int chain,sampleStart,sampleEnd;
+  int n,t,interval;
+  double *buf,*recv;
+  double *cov,*nPair,*geweke;
+  double tau,ess,z,rho;
+  double mA,mB,vA,vB;
+
+  MPI_Comm_rank(comm_parent,&rank0);
+  MPI_Comm_size(comm_parent,&size0);
+  MPI_Comm_rank(comm_child1,&rank1);
+  MPI_Comm_size(comm_child1,&size1);
+
+  if(maxLag>D_AutoCorrMaxLag) maxLag = D_AutoCorrMaxLag;
+  if(maxLag<1) maxLag = 1;
+  n = 2*maxLag+2+6;
+
+  /* the samples of a Markov chain are distributed over comm_child1 */
+  if(size1>1) {
+    recv = (double*)malloc(sizeof(double)*NVMCSample);
+    SafeMpiAllReduce(SampleLocEnergy,recv,NVMCSample,comm_child1);
+    for(t=0;t<NVMCSample;t++) SampleLocEnergy[t] = recv[t];
+    free(recv);
+  }
+
+  /* the replicas with beta<1 have no samples */
+  buf = (double*)calloc(2*n, sizeof(double));
+  recv = buf + n;
+  if(rank1==0 && TemperingRung==0) {
+    for(chain=0;chain<nChain;chain++) {
+      SplitLoop(&sampleStart,&sampleEnd,NVMCSample,chain,nChain);
+      accumulateAutoCorr(sampleStart,sampleEnd,maxLag,buf);
+    }
+  }
+  if(size0>1) {
+    SafeMpiAllReduce(buf,recv,n,comm_parent);
+    for(t=0;t<n;t++) buf[t] = recv[t];
+  }
+  cov = buf;
+  nPair = buf + maxLag+1;
+  geweke = buf + 2*maxLag+2;
+
+  /* automatic windowing of the integrated autocorrelation time */
+  tau = 0.5;
+  if(cov[0]>0.0) {
+    for(t=1;t<=maxLag;t++) {
+      if(nPair[t]<1.0) break;
+      rho = (cov[t]/nPair[t]) / (cov[0]/nPair[0]);
+      tau += rho;
+      if((double)t >= D_AutoCorrWindow*tau) break;
+    }
+  }
+  if(tau<0.5) tau = 0.5;
+  ess = nPair[0]/(2.0*tau);
+
+  z = 0.0;
+  if(geweke[0]>1.0 && geweke[3]>1.0) {
+    mA = geweke[1]/geweke[0];
+    mB = geweke[4]/geweke[3];
+    vA = (geweke[2]/geweke[0] - mA*mA) * 2.0*tau/geweke[0];
+    vB = (geweke[5]/geweke[3] - mB*mB) * 2.0*tau/geweke[3];
+    if(vA+vB>0.0) z = (mA-mB)/sqrt(vA+vB);
+  }
+
+  interval = NVMCInterval;
+  if(NVMCAutoCorr==2) {
+    t = (int)ceil((double)NVMCInterval*tau/DVMCAutoCorrTarget);
+    /* avoid oscillation caused by the statistical error of tau */
+    if(t>2*NVMCInterval) t = 2*NVMCInterval;
+    if(t<NVMCInterval/2) t = NVMCInterval/2;
+    NVMCInterval = (t<1) ? 1 : t;
+  }
+
+  if(rank0==0) {
+    fprintf(FileAutoCorr, "%6d % .5e % .5e % .5e %6d\n", step, tau, ess, z, interval);
+  }
+
+  free(buf);
+  return;
+}
+
+#endif
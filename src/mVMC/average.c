@@ -34,6 +34,8 @@ along with this program. If not, see http://www.gnu.org/licenses/.
 void weightAverageReduce(int n, double *vec, MPI_Comm comm);
 void weightAverageReduce_fcmp(int n, double complex *vec, MPI_Comm comm);
 void weightAverageReduce_real(int n, double *vec, MPI_Comm comm);
+void weightAverageSROptUpper(MPI_Comm comm);
+void weightAverageSROptUpper_real(MPI_Comm comm);
 
 
 /* calculate average of Wc, Etot and Etot2 ;Sztot,Sztot2 for fsz*/
@@ -83,11 +85,17 @@ void WeightAverageSROpt(MPI_Comm comm) {
   MPI_Comm_rank(comm,&rank);
   MPI_Comm_size(comm,&size);
 
+  if(NStoreOBlock>0){
+    /* only the upper triangle of SROptOO is accumulated */
+    weightAverageSROptUpper(comm);
+    return;
+  }
+
   /* SROptOO and SROptHO */ // except for SROptO 
-  if(NSRCG == 0){
-    n = 2*SROptSize*(2*SROptSize+1);
+  if(NSRCG == 0 && FlagSROptDist == 0){
+    n = SROptCmpSize*(SROptCmpSize+1);
   }else{
-    n = 2*SROptSize*3;
+    n = SROptCmpSize*3;
   }
   vec = SROptOO;
   if(size>1) {
@@ -120,8 +128,14 @@ void WeightAverageSROpt_real(MPI_Comm comm) {
   MPI_Comm_rank(comm,&rank);
   MPI_Comm_size(comm,&size);
 
+  if(NStoreOBlock>0){
+    /* only the upper triangle of SROptOO_real is accumulated */
+    weightAverageSROptUpper_real(comm);
+    return;
+  }
+
   /* SROptOO and SROptHO */ // except for SROptO 
-  if(NSRCG == 0){
+  if(NSRCG == 0 && FlagSROptDist == 0){
     n = SROptSize*(SROptSize+1);
   }else{
     n = SROptSize*3;
@@ -148,6 +162,84 @@ void WeightAverageSROpt_real(MPI_Comm comm) {
 
 
 
+/* average of SROptOO accumulated in the upper triangle (NStoreOBlock>0) */
+/* The packed upper triangle and SROptHO are reduced, and the lower triangle is restored. */
+void weightAverageSROptUpper(MPI_Comm comm) {
+  const int n=SROptCmpSize;
+  const int nTri=n*(n+1)/2;
+  double invW = 1.0/creal(Wc);
+  double complex *oo=SROptOO, *ho=SROptHO;
+  double complex *vec,*buf;
+  int i,j;
+  int size;
+  MPI_Comm_size(comm,&size);
+
+  RequestWorkSpaceComplex(2*(nTri+n));
+  vec = GetWorkSpaceComplex(nTri+n);
+  buf = GetWorkSpaceComplex(nTri+n);
+
+  #pragma omp parallel for default(shared) private(i,j)
+  for(j=0;j<n;j++) {
+    for(i=0;i<=j;i++) vec[j*(j+1)/2+i] = oo[i+j*n];
+    vec[nTri+j] = ho[j];
+  }
+
+  if(size>1) {
+    SafeMpiAllReduce_fcmp(vec,buf,nTri+n,comm);
+    vec = buf;
+  }
+
+  #pragma omp parallel for default(shared) private(i,j)
+  for(j=0;j<n;j++) {
+    for(i=0;i<=j;i++) {
+      oo[i+j*n] = vec[j*(j+1)/2+i] * invW;
+      oo[j+i*n] = conj(oo[i+j*n]);
+    }
+    ho[j] = vec[nTri+j] * invW;
+  }
+
+  ReleaseWorkSpaceComplex();
+  return;
+}
+
+void weightAverageSROptUpper_real(MPI_Comm comm) {
+  const int n=SROptSize;
+  const int nTri=n*(n+1)/2;
+  double invW = 1.0/creal(Wc);
+  double *oo=SROptOO_real, *ho=SROptHO_real;
+  double *vec,*buf;
+  int i,j;
+  int size;
+  MPI_Comm_size(comm,&size);
+
+  RequestWorkSpaceDouble(2*(nTri+n));
+  vec = GetWorkSpaceDouble(nTri+n);
+  buf = GetWorkSpaceDouble(nTri+n);
+
+  #pragma omp parallel for default(shared) private(i,j)
+  for(j=0;j<n;j++) {
+    for(i=0;i<=j;i++) vec[j*(j+1)/2+i] = oo[i+j*n];
+    vec[nTri+j] = ho[j];
+  }
+
+  if(size>1) {
+    SafeMpiAllReduce(vec,buf,nTri+n,comm);
+    vec = buf;
+  }
+
+  #pragma omp parallel for default(shared) private(i,j)
+  for(j=0;j<n;j++) {
+    for(i=0;i<=j;i++) {
+      oo[i+j*n] = vec[j*(j+1)/2+i] * invW;
+      oo[j+i*n] = oo[i+j*n];
+    }
+    ho[j] = vec[nTri+j] * invW;
+  }
+
+  ReleaseWorkSpaceDouble();
+  return;
+}
+
 /* calculate average of SROptOO and SROptHO */
 /* All processes will have the result */
 /*
@@ -215,6 +307,13 @@ void WeightAverageGreenFunc(MPI_Comm comm) {
   n = NCisAjs+NCisAjsCktAlt+NCisAjsCktAltDC;
   vec = PhysCisAjs;
   weightAverageReduce_fcmp(n,vec,comm);
+
+  if(NMomentum>0){
+    /* N(q), Sz(q), n_up(k) and n_down(k) */
+    n = 4*NMomentum;
+    vec = PhysMomentum;
+    weightAverageReduce_fcmp(n,vec,comm);
+  }
   
   if(NLanczosMode>0){
     /* QQQQ */
@@ -37,17 +37,17 @@ void CalcAveVar(int i, int n, double complex* _ave, double* _var){
   double complex ave=0;
   double var=0;
   
-  for(sample=0;sample<NSROptItrSmp;sample++) {
+  for(sample=0;sample<NSROptDataSmp;sample++) {
     ave += SROptData[i+n*sample];
   }
-  ave /= (double)(NSROptItrSmp);
+  ave /= (double)(NSROptDataSmp);
   
   var = 0.0;
-  for(sample=0;sample<NSROptItrSmp;sample++) {
+  for(sample=0;sample<NSROptDataSmp;sample++) {
     data = SROptData[i+n*sample] - ave;
     var += creal(data*conj(data));//TBC
   }
-  var = sqrt( var/((double)(NSROptItrSmp)-1.0) );
+  var = sqrt( var/((double)(NSROptDataSmp)-1.0) );
 
   *_ave= ave;
   *_var= var;
@@ -103,7 +103,7 @@ void OutputOptData() {
   sprintf(fileName, "%s_opt.dat", CParaFileHead);
   fp = fopen(fileName, "w");
 
-  if(NSROptItrSmp==1) {
+  if(NSROptDataSmp==1) {
     for(i=0;i<n;i++) {
       fprintf(fp,"% .18e % .18e ", creal(SROptData[i]), 0.0);//TBC
     }
@@ -29,6 +29,278 @@ along with this program. If not, see http://www.gnu.org/licenses/.
 #ifndef _CALGRN_SRC
 #define _CALGRN_SRC
 
+static long long *greenTransKey;
+
+/* order of the Green functions by the key of their classes, then by the index */
+static int compareGreenTransKey(const void *a, const void *b) {
+  const int i = *(const int*)a;
+  const int j = *(const int*)b;
+  if(greenTransKey[i]<greenTransKey[j]) return -1;
+  if(greenTransKey[i]>greenTransKey[j]) return 1;
+  return i-j;
+}
+
+/* Classify n Green functions of nOp pairs of (r,s) in gIdx[][2*nOp]                 */
+/* into the classes equivalent under the translations QPTrans[0..NMPTrans-1].        */
+/* The key of a class is the smallest translated copy encoded in base Nsite2,        */
+/* and the representative is the smallest index in the class.                       */
+void makeGreenTransClass(const int nOp, const int n, int **gIdx,
+                         int *nClass, int *classIdx, int *classSgn, int *classRep) {
+  int i,k,r,s,mpidx,sgn,minSgn=1;
+  long long key,minKey=0;
+  int *order, *keySgn;
+
+  greenTransKey = (long long*)malloc(sizeof(long long)*n);
+  order = (int*)malloc(sizeof(int)*2*n);
+  keySgn = order + n;
+
+  for(i=0;i<n;i++) {
+    for(mpidx=0;mpidx<NMPTrans;mpidx++) {
+      key = 0;
+      sgn = 1;
+      for(k=0;k<nOp;k++) {
+        r = gIdx[i][2*k];
+        s = gIdx[i][2*k+1];
+        key = key*Nsite2 + QPTrans[mpidx][r] + s*Nsite;
+        sgn *= QPTransSgn[mpidx][r];
+      }
+      if(mpidx==0 || key<minKey) {
+        minKey = key;
+        minSgn = sgn;
+      }
+    }
+    greenTransKey[i] = minKey;
+    keySgn[i] = minSgn;
+    order[i] = i;
+  }
+
+  qsort(order, n, sizeof(int), compareGreenTransKey);
+
+  *nClass = 0;
+  for(k=0;k<n;k++) {
+    i = order[k];
+    if(k==0 || greenTransKey[i]!=greenTransKey[order[k-1]]) {
+      classRep[*nClass] = i;
+      (*nClass)++;
+    }
+    classIdx[i] = *nClass-1;
+    classSgn[i] = keySgn[i]*keySgn[classRep[*nClass-1]];
+  }
+
+  free(order);
+  free(greenTransKey);
+  return;
+}
+
+/* 1 if the set of n sites b is the image of a under the translation trans */
+static int isTransSiteSet(const int n, const int *a, const int *b, const int *trans) {
+  int k,l;
+  for(k=0;k<n;k++) {
+    if(a[k]<0) continue;
+    for(l=0;l<n;l++) {
+      if(b[l]==trans[a[k]]) break;
+    }
+    if(l==n) return 0;
+  }
+  return 1;
+}
+
+/* 1 if QPTrans[0..NMPTrans-1] with their signs form a group */
+static int isGreenTransGroup() {
+  int a,b,c,r,t;
+  for(a=0;a<NMPTrans;a++) {
+    for(r=0;r<Nsite;r++) {
+      if(QPTrans[a][r]!=r || QPTransSgn[a][r]!=1) break;
+    }
+    if(r==Nsite) break;
+  }
+  if(a==NMPTrans) return 0; /* no identity */
+
+  /* closure: T_a T_b = T_c */
+  for(a=0;a<NMPTrans;a++) {
+    for(b=0;b<NMPTrans;b++) {
+      for(c=0;c<NMPTrans;c++) {
+        for(r=0;r<Nsite;r++) {
+          t = QPTrans[b][r];
+          if(QPTrans[c][r]!=QPTrans[a][t]
+             || QPTransSgn[c][r]!=QPTransSgn[a][t]*QPTransSgn[b][r]) break;
+        }
+        if(r==Nsite) break;
+      }
+      if(c==NMPTrans) return 0;
+    }
+  }
+  return 1;
+}
+
+/* 1 if LocSpn and the correlation factors are invariant under QPTrans[0..NMPTrans-1] */
+static int isGreenTransInvariant() {
+  int mpidx,idx,r,s;
+  const int *t;
+  for(mpidx=0;mpidx<NMPTrans;mpidx++) {
+    t = QPTrans[mpidx];
+    for(r=0;r<Nsite;r++) {
+      if(LocSpn[t[r]]!=LocSpn[r]) return 0;
+      if(NGutzwillerIdx>0 && GutzwillerIdx[t[r]]!=GutzwillerIdx[r]) return 0;
+      if(NJastrowIdx>0) {
+        for(s=0;s<Nsite;s++) {
+          if(s!=r && JastrowIdx[t[r]][t[s]]!=JastrowIdx[r][s]) return 0;
+        }
+      }
+      for(idx=0;idx<NDoublonHolon2siteIdx;idx++) {
+        if(!isTransSiteSet(2,DoublonHolon2siteIdx[idx]+2*r,DoublonHolon2siteIdx[idx]+2*t[r],t)) return 0;
+      }
+      for(idx=0;idx<NDoublonHolon4siteIdx;idx++) {
+        if(!isTransSiteSet(4,DoublonHolon4siteIdx[idx]+4*r,DoublonHolon4siteIdx[idx]+4*t[r],t)) return 0;
+      }
+    }
+  }
+  return 1;
+}
+
+/* Check the assumptions of NGreenTransSym>0 and switch it off if they fail.
+   Called after ReadDefFileIdxPara and before SetMemory. */
+void CheckGreenTransSym(MPI_Comm comm) {
+  int rank;
+  MPI_Comm_rank(comm, &rank);
+  if(NVMCCalMode!=1 || NGreenTransSym==0) return;
+
+  if(!isGreenTransGroup()) {
+    if(rank==0) {
+      fprintf(stdout, "Warning: NGreenTransSym (in modpara.def) must be 0 when the first NMPTrans\n");
+      fprintf(stdout, "         translations in TransSym do not form a group.\n");
+      fprintf(stdout, "         NGreenTransSym set as 0.\n");
+    }
+    NGreenTransSym = 0;
+  } else if(!isGreenTransInvariant()) {
+    if(rank==0) {
+      fprintf(stdout, "Warning: NGreenTransSym (in modpara.def) must be 0 when LocSpn, Gutzwiller, Jastrow\n");
+      fprintf(stdout, "         or DoublonHolon factors are not invariant under the translations.\n");
+      fprintf(stdout, "         NGreenTransSym set as 0.\n");
+    }
+    NGreenTransSym = 0;
+  }
+  return;
+}
+
+/* Make the classes of the Green functions for NGreenTransSym>0 */
+void InitGreenTransSym() {
+  NCisAjsTrans = 0;
+  NCisAjsCktAltDCTrans = 0;
+  if(NVMCCalMode!=1 || NGreenTransSym==0) return;
+
+  /* LocalCisAjs of every index is needed for CisAjsCktAlt and the Lanczos step */
+  if(NCisAjsCktAlt==0 && NLanczosMode<2) {
+    makeGreenTransClass(2,NCisAjs,CisAjsIdx,
+                        &NCisAjsTrans,CisAjsTransIdx,CisAjsTransSgn,CisAjsTransRep);
+  }
+  makeGreenTransClass(4,NCisAjsCktAltDC,CisAjsCktAltDCIdx,
+                      &NCisAjsCktAltDCTrans,CisAjsCktAltDCTransIdx,CisAjsCktAltDCTransSgn,
+                      CisAjsCktAltDCTransRep);
+  return;
+}
+
+/* <CisAjs> of the class of CisAjsIdx[idx]                           */
+/* NGreenTransSym=1: the representative, 2: average over the copies  */
+double complex greenFunc1Trans(const int idx, const double complex ip,
+                               int *eleIdx, const int *eleCfg, int *eleNum, const int *eleProjCnt,
+                               int *projCntNew, double complex *buffer) {
+  const int ri = CisAjsIdx[idx][0];
+  const int rj = CisAjsIdx[idx][2];
+  const int s  = CisAjsIdx[idx][3];
+  int mpidx;
+  double complex z=0.0;
+
+  if(NGreenTransSym==1) {
+    return GreenFunc1(ri,rj,s,ip,eleIdx,eleCfg,eleNum,eleProjCnt,projCntNew,buffer);
+  }
+
+  for(mpidx=0;mpidx<NMPTrans;mpidx++) {
+    z += QPTransSgn[mpidx][ri]*QPTransSgn[mpidx][rj]
+      * GreenFunc1(QPTrans[mpidx][ri],QPTrans[mpidx][rj],s,ip,
+                   eleIdx,eleCfg,eleNum,eleProjCnt,projCntNew,buffer);
+  }
+  return z/(double)NMPTrans;
+}
+
+/* <CisAjsCktAlt> of the class of CisAjsCktAltDCIdx[idx] */
+double complex greenFunc2Trans(const int idx, const double complex ip,
+                               int *eleIdx, const int *eleCfg, int *eleNum, const int *eleProjCnt,
+                               int *projCntNew, double complex *buffer) {
+  const int ri = CisAjsCktAltDCIdx[idx][0];
+  const int rj = CisAjsCktAltDCIdx[idx][2];
+  const int s  = CisAjsCktAltDCIdx[idx][1];
+  const int rk = CisAjsCktAltDCIdx[idx][4];
+  const int rl = CisAjsCktAltDCIdx[idx][6];
+  const int t  = CisAjsCktAltDCIdx[idx][5];
+  const int *xqp, *xqpSgn;
+  int mpidx;
+  double complex z=0.0;
+
+  if(NGreenTransSym==1) {
+    return GreenFunc2(ri,rj,rk,rl,s,t,ip,eleIdx,eleCfg,eleNum,eleProjCnt,projCntNew,buffer);
+  }
+
+  for(mpidx=0;mpidx<NMPTrans;mpidx++) {
+    xqp = QPTrans[mpidx];
+    xqpSgn = QPTransSgn[mpidx];
+    z += xqpSgn[ri]*xqpSgn[rj]*xqpSgn[rk]*xqpSgn[rl]
+      * GreenFunc2(xqp[ri],xqp[rj],xqp[rk],xqp[rl],s,t,ip,
+                   eleIdx,eleCfg,eleNum,eleProjCnt,projCntNew,buffer);
+  }
+  return z/(double)NMPTrans;
+}
+
+/* Real version of greenFunc1Trans (FlagRealSlaterElm=1) */
+double greenFunc1Trans_real(const int idx, const double ip,
+                            int *eleIdx, const int *eleCfg, int *eleNum, const int *eleProjCnt,
+                            int *projCntNew, double *buffer) {
+  const int ri = CisAjsIdx[idx][0];
+  const int rj = CisAjsIdx[idx][2];
+  const int s  = CisAjsIdx[idx][3];
+  int mpidx;
+  double z=0.0;
+
+  if(NGreenTransSym==1) {
+    return GreenFunc1_real(ri,rj,s,ip,eleIdx,eleCfg,eleNum,eleProjCnt,projCntNew,buffer);
+  }
+
+  for(mpidx=0;mpidx<NMPTrans;mpidx++) {
+    z += QPTransSgn[mpidx][ri]*QPTransSgn[mpidx][rj]
+      * GreenFunc1_real(QPTrans[mpidx][ri],QPTrans[mpidx][rj],s,ip,
+                        eleIdx,eleCfg,eleNum,eleProjCnt,projCntNew,buffer);
+  }
+  return z/(double)NMPTrans;
+}
+
+/* Real version of greenFunc2Trans (FlagRealSlaterElm=1) */
+double greenFunc2Trans_real(const int idx, const double ip,
+                            int *eleIdx, const int *eleCfg, int *eleNum, const int *eleProjCnt,
+                            int *projCntNew, double *buffer) {
+  const int ri = CisAjsCktAltDCIdx[idx][0];
+  const int rj = CisAjsCktAltDCIdx[idx][2];
+  const int s  = CisAjsCktAltDCIdx[idx][1];
+  const int rk = CisAjsCktAltDCIdx[idx][4];
+  const int rl = CisAjsCktAltDCIdx[idx][6];
+  const int t  = CisAjsCktAltDCIdx[idx][5];
+  const int *xqp, *xqpSgn;
+  int mpidx;
+  double z=0.0;
+
+  if(NGreenTransSym==1) {
+    return GreenFunc2_real(ri,rj,rk,rl,s,t,ip,eleIdx,eleCfg,eleNum,eleProjCnt,projCntNew,buffer);
+  }
+
+  for(mpidx=0;mpidx<NMPTrans;mpidx++) {
+    xqp = QPTrans[mpidx];
+    xqpSgn = QPTransSgn[mpidx];
+    z += xqpSgn[ri]*xqpSgn[rj]*xqpSgn[rk]*xqpSgn[rl]
+      * GreenFunc2_real(xqp[ri],xqp[rj],xqp[rk],xqp[rl],s,t,ip,
+                        eleIdx,eleCfg,eleNum,eleProjCnt,projCntNew,buffer);
+  }
+  return z/(double)NMPTrans;
+}
+
 void CalculateGreenFunc(const double w, const double complex ip, int *eleIdx, int *eleCfg,
                         int *eleNum, int *eleProjCnt) {
 
@@ -38,6 +310,11 @@ void CalculateGreenFunc(const double w, const double complex ip, int *eleIdx, in
   int *myEleIdx, *myEleNum, *myProjCntNew;
   double complex *myBuffer;
 
+  if(FlagRealSlaterElm==1) {
+    CalculateGreenFunc_real(w,creal(ip),eleIdx,eleCfg,eleNum,eleProjCnt);
+    return;
+  }
+
   RequestWorkSpaceThreadInt(Nsize+Nsite2+NProj);
   RequestWorkSpaceThreadComplex(NQPFull+2*Nsize);
   /* GreenFunc1: NQPFull, GreenFunc2: NQPFull+2*Nsize */
@@ -58,30 +335,59 @@ void CalculateGreenFunc(const double w, const double complex ip, int *eleIdx, in
     #pragma omp master
     {StartTimer(50);}
 
-    #pragma omp for private(idx,ri,rj,s,tmp) schedule(dynamic) nowait
-    for(idx=0;idx<NCisAjs;idx++) {
-      ri = CisAjsIdx[idx][0];
-      rj = CisAjsIdx[idx][2];
-      s  = CisAjsIdx[idx][3];
-      tmp = GreenFunc1(ri,rj,s,ip,myEleIdx,eleCfg,myEleNum,eleProjCnt,
-                       myProjCntNew,myBuffer);
-      LocalCisAjs[idx] = tmp;
+    if(NCisAjsTrans>0) {
+      #pragma omp for private(idx) schedule(dynamic) nowait
+      for(idx=0;idx<NCisAjsTrans;idx++) {
+        LocalGreenTrans[idx] = greenFunc1Trans(CisAjsTransRep[idx],ip,myEleIdx,eleCfg,myEleNum,eleProjCnt,
+                                               myProjCntNew,myBuffer);
+      }
+    } else {
+      #pragma omp for private(idx,ri,rj,s,tmp) schedule(dynamic) nowait
+      for(idx=0;idx<NCisAjs;idx++) {
+        ri = CisAjsIdx[idx][0];
+        rj = CisAjsIdx[idx][2];
+        s  = CisAjsIdx[idx][3];
+        tmp = GreenFunc1(ri,rj,s,ip,myEleIdx,eleCfg,myEleNum,eleProjCnt,
+                         myProjCntNew,myBuffer);
+        LocalCisAjs[idx] = tmp;
+      }
     }
     #pragma omp master
     {StopTimer(50);StartTimer(51);}
     
-    #pragma omp for private(idx,ri,rj,s,rk,rl,t,tmp) schedule(dynamic)
-    for(idx=0;idx<NCisAjsCktAltDC;idx++) {
-      ri = CisAjsCktAltDCIdx[idx][0];
-      rj = CisAjsCktAltDCIdx[idx][2];
-      s  = CisAjsCktAltDCIdx[idx][1];
-      rk = CisAjsCktAltDCIdx[idx][4];
-      rl = CisAjsCktAltDCIdx[idx][6];
-      t  = CisAjsCktAltDCIdx[idx][5];
+    if(NCisAjsCktAltDCTrans>0) {
+      #pragma omp for private(idx) schedule(dynamic)
+      for(idx=0;idx<NCisAjsCktAltDCTrans;idx++) {
+        LocalGreenTrans[NCisAjsTrans+idx] = greenFunc2Trans(CisAjsCktAltDCTransRep[idx],ip,myEleIdx,eleCfg,myEleNum,
+                                                            eleProjCnt,myProjCntNew,myBuffer);
+      }
+
+      #pragma omp for private(idx) nowait
+      for(idx=0;idx<NCisAjsCktAltDC;idx++) {
+        PhysCisAjsCktAltDC[idx] += w*CisAjsCktAltDCTransSgn[idx]
+          *LocalGreenTrans[NCisAjsTrans+CisAjsCktAltDCTransIdx[idx]];
+      }
+    } else {
+      #pragma omp for private(idx,ri,rj,s,rk,rl,t,tmp) schedule(dynamic)
+      for(idx=0;idx<NCisAjsCktAltDC;idx++) {
+        ri = CisAjsCktAltDCIdx[idx][0];
+        rj = CisAjsCktAltDCIdx[idx][2];
+        s  = CisAjsCktAltDCIdx[idx][1];
+        rk = CisAjsCktAltDCIdx[idx][4];
+        rl = CisAjsCktAltDCIdx[idx][6];
+        t  = CisAjsCktAltDCIdx[idx][5];
+
+        tmp = GreenFunc2(ri,rj,rk,rl,s,t,ip,myEleIdx,eleCfg,myEleNum,eleProjCnt,
+                         myProjCntNew,myBuffer);
+        PhysCisAjsCktAltDC[idx] += w*tmp;
+      }
+    }
 
-      tmp = GreenFunc2(ri,rj,rk,rl,s,t,ip,myEleIdx,eleCfg,myEleNum,eleProjCnt,
-                       myProjCntNew,myBuffer);
-      PhysCisAjsCktAltDC[idx] += w*tmp;
+    if(NCisAjsTrans>0) {
+      #pragma omp for private(idx)
+      for(idx=0;idx<NCisAjs;idx++) {
+        LocalCisAjs[idx] = CisAjsTransSgn[idx]*LocalGreenTrans[CisAjsTransIdx[idx]];
+      }
     }
     
     #pragma omp master
@@ -112,6 +418,118 @@ void CalculateGreenFunc(const double w, const double complex ip, int *eleIdx, in
 }
 
 
+/* Real version of CalculateGreenFunc using SlaterElm_real and InvM_real (FlagRealSlaterElm=1) */
+void CalculateGreenFunc_real(const double w, const double ip, int *eleIdx, int *eleCfg,
+                             int *eleNum, int *eleProjCnt) {
+
+  int idx,idx0,idx1;
+  int ri,rj,s,rk,rl,t;
+  double tmp;
+  int *myEleIdx, *myEleNum, *myProjCntNew;
+  double *myBuffer;
+
+  RequestWorkSpaceThreadInt(Nsize+Nsite2+NProj);
+  RequestWorkSpaceThreadDouble(NQPFull+2*Nsize);
+  /* GreenFunc1: NQPFull, GreenFunc2: NQPFull+2*Nsize */
+
+  #pragma omp parallel default(shared)		\
+  private(myEleIdx,myEleNum,myProjCntNew,myBuffer,idx)
+  {
+    myEleIdx = GetWorkSpaceThreadInt(Nsize);
+    myEleNum = GetWorkSpaceThreadInt(Nsite2);
+    myProjCntNew = GetWorkSpaceThreadInt(NProj);
+    myBuffer = GetWorkSpaceThreadDouble(NQPFull+2*Nsize);
+
+    #pragma loop noalias
+    for(idx=0;idx<Nsize;idx++) myEleIdx[idx] = eleIdx[idx];
+    #pragma loop noalias
+    for(idx=0;idx<Nsite2;idx++) myEleNum[idx] = eleNum[idx];
+
+    #pragma omp master
+    {StartTimer(50);}
+
+    if(NCisAjsTrans>0) {
+      #pragma omp for private(idx) schedule(dynamic) nowait
+      for(idx=0;idx<NCisAjsTrans;idx++) {
+        LocalGreenTrans[idx] = greenFunc1Trans_real(CisAjsTransRep[idx],ip,myEleIdx,eleCfg,myEleNum,eleProjCnt,
+                                                    myProjCntNew,myBuffer);
+      }
+    } else {
+      #pragma omp for private(idx,ri,rj,s,tmp) schedule(dynamic) nowait
+      for(idx=0;idx<NCisAjs;idx++) {
+        ri = CisAjsIdx[idx][0];
+        rj = CisAjsIdx[idx][2];
+        s  = CisAjsIdx[idx][3];
+        tmp = GreenFunc1_real(ri,rj,s,ip,myEleIdx,eleCfg,myEleNum,eleProjCnt,
+                              myProjCntNew,myBuffer);
+        LocalCisAjs[idx] = tmp;
+      }
+    }
+    #pragma omp master
+    {StopTimer(50);StartTimer(51);}
+    
+    if(NCisAjsCktAltDCTrans>0) {
+      #pragma omp for private(idx) schedule(dynamic)
+      for(idx=0;idx<NCisAjsCktAltDCTrans;idx++) {
+        LocalGreenTrans[NCisAjsTrans+idx] = greenFunc2Trans_real(CisAjsCktAltDCTransRep[idx],ip,myEleIdx,eleCfg,
+                                                                 myEleNum,eleProjCnt,myProjCntNew,myBuffer);
+      }
+
+      #pragma omp for private(idx) nowait
+      for(idx=0;idx<NCisAjsCktAltDC;idx++) {
+        PhysCisAjsCktAltDC[idx] += w*CisAjsCktAltDCTransSgn[idx]
+          *LocalGreenTrans[NCisAjsTrans+CisAjsCktAltDCTransIdx[idx]];
+      }
+    } else {
+      #pragma omp for private(idx,ri,rj,s,rk,rl,t,tmp) schedule(dynamic)
+      for(idx=0;idx<NCisAjsCktAltDC;idx++) {
+        ri = CisAjsCktAltDCIdx[idx][0];
+        rj = CisAjsCktAltDCIdx[idx][2];
+        s  = CisAjsCktAltDCIdx[idx][1];
+        rk = CisAjsCktAltDCIdx[idx][4];
+        rl = CisAjsCktAltDCIdx[idx][6];
+        t  = CisAjsCktAltDCIdx[idx][5];
+
+        tmp = GreenFunc2_real(ri,rj,rk,rl,s,t,ip,myEleIdx,eleCfg,myEleNum,eleProjCnt,
+                              myProjCntNew,myBuffer);
+        PhysCisAjsCktAltDC[idx] += w*tmp;
+      }
+    }
+
+    if(NCisAjsTrans>0) {
+      #pragma omp for private(idx)
+      for(idx=0;idx<NCisAjs;idx++) {
+        LocalCisAjs[idx] = CisAjsTransSgn[idx]*LocalGreenTrans[CisAjsTransIdx[idx]];
+      }
+    }
+    
+    #pragma omp master
+    {StopTimer(51);StartTimer(52);}
+
+    #pragma omp for private(idx) nowait
+    for(idx=0;idx<NCisAjs;idx++) {
+      PhysCisAjs[idx] += w*LocalCisAjs[idx];
+    }
+
+    #pragma omp master
+    {StopTimer(52);StartTimer(53);}
+
+    #pragma omp for private(idx,idx0,idx1) nowait
+    for(idx=0;idx<NCisAjsCktAlt;idx++) {
+      idx0 = CisAjsCktAltIdx[idx][0];
+      idx1 = CisAjsCktAltIdx[idx][1];
+      PhysCisAjsCktAlt[idx] += w*LocalCisAjs[idx0]*conj(LocalCisAjs[idx1]);
+    }
+
+    #pragma omp master
+    {StopTimer(53);}
+  }
+
+  ReleaseWorkSpaceThreadInt();
+  ReleaseWorkSpaceThreadDouble();
+  return;
+}
+
 void CalculateGreenFuncBF(const double w, const double ip, int *eleIdx, int *eleCfg,
                           int *eleNum, int *eleProjCnt, const int *eleProjBFCnt) {
 
@@ -26,6 +26,7 @@ along with this program. If not, see http://www.gnu.org/licenses/.
  * by Satoshi Morita
  *-------------------------------------------------------------*/
 #include "calham.h"
+#include "locgrn_batch.h"
 
 #pragma once
 
@@ -67,6 +68,8 @@ double complex CalculateHamiltonian(const double complex ip, int *eleIdx, const
   double complex *myBuffer;
   double complex myEnergy;
 
+  if(FlagLocGrnBatch==1) return CalculateHamiltonianBatch(ip,eleIdx,eleCfg,eleNum,eleProjCnt);
+
   RequestWorkSpaceThreadInt(Nsize+Nsite2+NProj);
   RequestWorkSpaceThreadComplex(NQPFull+2*Nsize);
   /* GreenFunc1: NQPFull, GreenFunc2: NQPFull+2*Nsize */
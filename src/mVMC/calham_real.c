@@ -32,6 +32,7 @@ along with this program. If not, see http://www.gnu.org/licenses/.
 #include "slater.h"
 #include "locgrn_real.h"
 #include "calham_real.h"
+#include "locgrn_batch.h"
 
 ///
 /// \param ip
@@ -51,6 +52,8 @@ double CalculateHamiltonian_real(const double ip, int *eleIdx, const int *eleCfg
   double  *myBuffer;
   double  myEnergy;
 
+  if(FlagLocGrnBatch==1) return CalculateHamiltonianBatch_real(ip,eleIdx,eleCfg,eleNum,eleProjCnt);
+
   RequestWorkSpaceThreadInt(Nsize+Nsite2+NProj);
   RequestWorkSpaceThreadDouble(NQPFull+2*Nsize);
   /* GreenFunc1: NQPFull, GreenFunc2: NQPFull+2*Nsize */
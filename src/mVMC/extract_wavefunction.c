@@ -5,7 +5,9 @@
 #include <stdbool.h>
 
 FILE* globalOutputFile = NULL;
+char const* globalOutputName = NULL;
 bool shouldWalk = false;
+MPI_Comm walkComm = MPI_COMM_SELF;
 
 void InitWaveFunctionExtraction(MPI_Comm comm) {
   char const* filename = getenv("EXTRACT_WAVEFUNCTION");
@@ -14,6 +16,13 @@ void InitWaveFunctionExtraction(MPI_Comm comm) {
       fprintf(stderr, "InitWaveFunctionExtraction: globalOutputFile already initialized. Aborting ...\n");
       MPI_Abort(comm, -1);
     }
+    globalOutputName = filename;
+
+    // the exhaustive enumeration writes the binary file by itself
+    if (getenv("WALK") != NULL) {
+      shouldWalk = true;
+      return;
+    }
 
     int size;
     MPI_Comm_size(comm, &size);
@@ -26,10 +35,6 @@ void InitWaveFunctionExtraction(MPI_Comm comm) {
                     "InitWaveFunctionExtraction: all wave function evaluations will be written to it\n",
                     filename);
     globalOutputFile = fopen(filename, "a");
-
-    if (getenv("WALK") != NULL) {
-      shouldWalk = true;
-    }
   }
 }
 
@@ -39,14 +44,28 @@ void ExitWaveFunctionExtraction(MPI_Comm comm) {
     fflush(globalOutputFile);
     fclose(globalOutputFile);
     globalOutputFile = NULL;
-    shouldWalk = false;
   }
+  globalOutputName = NULL;
+  shouldWalk = false;
 }
 
 FILE* WaveFunctionOutputFile(void) {
   return globalOutputFile;
 }
 
+char const* WaveFunctionOutputName(void) {
+  return globalOutputName;
+}
+
 bool GetShouldWalk(void) {
   return shouldWalk;
 }
+
+// the processes which share the enumeration of the configurations
+void SetWaveFunctionWalkComm(MPI_Comm comm) {
+  walkComm = comm;
+}
+
+MPI_Comm GetWaveFunctionWalkComm(void) {
+  return walkComm;
+}
@@ -4,7 +4,25 @@
 #include <stdio.h>
 #include <stdbool.h>
 
+/* EXTRACT_WAVEFUNCTION=<file>: every evaluated amplitude is appended to <file> as
+   "<spin configuration>\t<amplitude>". The spin configuration is the bitset of the sites
+   occupied by down spins; more than 64 sites are written as 64-bit words separated by ':'
+   from the most significant one.
+
+   EXTRACT_WAVEFUNCTION=<file> WALK=1: the amplitudes of all the configurations with
+   Ne down spins are enumerated in parallel and written to <file> in binary:
+     char     magic[8] = "mVMCwf01"
+     int32_t  Nsite
+     int32_t  Ne (the number of down spins)
+     uint64_t nConfig = binomial(Nsite, Ne)
+     double   amplitude[nConfig]
+   The configuration with down spins on the sites c_0 < c_1 < ... < c_{Ne-1} has the index
+   binomial(c_0,1) + binomial(c_1,2) + ... + binomial(c_{Ne-1},Ne). */
+
 void InitWaveFunctionExtraction(MPI_Comm comm);
 void ExitWaveFunctionExtraction(MPI_Comm comm);
 FILE* WaveFunctionOutputFile(void);
+char const* WaveFunctionOutputName(void);
 bool GetShouldWalk(void);
+void SetWaveFunctionWalkComm(MPI_Comm comm);
+MPI_Comm GetWaveFunctionWalkComm(void);
@@ -0,0 +1,7 @@
+#ifndef _AUTOCORR
+#define _AUTOCORR
+#include <mpi.h>
+
+void CalculateAutoCorr(const int step, MPI_Comm comm_parent, MPI_Comm comm_child1);
+
+#endif
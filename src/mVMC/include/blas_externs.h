@@ -33,15 +33,18 @@ along with this program. If not, see http://www.gnu.org/licenses/.
 #define M_DGEMM  dgemm_
 #define M_DGEMV  dgemv_
 #define M_DGER  dger_
+#define M_DSYRK dsyrk_
 #define M_ZAXPY zaxpy_
 #define M_ZGEMM zgemm_
 #define M_ZGEMV zgemv_
 #define M_ZGERC zgerc_
+#define M_ZHERK zherk_
 
 // LAPACK
 #define M_DGETRF dgetrf_
 #define M_DGETRI dgetri_
 #define M_DPOSV  dposv_
+#define M_DSYSV  dsysv_
 #define M_ZGETRF zgetrf_
 #define M_ZGETRI zgetri_
 #define M_ZPOSV  zposv_
@@ -79,6 +82,9 @@ extern void M_DGEMV(const char *trans, const int *m, const int *n, const double
 extern void M_DGEMM(const char *transa, const char *transb, const int *m, const int *n, const int *k,
                     const double *alpha, const double *a, const int *lda, const double *b, const int *ldb,
                     const double *beta, double *c, const int *ldc);
+extern void M_DSYRK(const char *uplo, const char *trans, const int *n, const int *k,
+                    const double *alpha, const double *a, const int *lda,
+                    const double *beta, double *c, const int *ldc);
 extern void M_ZGEMM(const char *transa, const char *transb, const int *m, const int *n, const int *k,
                     const double complex *alpha, const double complex *a, const int *lda,
                     const double complex *b, const int *ldb, const double complex *beta,
@@ -90,12 +96,18 @@ extern void M_DGER(const int *m, const int *n, const double *alpha, const double
                    const double *y, const int *incy, double *a, const int *lda);
 extern void M_ZGERC(const int *m, const int *n, const double complex *alpha, const double complex *x, const int *incx,
                     const double complex *y, const int *incy, double complex *a, const int *lda);
+extern void M_ZHERK(const char *uplo, const char *trans, const int *n, const int *k,
+                    const double *alpha, const double complex *a, const int *lda,
+                    const double *beta, double complex *c, const int *ldc);
 extern void M_DAXPY(const int *n, const double *alpha, const double *x, const int *incx, double *y, const int *incy);
 extern void M_ZAXPY(const int *n, const double complex *alpha, const double complex *x, const int *incx, double complex *y, const int *incy);
 
 // LAPACK
 extern void M_DPOSV(const char* uplo, const int* n, const int* nrhs, double* a,
                     const int* lda, double* b, const int* ldb, int* info );
+extern void M_DSYSV(const char* uplo, const int* n, const int* nrhs, double* a,
+                    const int* lda, int* ipiv, double* b, const int* ldb,
+                    double* work, const int* lwork, int* info );
 extern void M_DGETRF(const int* m, const int* n, double* a, const int* lda,
                      int* ipiv, int* info );
 extern void M_DGETRI(const int* n, double* a, const int* lda,
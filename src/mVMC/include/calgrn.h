@@ -2,9 +2,31 @@
 #define _CALGRN
 #include <complex.h>
 
+void CheckGreenTransSym(MPI_Comm comm);
+void InitGreenTransSym();
+
 void CalculateGreenFunc(const double w, const double complex ip, int *eleIdx, int *eleCfg,
                          int *eleNum, int *eleProjCnt);
 
+void CalculateGreenFunc_real(const double w, const double ip, int *eleIdx, int *eleCfg,
+                             int *eleNum, int *eleProjCnt);
+
 void CalculateGreenFuncBF(const double w, const double ip, int *eleIdx, int *eleCfg,
                           int *eleNum, int *eleProjCnt, const int *eleProjBFCnt);
+
+double complex greenFunc1Trans(const int idx, const double complex ip,
+                               int *eleIdx, const int *eleCfg, int *eleNum, const int *eleProjCnt,
+                               int *projCntNew, double complex *buffer);
+
+double complex greenFunc2Trans(const int idx, const double complex ip,
+                               int *eleIdx, const int *eleCfg, int *eleNum, const int *eleProjCnt,
+                               int *projCntNew, double complex *buffer);
+
+double greenFunc1Trans_real(const int idx, const double ip,
+                            int *eleIdx, const int *eleCfg, int *eleNum, const int *eleProjCnt,
+                            int *projCntNew, double *buffer);
+
+double greenFunc2Trans_real(const int idx, const double ip,
+                            int *eleIdx, const int *eleCfg, int *eleNum, const int *eleProjCnt,
+                            int *projCntNew, double *buffer);
 #endif
@@ -31,6 +31,8 @@ along with this program. If not, see http://www.gnu.org/licenses/.
 #include <complex.h>
 #include "stdio.h"
 #define D_FileNameMax 256
+#define D_StoreOChunk 32 /* the number of columns of the single-precision O converted at once */
+#define D_SROptHeunMaxTrial 8 /* the maximum number of the trials of the second stage of a Heun step */
 
 /***** definition *****/
 char CDataFileHead[D_FileNameMax]; /* prefix of output files */
@@ -41,9 +43,15 @@ int NVMCCalMode; /* calculation mode
                     1: calculation of expectation values */
 int NLanczosMode; /* mode of the single Lanczos step
                      0: none, 1: only energy, 2: Green functions */
+int NGreenTransSym; /* Green functions equivalent under QPTrans are measured once
+                       0: off, 1: a representative of each class, 2: average over NMPTrans copies */
 
-int NStoreO; /* choice of store O: 0-> normal other-> store  */
-int NSRCG; /* choice of solver for Sx=g: 0-> (Sca)LAPACK other-> CG  */
+int NStoreO; /* choice of store O: 0-> normal 2-> store in single precision other-> store  */
+int NStoreOBlock; /* the number of samples accumulated at once by ZHERK (DSYRK) for NStoreO=0 */
+int NStoreOBlockStored; /* the number of samples stored in SROptO_Block */
+int NSRCG; /* choice of solver for Sx=g: 0-> (Sca)LAPACK 2-> sample space other-> CG  */
+int FlagSROptDist; /* 1: S is assembled in the tiles of ScaLAPACK from SROptO_Store,
+                      and SROptOO keeps only <O> and the diagonal of <OO> as in SR-CG */
 
 int NDataIdxStart; /* starting value of the file index */
 int NDataQtySmp; /* the number of output files */
@@ -69,6 +77,9 @@ int NSROptFixSmp; /* the number of SR method steps with fixed samples (1 is reco
 double DSROptRedCut; /* SR stabilizing factor for truncation of redundant directions */
 double DSROptStaDel; /* SR stabiliaing factor for diagonal element modification */
 double DSROptStepDt; /* step width of the SR method */
+int NSROptAdaptive; /* 0: Euler step with fixed DSROptStepDt, 1: Heun step with adaptive DSROptStepDt */
+double DSROptAdaptTol; /* the tolerance of the local error of the adaptive Heun step */
+int FlagSROptReweight; /* 1: the samples are reused with the weight |psi/psi_sample|^2 (the second stage of a Heun step) */
 
 int NSROptCGMaxIter; /* the number of maximum iterations in SR-CG method */
 double DSROptCGTol; /* the tolerance for SR-CG method */
@@ -77,7 +88,15 @@ int NVMCWarmUp; /* Monte Carlo steps for warming up */
 int NVMCInterval; /* sampling interval [MCS] */ 
 int NVMCSample; /* the number of samples */
 int NExUpdatePath; /* update by exchange hopping  0: off, 1: on */
-int NBlockUpdateSize; /* {DEFINED: _pf_block_update} size of block Pfaffian update */
+int NVMCWalker; /* the number of Markov chains in each process (one per thread) */
+int NVMCCalFuse; /* 1: physical quantities are calculated in VMCMakeSample with its InvM */
+int NVMCBatch; /* the number of proposals whose inner products are reduced at once (NSplitSize>1) */
+int NVMCTempering; /* the number of replicas in a ladder of the replica exchange (1: off) */
+double DVMCTemperingBeta; /* the smallest beta of the ladder */
+int NVMCAutoCorr; /* 0: off, 1: estimate the autocorrelation of the local energy, 2: and tune NVMCInterval */
+double DVMCAutoCorrTarget; /* the target of the integrated autocorrelation time (NVMCAutoCorr=2) */
+int NDelayUpdate; /* the maximum number of hoppings whose updates of InvM are delayed (0: immediate) */
+int NBlockUpdateSize; /* {DEFINED: _pf_block_update} size of block Pfaffian update (0: default, -1: auto) */
 
 int RndSeed; /* seed for pseudorandom number generator */
 int NSplitSize; /* the number of inner MPI processes */
@@ -119,6 +138,15 @@ int NInterAll;
 int **InterAll; /* [NInterAll][8] */
 double complex*ParaInterAll;
 
+/* for the batched local Green functions (FlagLocGrnBatch=1) */
+int NLocGrnBatch; /* -1: automatic, 0: off, 1: on */
+int FlagLocGrnBatch; /* 1: off-diagonal terms of the Hamiltonian are evaluated in a batch */
+int NLocGrnTerm; /* NTransfer+NPairHopping+2*NExchangeCoupling+NInterAll */
+int *LocGrnTermIdx; /* [NLocGrnTerm][4] msa, rsa, msb, rsb of hopping electrons */
+double complex *LocGrnTerm; /* [3][NLocGrnTerm] coefficient, projection ratio, inner product */
+double complex *LocGrnBuf; /* [2][Nsize*Nsite2] rows of SlaterElm and InvM*SlaterElm */
+double *LocGrnBuf_real; /* [2][Nsize*Nsite2] */
+
 /* for variational parameters */
 int NGutzwillerIdx, *GutzwillerIdx; /* [Nsite] */
 int NJastrowIdx, **JastrowIdx; /* [Nsite][Nsite] */
@@ -147,6 +175,22 @@ int NCisAjsCktAltDC, **CisAjsCktAltDCIdx; /* [NCisAjsCktAltDC][6] */
 int NCisAjsLz, **CisAjsLzIdx, **iOneBodyGIdx; /* For Lanczos method only for rank 0*/
 int NCisAjsCktAltLz, **CisAjsCktAltLzIdx;
 
+/* classes of Green functions equivalent under QPTrans (NGreenTransSym>0) */
+int NCisAjsTrans;          /* the number of classes of CisAjs (0: not reduced) */
+int *CisAjsTransIdx;       /* [NCisAjs] the class of CisAjs */
+int *CisAjsTransSgn;       /* [NCisAjs] CisAjs = sgn * the representative of the class */
+int *CisAjsTransRep;       /* [NCisAjsTrans] the representative index of CisAjsIdx */
+int NCisAjsCktAltDCTrans;  /* the number of classes of CisAjsCktAltDC (0: not reduced) */
+int *CisAjsCktAltDCTransIdx; /* [NCisAjsCktAltDC] */
+int *CisAjsCktAltDCTransSgn; /* [NCisAjsCktAltDC] */
+int *CisAjsCktAltDCTransRep; /* [NCisAjsCktAltDCTrans] */
+double complex *LocalGreenTrans; /* [NCisAjsTrans+NCisAjsCktAltDCTrans] local Green functions of the classes */
+
+/* structure factors and momentum distribution (momentum.def) */
+int NMomentum; /* the number of q-points */
+int NMomentumDist; /* 1: the momentum distribution n(k) is calculated, 0: only N(q) and Sz(q) */
+double complex *MomentumExp; /* [NMomentum][Nsite] exp(i q.r_i) */
+
 /* Optimization flag */
 int *OptFlag; /* [NPara]  1: optimized, 0 or 2: fixed */
 int AllComplexFlag;/* 0 -> all real variables, !=0-> including complex variables*/
@@ -200,6 +244,7 @@ int *EleSpn;     /* EleIdx[sample][mi+si*Ne] */ //fsz
 int *EleProjBFCnt; /* EleProjCnt[sample][proj] */
 //[e] MERGE BY TM
 double *logSqPfFullSlater; /* logSqPfFullSlater[sample] */
+double *SampleLocEnergy; /* [NVMCSample] the local energy of each sample (NVMCAutoCorr>0) */
 //double complex *SmpSltElmBF; /* logSqPfFullSlater[sample] */
 double *SmpSltElmBF_real; /* logSqPfFullSlater[sample] */
 
@@ -222,8 +267,23 @@ int *BurnEleProjCnt;
 int *BurnEleSpn;
 int BurnFlag=0; /* 0: off, 1: on */
 
+/* for multi-walker sampling (NVMCWalker>1) */
+int *WalkerEleIdx; /* [NVMCWalker][Nsize+2*Nsite+2*Nsite+NProj] EleIdx, EleCfg, EleNum, EleProjCnt */
+double complex *WalkerInvM; /* [NVMCWalker][NQPFull*(Nsize*Nsize+1)] InvM and PfM of each walker */
+double *WalkerInvM_real; /* [NVMCWalker][NQPFull*(Nsize*Nsize+1)] */
+
+/* for the replica exchange (NVMCTempering>1) */
+int TemperingRung; /* the position in the ladder. 0: beta=1, the samples are stored */
+double TemperingBeta; /* the replica samples |<phi|L|x>|^{2 TemperingBeta} */
+MPI_Comm CommTempering; /* the processes exchanging the configurations */
+
 /***** Slater Elements ******/
 double complex *SlaterElm; /* SlaterElm[QPidx][ri+si*Nsite][rj+sj*Nsite] */
+/* or SlaterElm[QPidx][ri+si*Nsite][rj] (sj=1-si) for the compact layout */
+int FlagSlaterElmCompact; /* 1: only the up-down and down-up blocks of SlaterElm are stored */
+int NSlaterElmCol; /* the number of columns of SlaterElm: Nsite2, or Nsite for the compact layout */
+int FlagRealSlaterElm; /* 1: SlaterElm_real and InvM_real are used without the complex copies
+                          (real parameters, Sz conserved and no backflow) */
 double complex *InvM; /* InvM[QPidx][mi+si*Ne][mj+sj*Ne] */
 double complex *PfM; /* PfM[QPidx] */
 // TBC only for real
@@ -238,6 +298,11 @@ double *SlaterElm_real; /* SlaterElm[QPidx][ri+si*Nsite][rj+sj*Nsite] */
 double *SlaterElmBF_real;/* SlaterElm[QPidx][ri+si*Nsite][rj+sj*Nsite] */
 double *InvM_real; /* InvM[QPidx][mi+si*Ne][mj+sj*Ne] */
 double *PfM_real; /* PfM[QPidx] */
+/* delayed updates of InvM (NDelayUpdate>1) */
+/* InvM[i][j] + sum_k (DelayU[k][i]*DelayV[k][j] - DelayV[k][i]*DelayU[k][j]) is the current InvM */
+int NDelayStored; /* the number of hoppings stored in DelayU and DelayV */
+double complex *DelayU, *DelayV; /* [NQPFull][NDelayUpdate][Nsize] */
+double *DelayU_real, *DelayV_real; /* [NQPFull][NDelayUpdate][Nsize] */
 /***** Quantum Projection *****/
 double complex *QPFullWeight; /* QPFullWeight[NQPFull] */
 double complex *QPFixWeight; /* QPFixWeight[NQPFix] */
@@ -246,17 +311,27 @@ double complex *SPGLCosSin, *SPGLCosCos, *SPGLSinSin; /* [NSPGaussLeg] */
 
 /***** Stocastic Reconfiguration *****/
 int    SROptSize; /* 1+NPara */
+int    SROptCmpSize; /* the length of the complex O: the imaginary directions of the parameters with OptFlag=0 are dropped */
+int    *SROptCmpIdx; /* [2*SROptSize] position of each direction of O in the complex O (-1: dropped) */
 double complex *SROptOO; /* [SROptSize*SROptSize] <O^\dagger O> */
 double complex *SROptHO; /* [SROptSize]            < HO > */
 double complex *SROptO;  /* [SROptSize] calculation buffar */
-double complex *SROptO_Store;  /* [SROptSize*NVMCSample] calculation buffer */
+double complex *SROptO_Store;  /* [SROptCmpSize*NVMCSample] calculation buffer */
 //for real
 double *SROptOO_real; /* [SROptSize*SROptSize] <O^\dagger O> */ //TBC
 double *SROptHO_real; /* [SROptSize]            < HO > */       //TBC
 double *SROptO_real;  /* [SROptSize] calculation buffar */      //TBC
 double *SROptO_Store_real;  /* [SROptSize*NVMCSample] calculation buffer */
+float complex *SROptO_Store_float; /* [SROptCmpSize*NVMCSample] SROptO_Store in single precision (NStoreO=2) */
+float *SROptO_Store_float_real; /* [SROptSize*NVMCSample] */
+double complex *SROptO_Block; /* [NStoreOBlock][SROptCmpSize] buffer of sqrt(w)*O for NStoreOBlock>0 */
+double *SROptO_Block_real; /* [NStoreOBlock][SROptSize] */
+double *SROptCGWarmX; /* [2*NPara] the last solution of SR-CG used as the initial guess */
+double complex *SROptHeunPara; /* [2*NPara] the parameters at the start of the Heun step and the Euler update */
+double complex SROptHeunEtot[2]; /* Etot and Etot2 at the start of the Heun step */
 
 double complex *SROptData; /* [2+NPara] storage for energy and variational parameters */
+int NSROptDataSmp; /* the number of the steps stored in SROptData (<= NSROptItrSmp) */
 
 /***** Physical Quantity *****/
 double complex Wc; /* Weight for correlation sampling = <psi|x> */
@@ -271,6 +346,8 @@ double complex *PhysCisAjsCktAltDC; /* [NCisAjsCktAltDC] */
 double complex *LocalCisAjs; /* [NCisAjs] */
 
 double complex Sztot,Sztot2; /* <Sz>,<Sz^2> */
+double complex *PhysMomentum; /* [NMomentum][4] N(q), Sz(q), n_up(k), n_down(k) */
+double complex *LocalMomentumG; /* [2][Nsite][Nsite] the local one-body Green function (NMomentumDist=1) */
 
 
 double complex *PhysCisAjs; /* [NCisAjs] */
@@ -292,15 +369,25 @@ double *QCisAjsQ_real; /* QCisAjsQ[NLSHam][NLSHam][NCisAjs]*/ //TBC
 double *QCisAjsCktAltQ_real; /* QCisAjsCktAltQ[NLSHam][NLSHam][NCisAjsCktAlt]*/ //TBC
 double *LSLCisAjs_real; /* [NLSHam][NCisAjs]*/                //TBC
 
+/* one-hop terms <psi|H CisAjs|x>/<psi|x> shared in a Lanczos step (lslocgrn.c) */
+int NLSHop; /* number of the distinct hoppings in the current sample */
+int *LSHopIdx; /* [Nsite2][Nsite] index of the hopping CisAjs in LSHop, or -1 */
+int *LSHop; /* [NTransfer+NPairHopping+2*NExchangeCoupling+NInterAll+NCisAjs][2] (rsi,rsj) */
+double complex *LSHopVal; /* [NTransfer+NPairHopping+2*NExchangeCoupling+NInterAll+NCisAjs] */
+double *LSHopVal_real; /* [NTransfer+NPairHopping+2*NExchangeCoupling+NInterAll+NCisAjs] */
+
 /***** Output File *****/
 /* FILE *FileCfg; */
 FILE *FileOut;
 FILE *FileVar;
 FILE *FileTime;
 FILE *FileSRinfo; /* zvo_SRinfo.dat */
+FILE *FileSRdt; /* zvo_SRdt.dat (NSROptAdaptive=1) */
+FILE *FileAutoCorr; /* zvo_autocorr.dat (NVMCAutoCorr>0) */
 FILE *FileCisAjs;
 FILE *FileCisAjsCktAlt;
 FILE *FileCisAjsCktAltDC;
+FILE *FileMomentum; /* zvo_momentum.dat (NMomentum>0) */
 FILE *FileLS;
 FILE *FileLSQQQQ;
 FILE *FileLSQCisAjsQ;
@@ -315,6 +402,7 @@ FILE *FileLSCisAjsCktAlt;
 /***** HitachiTimer *****/
 const int NTimer=1000;
 double Timer[1000], TimerStart[1000];
+double TimerPrevSample; /* Timer[3] at the previous OutputTime (reset by InitTimer) */
 
 /* flag for  SROptimization*/
 int SRFlag; /* 0: periodic, 1: Diagonalization */
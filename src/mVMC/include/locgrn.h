@@ -11,6 +11,16 @@ double complex GreenFunc2(const int ri, const int rj, const int rk, const int rl
                   int *eleIdx, const int *eleCfg, int *eleNum, const int *eleProjCnt,
                   int *projCntNew, double complex *buffer);
 
+double complex greenFunc1_child(const int ri, const int rj, const int s, const double complex ip,
+                        int *eleIdx, const int *eleCfg, int *eleNum, const int *eleProjCnt,
+                        int *projCntNew, double complex *buffer,
+                        double complex *pfM, double complex *invM);
+double complex greenFunc2_child(const int ri, const int rj, const int rk, const int rl,
+                        const int s, const int t, const double complex ip,
+                        int *eleIdx, const int *eleCfg, int *eleNum, const int *eleProjCnt,
+                        int *projCntNew, double complex *buffer,
+                        double complex *pfM, double complex *invM);
+
 double complex GreenFuncN(const int n, int *rsi, int *rsj, const double complex  ip,
                   int *eleIdx, const int *eleCfg, int *eleNum, const int *eleProjCnt,
                   double complex *buffer, int *bufferInt);
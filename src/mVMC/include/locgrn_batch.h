@@ -0,0 +1,11 @@
+#ifndef _LOCGRN_BATCH
+#define _LOCGRN_BATCH
+
+#include <complex.h>
+
+void InitLocGrnBatch();
+double complex CalculateHamiltonianBatch(const double complex ip, int *eleIdx, const int *eleCfg,
+                                         int *eleNum, const int *eleProjCnt);
+double CalculateHamiltonianBatch_real(const double ip, int *eleIdx, const int *eleCfg,
+                                      int *eleNum, const int *eleProjCnt);
+#endif
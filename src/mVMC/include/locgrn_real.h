@@ -8,6 +8,15 @@ double GreenFunc2_real(const int ri, const int rj, const int rk, const int rl,
                   const int s, const int t, const double  ip,
                   int *eleIdx, const int *eleCfg, int *eleNum, const int *eleProjCnt,
                   int *projCntNew, double *buffer);
+double greenFunc1_child_real(const int ri, const int rj, const int s, const double ip,
+                             int *eleIdx, const int *eleCfg, int *eleNum, const int *eleProjCnt,
+                             int *projCntNew, double *buffer,
+                             double *pfM, double *invM);
+double greenFunc2_child_real(const int ri, const int rj, const int rk, const int rl,
+                             const int s, const int t, const double ip,
+                             int *eleIdx, const int *eleCfg, int *eleNum, const int *eleProjCnt,
+                             int *projCntNew, double *buffer,
+                             double *pfM, double *invM);
 
 double GreenFuncN_real(const int n, int *rsi, int *rsj, const double ip,
                   int *eleIdx, const int *eleCfg, int *eleNum, const int *eleProjCnt,
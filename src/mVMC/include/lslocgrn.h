@@ -7,5 +7,9 @@ void LSLocalQ(const double complex h1, const double complex ip, int *eleIdx, int
 
 void LSLocalCisAjs(const double complex h1, const double complex ip, int *eleIdx, int *eleCfg, int *eleNum, int *eleProjCnt);
 
+void MakeLSHop(const int *eleNum);
+int ReduceHCACA(const int ri, const int rj, const int rk, const int rl,
+                const int si, const int sk, const int *eleNum, int *hop, int *sgn);
+
 
 #endif
@@ -3,19 +3,26 @@
 
 void LSLocalQ_real(const double h1, const double ip, int *eleIdx, int *eleCfg, int *eleNum, int *eleProjCnt, double *_LSLQ_real);
 
-double calculateHK_real(const double h1, const double ip, int *eleIdx, int *eleCfg, int *eleNum, int *eleProjCnt);
+void calculateLSHop_real(const double ip, int *eleIdx, int *eleCfg, int *eleNum, int *eleProjCnt);
+
+double calculateHK_real(const double h1, const int *eleNum);
 
 double calHCA_real(const int ri, const int rj, const int s,
-                   const double h1, const double ip, int *eleIdx, int *eleCfg,
-                   int *eleNum, int *eleProjCnt);
+                   const double h1, const int *eleNum);
+
+double calHCA_child_real(const int ri, const int rj, const int s,
+                         const double ip, int *eleIdx, int *eleCfg, int *eleNum, int *eleProjCnt,
+                         double *invM, double *pfM, double *buffer, int *bufferInt);
 
 double checkGF1_real(const int ri, const int rj, const int s, const double ip,
                 int *eleIdx, const int *eleCfg, int *eleNum);
 
 double calHCA1_real(const int ri, const int rj, const int s,
-               const double ip, int *eleIdx, int *eleCfg, int *eleNum, int *eleProjCnt);
+               const double ip, int *eleIdx, int *eleCfg, int *eleNum, int *eleProjCnt,
+               double *invM, double *pfM, double *buffer, int *bufferInt);
 double calHCA2_real(const int ri, const int rj, const int s,
-                       const double ip, int *eleIdx, int *eleCfg, int *eleNum, int *eleProjCnt);
+                       const double ip, int *eleIdx, int *eleCfg, int *eleNum, int *eleProjCnt,
+                       double *buffer, int *bufferInt);
 
 double calculateHW_real(const double h1, const double ip, int *eleIdx, int *eleCfg,
                            int *eleNum, int *eleProjCnt);
@@ -23,20 +30,28 @@ double calculateHW_real(const double h1, const double ip, int *eleIdx, int *eleC
 double calHCACA_real(const int ri, const int rj, const int rk, const int rl,
                         const int si,const int sk,
                         const double h1, const double ip, int *eleIdx, int *eleCfg,
-                        int *eleNum, int *eleProjCnt);
+                        int *eleNum, int *eleProjCnt,
+                        double *invM, double *pfM, double *buffer, int *bufferInt);
 
 double checkGF2_real(const int ri, const int rj, const int rk, const int rl,
                      const int s, const int t, const double ip,
-                     int *eleIdx, const int *eleCfg, int *eleNum);
+                     int *eleIdx, const int *eleCfg, int *eleNum, double *buffer);
 
 double calHCACA1_real(const int ri, const int rj, const int rk, const int rl,
                  const int si,const int sk,
                  const double ip, int *eleIdx, int *eleCfg,
-                 int *eleNum, int *eleProjCnt);
+                 int *eleNum, int *eleProjCnt,
+                 double *invM, double *pfM, double *buffer, int *bufferInt);
 
 double calHCACA2_real(const int ri, const int rj, const int rk, const int rl,
                       const int si,const int sk,
-                      const double ip, int *eleIdx, int *eleCfg, int *eleNum, int *eleProjCnt);
+                      const double ip, int *eleIdx, int *eleCfg, int *eleNum, int *eleProjCnt,
+                      double *buffer, int *bufferInt);
+
+double calculateHamiltonian_child_real(const double ip, int *eleIdx, const int *eleCfg,
+                                       int *eleNum, const int *eleProjCnt,
+                                       double *pfM, double *invM,
+                                       double *buffer, int *bufferInt);
 
 void LSLocalCisAjs_real(const double h1, const double ip, int *eleIdx, int *eleCfg, int *eleNum, int *eleProjCnt);
 
@@ -13,7 +13,7 @@ int CalculateMAll_fsz_real(const int *eleIdx,const int *eleSpn, const int qpStar
 int calculateMAll_child_real(const int *eleIdx, const int qpStart, const int qpEnd, const int qpidx,
     double *bufM, int *iwork, double *work, int lwork, double* pfM_real, double *invM_real);
 int calculateMAll_child_fcmp(const int *eleIdx, const int qpStart, const int qpEnd, const int qpidx,
-    double complex *bufM, int *iwork, double complex *work, int lwork,double *rwork);
+    double complex *bufM, int *iwork, double complex *work, int lwork,double *rwork, double complex* pfM, double complex*invM);
 
 int calculateMAll_BF_real_child(const int *eleIdx, const int qpStart, const int qpEnd, const int qpidx,
     double *bufM, int *iwork, double *work, int lwork, double* pfM_real, double *invM_real);
@@ -0,0 +1,8 @@
+#ifndef _MOMENTUM
+#define _MOMENTUM
+#include <complex.h>
+
+void CalculateMomentum(const double w, const double complex ip, int *eleIdx, int *eleCfg,
+                       int *eleNum, int *eleProjCnt);
+
+#endif
@@ -3,13 +3,17 @@
 #include <complex.h>
 void CalculateNewPfM(const int mi, const int s, double complex *pfMNew, const int *eleIdx,
                      const int qpStart, const int qpEnd);
+void calculateNewPfM_child(const int ma, const int s, double complex *pfMNew, const int *eleIdx,
+                           const int qpStart, const int qpEnd, const int qpidx,
+                           const double complex *PfM, const double complex *InvM);
 void CalculateNewPfM2(const int mi, const int s, double complex *pfMNew, const int *eleIdx,
                      const int qpStart, const int qpEnd);
 void UpdateMAll(const int mi, const int s, const int *eleIdx,
                 const int qpStart, const int qpEnd);
 void updateMAll_child(const int ma, const int s, const int *eleIdx,
                       const int qpStart, const int qpEnd, const int qpidx,
-                      double complex *vec1, double complex *vec2);
+                      double complex *vec1, double complex *vec2,
+                      double complex *PfM, double complex *InvM);
 
 void CalculateNewPfMBF(const int *icount, const int *msaTmp,double complex*pfMNew, const int *eleIdx,
                        const int qpStart, const int qpEnd, const double complex*bufM) ;
@@ -0,0 +1,17 @@
+#ifndef _PFUPDATE_DELAY
+#define _PFUPDATE_DELAY
+#include <complex.h>
+
+void FlushDelayMAll_fcmp(const int qpStart, const int qpEnd);
+void FlushDelayMAll_real(const int qpStart, const int qpEnd);
+void CalculateNewPfMDelay_fcmp(const int msa, const int rsa, double complex *pfMNew,
+                               const int *eleIdx, const int *eleSpn,
+                               const int qpStart, const int qpEnd);
+void CalculateNewPfMDelay_real(const int msa, const int rsa, double *pfMNew,
+                               const int *eleIdx, const int *eleSpn,
+                               const int qpStart, const int qpEnd);
+void UpdateMAllDelay_fcmp(const int msa, const int rsa, const int *eleIdx, const int *eleSpn,
+                          const int qpStart, const int qpEnd);
+void UpdateMAllDelay_real(const int msa, const int rsa, const int *eleIdx, const int *eleSpn,
+                          const int qpStart, const int qpEnd);
+#endif
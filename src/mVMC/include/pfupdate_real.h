@@ -2,6 +2,9 @@
 #define _PFUPDATE_REAL
 void CalculateNewPfM_real(const int mi, const int s, double *pfMNew_real, const int *eleIdx,
                      const int qpStart, const int qpEnd);
+void calculateNewPfM_child_real(const int ma, const int s, double *pfMNew_real, const int *eleIdx,
+                                const int qpStart, const int qpEnd, const int qpidx,
+                                const double *PfM_real, const double *InvM_real);
 void CalculateNewPfM2_real(const int mi, const int s, double *pfMNew_real, const int *eleIdx,
                      const int qpStart, const int qpEnd);
 void UpdateMAll_real(const int mi, const int s, const int *eleIdx,
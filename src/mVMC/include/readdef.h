@@ -42,7 +42,7 @@ static char cKWListOfFileNameList[][D_CharTmpReadDef]={
 	"InOrbitalParallel", "InOrbitalGeneral",
   "OneBodyG", "TwoBodyG", "TwoBodyGEx",
   "InterAll", "OptTrans", "InOptTrans",
-  "BF", "BFRange"
+  "BF", "BFRange", "Momentum"
 };
 
 /**
@@ -60,7 +60,7 @@ enum KWIdxInt{
 	KWInOrbitalParallel, KWInorbitalGeneral,
   KWOneBodyG, KWTwoBodyG, KWTwoBodyGEx,
   KWInterAll, KWOptTrans, KWInOptTrans,
-  KWBF, KWBFRange,
+  KWBF, KWBFRange, KWMomentum,
   KWIdxInt_end
 };
 
@@ -83,14 +83,17 @@ enum ParamIdxInt{
   IdxNDH2, IdxNDH4, IdxNOrbit, IdxNOrbitGeneral,
 	IdxNQPTrans, IdxNOneBodyG, IdxNTwoBodyG,
   IdxNTwoBodyGEx, IdxNInterAll, IdxNQPOptTrans,
-  IdxSROptCGMaxIter,
+  IdxSROptCGMaxIter, IdxVMCWalker, IdxVMCBatch, IdxVMCCalFuse, IdxVMCTempering, IdxLocGrnBatch,
+  IdxVMCAutoCorr, IdxDelayUpdate, IdxBlockUpdateSize, IdxStoreOBlock, IdxSROptAdaptive,
+  IdxGreenTransSym, IdxNMomentum, IdxMomentumDist,
   IdxNBF,IdxNrange, IdxNNz, Idx2Sz, IdxNCond,
   ParamIdxInt_End
 };
 
 enum ParamIdxDouble{
   IdxSROptRedCut, IdxSROptStaDel, IdxSROptStepDt,
-  IdxSROptCGTol,
+  IdxSROptCGTol, IdxSROptAdaptTol, IdxVMCTemperingBeta,
+  IdxVMCAutoCorrTarget,
   ParamIdxDouble_End
 };
 
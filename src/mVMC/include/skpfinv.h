@@ -0,0 +1,10 @@
+#ifndef _SKPFINV
+#define _SKPFINV
+#include <complex.h>
+
+int SkPfaInv_fcmp(const int n, double complex *a, const int lda, double complex *pfaff,
+                  int *iwork, double complex *inv, const int ldinv, double complex *work);
+int SkPfaInv_real(const int n, double *a, const int lda, double *pfaff,
+                  int *iwork, double *inv, const int ldinv, double *work);
+
+#endif
@@ -1,7 +1,13 @@
 #ifndef _SLATER
 #define _SLATER
 void UpdateSlaterElm_fcmp();
+void UpdateSlaterElm_real();
+double complex GetSlaterElm_fcmp(const double complex *sltE, const int rsi, const int rsj);
+double GetSlaterElm_real(const double *sltE, const int rsi, const int rsj);
+void GetSlaterElmRow_fcmp(double complex *vec, const double complex *sltE, const int rsa, const int *eleIdx);
+void GetSlaterElmRow_real(double *vec, const double *sltE, const int rsa, const int *eleIdx);
 void SlaterElmDiff_fcmp(double complex *srOptO, const double complex ip, int *eleIdx);
+void SlaterElmDiff_real(double *srOptO, const double ip, int *eleIdx);
 
 void SlaterElmBFDiff_fcmp(double complex*srOptO, const double complex ip, int *eleIdx, int *eleNum, int *eleCfg, int *eleProjConst,const int * eleProjBFCnt);
 
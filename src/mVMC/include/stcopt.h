@@ -5,5 +5,9 @@
 int StochasticOpt(MPI_Comm comm);
 void stcOptInit(double *const s, double *const g, const int nSmat, const int *const smatToParaIdx);
 int stcOptMain(double *g, const int nSmat, const int *smatToParaIdx, MPI_Comm);
+void SROptHeunStart();
+void SROptHeunPredict();
+int SROptHeunCorrect(const int step, MPI_Comm comm);
+void SROptHeunEnd(const int accept);
 
 #endif
@@ -4,6 +4,7 @@
 #include <mpi.h>
 
 void stcOptInit(double *const s, double *const g, const int nSmat, const int *const smatToParaIdx);
+void stcOptInit_real(double *const s, double *const g, const int nSmat, const int *const smatToParaIdx);
 
 #endif
 #endif
@@ -2,6 +2,9 @@
 #define _VMCCAL
 #include <complex.h>
 void VMCMainCal(MPI_Comm comm);
+void VMCMainCalFusedStart();
+void VMCMainCalFused(const int sample, MPI_Comm comm);
+void VMCMainCalFusedEnd();
 void VMC_BF_MainCal(MPI_Comm comm);
 #endif
 
@@ -85,7 +85,9 @@ extern int omp_get_thread_num(void);
 #include "../slater_fsz.c"
 #include "../qp.c"
 #include "../qp_real.c"
+#include "../skpfinv.c"
 #include "../matrix.c"
+#include "../pfupdate_delay.c"
 #include "../pfupdate.c"
 #include "../pfupdate_real.c"
 #include "../pfupdate_fsz.c"
@@ -98,21 +100,26 @@ extern int omp_get_thread_num(void);
 #include "../locgrn_real.c"
 #include "../locgrn_fsz.c"
 #include "../locgrn_fsz_real.c"
+#include "../locgrn_batch.c"
 #include "../calham.c"
 #include "../calham_real.c"
 #include "../calham_fsz.c"
 #include "../calham_fsz_real.c"
 #include "../calgrn.c"
 #include "../calgrn_fsz.c"
+#include "../momentum.c"
 #include "../setmemory.c"
 #include "../readdef.c"
 #include "../initfile.c"
 
+#include "../vmcmake_tempering.c"
 #include "../vmcmake.c"
 #include "../vmcmake_real.c"
 #include "../vmcmake_fsz.c"
 #include "../vmcmake_fsz_real.c"
+#include "../vmcmake_walker.c"
 #include "../vmccal.c"
 #include "../vmccal_fsz.c"
+#include "../autocorr.c"
 
 #endif /* _VMC_INCLUDE_FILES */
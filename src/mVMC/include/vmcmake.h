@@ -4,8 +4,17 @@
 #include <mpi.h>
 
 void VMCMakeSample(MPI_Comm comm);
+#ifdef _pf_block_update
+void SetBlockUpdateSize_fcmp(int *eleIdx, int *eleSpn, const int defaultSize, MPI_Comm comm);
+void SetBlockUpdateSize_real(int *eleIdx, int *eleSpn, const int defaultSize, MPI_Comm comm);
+int tuneBlockUpdateSize_fcmp(int *eleIdx, int *eleSpn, MPI_Comm comm);
+int tuneBlockUpdateSize_real(int *eleIdx, int *eleSpn, MPI_Comm comm);
+#endif
+int makeBatchUpdate(const int nBatch, double complex *logIpOld, int *nAccept,
+                    const int qpStart, const int qpEnd, MPI_Comm comm);
 int makeInitialSample(int *eleIdx, int *eleCfg, int *eleNum, int *eleProjCnt,
                       const int qpStart, const int qpEnd, MPI_Comm comm);
+void makeRandomEleConfig(int *eleIdx, int *eleCfg, int *eleNum, int *eleProjCnt);
 void copyFromBurnSample(int *eleIdx, int *eleCfg, int *eleNum, int *eleProjCnt);
 void copyToBurnSample(const int *eleIdx, const int *eleCfg, const int *eleNum, const int *eleProjCnt);
 void saveEleConfig(const int sample, const double complex logIp,
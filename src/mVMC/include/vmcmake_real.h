@@ -6,6 +6,9 @@
 void VMCMakeSample_real(MPI_Comm comm);
 void VMC_BF_MakeSample_real(MPI_Comm comm);
 
+int makeBatchUpdate_real(const int nBatch, double *logIpOld, int *nAccept,
+                         const int qpStart, const int qpEnd, MPI_Comm comm);
+
 int makeInitialSample_real(int *eleIdx, int *eleCfg, int *eleNum, int *eleProjCnt,
                            const int qpStart, const int qpEnd, MPI_Comm comm);
 
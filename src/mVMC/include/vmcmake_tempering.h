@@ -0,0 +1,12 @@
+#ifndef _VMCMAKE_TEMPERING
+#define _VMCMAKE_TEMPERING
+#include <complex.h>
+#include <mpi.h>
+
+void InitTempering(MPI_Comm comm);
+int ExchangeReplica_fcmp(const int outStep, double complex *logIpOld,
+                         const int qpStart, const int qpEnd, MPI_Comm comm);
+int ExchangeReplica_real(const int outStep, double *logIpOld,
+                         const int qpStart, const int qpEnd, MPI_Comm comm);
+
+#endif
@@ -0,0 +1,10 @@
+#ifndef _VMCMAKE_WALKER
+#define _VMCMAKE_WALKER
+#include <complex.h>
+#include <mpi.h>
+
+void InitWalkerRandom(const int seed);
+void VMCMakeSampleWalker();
+void VMCMakeSampleWalker_real(MPI_Comm comm);
+
+#endif
@@ -32,6 +32,8 @@ along with this program. If not, see http://www.gnu.org/licenses/.
 
 void InitFile(char *xNameListFile, int rank) {
   char fileName[D_FileNameMax];
+  FILE *fp;
+  int i;
 
   if(rank!=0) return;
 
@@ -41,16 +43,57 @@ void InitFile(char *xNameListFile, int rank) {
   sprintf(fileName, "%s_time_%03d.dat", CDataFileHead, NDataIdxStart);
   FileTime = fopen(fileName, "w");
 
+  if(NVMCAutoCorr>0) {
+    /* tau: the integrated autocorrelation time of the local energy [samples],
+       ess: the effective sample size, geweke: the z-score of the first 10% and the last 50%
+       of the Markov chains, interval: NVMCInterval used in the sampling */
+    sprintf(fileName, "%s_autocorr.dat", CDataFileHead);
+    FileAutoCorr = fopen(fileName, "w");
+    fprintf(FileAutoCorr, "# step        tau        ess     geweke interval\n");
+  }
+
+  if(NCisAjsTrans>0 || NCisAjsCktAltDCTrans>0) {
+    /* the class of each Green function and the sign to the representative of the class,
+       which is the first Green function of the class in cisajs.def or cisajscktalt.def */
+    sprintf(fileName, "%s_greentrans.dat", CDataFileHead);
+    fp = fopen(fileName, "w");
+    fprintf(fp, "# cisajs %d %d\n", NCisAjs, NCisAjsTrans);
+    for(i=0;i<NCisAjs && NCisAjsTrans>0;i++) {
+      fprintf(fp, "%d %d %d %d %d %d\n", CisAjsIdx[i][0], CisAjsIdx[i][1], CisAjsIdx[i][2],
+              CisAjsIdx[i][3], CisAjsTransIdx[i], CisAjsTransSgn[i]);
+    }
+    fprintf(fp, "# cisajscktalt %d %d\n", NCisAjsCktAltDC, NCisAjsCktAltDCTrans);
+    for(i=0;i<NCisAjsCktAltDC && NCisAjsCktAltDCTrans>0;i++) {
+      fprintf(fp, "%d %d %d %d %d %d %d %d %d %d\n",
+              CisAjsCktAltDCIdx[i][0], CisAjsCktAltDCIdx[i][1], CisAjsCktAltDCIdx[i][2], CisAjsCktAltDCIdx[i][3],
+              CisAjsCktAltDCIdx[i][4], CisAjsCktAltDCIdx[i][5], CisAjsCktAltDCIdx[i][6], CisAjsCktAltDCIdx[i][7],
+              CisAjsCktAltDCTransIdx[i], CisAjsCktAltDCTransSgn[i]);
+    }
+    fclose(fp);
+  }
+
   if(NVMCCalMode==0) {
     sprintf(fileName, "%s_SRinfo.dat", CDataFileHead);
     FileSRinfo = fopen(fileName, "w");
-    if(SRFlag == 0){
+    if(NSRCG != 0){
+      /* iter: the number of CG iterations (NSRCG=1) or info of DSYSV (NSRCG=2), time: the solve time [s] */
+      fprintf(FileSRinfo,
+            "#Npara Msize optCut diagCut sDiagMax  sDiagMin    absRmax       imax  iter time\n");
+    }else if(SRFlag == 0){
       fprintf(FileSRinfo,
             "#Npara Msize optCut diagCut sDiagMax  sDiagMin    absRmax       imax\n");
     }else{
       fprintf(FileSRinfo,
             "#Npara Msize optCut diagCut sEigenMax  sEigenMin    absRmax       imax\n");
     }
+    if(NSROptAdaptive==1){
+      /* one line per trial of the second stage of a Heun step.
+         dt: the step width used in the trial, err: the estimated local error,
+         accept: 1 if the Heun step is accepted, 0 if it is rejected */
+      sprintf(fileName, "%s_SRdt.dat", CDataFileHead);
+      FileSRdt = fopen(fileName, "w");
+      fprintf(FileSRdt, "# step         dt        err accept\n");
+    }
 
     sprintf(fileName, "%s_out_%03d.dat", CDataFileHead, NDataIdxStart);
     FileOut = fopen(fileName, "w");
@@ -104,6 +147,11 @@ void InitFilePhysCal(int i, int rank) {
     sprintf(fileName, "%s_cisajscktalt_%03d.dat", CDataFileHead, idx);
     FileCisAjsCktAltDC = fopen(fileName, "w");
   }
+
+  if(NMomentum>0){
+    sprintf(fileName, "%s_momentum_%03d.dat", CDataFileHead, idx);
+    FileMomentum = fopen(fileName, "w");
+  }
   
   if(NLanczosMode>0){
     sprintf(fileName, "%s_ls_out_%03d.dat", CDataFileHead, idx);
@@ -139,9 +187,11 @@ void CloseFile(int rank) {
   if(rank!=0) return;
 
   fclose(FileTime);
+  if(NVMCAutoCorr>0) fclose(FileAutoCorr);
 
   if(NVMCCalMode==0) {
     fclose(FileSRinfo);
+    if(NSROptAdaptive==1) fclose(FileSRdt);
     fclose(FileOut);
     fclose(FileVar);
   }
@@ -164,6 +214,9 @@ void CloseFilePhysCal(int rank) {
   if(NCisAjsCktAltDC>0){
     fclose(FileCisAjsCktAltDC);
   }
+  if(NMomentum>0){
+    fclose(FileMomentum);
+  }
   
   if(NLanczosMode>0){
     fclose(FileLS);
@@ -187,8 +240,10 @@ void FlushFile(int step, int rank) {
 
   if(step%NFileFlushInterval==0) {
     fflush(FileTime);
+    if(NVMCAutoCorr>0) fflush(FileAutoCorr);
     if(NVMCCalMode==0) {
       fflush(FileSRinfo);
+      if(NSROptAdaptive==1) fflush(FileSRdt);
       fflush(FileOut);
       fflush(FileVar);
     }
@@ -0,0 +1,241 @@
+/*
+mVMC - A numerical solver package for a wide range of quantum lattice models based on many-variable Variational Monte Carlo method
+Copyright (C) 2016 The University of Tokyo, All rights reserved.
+
+This program is developed based on the mVMC-mini program
+(https://github.com/fiber-miniapp/mVMC-mini)
+which follows "The BSD 3-Clause License".
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details. 
+
+You should have received a copy of the GNU General Public License 
+along with this program. If not, see http://www.gnu.org/licenses/. 
+*/
+/*-------------------------------------------------------------
+ * Variational Monte Carlo
+ * library interface: evaluate amplitudes of an optimized wave function
+ *-------------------------------------------------------------*/
+#include "vmcmain.h"
+#include "libmvmc.h"
+
+#define D_LibInitMax 4 /* the number of stages of the initialization */
+
+int mvmcInitStage = 0; /* 0: not initialized, D_LibInitMax: ready */
+int mvmcFinalizeMPI = 0; /* 1: MPI was initialized by mvmc_initialize */
+
+/* Read the *def files of a finished run and the optimized parameters.
+   fileDefList: namelist.def, fileInitPara: zqp_opt.dat (NULL: the parameters of the *def files).
+   Every process reads the files by itself (MPI_COMM_SELF). */
+int mvmc_initialize(const char *fileDefList, const char *fileInitPara) {
+  char defList[D_FileNameMax];
+  char initPara[D_FileNameMax];
+  MPI_Comm comm = MPI_COMM_SELF;
+  int flag=0;
+
+  if(mvmcInitStage!=0) {
+    fprintf(stderr, "error: mvmc_initialize: already initialized.\n");
+    return -1;
+  }
+  strncpy(defList, fileDefList, D_FileNameMax-1);
+  defList[D_FileNameMax-1] = '\0';
+
+#ifdef _mpi_use
+  MPI_Initialized(&flag);
+  if(!flag) {
+    MPI_Init(NULL, NULL);
+    mvmcFinalizeMPI = 1;
+  }
+#endif
+  NThread = omp_get_max_threads();
+  InitTimer();
+
+  if(ReadDefFileNInt(defList, comm)!=0) return 1;
+  SetMemoryDef();
+  if(ReadDefFileIdxPara(defList, comm)!=0) return 1;
+  mvmcInitStage = 1;
+  if(iFlgOrbitalGeneral!=0 || NProjBF!=0) {
+    fprintf(stderr, "error: mvmc_initialize: general orbitals and backflow are not supported.\n");
+    FreeMemoryDef();
+    mvmcInitStage = 0;
+    return 2;
+  }
+  SetMemory();
+  mvmcInitStage = 2;
+
+  init_gen_rand(RndSeed);
+  LapackLWork = getLWork_fcmp();
+
+  InitParameter();
+  if(fileInitPara!=NULL) {
+    strncpy(initPara, fileInitPara, D_FileNameMax-1);
+    initPara[D_FileNameMax-1] = '\0';
+    if(ReadInitParameter(initPara)!=0) return 3;
+  }
+  if(ReadInputParameters(defList, comm)!=0) return 3;
+  SyncModifiedParameter(comm);
+  mvmcInitStage = 3;
+
+  InitQPWeight();
+  if(FlagRealSlaterElm==1) {
+    UpdateSlaterElm_real();
+  } else {
+    UpdateSlaterElm_fcmp();
+  }
+  UpdateQPWeight();
+  mvmcInitStage = D_LibInitMax;
+
+  return 0;
+}
+
+int mvmc_num_sites(void) {
+  return Nsite;
+}
+
+int mvmc_num_electrons(void) {
+  return Ne;
+}
+
+/* Set eleIdx, eleCfg and eleNum from the occupation numbers.
+   Return 0 if the numbers of electrons are correct. */
+int setEleConfigFromNum(const int *num, int *eleIdx, int *eleCfg, int *eleNum) {
+  int ri,s,mi;
+
+  for(s=0;s<2;s++) {
+    mi = 0;
+    for(ri=0;ri<Nsite;ri++) {
+      eleNum[ri+s*Nsite] = num[ri+s*Nsite];
+      eleCfg[ri+s*Nsite] = -1;
+      if(num[ri+s*Nsite]==1) {
+        if(mi>=Ne) return 1;
+        eleIdx[mi+s*Ne] = ri;
+        eleCfg[ri+s*Nsite] = mi;
+        mi++;
+      } else if(num[ri+s*Nsite]!=0) {
+        return 1;
+      }
+    }
+    if(mi!=Ne) return 1;
+  }
+  return 0;
+}
+
+/* Evaluate log <x|psi> = log P(x) + log <phi|L|x> of n configurations in parallel over threads.
+   configs: [n][2*Nsite] occupation numbers of the up spins (sites 0,...,Nsite-1) followed by
+            those of the down spins; the electrons are ordered by the site index for each spin.
+   out:     [n][2] the real and imaginary parts of log <x|psi>.
+   Return the number of configurations which are invalid or whose amplitude is zero;
+   their log amplitudes are set to -inf. */
+int evaluate_log_amplitudes(const int *configs, int n, double *out) {
+  const int nEle = Nsize+2*Nsite+2*Nsite+NProj;
+  const int nInvM = NQPFull*(Nsize*Nsize+1);
+  const int nComplex = (FlagRealSlaterElm==1) ? 0 : Nsize*Nsize+LapackLWork+nInvM;
+  const int nDouble = (FlagRealSlaterElm==1) ? Nsize*Nsize+LapackLWork+nInvM : LapackLWork;
+  int sample,nFail=0;
+
+  double complex *myBufM, *myWork, *myInvM;
+  double *myBufM_real, *myWork_real, *myInvM_real;
+  double *myRWork;
+  int *myIWork, *myEle;
+
+  if(mvmcInitStage!=D_LibInitMax) {
+    fprintf(stderr, "error: evaluate_log_amplitudes: mvmc_initialize is not called.\n");
+    return n;
+  }
+
+  RequestWorkSpaceThreadInt(Nsize+nEle);
+  RequestWorkSpaceThreadComplex(nComplex);
+  RequestWorkSpaceThreadDouble(nDouble);
+
+#pragma omp parallel default(shared) \
+  private(myIWork,myEle,myBufM,myWork,myInvM,myBufM_real,myWork_real,myInvM_real,myRWork,sample) \
+  reduction(+:nFail)
+  {
+    int *eleIdx,*eleCfg,*eleNum,*eleProjCnt;
+    double complex *pfM=NULL;
+    double *pfM_real=NULL;
+    double complex ip;
+    int qpidx,info;
+
+    myIWork = GetWorkSpaceThreadInt(Nsize);
+    myEle   = GetWorkSpaceThreadInt(nEle);
+    eleIdx = myEle;
+    eleCfg = eleIdx + Nsize;
+    eleNum = eleCfg + 2*Nsite;
+    eleProjCnt = eleNum + 2*Nsite;
+    /* only one of the complex and real buffers is used */
+    myBufM = myWork = myInvM = NULL;
+    myBufM_real = myWork_real = myInvM_real = myRWork = NULL;
+    if(FlagRealSlaterElm==1) {
+      /* real wave functions keep only SlaterElm_real (FlagRealSlaterElm=1) */
+      myBufM_real = GetWorkSpaceThreadDouble(Nsize*Nsize);
+      myWork_real = GetWorkSpaceThreadDouble(LapackLWork);
+      myInvM_real = GetWorkSpaceThreadDouble(nInvM);
+      pfM_real = myInvM_real + NQPFull*Nsize*Nsize;
+    } else {
+      myBufM  = GetWorkSpaceThreadComplex(Nsize*Nsize);
+      myWork  = GetWorkSpaceThreadComplex(LapackLWork);
+      myInvM  = GetWorkSpaceThreadComplex(nInvM);
+      myRWork = GetWorkSpaceThreadDouble(LapackLWork);
+      pfM = myInvM + NQPFull*Nsize*Nsize;
+    }
+
+#pragma omp for schedule(dynamic)
+    for(sample=0;sample<n;sample++) {
+      out[2*sample]   = -INFINITY;
+      out[2*sample+1] = 0.0;
+      if(setEleConfigFromNum(configs+sample*2*Nsite,eleIdx,eleCfg,eleNum)!=0) {
+        nFail++;
+        continue;
+      }
+      MakeProjCnt(eleProjCnt,eleNum);
+
+      ip = 0.0;
+      for(qpidx=0;qpidx<NQPFull;qpidx++) {
+        /* a singular matrix has zero Pfaffian */
+        if(FlagRealSlaterElm==1) {
+          info = calculateMAll_child_real(eleIdx,0,NQPFull,qpidx,myBufM_real,myIWork,myWork_real,
+                                          LapackLWork,pfM_real,myInvM_real);
+          if(info==0) ip += QPFullWeight[qpidx]*pfM_real[qpidx];
+        } else {
+          info = calculateMAll_child_fcmp(eleIdx,0,NQPFull,qpidx,myBufM,myIWork,myWork,LapackLWork,
+                                          myRWork,pfM,myInvM);
+          if(info==0) ip += QPFullWeight[qpidx]*pfM[qpidx];
+        }
+      }
+      if(cabs(ip)==0.0 || !isfinite(creal(ip)+cimag(ip))) {
+        nFail++;
+        continue;
+      }
+      ip = clog(ip);
+      out[2*sample]   = creal(ip) + LogProjVal(eleProjCnt);
+      out[2*sample+1] = cimag(ip);
+    }
+  }
+
+  ReleaseWorkSpaceThreadInt();
+  ReleaseWorkSpaceThreadComplex();
+  ReleaseWorkSpaceThreadDouble();
+
+  return nFail;
+}
+
+void mvmc_finalize(void) {
+  if(mvmcInitStage>=2) FreeMemory();
+  if(mvmcInitStage>=1) FreeMemoryDef();
+  mvmcInitStage = 0;
+#ifdef _mpi_use
+  if(mvmcFinalizeMPI==1) {
+    MPI_Finalize();
+    mvmcFinalizeMPI = 0;
+  }
+#endif
+  return;
+}
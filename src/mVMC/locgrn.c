@@ -40,8 +40,17 @@ double complex calculateNewPfMN_child(const int qpidx, const int n, const int *m
 double complex GreenFunc1(const int ri, const int rj, const int s, const double complex  ip,
                   int *eleIdx, const int *eleCfg, int *eleNum, const int *eleProjCnt,
                   int *projCntNew, double complex *buffer) {
+  return greenFunc1_child(ri,rj,s,ip,eleIdx,eleCfg,eleNum,eleProjCnt,projCntNew,buffer,PfM,InvM);
+}
+
+/* GreenFunc1 with the given PfM and InvM */
+double complex greenFunc1_child(const int ri, const int rj, const int s, const double complex  ip,
+                        int *eleIdx, const int *eleCfg, int *eleNum, const int *eleProjCnt,
+                        int *projCntNew, double complex *buffer,
+                        double complex *pfM, double complex *invM) {
   double complex z;
   int mj,msj,rsi,rsj;
+  int qpidx;
   double complex *pfMNew = buffer; /* NQPFull */
 
   if(ri==rj) return eleNum[ri+s*Nsite];
@@ -60,7 +69,9 @@ double complex GreenFunc1(const int ri, const int rj, const int s, const double
   z = ProjRatio(projCntNew,eleProjCnt);
 
   /* calculate Pfaffian */
-  CalculateNewPfM(mj, s, pfMNew, eleIdx, 0, NQPFull);
+  for(qpidx=0;qpidx<NQPFull;qpidx++) {
+    calculateNewPfM_child(mj, s, pfMNew, eleIdx, 0, NQPFull, qpidx, pfM, invM);
+  }
   z *= CalculateIP_fcmp(pfMNew, 0, NQPFull, MPI_COMM_SELF);
 
   /* revert hopping */
@@ -77,8 +88,18 @@ double complex GreenFunc2(const int ri, const int rj, const int rk, const int rl
                   const int s, const int t, const double complex ip,
                   int *eleIdx, const int *eleCfg, int *eleNum, const int *eleProjCnt,
                   int *projCntNew, double complex *buffer) {
+  return greenFunc2_child(ri,rj,rk,rl,s,t,ip,eleIdx,eleCfg,eleNum,eleProjCnt,projCntNew,buffer,PfM,InvM);
+}
+
+/* GreenFunc2 with the given PfM and InvM */
+double complex greenFunc2_child(const int ri, const int rj, const int rk, const int rl,
+                        const int s, const int t, const double complex ip,
+                        int *eleIdx, const int *eleCfg, int *eleNum, const int *eleProjCnt,
+                        int *projCntNew, double complex *buffer,
+                        double complex *pfM, double complex *invM) {
   double complex z;
   int mj,msj,ml,mtl;
+  int qpidx;
   int rsi,rsj,rtk,rtl;
   double complex *pfMNew = buffer; /* [NQPFull] */
   double complex *bufV   = buffer+NQPFull; /* 2*Nsize */
@@ -91,37 +112,37 @@ double complex GreenFunc2(const int ri, const int rj, const int rk, const int rl
   if(s==t) {
     if(rk==rl) { /* CisAjsNks */
       if(eleNum[rtk]==0) return 0.0;
-      else return GreenFunc1(ri,rj,s,ip,eleIdx,eleCfg,eleNum,
-                             eleProjCnt,projCntNew,buffer); /* CisAjs */
+      else return greenFunc1_child(ri,rj,s,ip,eleIdx,eleCfg,eleNum,
+                                   eleProjCnt,projCntNew,buffer,pfM,invM); /* CisAjs */
     }else if(rj==rl) {
       return 0.0; /* CisAjsCksAjs (j!=k) */
     }else if(ri==rl) { /* AjsCksNis */
       if(eleNum[rsi]==0) return 0.0;
       else if(rj==rk) return 1.0-eleNum[rsj];
-      else return -GreenFunc1(rk,rj,s,ip,eleIdx,eleCfg,eleNum,
-                              eleProjCnt,projCntNew,buffer); /* -CksAjs */
+      else return -greenFunc1_child(rk,rj,s,ip,eleIdx,eleCfg,eleNum,
+                                    eleProjCnt,projCntNew,buffer,pfM,invM); /* -CksAjs */
     }else if(rj==rk) { /* CisAls(1-Njs) */
       if(eleNum[rsj]==1) return 0.0;
       else if(ri==rl) return eleNum[rsi];
-      else return GreenFunc1(ri,rl,s,ip,eleIdx,eleCfg,eleNum,
-                             eleProjCnt,projCntNew,buffer); /* CisAls */
+      else return greenFunc1_child(ri,rl,s,ip,eleIdx,eleCfg,eleNum,
+                                   eleProjCnt,projCntNew,buffer,pfM,invM); /* CisAls */
     }else if(ri==rk) {
       return 0.0; /* CisAjsCisAls (i!=j) */
     }else if(ri==rj) { /* NisCksAls (i!=k,l) */
       if(eleNum[rsi]==0) return 0.0;
-      else return GreenFunc1(rk,rl,s,ip,eleIdx,eleCfg,eleNum,
-                             eleProjCnt,projCntNew,buffer); /* CksAls */
+      else return greenFunc1_child(rk,rl,s,ip,eleIdx,eleCfg,eleNum,
+                                   eleProjCnt,projCntNew,buffer,pfM,invM); /* CksAls */
     }
   }else{
     if(rk==rl) { /* CisAjsNkt */
       if(eleNum[rtk]==0) return 0.0;
       else if(ri==rj) return eleNum[rsi];
-      else return GreenFunc1(ri,rj,s,ip,eleIdx,eleCfg,eleNum,
-                             eleProjCnt,projCntNew,buffer); /* CisAjs */
+      else return greenFunc1_child(ri,rj,s,ip,eleIdx,eleCfg,eleNum,
+                                   eleProjCnt,projCntNew,buffer,pfM,invM); /* CisAjs */
     }else if(ri==rj) { /* NisCktAlt */
       if(eleNum[rsi]==0) return 0.0;
-      else return GreenFunc1(rk,rl,t,ip,eleIdx,eleCfg,eleNum,
-                             eleProjCnt,projCntNew,buffer); /* CktAlt */
+      else return greenFunc1_child(rk,rl,t,ip,eleIdx,eleCfg,eleNum,
+                                   eleProjCnt,projCntNew,buffer,pfM,invM); /* CktAlt */
     }
   }
 
@@ -145,7 +166,10 @@ double complex GreenFunc2(const int ri, const int rj, const int rk, const int rl
   z = ProjRatio(projCntNew,eleProjCnt);
 
   /* calculate Pfaffian */
-  CalculateNewPfMTwo_fcmp(ml, t, mj, s, pfMNew, eleIdx, 0, NQPFull, bufV);
+  for(qpidx=0;qpidx<NQPFull;qpidx++) {
+    calculateNewPfMTwo_child_fcmp(ml, t, mj, s, pfMNew, eleIdx, 0, NQPFull, qpidx,
+                                  bufV, bufV+Nsize, pfM, invM);
+  }
   z *= CalculateIP_fcmp(pfMNew, 0, NQPFull, MPI_COMM_SELF);
 
   /* revert hopping */
@@ -296,7 +320,6 @@ double complex calculateNewPfMN_child(const int qpidx, const int n, const int *m
   const int nsize = Nsize;
   const int n2 = 2*n;
   const double complex *sltE;
-  const double complex *sltE_k;
   const double complex *invM;
   const double complex *invM_i, *invM_k, *invM_l;
 
@@ -306,22 +329,20 @@ double complex calculateNewPfMN_child(const int qpidx, const int n, const int *m
   double complex *mat_k;
   double sgn;
 
-  int rsi,rsk,msi,msj,k,l;
+  int rsk,msi,msj,k,l;
   double complex val,tmp;
 
   /* for DSKPFA */
   char uplo='U', mthd='P';
-  int lda,info=0;
+  int nn,lda,info=0;
   double complex pfaff;
   int iwork[n2];
   double complex work[n2*n2]; /* [n2][n2] */
   int lwork = n2*n2;
-  double *rwork = GetWorkSpaceThreadDouble(LapackLWork); //TBC for rwork
+  double rwork[n2];
+  nn=lda=n2;
 
-  //int nn;
-  //nn=lda=n2;
-
-  sltE = SlaterElm + qpidx*Nsite2*Nsite2;
+  sltE = SlaterElm + qpidx*Nsite2*NSlaterElmCol;
   invM = InvM + qpidx*Nsize*Nsize;
 
   vec = buffer; /* n*nsize */
@@ -329,13 +350,8 @@ double complex calculateNewPfMN_child(const int qpidx, const int n, const int *m
   #pragma loop noalias
   for(k=0;k<n;k++) {
     rsk = eleIdx[msa[k]] + (msa[k]/Ne)*Nsite;
-    sltE_k = sltE + rsk*Nsite2;
     vec_k = vec + k*nsize;
-    #pragma loop norecurrence
-    for(msi=0;msi<nsize;msi++) {
-      rsi = eleIdx[msi] + (msi/Ne)*Nsite;
-      vec_k[msi] = sltE_k[rsi];
-    }
+    GetSlaterElmRow_fcmp(vec_k, sltE, rsk, eleIdx);
   }
 
   /* X_kl */
@@ -394,9 +410,9 @@ double complex calculateNewPfMN_child(const int qpidx, const int n, const int *m
   //M_ZSKPFA(&uplo, &mthd, &n, mat, &lda, &pfaff, iwork, work, &lwork, rwork, &info); //TBC
 #ifdef _pfaffine
   info = 1; // Skip inverse.
-  M_ZSKPFA(&uplo, &mthd, &n, mat, &lda, &pfaff, iwork, work, &lwork/*, rwork*/, &info);
+  M_ZSKPFA(&uplo, &mthd, &nn, mat, &lda, &pfaff, iwork, work, &lwork/*, rwork*/, &info);
 #else
-  M_ZSKPFA(&uplo, &mthd, &n, mat, &lda, &pfaff, iwork, work, &lwork, rwork, &info);
+  M_ZSKPFA(&uplo, &mthd, &nn, mat, &lda, &pfaff, iwork, work, &lwork, rwork, &info);
 #endif
   sgn = ( (n*(n-1)/2)%2==0 ) ? 1.0 : -1.0;
 
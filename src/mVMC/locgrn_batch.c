@@ -0,0 +1,538 @@
+/*
+mVMC - A numerical solver package for a wide range of quantum lattice models based on many-variable Variational Monte Carlo method
+Copyright (C) 2016 The University of Tokyo, All rights reserved.
+
+This program is developed based on the mVMC-mini program
+(https://github.com/fiber-miniapp/mVMC-mini)
+which follows "The BSD 3-Clause License".
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details. 
+
+You should have received a copy of the GNU General Public License 
+along with this program. If not, see http://www.gnu.org/licenses/. 
+*/
+/*-------------------------------------------------------------
+ * Variational Monte Carlo
+ * batched evaluation of local Green Functions
+ *-------------------------------------------------------------*/
+#include "locgrn_batch.h"
+#include "calham.h"
+#include "calham_real.h"
+#include "global.h"
+#include "projection.h"
+
+#ifndef _SRC_LOCGRN_BATCH
+#define _SRC_LOCGRN_BATCH
+
+double complex setLocGrnTerm1(const int idx, const int ri, const int rj, const int s,
+                              const double complex coef, const int *eleCfg, int *eleNum,
+                              const int *eleProjCnt, int *projCntNew);
+double complex setLocGrnTerm2(const int idx, const int ri, const int rj, const int rk, const int rl,
+                              const int s, const int t, const double complex coef,
+                              const int *eleCfg, int *eleNum, const int *eleProjCnt, int *projCntNew);
+double complex calculateLocGrnTerm(const int *eleCfg, const int *eleNum, const int *eleProjCnt);
+void calculateLocGrnIP_fcmp(const int *eleIdx);
+void calculateLocGrnIP_real(const int *eleIdx);
+double complex calculateLocGrnRatio_fcmp(const int *termIdx, const int *eleIdx,
+                                         const double complex *sltE, const double complex *invM,
+                                         const double complex *locG);
+double calculateLocGrnRatio_real(const int *termIdx, const int *eleIdx,
+                                 const double *sltE, const double *invM, const double *locG);
+
+/* Decide whether the off-diagonal terms of the Hamiltonian are evaluated in a batch. */
+/* Called on every process after ReadDefFileIdxPara and before SetMemory. */
+/* GreenFunc2 costs O(NQPFull*Nsize^2) for each two-body term, */
+/* while the batched evaluation costs O(NQPFull*Nsize^2*Nsite2) in total. */
+void InitLocGrnBatch() {
+  int idx;
+  int nTwoBody = NPairHopping + 2*NExchangeCoupling;
+
+  for(idx=0;idx<NInterAll;idx++) {
+    if(InterAll[idx][0]!=InterAll[idx][2] || InterAll[idx][4]!=InterAll[idx][6]) nTwoBody++;
+  }
+
+  NLocGrnTerm = NTransfer + NPairHopping + 2*NExchangeCoupling + NInterAll;
+  if(NBackFlowIdx>0 || iFlgOrbitalGeneral==1) {
+    FlagLocGrnBatch = 0;
+  } else if(NLocGrnBatch>=0) {
+    FlagLocGrnBatch = NLocGrnBatch;
+  } else {
+    FlagLocGrnBatch = (nTwoBody >= Nsite2) ? 1 : 0;
+  }
+  return;
+}
+
+/* Calculate the local energy <psi|H|x>/<psi|x> with the batched local Green functions */
+double complex CalculateHamiltonianBatch(const double complex ip, int *eleIdx, const int *eleCfg,
+                                         int *eleNum, const int *eleProjCnt) {
+  const double complex *termCoef = LocGrnTerm;
+  const double complex *termProj = LocGrnTerm + NLocGrnTerm;
+  const double complex *termIp   = LocGrnTerm + 2*NLocGrnTerm;
+  double complex e;
+  int idx;
+
+  StartTimer(70);
+  e = CalculateHamiltonian0(eleNum);
+  StopTimer(70);
+
+  StartTimer(71);
+  e += calculateLocGrnTerm(eleCfg,eleNum,eleProjCnt);
+  StopTimer(71);
+
+  StartTimer(72);
+  calculateLocGrnIP_fcmp(eleIdx);
+  for(idx=0;idx<NLocGrnTerm;idx++) {
+    if(LocGrnTermIdx[4*idx]<0) continue;
+    e += termCoef[idx] * conj(termProj[idx]*termIp[idx]/ip);
+  }
+  StopTimer(72);
+
+  return e;
+}
+
+double CalculateHamiltonianBatch_real(const double ip, int *eleIdx, const int *eleCfg,
+                                      int *eleNum, const int *eleProjCnt) {
+  const double complex *termCoef = LocGrnTerm;
+  const double complex *termProj = LocGrnTerm + NLocGrnTerm;
+  const double complex *termIp   = LocGrnTerm + 2*NLocGrnTerm;
+  double e;
+  int idx;
+
+  StartTimer(70);
+  e = CalculateHamiltonian0_real(eleNum);
+  StopTimer(70);
+
+  StartTimer(71);
+  e += creal(calculateLocGrnTerm(eleCfg,eleNum,eleProjCnt));
+  StopTimer(71);
+
+  StartTimer(72);
+  calculateLocGrnIP_real(eleIdx);
+  for(idx=0;idx<NLocGrnTerm;idx++) {
+    if(LocGrnTermIdx[4*idx]<0) continue;
+    e += creal(termCoef[idx]) * creal(termProj[idx]) * creal(termIp[idx]) / ip;
+  }
+  StopTimer(72);
+
+  return e;
+}
+
+/* Set coef*<psi|CisAjs|x>/<psi|x> as the idx-th term. */
+/* The value is returned if it is given by the electron numbers. */
+double complex setLocGrnTerm1(const int idx, const int ri, const int rj, const int s,
+                              const double complex coef, const int *eleCfg, int *eleNum,
+                              const int *eleProjCnt, int *projCntNew) {
+  int *termIdx = LocGrnTermIdx + 4*idx;
+  const int rsi = ri + s*Nsite;
+  const int rsj = rj + s*Nsite;
+
+  termIdx[0] = -1;
+  if(ri==rj) return coef*eleNum[rsi];
+  if(eleNum[rsi]==1 || eleNum[rsj]==0) return 0.0;
+
+  /* hopping */
+  eleNum[rsj] = 0;
+  eleNum[rsi] = 1;
+  UpdateProjCnt(rj, ri, s, projCntNew, eleProjCnt, eleNum);
+  LocGrnTerm[NLocGrnTerm+idx] = ProjRatio(projCntNew,eleProjCnt);
+
+  /* revert hopping */
+  eleNum[rsj] = 1;
+  eleNum[rsi] = 0;
+
+  /* the msa-th electron hops to rsa */
+  termIdx[0] = eleCfg[rsj] + s*Ne; /* msa */
+  termIdx[1] = rsi;                /* rsa */
+  termIdx[2] = -1;
+  termIdx[3] = -1;
+  LocGrnTerm[idx] = coef;
+  return 0.0;
+}
+
+/* Set coef*<psi|CisAjsCktAlt|x>/<psi|x> as the idx-th term. */
+/* The reduction to 1-body terms follows GreenFunc2. */
+double complex setLocGrnTerm2(const int idx, const int ri, const int rj, const int rk, const int rl,
+                              const int s, const int t, const double complex coef,
+                              const int *eleCfg, int *eleNum, const int *eleProjCnt, int *projCntNew) {
+  int *termIdx = LocGrnTermIdx + 4*idx;
+  const int rsi = ri + s*Nsite;
+  const int rsj = rj + s*Nsite;
+  const int rtk = rk + t*Nsite;
+  const int rtl = rl + t*Nsite;
+  int mj,ml;
+
+  termIdx[0] = -1;
+
+  if(s==t) {
+    if(rk==rl) { /* CisAjsNks */
+      if(eleNum[rtk]==0) return 0.0;
+      else return setLocGrnTerm1(idx,ri,rj,s,coef,eleCfg,eleNum,
+                                 eleProjCnt,projCntNew); /* CisAjs */
+    }else if(rj==rl) {
+      return 0.0; /* CisAjsCksAjs (j!=k) */
+    }else if(ri==rl) { /* AjsCksNis */
+      if(eleNum[rsi]==0) return 0.0;
+      else if(rj==rk) return coef*(1.0-eleNum[rsj]);
+      else return setLocGrnTerm1(idx,rk,rj,s,-coef,eleCfg,eleNum,
+                                 eleProjCnt,projCntNew); /* -CksAjs */
+    }else if(rj==rk) { /* CisAls(1-Njs) */
+      if(eleNum[rsj]==1) return 0.0;
+      else if(ri==rl) return coef*eleNum[rsi];
+      else return setLocGrnTerm1(idx,ri,rl,s,coef,eleCfg,eleNum,
+                                 eleProjCnt,projCntNew); /* CisAls */
+    }else if(ri==rk) {
+      return 0.0; /* CisAjsCisAls (i!=j) */
+    }else if(ri==rj) { /* NisCksAls (i!=k,l) */
+      if(eleNum[rsi]==0) return 0.0;
+      else return setLocGrnTerm1(idx,rk,rl,s,coef,eleCfg,eleNum,
+                                 eleProjCnt,projCntNew); /* CksAls */
+    }
+  }else{
+    if(rk==rl) { /* CisAjsNkt */
+      if(eleNum[rtk]==0) return 0.0;
+      else if(ri==rj) return coef*eleNum[rsi];
+      else return setLocGrnTerm1(idx,ri,rj,s,coef,eleCfg,eleNum,
+                                 eleProjCnt,projCntNew); /* CisAjs */
+    }else if(ri==rj) { /* NisCktAlt */
+      if(eleNum[rsi]==0) return 0.0;
+      else return setLocGrnTerm1(idx,rk,rl,t,coef,eleCfg,eleNum,
+                                 eleProjCnt,projCntNew); /* CktAlt */
+    }
+  }
+
+  if(eleNum[rsi]==1 || eleNum[rsj]==0 || eleNum[rtk]==1 || eleNum[rtl]==0) return 0.0;
+
+  mj = eleCfg[rsj];
+  ml = eleCfg[rtl];
+
+  /* hopping */
+  eleNum[rtl] = 0;
+  eleNum[rtk] = 1;
+  UpdateProjCnt(rl, rk, t, projCntNew, eleProjCnt, eleNum);
+  eleNum[rsj] = 0;
+  eleNum[rsi] = 1;
+  UpdateProjCnt(rj, ri, s, projCntNew, projCntNew, eleNum);
+  LocGrnTerm[NLocGrnTerm+idx] = ProjRatio(projCntNew,eleProjCnt);
+
+  /* revert hopping */
+  eleNum[rtl] = 1;
+  eleNum[rtk] = 0;
+  eleNum[rsj] = 1;
+  eleNum[rsi] = 0;
+
+  /* the msa-th electron hops to rsa and the msb-th electron hops to rsb */
+  termIdx[0] = ml + t*Ne; /* msa */
+  termIdx[1] = rtk;       /* rsa */
+  termIdx[2] = mj + s*Ne; /* msb */
+  termIdx[3] = rsi;       /* rsb */
+  LocGrnTerm[idx] = coef;
+  return 0.0;
+}
+
+/* Set all the off-diagonal terms of the Hamiltonian and their projection ratios. */
+/* The sum of the terms given by the electron numbers is returned. */
+double complex calculateLocGrnTerm(const int *eleCfg, const int *eleNum, const int *eleProjCnt) {
+  const int offPH = NTransfer;
+  const int offEx = offPH + NPairHopping;
+  const int offIA = offEx + 2*NExchangeCoupling;
+  double complex e=0.0;
+  int idx;
+  int ri,rj,s,rk,rl,t;
+  int *myEleNum, *myProjCntNew;
+
+  RequestWorkSpaceThreadInt(Nsite2+NProj);
+
+#pragma omp parallel default(shared)                  \
+  private(myEleNum,myProjCntNew,idx,ri,rj,s,rk,rl,t)  \
+  reduction(+:e)
+  {
+    myEleNum = GetWorkSpaceThreadInt(Nsite2);
+    myProjCntNew = GetWorkSpaceThreadInt(NProj);
+
+    #pragma loop noalias
+    for(idx=0;idx<Nsite2;idx++) myEleNum[idx] = eleNum[idx];
+
+    /* Transfer */
+    #pragma omp for schedule(dynamic) nowait
+    for(idx=0;idx<NTransfer;idx++) {
+      ri = Transfer[idx][0];
+      rj = Transfer[idx][2];
+      s  = Transfer[idx][3];
+      e += setLocGrnTerm1(idx,ri,rj,s,-ParaTransfer[idx],
+                          eleCfg,myEleNum,eleProjCnt,myProjCntNew);
+      /* Caution: negative sign */
+    }
+
+    /* Pair Hopping */
+    #pragma omp for schedule(dynamic) nowait
+    for(idx=0;idx<NPairHopping;idx++) {
+      ri = PairHopping[idx][0];
+      rj = PairHopping[idx][1];
+      e += setLocGrnTerm2(offPH+idx,ri,rj,ri,rj,0,1,ParaPairHopping[idx],
+                          eleCfg,myEleNum,eleProjCnt,myProjCntNew);
+    }
+
+    /* Exchange Coupling */
+    #pragma omp for schedule(dynamic) nowait
+    for(idx=0;idx<NExchangeCoupling;idx++) {
+      ri = ExchangeCoupling[idx][0];
+      rj = ExchangeCoupling[idx][1];
+      e += setLocGrnTerm2(offEx+2*idx,ri,rj,rj,ri,0,1,ParaExchangeCoupling[idx],
+                          eleCfg,myEleNum,eleProjCnt,myProjCntNew);
+      e += setLocGrnTerm2(offEx+2*idx+1,ri,rj,rj,ri,1,0,ParaExchangeCoupling[idx],
+                          eleCfg,myEleNum,eleProjCnt,myProjCntNew);
+    }
+
+    /* Inter All */
+    #pragma omp for schedule(dynamic) nowait
+    for(idx=0;idx<NInterAll;idx++) {
+      ri = InterAll[idx][0];
+      rj = InterAll[idx][2];
+      s  = InterAll[idx][3];
+      rk = InterAll[idx][4];
+      rl = InterAll[idx][6];
+      t  = InterAll[idx][7];
+      e += setLocGrnTerm2(offIA+idx,ri,rj,rk,rl,s,t,ParaInterAll[idx],
+                          eleCfg,myEleNum,eleProjCnt,myProjCntNew);
+    }
+  }
+
+  ReleaseWorkSpaceThreadInt();
+  return e;
+}
+
+/* Calculate the inner products <phi|L|x'> of all the terms. */
+/* For each quantum projection, LocG[msi][rsj] = sum_k InvM[msi][k] SlaterElm[rsj][rs_k] */
+/* is obtained by a single ZGEMM, from which the Pfaffian ratios are read off. */
+void calculateLocGrnIP_fcmp(const int *eleIdx) {
+  const int nsize=Nsize;
+  const int nsite2=Nsite2;
+  const int nTerm=NLocGrnTerm;
+  double complex *bufS = LocGrnBuf;               /* [Nsize][Nsite2] */
+  double complex *locG = LocGrnBuf + Nsize*Nsite2; /* [Nsize][Nsite2] */
+  double complex *termIp = LocGrnTerm + 2*NLocGrnTerm;
+  const double complex *sltE, *sltE_k;
+  const double complex *invM;
+  double complex *bufS_k;
+  double complex w;
+  char transa='N', transb='N';
+  double complex alpha=-1.0, beta=0.0;
+  int qpidx,idx,msk,rsk,rsj;
+  int nHop=0;
+
+  for(idx=0;idx<nTerm;idx++) {
+    termIp[idx] = 0.0;
+    if(LocGrnTermIdx[4*idx]>=0) nHop++;
+  }
+  if(nHop==0) return;
+
+  for(qpidx=0;qpidx<NQPFull;qpidx++) {
+    sltE = SlaterElm + qpidx*Nsite2*NSlaterElmCol;
+    invM = InvM + qpidx*Nsize*Nsize;
+    w = QPFullWeight[qpidx] * PfM[qpidx];
+
+    /* bufS[msk][rsj] = SlaterElm[rs_k][rsj] = -SlaterElm[rsj][rs_k] */
+    #pragma omp parallel for default(shared) private(msk,rsk,rsj,sltE_k,bufS_k)
+    for(msk=0;msk<nsize;msk++) {
+      rsk = eleIdx[msk] + (msk/Ne)*Nsite;
+      bufS_k = bufS + msk*nsite2;
+      if(FlagSlaterElmCompact==1) {
+        /* only the opposite-spin block is stored */
+        sltE_k = sltE + rsk*Nsite;
+        for(rsj=0;rsj<nsite2;rsj++) bufS_k[rsj] = 0.0;
+        if(rsk<Nsite) bufS_k += Nsite;
+        for(rsj=0;rsj<Nsite;rsj++) bufS_k[rsj] = sltE_k[rsj];
+      } else {
+        sltE_k = sltE + rsk*nsite2;
+        for(rsj=0;rsj<nsite2;rsj++) bufS_k[rsj] = sltE_k[rsj];
+      }
+    }
+
+    /* locG = -InvM * bufS in row-major */
+    M_ZGEMM(&transa, &transb, &nsite2, &nsize, &nsize, &alpha, bufS, &nsite2,
+            invM, &nsize, &beta, locG, &nsite2);
+
+    #pragma omp parallel for default(shared) private(idx) schedule(dynamic)
+    for(idx=0;idx<nTerm;idx++) {
+      if(LocGrnTermIdx[4*idx]<0) continue;
+      termIp[idx] += w * calculateLocGrnRatio_fcmp(LocGrnTermIdx+4*idx,eleIdx,sltE,invM,locG);
+    }
+  }
+
+  return;
+}
+
+void calculateLocGrnIP_real(const int *eleIdx) {
+  const int nsize=Nsize;
+  const int nsite2=Nsite2;
+  const int nTerm=NLocGrnTerm;
+  double *bufS = LocGrnBuf_real;               /* [Nsize][Nsite2] */
+  double *locG = LocGrnBuf_real + Nsize*Nsite2; /* [Nsize][Nsite2] */
+  double complex *termIp = LocGrnTerm + 2*NLocGrnTerm;
+  const double *sltE, *sltE_k;
+  const double *invM;
+  double *bufS_k;
+  double w;
+  char transa='N', transb='N';
+  double alpha=-1.0, beta=0.0;
+  int qpidx,idx,msk,rsk,rsj;
+  int nHop=0;
+
+  for(idx=0;idx<nTerm;idx++) {
+    termIp[idx] = 0.0;
+    if(LocGrnTermIdx[4*idx]>=0) nHop++;
+  }
+  if(nHop==0) return;
+
+  for(qpidx=0;qpidx<NQPFull;qpidx++) {
+    sltE = SlaterElm_real + qpidx*Nsite2*NSlaterElmCol;
+    invM = InvM_real + qpidx*Nsize*Nsize;
+    w = creal(QPFullWeight[qpidx]) * PfM_real[qpidx];
+
+    /* bufS[msk][rsj] = SlaterElm[rs_k][rsj] = -SlaterElm[rsj][rs_k] */
+    #pragma omp parallel for default(shared) private(msk,rsk,rsj,sltE_k,bufS_k)
+    for(msk=0;msk<nsize;msk++) {
+      rsk = eleIdx[msk] + (msk/Ne)*Nsite;
+      bufS_k = bufS + msk*nsite2;
+      if(FlagSlaterElmCompact==1) {
+        /* only the opposite-spin block is stored */
+        sltE_k = sltE + rsk*Nsite;
+        for(rsj=0;rsj<nsite2;rsj++) bufS_k[rsj] = 0.0;
+        if(rsk<Nsite) bufS_k += Nsite;
+        for(rsj=0;rsj<Nsite;rsj++) bufS_k[rsj] = sltE_k[rsj];
+      } else {
+        sltE_k = sltE + rsk*nsite2;
+        for(rsj=0;rsj<nsite2;rsj++) bufS_k[rsj] = sltE_k[rsj];
+      }
+    }
+
+    /* locG = -InvM * bufS in row-major */
+    M_DGEMM(&transa, &transb, &nsite2, &nsize, &nsize, &alpha, bufS, &nsite2,
+            invM, &nsize, &beta, locG, &nsite2);
+
+    #pragma omp parallel for default(shared) private(idx) schedule(dynamic)
+    for(idx=0;idx<nTerm;idx++) {
+      if(LocGrnTermIdx[4*idx]<0) continue;
+      termIp[idx] += w * calculateLocGrnRatio_real(LocGrnTermIdx+4*idx,eleIdx,sltE,invM,locG);
+    }
+  }
+
+  return;
+}
+
+/* Pfaffian ratio PfM'/PfM of the term for a quantum projection. */
+/* This gives the same value as calculateNewPfM_child (1-body) or */
+/* calculateNewPfMTwo_child_fcmp (2-body) with the Slater elements */
+/* of the new configuration written by locG of the old configuration. */
+double complex calculateLocGrnRatio_fcmp(const int *termIdx, const int *eleIdx,
+                                         const double complex *sltE, const double complex *invM,
+                                         const double complex *locG) {
+  const int nsize=Nsize;
+  const int nsite2=Nsite2;
+  const int msa=termIdx[0];
+  const int rsa=termIdx[1];
+  const int msb=termIdx[2];
+  const int rsb=termIdx[3];
+  const int rsaOld = eleIdx[msa] + (msa/Ne)*Nsite;
+  int rsbOld;
+  int msi,rsi;
+
+  const double complex *invM_a = invM + msa*nsize;
+  const double complex *invM_b, *invM_i;
+  const double complex *locG_a = locG + msa*nsite2;
+  const double complex *locG_b;
+
+  double complex dva_a,dva_b,dvb_a,dvb_b;
+  double complex p_a,p_b,q_a,q_b,bMa;
+
+  if(msb<0) {
+    /* The element of the msa-th column is SlaterElm[rsa][rsa]=0 in the new configuration. */
+    return -(locG_a[rsa] - invM_a[msa]*GetSlaterElm_fcmp(sltE,rsa,rsaOld));
+  }
+
+  rsbOld = eleIdx[msb] + (msb/Ne)*Nsite;
+  invM_b = invM + msb*nsize;
+  locG_b = locG + msb*nsite2;
+
+  /* vec_a and vec_b differ from the old Slater elements only at msa and msb */
+  dva_a = -GetSlaterElm_fcmp(sltE,rsa,rsaOld);
+  dva_b = GetSlaterElm_fcmp(sltE,rsa,rsb) - GetSlaterElm_fcmp(sltE,rsa,rsbOld);
+  dvb_a = GetSlaterElm_fcmp(sltE,rsb,rsa) - GetSlaterElm_fcmp(sltE,rsb,rsaOld);
+  dvb_b = -GetSlaterElm_fcmp(sltE,rsb,rsbOld);
+
+  p_a = locG_a[rsa] + invM_a[msa]*dva_a + invM_a[msb]*dva_b;
+  p_b = locG_b[rsa] + invM_b[msa]*dva_a + invM_b[msb]*dva_b;
+  q_a = locG_a[rsb] + invM_a[msa]*dvb_a + invM_a[msb]*dvb_b;
+  q_b = locG_b[rsb] + invM_b[msa]*dvb_a + invM_b[msb]*dvb_b;
+
+  bMa = 0.0;
+  for(msi=0;msi<nsize;msi++) {
+    if(msi==msa) rsi = rsa;
+    else if(msi==msb) rsi = rsb;
+    else rsi = eleIdx[msi] + (msi/Ne)*Nsite;
+    invM_i = invM + msi*nsize;
+    bMa += GetSlaterElm_fcmp(sltE,rsb,rsi) * (locG[msi*nsite2+rsa] + invM_i[msa]*dva_a + invM_i[msb]*dva_b);
+  }
+
+  return invM_a[msb]*GetSlaterElm_fcmp(sltE,rsb,rsa) + invM_a[msb]*bMa + p_a*q_b - p_b*q_a;
+}
+
+double calculateLocGrnRatio_real(const int *termIdx, const int *eleIdx,
+                                 const double *sltE, const double *invM, const double *locG) {
+  const int nsize=Nsize;
+  const int nsite2=Nsite2;
+  const int msa=termIdx[0];
+  const int rsa=termIdx[1];
+  const int msb=termIdx[2];
+  const int rsb=termIdx[3];
+  const int rsaOld = eleIdx[msa] + (msa/Ne)*Nsite;
+  int rsbOld;
+  int msi,rsi;
+
+  const double *invM_a = invM + msa*nsize;
+  const double *invM_b, *invM_i;
+  const double *locG_a = locG + msa*nsite2;
+  const double *locG_b;
+
+  double dva_a,dva_b,dvb_a,dvb_b;
+  double p_a,p_b,q_a,q_b,bMa;
+
+  if(msb<0) {
+    return -(locG_a[rsa] - invM_a[msa]*GetSlaterElm_real(sltE,rsa,rsaOld));
+  }
+
+  rsbOld = eleIdx[msb] + (msb/Ne)*Nsite;
+  invM_b = invM + msb*nsize;
+  locG_b = locG + msb*nsite2;
+
+  dva_a = -GetSlaterElm_real(sltE,rsa,rsaOld);
+  dva_b = GetSlaterElm_real(sltE,rsa,rsb) - GetSlaterElm_real(sltE,rsa,rsbOld);
+  dvb_a = GetSlaterElm_real(sltE,rsb,rsa) - GetSlaterElm_real(sltE,rsb,rsaOld);
+  dvb_b = -GetSlaterElm_real(sltE,rsb,rsbOld);
+
+  p_a = locG_a[rsa] + invM_a[msa]*dva_a + invM_a[msb]*dva_b;
+  p_b = locG_b[rsa] + invM_b[msa]*dva_a + invM_b[msb]*dva_b;
+  q_a = locG_a[rsb] + invM_a[msa]*dvb_a + invM_a[msb]*dvb_b;
+  q_b = locG_b[rsb] + invM_b[msa]*dvb_a + invM_b[msb]*dvb_b;
+
+  bMa = 0.0;
+  for(msi=0;msi<nsize;msi++) {
+    if(msi==msa) rsi = rsa;
+    else if(msi==msb) rsi = rsb;
+    else rsi = eleIdx[msi] + (msi/Ne)*Nsite;
+    invM_i = invM + msi*nsize;
+    bMa += GetSlaterElm_real(sltE,rsb,rsi) * (locG[msi*nsite2+rsa] + invM_i[msa]*dva_a + invM_i[msb]*dva_b);
+  }
+
+  return invM_a[msb]*GetSlaterElm_real(sltE,rsb,rsa) + invM_a[msb]*bMa + p_a*q_b - p_b*q_a;
+}
+
+#endif
@@ -44,8 +44,17 @@ double calculateNewPfMN_real_child(const int qpidx, const int n, const int *msa,
 double  GreenFunc1_real(const int ri, const int rj, const int s, const double ip,
                   int *eleIdx, const int *eleCfg, int *eleNum, const int *eleProjCnt,
                   int *projCntNew, double *buffer) {
+  return greenFunc1_child_real(ri,rj,s,ip,eleIdx,eleCfg,eleNum,eleProjCnt,projCntNew,buffer,PfM_real,InvM_real);
+}
+
+/* GreenFunc1_real with the given PfM_real and InvM_real */
+double greenFunc1_child_real(const int ri, const int rj, const int s, const double ip,
+                             int *eleIdx, const int *eleCfg, int *eleNum, const int *eleProjCnt,
+                             int *projCntNew, double *buffer,
+                             double *pfM, double *invM) {
   double  z;
   int mj,msj,rsi,rsj;
+  int qpidx;
   double  *pfMNew_real = buffer; /* NQPFull */
 
   if(ri==rj) return eleNum[ri+s*Nsite];
@@ -64,7 +73,9 @@ double  GreenFunc1_real(const int ri, const int rj, const int s, const double ip
   z = ProjRatio(projCntNew,eleProjCnt);
 
   /* calculate Pfaffian */
-  CalculateNewPfM_real(mj, s, pfMNew_real, eleIdx, 0, NQPFull);
+  for(qpidx=0;qpidx<NQPFull;qpidx++) {
+    calculateNewPfM_child_real(mj, s, pfMNew_real, eleIdx, 0, NQPFull, qpidx, pfM, invM);
+  }
   z *= CalculateIP_real(pfMNew_real, 0, NQPFull, MPI_COMM_SELF);
 
   /* revert hopping */
@@ -81,8 +92,18 @@ double GreenFunc2_real(const int ri, const int rj, const int rk, const int rl,
                   const int s, const int t, const double ip,
                   int *eleIdx, const int *eleCfg, int *eleNum, const int *eleProjCnt,
                   int *projCntNew, double *buffer) {
+  return greenFunc2_child_real(ri,rj,rk,rl,s,t,ip,eleIdx,eleCfg,eleNum,eleProjCnt,projCntNew,buffer,PfM_real,InvM_real);
+}
+
+/* GreenFunc2_real with the given PfM_real and InvM_real */
+double greenFunc2_child_real(const int ri, const int rj, const int rk, const int rl,
+                             const int s, const int t, const double ip,
+                             int *eleIdx, const int *eleCfg, int *eleNum, const int *eleProjCnt,
+                             int *projCntNew, double *buffer,
+                             double *pfM, double *invM) {
   double z;
   int mj,msj,ml,mtl;
+  int qpidx;
   int rsi,rsj,rtk,rtl;
   double *pfMNew_real = buffer; /* [NQPFull] */
   double *bufV   = buffer+NQPFull; /* 2*Nsize */
@@ -95,37 +116,37 @@ double GreenFunc2_real(const int ri, const int rj, const int rk, const int rl,
   if(s==t) {
     if(rk==rl) { /* CisAjsNks */
       if(eleNum[rtk]==0) return 0.0;
-      else return GreenFunc1_real(ri,rj,s,ip,eleIdx,eleCfg,eleNum,
-                             eleProjCnt,projCntNew,buffer); /* CisAjs */
+      else return greenFunc1_child_real(ri,rj,s,ip,eleIdx,eleCfg,eleNum,
+                                   eleProjCnt,projCntNew,buffer,pfM,invM); /* CisAjs */
     }else if(rj==rl) {
       return 0.0; /* CisAjsCksAjs (j!=k) */
     }else if(ri==rl) { /* AjsCksNis */
       if(eleNum[rsi]==0) return 0.0;
       else if(rj==rk) return 1.0-eleNum[rsj];
-      else return -GreenFunc1_real(rk,rj,s,ip,eleIdx,eleCfg,eleNum,
-                              eleProjCnt,projCntNew,buffer); /* -CksAjs */
+      else return -greenFunc1_child_real(rk,rj,s,ip,eleIdx,eleCfg,eleNum,
+                                    eleProjCnt,projCntNew,buffer,pfM,invM); /* -CksAjs */
     }else if(rj==rk) { /* CisAls(1-Njs) */
       if(eleNum[rsj]==1) return 0.0;
       else if(ri==rl) return eleNum[rsi];
-      else return GreenFunc1_real(ri,rl,s,ip,eleIdx,eleCfg,eleNum,
-                             eleProjCnt,projCntNew,buffer); /* CisAls */
+      else return greenFunc1_child_real(ri,rl,s,ip,eleIdx,eleCfg,eleNum,
+                                   eleProjCnt,projCntNew,buffer,pfM,invM); /* CisAls */
     }else if(ri==rk) {
       return 0.0; /* CisAjsCisAls (i!=j) */
     }else if(ri==rj) { /* NisCksAls (i!=k,l) */
       if(eleNum[rsi]==0) return 0.0;
-      else return GreenFunc1_real(rk,rl,s,ip,eleIdx,eleCfg,eleNum,
-                             eleProjCnt,projCntNew,buffer); /* CksAls */
+      else return greenFunc1_child_real(rk,rl,s,ip,eleIdx,eleCfg,eleNum,
+                                   eleProjCnt,projCntNew,buffer,pfM,invM); /* CksAls */
     }
   }else{
     if(rk==rl) { /* CisAjsNkt */
       if(eleNum[rtk]==0) return 0.0;
       else if(ri==rj) return eleNum[rsi];
-      else return GreenFunc1_real(ri,rj,s,ip,eleIdx,eleCfg,eleNum,
-                             eleProjCnt,projCntNew,buffer); /* CisAjs */
+      else return greenFunc1_child_real(ri,rj,s,ip,eleIdx,eleCfg,eleNum,
+                                   eleProjCnt,projCntNew,buffer,pfM,invM); /* CisAjs */
     }else if(ri==rj) { /* NisCktAlt */
       if(eleNum[rsi]==0) return 0.0;
-      else return GreenFunc1_real(rk,rl,t,ip,eleIdx,eleCfg,eleNum,
-                             eleProjCnt,projCntNew,buffer); /* CktAlt */
+      else return greenFunc1_child_real(rk,rl,t,ip,eleIdx,eleCfg,eleNum,
+                                   eleProjCnt,projCntNew,buffer,pfM,invM); /* CktAlt */
     }
   }
 
@@ -149,7 +170,10 @@ double GreenFunc2_real(const int ri, const int rj, const int rk, const int rl,
   z = ProjRatio(projCntNew,eleProjCnt);
 
   /* calculate Pfaffian */
-  CalculateNewPfMTwo_real(ml, t, mj, s, pfMNew_real, eleIdx, 0, NQPFull, bufV);
+  for(qpidx=0;qpidx<NQPFull;qpidx++) {
+    calculateNewPfMTwo_child_real(ml, t, mj, s, pfMNew_real, eleIdx, 0, NQPFull, qpidx,
+                                  bufV, bufV+Nsize, pfM, invM);
+  }
   z *= CalculateIP_real(pfMNew_real, 0, NQPFull, MPI_COMM_SELF);
 
   /* revert hopping */
@@ -306,7 +330,6 @@ double calculateNewPfMN_real_child(const int qpidx, const int n, const int *msa,
   const int nsize = Nsize;
   const int n2 = 2*n;
   const double  *sltE;
-  const double  *sltE_k;
   const double  *invM;
   const double  *invM_i, *invM_k, *invM_l;
 
@@ -316,7 +339,7 @@ double calculateNewPfMN_real_child(const int qpidx, const int n, const int *msa,
   double  *mat_k;
   double sgn;
 
-  int rsi,rsk,msi,msj,k,l;
+  int rsk,msi,msj,k,l;
   double val,tmp;
 
   /* for DSKPFA */
@@ -328,7 +351,7 @@ double calculateNewPfMN_real_child(const int qpidx, const int n, const int *msa,
   int lwork = n2*n2;
   nn=lda=n2;
 
-  sltE = SlaterElm_real + qpidx*Nsite2*Nsite2;
+  sltE = SlaterElm_real + qpidx*Nsite2*NSlaterElmCol;
   invM = InvM_real + qpidx*Nsize*Nsize;
 
   vec = buffer; /* n*nsize */
@@ -336,13 +359,8 @@ double calculateNewPfMN_real_child(const int qpidx, const int n, const int *msa,
   #pragma loop noalias
   for(k=0;k<n;k++) {
     rsk = eleIdx[msa[k]] + (msa[k]/Ne)*Nsite;
-    sltE_k = sltE + rsk*Nsite2;
     vec_k = vec + k*nsize;
-    #pragma loop norecurrence
-    for(msi=0;msi<nsize;msi++) {
-      rsi = eleIdx[msi] + (msi/Ne)*Nsite;
-      vec_k[msi] = sltE_k[rsi];
-    }
+    GetSlaterElmRow_real(vec_k, sltE, rsk, eleIdx);
   }
 
   /* X_kl */
@@ -39,37 +39,51 @@ along with this program. If not, see http://www.gnu.org/licenses/.
 #include "pfupdate_two_fcmp.h"
 #include "projection.h"
 
-double complex calculateHK(const double complex h1, const double complex ip, int *eleIdx, int *eleCfg,
-                   int *eleNum, int *eleProjCnt);
+void addLSHop(const int ri, const int rj, const int s, const int *eleNum);
+void calculateLSHop(const double complex ip, int *eleIdx, int *eleCfg, int *eleNum, int *eleProjCnt);
+
+double complex calculateHK(const double complex h1, const int *eleNum);
 double complex calculateHW(const double complex h1, const double complex ip, int *eleIdx, int *eleCfg,
                    int *eleNum, int *eleProjCnt);
 
 double complex calHCA(const int ri, const int rj, const int s,
-              const double complex h1, const double complex ip, int *eleIdx, int *eleCfg,
-              int *eleNum, int *eleProjCnt);
+              const double complex h1, const int *eleNum);
 double complex calHCACA(const int ri, const int rj, const int rk, const int rl,
                 const int si,const int sk,
                 const double complex h1, const double complex ip, int *eleIdx, int *eleCfg,
-                int *eleNum, int *eleProjCnt);
+                int *eleNum, int *eleProjCnt,
+                double complex *invM, double complex *pfM, double complex *buffer, int *bufferInt);
 
+double complex calHCA_child(const int ri, const int rj, const int s,
+                    const double complex ip, int *eleIdx, int *eleCfg, int *eleNum, int *eleProjCnt,
+                    double complex *invM, double complex *pfM, double complex *buffer, int *bufferInt);
 double complex checkGF1(const int ri, const int rj, const int s, const double complex ip,
                 int *eleIdx, const int *eleCfg, int *eleNum);
 double complex calHCA1(const int ri, const int rj, const int s,
-               const double complex ip, int *eleIdx, int *eleCfg, int *eleNum, int *eleProjCnt);
+               const double complex ip, int *eleIdx, int *eleCfg, int *eleNum, int *eleProjCnt,
+               double complex *invM, double complex *pfM, double complex *buffer, int *bufferInt);
 double complex calHCA2(const int ri, const int rj, const int s,
-               const double complex ip, int *eleIdx, int *eleCfg, int *eleNum, int *eleProjCnt);
+               const double complex ip, int *eleIdx, int *eleCfg, int *eleNum, int *eleProjCnt,
+               double complex *buffer, int *bufferInt);
 
 
 double complex checkGF2(const int ri, const int rj, const int rk, const int rl,
                 const int s, const int t, const double complex ip,
-                int *eleIdx, const int *eleCfg, int *eleNum);
+                int *eleIdx, const int *eleCfg, int *eleNum, double complex *buffer);
 double complex calHCACA1(const int ri, const int rj, const int rk, const int rl,
                  const int si,const int sk,
                  const double complex ip, int *eleIdx, int *eleCfg,
-                 int *eleNum, int *eleProjCnt);
+                 int *eleNum, int *eleProjCnt,
+                 double complex *invM, double complex *pfM, double complex *buffer, int *bufferInt);
 double complex calHCACA2(const int ri, const int rj, const int rk, const int rl,
                  const int si,const int sk,
-                 const double complex ip, int *eleIdx, int *eleCfg, int *eleNum, int *eleProjCnt);
+                 const double complex ip, int *eleIdx, int *eleCfg, int *eleNum, int *eleProjCnt,
+                 double complex *buffer, int *bufferInt);
+
+double complex calculateHamiltonian_child(const double complex ip, int *eleIdx, const int *eleCfg,
+                                  int *eleNum, const int *eleProjCnt,
+                                  double complex *pfM, double complex *invM,
+                                  double complex *buffer, int *bufferInt);
 
 void copyMAll(double complex *invM_from, double complex *pfM_from, double complex *invM_to, double complex *pfM_to);
 
@@ -80,8 +94,12 @@ void LSLocalQ(const double complex h1, const double complex ip, int *eleIdx, int
 
   e0 = CalculateHamiltonian0(eleNum); /* V */
 
+  /* <psi|H CisAjs|x>/<psi|x> of the hoppings used in this sample */
+  MakeLSHop(eleNum);
+  calculateLSHop(ip,eleIdx,eleCfg,eleNum,eleProjCnt);
+
   h2 = h1*e0; /* HV = (V+K+W)V */
-  h2 += calculateHK(h1,ip,eleIdx,eleCfg,eleNum,eleProjCnt);
+  h2 += calculateHK(h1,eleNum);
   h2 += calculateHW(h1,ip,eleIdx,eleCfg,eleNum,eleProjCnt);
 
   /* calculate local Q (IQ) */
@@ -96,6 +114,7 @@ void LSLocalQ(const double complex h1, const double complex ip, int *eleIdx, int
 }
 
 /* Calculate <psi|QCisAjs|x>/<psi|x> */
+/* The hoppings are evaluated in LSLocalQ for the same sample. */
 void LSLocalCisAjs(const double complex h1, const double complex ip, int *eleIdx, int *eleCfg, int *eleNum, int *eleProjCnt) {
   const int nCisAjs=NCisAjs;
   double complex*lsLCisAjs = LSLCisAjs;
@@ -115,53 +134,89 @@ void LSLocalCisAjs(const double complex h1, const double complex ip, int *eleIdx
     s  = CisAjsIdx[idx][3];
 
     /* calculate local HCisAjs */
-    LSLCisAjs[idx+nCisAjs] = calHCA(ri,rj,s,h1,ip,eleIdx,eleCfg,eleNum,eleProjCnt);
+    LSLCisAjs[idx+nCisAjs] = calHCA(ri,rj,s,h1,eleNum);
   }
   return;
 }
 
-double complex calculateHK(const double complex h1, const double complex ip, int *eleIdx, int *eleCfg,
-                   int *eleNum, int *eleProjCnt) {
-  int idx,ri,rj,s;
-  double complex val=0.0;
-
-  for(idx=0;idx<NTransfer;idx++) {
-    ri = Transfer[idx][0];
-    rj = Transfer[idx][2];
-    s  = Transfer[idx][3];
-    
-    val -= ParaTransfer[idx] * calHCA(ri,rj,s,h1,ip,eleIdx,eleCfg,eleNum,eleProjCnt);
-    /* Caution: negative sign */
+/* Reduce <psi|H CisAjs CktAlt|x>/<psi|x> by the electron numbers. */
+/* return 0: the term vanishes */
+/*        1: the term is sgn*<psi|H C_{hop[0],hop[2]} A_{hop[1],hop[2]}|x>/<psi|x> */
+/*        2: two electrons hop */
+int ReduceHCACA(const int ri, const int rj, const int rk, const int rl,
+                const int si, const int sk, const int *eleNum, int *hop, int *sgn) {
+  const int rsi=ri+si*Nsite;
+  const int rsj=rj+si*Nsite;
+  const int rsk=rk+sk*Nsite;
+  const int rsl=rl+sk*Nsite;
+
+  *sgn = 1;
+  if(rsk==rsl) {
+    if(eleNum[rsk]==1) {
+      hop[0] = ri; hop[1] = rj; hop[2] = si;
+      return 1;
+    } else return 0;
+  } else if(rsj==rsk) {
+    if(eleNum[rsj]==1) return 0;
+    else {
+      hop[0] = ri; hop[1] = rl; hop[2] = si;
+      return 1;
+    }
+  } else if(rsj==rsl) {
+    return 0;
+  } else if(rsi==rsj) {
+    if(eleNum[rsi]==1) {
+      hop[0] = rk; hop[1] = rl; hop[2] = sk;
+      return 1;
+    } else return 0;
+  } else if(rsi==rsk) {
+    return 0;
+  } else if(rsi==rsl) {
+    if(eleNum[rsi]==1) {
+      hop[0] = rk; hop[1] = rj; hop[2] = sk;
+      *sgn = -1;
+      return 1;
+    } else return 0;
+  } else {
+    if(eleNum[rsl]==0) return 0;
+    if(eleNum[rsk]==1) return 0;
+    if(eleNum[rsj]==0) return 0;
+    if(eleNum[rsi]==1) return 0;
   }
 
-  return val;
+  return 2;
 }
 
-double complex calculateHW(const double complex h1, const double complex ip, int *eleIdx, int *eleCfg,
-                   int *eleNum, int *eleProjCnt) {
+/* Collect the distinct hoppings CisAjs (ri!=rj) of the Transfer terms, */
+/* of the W terms reduced to one hopping, and of CisAjsIdx (NLanczosMode>1). */
+/* <psi|H CisAjs|x>/<psi|x> is evaluated only once for each of them. */
+void MakeLSHop(const int *eleNum) {
   int idx,ri,rj,s,rk,rl,t;
-  double complex val=0.0,tmp;
+  int hop[3],sgn;
+
+  /* clear the hoppings of the previous sample */
+  for(idx=0;idx<NLSHop;idx++) {
+    LSHopIdx[LSHop[2*idx]*Nsite + LSHop[2*idx+1]%Nsite] = -1;
+  }
+  NLSHop = 0;
+
+  for(idx=0;idx<NTransfer;idx++) {
+    addLSHop(Transfer[idx][0],Transfer[idx][2],Transfer[idx][3],eleNum);
+  }
 
-  /* Pair Hopping */
   for(idx=0;idx<NPairHopping;idx++) {
     ri = PairHopping[idx][0];
     rj = PairHopping[idx][1];
-    
-    val += ParaPairHopping[idx]
-      * calHCACA(ri,rj,ri,rj,0,1,h1,ip,eleIdx,eleCfg,eleNum,eleProjCnt);
+    if(ReduceHCACA(ri,rj,ri,rj,0,1,eleNum,hop,&sgn)==1) addLSHop(hop[0],hop[1],hop[2],eleNum);
   }
 
-  /* Exchange Coupling */
   for(idx=0;idx<NExchangeCoupling;idx++) {
     ri = ExchangeCoupling[idx][0];
     rj = ExchangeCoupling[idx][1];
-    
-    tmp =  calHCACA(ri,rj,rj,ri,0,1,h1,ip,eleIdx,eleCfg,eleNum,eleProjCnt);
-    tmp += calHCACA(ri,rj,rj,ri,1,0,h1,ip,eleIdx,eleCfg,eleNum,eleProjCnt);
-    val += ParaExchangeCoupling[idx] * tmp;
+    if(ReduceHCACA(ri,rj,rj,ri,0,1,eleNum,hop,&sgn)==1) addLSHop(hop[0],hop[1],hop[2],eleNum);
+    if(ReduceHCACA(ri,rj,rj,ri,1,0,eleNum,hop,&sgn)==1) addLSHop(hop[0],hop[1],hop[2],eleNum);
   }
 
-  /* Inter All */
   for(idx=0;idx<NInterAll;idx++) {
     ri = InterAll[idx][0];
     rj = InterAll[idx][2];
@@ -169,22 +224,186 @@ double complex calculateHW(const double complex h1, const double complex ip, int
     rk = InterAll[idx][4];
     rl = InterAll[idx][6];
     t  = InterAll[idx][7];
+    if(ReduceHCACA(ri,rj,rk,rl,s,t,eleNum,hop,&sgn)==1) addLSHop(hop[0],hop[1],hop[2],eleNum);
+  }
+
+  if(NLanczosMode>1) {
+    for(idx=0;idx<NCisAjs;idx++) {
+      addLSHop(CisAjsIdx[idx][0],CisAjsIdx[idx][2],CisAjsIdx[idx][3],eleNum);
+    }
+  }
+
+  return;
+}
+
+void addLSHop(const int ri, const int rj, const int s, const int *eleNum) {
+  const int rsi=ri+s*Nsite;
+  const int rsj=rj+s*Nsite;
+  const int idx=rsi*Nsite+rj;
+
+  if(rsi==rsj || eleNum[rsj]==0 || eleNum[rsi]==1) return;
+  if(LSHopIdx[idx]>=0) return;
+
+  LSHopIdx[idx] = NLSHop;
+  LSHop[2*NLSHop]   = rsi;
+  LSHop[2*NLSHop+1] = rsj;
+  NLSHop++;
+  return;
+}
+
+/* Calculate <psi|H CisAjs|x>/<psi|x> of all the hoppings in LSHop. */
+/* Each thread keeps its own electron configuration, InvM and PfM. */
+void calculateLSHop(const double complex ip, int *eleIdx, int *eleCfg, int *eleNum, int *eleProjCnt) {
+  const int nsize=Nsize;
+  const int nsite2=Nsite2;
+  int idx,rsi,rsj;
+
+  int *myEleIdx, *myEleCfg, *myEleNum, *myBufferInt;
+  double complex *myInvM, *myPfM, *myBuffer;
+
+  if(NLSHop==0) return;
+
+  RequestWorkSpaceThreadInt(Nsize+2*Nsite2+2*NProj);
+  RequestWorkSpaceThreadComplex(NQPFull*(Nsize*Nsize+1)+NQPFull+4*Nsize);
+
+#pragma omp parallel default(shared)\
+  private(idx,rsi,rsj,myEleIdx,myEleCfg,myEleNum,myBufferInt,myInvM,myPfM,myBuffer)
+  {
+    myEleIdx = GetWorkSpaceThreadInt(Nsize);
+    myEleCfg = GetWorkSpaceThreadInt(Nsite2);
+    myEleNum = GetWorkSpaceThreadInt(Nsite2);
+    myBufferInt = GetWorkSpaceThreadInt(2*NProj);
+    myInvM = GetWorkSpaceThreadComplex(NQPFull*Nsize*Nsize);
+    myPfM = GetWorkSpaceThreadComplex(NQPFull);
+    myBuffer = GetWorkSpaceThreadComplex(NQPFull+4*Nsize);
+
+    #pragma loop noalias
+    for(idx=0;idx<nsize;idx++) myEleIdx[idx] = eleIdx[idx];
+    #pragma loop noalias
+    for(idx=0;idx<nsite2;idx++) myEleCfg[idx] = eleCfg[idx];
+    #pragma loop noalias
+    for(idx=0;idx<nsite2;idx++) myEleNum[idx] = eleNum[idx];
+
+    #pragma omp for schedule(dynamic)
+    for(idx=0;idx<NLSHop;idx++) {
+      rsi = LSHop[2*idx];
+      rsj = LSHop[2*idx+1];
+      LSHopVal[idx] = calHCA_child(rsi%Nsite,rsj%Nsite,rsi/Nsite,ip,
+                                   myEleIdx,myEleCfg,myEleNum,eleProjCnt,
+                                   myInvM,myPfM,myBuffer,myBufferInt);
+    }
+  }
+
+  ReleaseWorkSpaceThreadInt();
+  ReleaseWorkSpaceThreadComplex();
+  return;
+}
+
+double complex calculateHK(const double complex h1, const int *eleNum) {
+  int idx,ri,rj,s;
+  double complex val=0.0;
+
+  for(idx=0;idx<NTransfer;idx++) {
+    ri = Transfer[idx][0];
+    rj = Transfer[idx][2];
+    s  = Transfer[idx][3];
+    
+    val -= ParaTransfer[idx] * calHCA(ri,rj,s,h1,eleNum);
+    /* Caution: negative sign */
+  }
+
+  return val;
+}
+
+double complex calculateHW(const double complex h1, const double complex ip, int *eleIdx, int *eleCfg,
+                   int *eleNum, int *eleProjCnt) {
+  const int nsize=Nsize;
+  const int nsite2=Nsite2;
+  int idx,ri,rj,s,rk,rl,t;
+  double complex val=0.0,tmp;
+
+  int *myEleIdx, *myEleCfg, *myEleNum, *myBufferInt;
+  double complex *myInvM, *myPfM, *myBuffer;
+  double complex myValue;
+
+  if(NPairHopping+NExchangeCoupling+NInterAll==0) return 0.0;
+
+  RequestWorkSpaceThreadInt(Nsize+2*Nsite2+2*NProj);
+  RequestWorkSpaceThreadComplex(NQPFull*(Nsize*Nsize+1)+NQPFull+4*Nsize);
+
+#pragma omp parallel default(shared)\
+  private(idx,ri,rj,s,rk,rl,t,tmp,myEleIdx,myEleCfg,myEleNum,myBufferInt,myInvM,myPfM,myBuffer,myValue) \
+  reduction(+:val)
+  {
+    myEleIdx = GetWorkSpaceThreadInt(Nsize);
+    myEleCfg = GetWorkSpaceThreadInt(Nsite2);
+    myEleNum = GetWorkSpaceThreadInt(Nsite2);
+    myBufferInt = GetWorkSpaceThreadInt(2*NProj);
+    myInvM = GetWorkSpaceThreadComplex(NQPFull*Nsize*Nsize);
+    myPfM = GetWorkSpaceThreadComplex(NQPFull);
+    myBuffer = GetWorkSpaceThreadComplex(NQPFull+4*Nsize);
+
+    #pragma loop noalias
+    for(idx=0;idx<nsize;idx++) myEleIdx[idx] = eleIdx[idx];
+    #pragma loop noalias
+    for(idx=0;idx<nsite2;idx++) myEleCfg[idx] = eleCfg[idx];
+    #pragma loop noalias
+    for(idx=0;idx<nsite2;idx++) myEleNum[idx] = eleNum[idx];
+
+    myValue = 0.0;
+
+    /* Pair Hopping */
+    #pragma omp for schedule(dynamic) nowait
+    for(idx=0;idx<NPairHopping;idx++) {
+      ri = PairHopping[idx][0];
+      rj = PairHopping[idx][1];
+    
+      myValue += ParaPairHopping[idx]
+        * calHCACA(ri,rj,ri,rj,0,1,h1,ip,myEleIdx,myEleCfg,myEleNum,eleProjCnt,
+                   myInvM,myPfM,myBuffer,myBufferInt);
+    }
+
+    /* Exchange Coupling */
+    #pragma omp for schedule(dynamic) nowait
+    for(idx=0;idx<NExchangeCoupling;idx++) {
+      ri = ExchangeCoupling[idx][0];
+      rj = ExchangeCoupling[idx][1];
+    
+      tmp =  calHCACA(ri,rj,rj,ri,0,1,h1,ip,myEleIdx,myEleCfg,myEleNum,eleProjCnt,
+                      myInvM,myPfM,myBuffer,myBufferInt);
+      tmp += calHCACA(ri,rj,rj,ri,1,0,h1,ip,myEleIdx,myEleCfg,myEleNum,eleProjCnt,
+                      myInvM,myPfM,myBuffer,myBufferInt);
+      myValue += ParaExchangeCoupling[idx] * tmp;
+    }
+
+    /* Inter All */
+    #pragma omp for schedule(dynamic) nowait
+    for(idx=0;idx<NInterAll;idx++) {
+      ri = InterAll[idx][0];
+      rj = InterAll[idx][2];
+      s  = InterAll[idx][3];
+      rk = InterAll[idx][4];
+      rl = InterAll[idx][6];
+      t  = InterAll[idx][7];
       
-    val += ParaInterAll[idx]
-      * calHCACA(ri,rj,rk,rl,s,t,h1,ip,eleIdx,eleCfg,eleNum,eleProjCnt);
+      myValue += ParaInterAll[idx]
+        * calHCACA(ri,rj,rk,rl,s,t,h1,ip,myEleIdx,myEleCfg,myEleNum,eleProjCnt,
+                   myInvM,myPfM,myBuffer,myBufferInt);
+    }
+
+    val += myValue;
   }
 
+  ReleaseWorkSpaceThreadInt();
+  ReleaseWorkSpaceThreadComplex();
   return val;
 }
 
-/* calculate <psi| H C_is A_js |x>/<psi|x> */
+/* <psi| H C_is A_js |x>/<psi|x> from the hoppings evaluated by calculateLSHop */
 double complex calHCA(const int ri, const int rj, const int s,
-              const double complex h1, const double complex ip, int *eleIdx, int *eleCfg,
-              int *eleNum, int *eleProjCnt) {
+              const double complex h1, const int *eleNum) {
   int rsi=ri+s*Nsite;
   int rsj=rj+s*Nsite;
-  double complex val;
-  double complex g;
 
   /* check */
   if(rsi==rsj) {
@@ -195,11 +414,23 @@ double complex calHCA(const int ri, const int rj, const int s,
     if(eleNum[rsi]==1) return 0.0;
   }
 
+  return LSHopVal[LSHopIdx[rsi*Nsite+rj]];
+}
+
+/* calculate <psi| H C_is A_js |x>/<psi|x> */
+/* Assuming ri!=rj, eleNum[rsi]=0, eleNum[rsj]=1 */
+/* buffer size = NQPFull+4*Nsize, bufferInt size = 2*NProj */
+double complex calHCA_child(const int ri, const int rj, const int s,
+                    const double complex ip, int *eleIdx, int *eleCfg, int *eleNum, int *eleProjCnt,
+                    double complex *invM, double complex *pfM, double complex *buffer, int *bufferInt) {
+  double complex val;
+  double complex g;
+
   g = checkGF1(ri,rj,s,ip,eleIdx,eleCfg,eleNum);
   if(cabs(g)>1.0e-12) {
-    val = calHCA1(ri,rj,s,ip,eleIdx,eleCfg,eleNum,eleProjCnt);
+    val = calHCA1(ri,rj,s,ip,eleIdx,eleCfg,eleNum,eleProjCnt,invM,pfM,buffer,bufferInt);
   } else {
-    val = calHCA2(ri,rj,s,ip,eleIdx,eleCfg,eleNum,eleProjCnt);
+    val = calHCA2(ri,rj,s,ip,eleIdx,eleCfg,eleNum,eleProjCnt,buffer,bufferInt);
   }
 
   return val;
@@ -234,27 +465,19 @@ double complex checkGF1(const int ri, const int rj, const int s, const double co
 }
 
 /* calculate <psi| H C_is A_js |x>/<psi|x> = <psi|x'>/<psi|x> * <psi|H|x'>/<psi|x'> */
+/* InvM and PfM of x' are made in invM and pfM, and are used for all the terms of H. */
 double complex calHCA1(const int ri, const int rj, const int s,
                const double complex ip, int *eleIdx, int *eleCfg,
-               int *eleNum, int *eleProjCnt) {
-  complex double *oldInvM; /* [NQPFull*Nsize*Nsize;] */
-  complex double *oldPfM;  /* [NQPFull] */
-  int *projCntNew;
-
+               int *eleNum, int *eleProjCnt,
+               double complex *invM, double complex *pfM, double complex *buffer, int *bufferInt) {
+  int *projCntNew = bufferInt; /* [NProj] */
   int rsi=ri+s*Nsite;
   int rsj=rj+s*Nsite;
-  int mj;
+  int mj,qpidx;
   double complex ipNew,z,e;
 
-  RequestWorkSpaceInt(NProj);
-  RequestWorkSpaceComplex(NQPFull*(Nsize*Nsize+1));
-
-  projCntNew = GetWorkSpaceInt(NProj);
-  oldInvM = GetWorkSpaceComplex(NQPFull*Nsize*Nsize);
-  oldPfM  = GetWorkSpaceComplex(NQPFull);
-
   /* copy InvM and PfM */
-  copyMAll(InvM,PfM,oldInvM,oldPfM);
+  copyMAll(InvM,PfM,invM,pfM);
 
   /* The mj-th electron with spin s hops to site ri */
   mj = eleCfg[rsj];
@@ -267,10 +490,13 @@ double complex calHCA1(const int ri, const int rj, const int s,
   UpdateProjCnt(rj, ri, s, projCntNew, eleProjCnt, eleNum);
   z = ProjRatio(projCntNew,eleProjCnt);
 
-  UpdateMAll(mj,s,eleIdx,0,NQPFull);
-  ipNew = CalculateIP_fcmp(PfM,0,NQPFull,MPI_COMM_SELF);
+  for(qpidx=0;qpidx<NQPFull;qpidx++) {
+    updateMAll_child(mj, s, eleIdx, 0, NQPFull, qpidx, buffer, buffer+Nsize, pfM, invM);
+  }
+  ipNew = CalculateIP_fcmp(pfM,0,NQPFull,MPI_COMM_SELF);
 
-  e = CalculateHamiltonian(ipNew,eleIdx,eleCfg,eleNum,projCntNew);
+  e = calculateHamiltonian_child(ipNew,eleIdx,eleCfg,eleNum,projCntNew,
+                                 pfM,invM,buffer,bufferInt+NProj);
 
   /* revert hopping */
   eleIdx[mj+s*Ne] = rj;
@@ -279,11 +505,6 @@ double complex calHCA1(const int ri, const int rj, const int s,
   eleNum[rsj] = 1;
   eleNum[rsi] = 0;
 
-  /* restore InvM and PfM */
-  copyMAll(oldInvM,oldPfM,InvM,PfM);
-
-  ReleaseWorkSpaceInt();
-  ReleaseWorkSpaceComplex();
   return e*conj(z*ipNew/ip);
 }
 
@@ -291,34 +512,17 @@ double complex calHCA1(const int ri, const int rj, const int s,
 /* Assuming ri!=rj, eleNum[rsi]=1, eleNum[rsj]=0 */
 double complex calHCA2(const int ri, const int rj, const int s,
                const double complex ip, int *eleIdx, int *eleCfg,
-               int *eleNum, int *eleProjCnt) {
-  const int nsize=Nsize;
-  const int nsite2=Nsite2;
-
+               int *eleNum, int *eleProjCnt,
+               double complex *buffer, int *bufferInt) {
   int idx;
   int rk,rl,sk;
   double complex val=0.0;
   int rsi = ri+s*Nsite;
   int rsj = rj+s*Nsite;
+  int myRsi[3], myRsj[3];
 
   double complex g;
 
-  double complex *buffer;
-  int *bufferInt;
-
-  int *myEleIdx, *myEleNum, *myBufferInt, *myRsi, *myRsj;
-  double complex *myBuffer;
-  double complex myValue=0;
-  double complex v=0.0;
-
-  RequestWorkSpaceInt(NProj);      /* for GreenFunc1 */
-  RequestWorkSpaceComplex(NQPFull); /* for GreenFunc1 */
-  RequestWorkSpaceThreadInt(Nsize+Nsite2+NProj+6);
-  RequestWorkSpaceThreadComplex(NQPFull+3*Nsize);
-
-  bufferInt = GetWorkSpaceInt(NProj);
-  buffer = GetWorkSpaceComplex(NQPFull);
-
   /* H0 term */
   /* <psi|H0 CA|x>/<psi|x> = H0(x') <psi|CA|x>/<psi|x> */
   g = GreenFunc1(ri,rj,s,ip,eleIdx,eleCfg,eleNum,eleProjCnt,bufferInt,buffer);
@@ -335,164 +539,110 @@ double complex calHCA2(const int ri, const int rj, const int s,
 
   /* end of H0 term */
 
-#pragma omp parallel default(shared)\
-  private(myEleIdx,myEleNum,myBufferInt,myBuffer,myValue,myRsi,myRsj)  \
-  reduction(+:v)
-  {
-    myEleIdx = GetWorkSpaceThreadInt(Nsize);
-    myEleNum = GetWorkSpaceThreadInt(Nsite2);
-    myBufferInt = GetWorkSpaceThreadInt(NProj);
-    myRsi = GetWorkSpaceThreadInt(3);
-    myRsj = GetWorkSpaceThreadInt(3);
-    myBuffer = GetWorkSpaceThreadComplex(NQPFull+3*Nsize);
-
-    #pragma loop noalias
-    for(idx=0;idx<nsize;idx++) myEleIdx[idx] = eleIdx[idx];
-    #pragma loop noalias
-    for(idx=0;idx<nsite2;idx++) myEleNum[idx] = eleNum[idx];
-    
-    myValue = 0.0;
-
-    /* Transfer */
-    #pragma omp for private(idx,rk,rl,sk) schedule(dynamic) nowait
-    for(idx=0;idx<NTransfer;idx++) {
-      rk = Transfer[idx][0];
-      rl = Transfer[idx][2];
-      sk = Transfer[idx][3];
+  /* Transfer */
+  for(idx=0;idx<NTransfer;idx++) {
+    rk = Transfer[idx][0];
+    rl = Transfer[idx][2];
+    sk = Transfer[idx][3];
       
-      myValue -= ParaTransfer[idx]
-        * GreenFunc2(rk,rl,ri,rj,sk,s,ip,myEleIdx,eleCfg,myEleNum,eleProjCnt,myBufferInt,myBuffer);
-      /* Caution: negative sign */
-    }
+    val -= ParaTransfer[idx]
+      * GreenFunc2(rk,rl,ri,rj,sk,s,ip,eleIdx,eleCfg,eleNum,eleProjCnt,bufferInt,buffer);
+    /* Caution: negative sign */
+  }
 
-    /* Pair Hopping */
-    #pragma omp for private(idx,rk,rl) schedule(dynamic) nowait
-    for(idx=0;idx<NPairHopping;idx++) {
-      rk = PairHopping[idx][0];
-      rl = PairHopping[idx][1];
-      myRsi[0] = rk; /* s=0 */
-      myRsj[0] = rl; /* s=0 */
-      myRsi[1] = rk+Nsite; /* s=1 */
-      myRsj[1] = rl+Nsite; /* s=1 */
-      myRsi[2] = rsi;
-      myRsj[2] = rsj;
+  /* Pair Hopping */
+  for(idx=0;idx<NPairHopping;idx++) {
+    rk = PairHopping[idx][0];
+    rl = PairHopping[idx][1];
+    myRsi[0] = rk; /* s=0 */
+    myRsj[0] = rl; /* s=0 */
+    myRsi[1] = rk+Nsite; /* s=1 */
+    myRsj[1] = rl+Nsite; /* s=1 */
+    myRsi[2] = rsi;
+    myRsj[2] = rsj;
       
-      myValue += ParaPairHopping[idx]
-        * GreenFuncN(3,myRsi,myRsj,ip,myEleIdx,eleCfg,myEleNum,eleProjCnt,myBuffer,myBufferInt);
-    }
+    val += ParaPairHopping[idx]
+      * GreenFuncN(3,myRsi,myRsj,ip,eleIdx,eleCfg,eleNum,eleProjCnt,buffer,bufferInt);
+  }
 
-    /* Exchange Coupling */
-    #pragma omp for private(idx,rk,rl) schedule(dynamic) nowait
-    for(idx=0;idx<NExchangeCoupling;idx++) {
-      rk = ExchangeCoupling[idx][0];
-      rl = ExchangeCoupling[idx][1];
-      myRsi[0] = rk; /* s=0 */
-      myRsj[0] = rl; /* s=0 */
-      myRsi[1] = rl+Nsite; /* s=1 */
-      myRsj[1] = rk+Nsite; /* s=1 */
-      myRsi[2] = rsi;
-      myRsj[2] = rsj;
-      myValue += ParaExchangeCoupling[idx]
-        * GreenFuncN(3,myRsi,myRsj,ip,myEleIdx,eleCfg,myEleNum,eleProjCnt,myBuffer,myBufferInt);
+  /* Exchange Coupling */
+  for(idx=0;idx<NExchangeCoupling;idx++) {
+    rk = ExchangeCoupling[idx][0];
+    rl = ExchangeCoupling[idx][1];
+    myRsi[0] = rk; /* s=0 */
+    myRsj[0] = rl; /* s=0 */
+    myRsi[1] = rl+Nsite; /* s=1 */
+    myRsj[1] = rk+Nsite; /* s=1 */
+    myRsi[2] = rsi;
+    myRsj[2] = rsj;
+    val += ParaExchangeCoupling[idx]
+      * GreenFuncN(3,myRsi,myRsj,ip,eleIdx,eleCfg,eleNum,eleProjCnt,buffer,bufferInt);
       
-      myRsi[0] = rk+Nsite; /* s=1 */
-      myRsj[0] = rl+Nsite; /* s=1 */
-      myRsi[1] = rl; /* s=0 */
-      myRsj[1] = rk; /* s=0 */
-      myRsi[2] = rsi;
-      myRsj[2] = rsj;
-      myValue += ParaExchangeCoupling[idx]
-        * GreenFuncN(3,myRsi,myRsj,ip,myEleIdx,eleCfg,myEleNum,eleProjCnt,myBuffer,myBufferInt);
-    }
-    
-    /* Inter All */
-    #pragma omp for private(idx) schedule(dynamic) nowait
-    for(idx=0;idx<NInterAll;idx++) {
-      myRsi[0] = InterAll[idx][0] + InterAll[idx][3]*Nsite;
-      myRsj[0] = InterAll[idx][2] + InterAll[idx][3]*Nsite;
-      myRsi[1] = InterAll[idx][4] + InterAll[idx][7]*Nsite;
-      myRsj[1] = InterAll[idx][6] + InterAll[idx][7]*Nsite;
-      myRsi[2] = rsi;
-      myRsj[2] = rsj;
-      myValue += ParaInterAll[idx]
-        * GreenFuncN(3,myRsi,myRsj,ip,myEleIdx,eleCfg,myEleNum,eleProjCnt,myBuffer,myBufferInt);
-    }
+    myRsi[0] = rk+Nsite; /* s=1 */
+    myRsj[0] = rl+Nsite; /* s=1 */
+    myRsi[1] = rl; /* s=0 */
+    myRsj[1] = rk; /* s=0 */
+    myRsi[2] = rsi;
+    myRsj[2] = rsj;
+    val += ParaExchangeCoupling[idx]
+      * GreenFuncN(3,myRsi,myRsj,ip,eleIdx,eleCfg,eleNum,eleProjCnt,buffer,bufferInt);
+  }
     
-    v += myValue;
+  /* Inter All */
+  for(idx=0;idx<NInterAll;idx++) {
+    myRsi[0] = InterAll[idx][0] + InterAll[idx][3]*Nsite;
+    myRsj[0] = InterAll[idx][2] + InterAll[idx][3]*Nsite;
+    myRsi[1] = InterAll[idx][4] + InterAll[idx][7]*Nsite;
+    myRsj[1] = InterAll[idx][6] + InterAll[idx][7]*Nsite;
+    myRsi[2] = rsi;
+    myRsj[2] = rsj;
+    val += ParaInterAll[idx]
+      * GreenFuncN(3,myRsi,myRsj,ip,eleIdx,eleCfg,eleNum,eleProjCnt,buffer,bufferInt);
   }
-  val += v;
-
-  ReleaseWorkSpaceInt();
-  ReleaseWorkSpaceComplex();
-  ReleaseWorkSpaceThreadInt();
-  ReleaseWorkSpaceThreadComplex();
 
   return val;
 }
 
+/* calculate <psi| H C_is A_js C_kt A_lt |x>/<psi|x> */
+/* The terms reduced to one hopping are read from LSHopVal. */
 double complex calHCACA(const int ri, const int rj, const int rk, const int rl,
                 const int si,const int sk,
                 const double complex h1, const double complex ip, int *eleIdx, int *eleCfg,
-                int *eleNum, int *eleProjCnt) {
-  int rsi=ri+si*Nsite;
-  int rsj=rj+si*Nsite;
-  int rsk=rk+sk*Nsite;
-  int rsl=rl+sk*Nsite;
-
+                int *eleNum, int *eleProjCnt,
+                double complex *invM, double complex *pfM, double complex *buffer, int *bufferInt) {
   double complex val;
   double complex g;
+  int hop[3],sgn;
 
   /* check */
-  if(rsk==rsl) {
-    if(eleNum[rsk]==1) {
-      return calHCA(ri,rj,si,h1,ip,eleIdx,eleCfg,eleNum,eleProjCnt);
-    } else return 0;
-  } else if(rsj==rsk) {
-    if(eleNum[rsj]==1) return 0;
-    else {
-      return calHCA(ri,rl,si,h1,ip,eleIdx,eleCfg,eleNum,eleProjCnt);
-    }
-  } else if(rsj==rsl) {
-    return 0;
-  } else if(rsi==rsj) {
-    if(eleNum[rsi]==1) {
-      return calHCA(rk,rl,sk,h1,ip,eleIdx,eleCfg,eleNum,eleProjCnt);
-    } else return 0;
-  } else if(rsi==rsk) {
-    return 0;
-  } else if(rsi==rsl) {
-    if(eleNum[rsi]==1) {
-      return -calHCA(rk,rj,sk,h1,ip,eleIdx,eleCfg,eleNum,eleProjCnt);
-    } else return 0;
-  } else {
-    if(eleNum[rsl]==0) return 0.0;
-    if(eleNum[rsk]==1) return 0.0;
-    if(eleNum[rsj]==0) return 0.0;
-    if(eleNum[rsi]==1) return 0.0;
+  switch(ReduceHCACA(ri,rj,rk,rl,si,sk,eleNum,hop,&sgn)) {
+  case 0:
+    return 0.0;
+  case 1:
+    return sgn*calHCA(hop[0],hop[1],hop[2],h1,eleNum);
+  default:
+    break;
   }
 
-  g = checkGF2(ri,rj,rk,rl,si,sk,ip,eleIdx,eleCfg,eleNum);
+  g = checkGF2(ri,rj,rk,rl,si,sk,ip,eleIdx,eleCfg,eleNum,buffer);
   if(cabs(g)>1.0e-12) {
-    val = calHCACA1(ri,rj,rk,rl,si,sk,ip,eleIdx,eleCfg,eleNum,eleProjCnt);
+    val = calHCACA1(ri,rj,rk,rl,si,sk,ip,eleIdx,eleCfg,eleNum,eleProjCnt,invM,pfM,buffer,bufferInt);
   } else {
-    val = calHCACA2(ri,rj,rk,rl,si,sk,ip,eleIdx,eleCfg,eleNum,eleProjCnt);
+    val = calHCACA2(ri,rj,rk,rl,si,sk,ip,eleIdx,eleCfg,eleNum,eleProjCnt,buffer,bufferInt);
   }
 
   return val;
 }
 
+/* buffer size = NQPFull+2*Nsize */
 double complex checkGF2(const int ri, const int rj, const int rk, const int rl,
                 const int s, const int t, const double complex ip,
-                int *eleIdx, const int *eleCfg, int *eleNum) {
+                int *eleIdx, const int *eleCfg, int *eleNum, double complex *buffer) {
   double complex z;
   int mj,msj,ml,mtl;
   int rsi,rsj,rtk,rtl;
-  double complex *pfMNew;
-  double complex *buffer;
-
-  RequestWorkSpaceComplex(NQPFull+2*Nsize);
-  pfMNew = GetWorkSpaceComplex(NQPFull);
-  buffer = GetWorkSpaceComplex(2*Nsize);
+  double complex *pfMNew = buffer; /* [NQPFull] */
+  double complex *bufV = buffer+NQPFull; /* [2*Nsize] */
 
   rsi = ri + s*Nsite;
   rsj = rj + s*Nsite;
@@ -514,7 +664,7 @@ double complex checkGF2(const int ri, const int rj, const int rk, const int rl,
   eleNum[rsi] = 1;
 
   /* calculate Pfaffian */
-  CalculateNewPfMTwo_fcmp(ml, t, mj, s, pfMNew, eleIdx, 0, NQPFull, buffer);
+  CalculateNewPfMTwo_fcmp(ml, t, mj, s, pfMNew, eleIdx, 0, NQPFull, bufV);
   z = CalculateIP_fcmp(pfMNew, 0, NQPFull, MPI_COMM_SELF);
 
   /* revert hopping */
@@ -525,34 +675,25 @@ double complex checkGF2(const int ri, const int rj, const int rk, const int rl,
   eleNum[rsj] = 1;
   eleNum[rsi] = 0;
 
-  ReleaseWorkSpaceComplex();
   return z/ip;
 }
 
+/* InvM and PfM after the two hoppings are made in invM and pfM. */
 double complex calHCACA1(const int ri, const int rj, const int rk, const int rl,
                  const int si,const int sk,
                  const double complex ip, int *eleIdx, int *eleCfg,
-                 int *eleNum, int *eleProjCnt) {
-  double complex *oldInvM; /* [NQPFull*Nsize*Nsize;] */
-  double complex *oldPfM;  /* [NQPFull] */
-  int *projCntNew;
-
+                 int *eleNum, int *eleProjCnt,
+                 double complex *invM, double complex *pfM, double complex *buffer, int *bufferInt) {
+  int *projCntNew = bufferInt; /* [NProj] */
   int rsi=ri+si*Nsite;
   int rsj=rj+si*Nsite;
   int rsk=rk+sk*Nsite;
   int rsl=rl+sk*Nsite;
-  int mj,ml;
+  int mj,ml,qpidx;
   double complex ipNew,z,e;
 
-  RequestWorkSpaceInt(NProj);
-  RequestWorkSpaceComplex(NQPFull*(Nsize*Nsize+1));
-
-  projCntNew = GetWorkSpaceInt(NProj);
-  oldInvM = GetWorkSpaceComplex(NQPFull*Nsize*Nsize);
-  oldPfM  = GetWorkSpaceComplex(NQPFull);
-
   /* copy InvM and PfM */
-  copyMAll(InvM,PfM,oldInvM,oldPfM);
+  copyMAll(InvM,PfM,invM,pfM);
 
   /* The ml-th electron with spin sk hops from rl to rk */
   ml = eleCfg[rsl];
@@ -574,10 +715,14 @@ double complex calHCACA1(const int ri, const int rj, const int rk, const int rl,
 
   z = ProjRatio(projCntNew,eleProjCnt);
 
-  UpdateMAllTwo_fcmp(ml, sk, mj, si, rl, rj, eleIdx, 0, NQPFull);
-  ipNew = CalculateIP_fcmp(PfM,0,NQPFull,MPI_COMM_SELF);
+  for(qpidx=0;qpidx<NQPFull;qpidx++) {
+    updateMAllTwo_child_fcmp(ml, sk, mj, si, rl, rj, eleIdx, 0, NQPFull, qpidx,
+                             buffer, buffer+Nsize, buffer+2*Nsize, buffer+3*Nsize, pfM, invM);
+  }
+  ipNew = CalculateIP_fcmp(pfM,0,NQPFull,MPI_COMM_SELF);
 
-  e = CalculateHamiltonian(ipNew,eleIdx,eleCfg,eleNum,projCntNew);
+  e = calculateHamiltonian_child(ipNew,eleIdx,eleCfg,eleNum,projCntNew,
+                                 pfM,invM,buffer,bufferInt+NProj);
 
   /* revert hopping */
   eleIdx[mj+si*Ne] = rj;
@@ -592,11 +737,6 @@ double complex calHCACA1(const int ri, const int rj, const int rk, const int rl,
   eleNum[rsl] = 1;
   eleNum[rsk] = 0;
 
-  /* restore InvM and PfM */
-  copyMAll(oldInvM,oldPfM,InvM,PfM);
-
-  ReleaseWorkSpaceInt();
-  ReleaseWorkSpaceComplex();
   return e*z*ipNew/ip;
 }
 
@@ -604,10 +744,8 @@ double complex calHCACA1(const int ri, const int rj, const int rk, const int rl,
 /* Assuming ri,rj,rk,rl are different, eleNum[rsi]=1, eleNum[rsj]=0, eleNum[rsk]=1, eleNum[rsl]=0  */
 double complex calHCACA2(const int ri, const int rj, const int rk, const int rl,
                  const int si,const int sk,
-                 const double complex ip, int *eleIdx, int *eleCfg, int *eleNum, int *eleProjCnt) {
-  const int nsize=Nsize;
-  const int nsite2=Nsite2;
-
+                 const double complex ip, int *eleIdx, int *eleCfg, int *eleNum, int *eleProjCnt,
+                 double complex *buffer, int *bufferInt) {
   const int rsi = ri+si*Nsite;
   const int rsj = rj+si*Nsite;
   const int rsk = rk+sk*Nsite;
@@ -615,25 +753,10 @@ double complex calHCACA2(const int ri, const int rj, const int rk, const int rl,
 
   int idx,r0,r1;
   double complex val=0.0;
+  int myRsi[4], myRsj[4];
 
   double complex g;
 
-  double complex *buffer;
-  int *bufferInt;
-
-  int *myEleIdx, *myEleNum, *myBufferInt, *myRsi, *myRsj;
-  double complex *myBuffer;
-  double complex myValue=0.0;
-  double complex v=0.0;
-
-  RequestWorkSpaceInt(NProj);      /* for GreenFunc2 */
-  RequestWorkSpaceComplex(NQPFull+2*Nsize); /* for GreenFunc2 */
-  RequestWorkSpaceThreadInt(Nsize+Nsite2+NProj+8);
-  RequestWorkSpaceThreadComplex(NQPFull+3*Nsize);
-
-  bufferInt = GetWorkSpaceInt(NProj);
-  buffer = GetWorkSpaceComplex(NQPFull+2*Nsize);
-
   /* H0 term */
   /* <psi|H0 CACA|x>/<psi|x> = H0(x') <psi|CACA|x>/<psi|x> */
   g = GreenFunc2(ri,rj,rk,rl,si,sk,ip,
@@ -655,112 +778,159 @@ double complex calHCACA2(const int ri, const int rj, const int rk, const int rl,
 
   /* end of H0 term */
 
-#pragma omp parallel default(shared)\
-  private(myEleIdx,myEleNum,myBufferInt,myBuffer,myValue,myRsi,myRsj)  \
-  reduction(+:v)
-  {
-    myEleIdx = GetWorkSpaceThreadInt(Nsize);
-    myEleNum = GetWorkSpaceThreadInt(Nsite2);
-    myBufferInt = GetWorkSpaceThreadInt(NProj);
-    myRsi = GetWorkSpaceThreadInt(4);
-    myRsj = GetWorkSpaceThreadInt(4);
-    myBuffer = GetWorkSpaceThreadComplex(NQPFull+4*Nsize);
-
-    #pragma loop noalias
-    for(idx=0;idx<nsize;idx++) myEleIdx[idx] = eleIdx[idx];
-    #pragma loop noalias
-    for(idx=0;idx<nsite2;idx++) myEleNum[idx] = eleNum[idx];
-    
-    myValue = 0.0;
-
-    /* Transfer */
-    #pragma omp for private(idx) schedule(dynamic) nowait
-    for(idx=0;idx<NTransfer;idx++) {
-      myRsi[0] = Transfer[idx][0]+Transfer[idx][1]*Nsite;
-      myRsj[0] = Transfer[idx][2]+Transfer[idx][3]*Nsite;
-      myRsi[1] = rsi;
-      myRsj[1] = rsj;
-      myRsi[2] = rsk;
-      myRsj[2] = rsl;
+  /* Transfer */
+  for(idx=0;idx<NTransfer;idx++) {
+    myRsi[0] = Transfer[idx][0]+Transfer[idx][1]*Nsite;
+    myRsj[0] = Transfer[idx][2]+Transfer[idx][3]*Nsite;
+    myRsi[1] = rsi;
+    myRsj[1] = rsj;
+    myRsi[2] = rsk;
+    myRsj[2] = rsl;
       
-      myValue -= ParaTransfer[idx]
-        * GreenFuncN(3,myRsi,myRsj,ip,myEleIdx,eleCfg,myEleNum,eleProjCnt,myBuffer,myBufferInt);
-      /* Caution: negative sign */
-    }
+    val -= ParaTransfer[idx]
+      * GreenFuncN(3,myRsi,myRsj,ip,eleIdx,eleCfg,eleNum,eleProjCnt,buffer,bufferInt);
+    /* Caution: negative sign */
+  }
 
-    /* Pair Hopping */
-    #pragma omp for private(idx,r0,r1) schedule(dynamic) nowait
-    for(idx=0;idx<NPairHopping;idx++) {
-      r0 = PairHopping[idx][0];
-      r1 = PairHopping[idx][1];
-      myRsi[0] = r0; /* s=0 */
-      myRsj[0] = r1; /* s=0 */
-      myRsi[1] = r0+Nsite; /* s=1 */
-      myRsj[1] = r1+Nsite; /* s=1 */
-      myRsi[2] = rsi;
-      myRsj[2] = rsj;
-      myRsi[3] = rsk;
-      myRsj[3] = rsl;
+  /* Pair Hopping */
+  for(idx=0;idx<NPairHopping;idx++) {
+    r0 = PairHopping[idx][0];
+    r1 = PairHopping[idx][1];
+    myRsi[0] = r0; /* s=0 */
+    myRsj[0] = r1; /* s=0 */
+    myRsi[1] = r0+Nsite; /* s=1 */
+    myRsj[1] = r1+Nsite; /* s=1 */
+    myRsi[2] = rsi;
+    myRsj[2] = rsj;
+    myRsi[3] = rsk;
+    myRsj[3] = rsl;
       
-      myValue += ParaPairHopping[idx]
-        * GreenFuncN(4,myRsi,myRsj,ip,myEleIdx,eleCfg,myEleNum,eleProjCnt,myBuffer,myBufferInt);
-    }
+    val += ParaPairHopping[idx]
+      * GreenFuncN(4,myRsi,myRsj,ip,eleIdx,eleCfg,eleNum,eleProjCnt,buffer,bufferInt);
+  }
 
-    /* Exchange Coupling */
-    #pragma omp for private(idx,r0,r1) schedule(dynamic) nowait
-    for(idx=0;idx<NExchangeCoupling;idx++) {
-      r0 = ExchangeCoupling[idx][0];
-      r1 = ExchangeCoupling[idx][1];
-      myRsi[0] = r0; /* s=0 */
-      myRsj[0] = r1; /* s=0 */
-      myRsi[1] = r1+Nsite; /* s=1 */
-      myRsj[1] = r0+Nsite; /* s=1 */
-      myRsi[2] = rsi;
-      myRsj[2] = rsj;
-      myRsi[3] = rsk;
-      myRsj[3] = rsl;
-      myValue += ParaExchangeCoupling[idx]
-        * GreenFuncN(4,myRsi,myRsj,ip,myEleIdx,eleCfg,myEleNum,eleProjCnt,myBuffer,myBufferInt);
+  /* Exchange Coupling */
+  for(idx=0;idx<NExchangeCoupling;idx++) {
+    r0 = ExchangeCoupling[idx][0];
+    r1 = ExchangeCoupling[idx][1];
+    myRsi[0] = r0; /* s=0 */
+    myRsj[0] = r1; /* s=0 */
+    myRsi[1] = r1+Nsite; /* s=1 */
+    myRsj[1] = r0+Nsite; /* s=1 */
+    myRsi[2] = rsi;
+    myRsj[2] = rsj;
+    myRsi[3] = rsk;
+    myRsj[3] = rsl;
+    val += ParaExchangeCoupling[idx]
+      * GreenFuncN(4,myRsi,myRsj,ip,eleIdx,eleCfg,eleNum,eleProjCnt,buffer,bufferInt);
       
-      myRsi[0] = r0+Nsite; /* s=1 */
-      myRsj[0] = r1+Nsite; /* s=1 */
-      myRsi[1] = r1; /* s=0 */
-      myRsj[1] = r0; /* s=0 */
-      myRsi[2] = rsi;
-      myRsj[2] = rsj;
-      myRsi[3] = rsk;
-      myRsj[3] = rsl;
-      myValue += ParaExchangeCoupling[idx]
-        * GreenFuncN(4,myRsi,myRsj,ip,myEleIdx,eleCfg,myEleNum,eleProjCnt,myBuffer,myBufferInt);
-    }
-    
-    /* Inter All */
-    #pragma omp for private(idx) schedule(dynamic) nowait
-    for(idx=0;idx<NInterAll;idx++) {
-      myRsi[0] = InterAll[idx][0] + InterAll[idx][3]*Nsite;
-      myRsj[0] = InterAll[idx][2] + InterAll[idx][3]*Nsite;
-      myRsi[1] = InterAll[idx][4] + InterAll[idx][7]*Nsite;
-      myRsj[1] = InterAll[idx][6] + InterAll[idx][7]*Nsite;
-      myRsi[2] = rsi;
-      myRsj[2] = rsj;
-      myRsi[3] = rsk;
-      myRsj[3] = rsl;
-      myValue += ParaInterAll[idx]
-        * GreenFuncN(4,myRsi,myRsj,ip,myEleIdx,eleCfg,myEleNum,eleProjCnt,myBuffer,myBufferInt);
-    }
+    myRsi[0] = r0+Nsite; /* s=1 */
+    myRsj[0] = r1+Nsite; /* s=1 */
+    myRsi[1] = r1; /* s=0 */
+    myRsj[1] = r0; /* s=0 */
+    myRsi[2] = rsi;
+    myRsj[2] = rsj;
+    myRsi[3] = rsk;
+    myRsj[3] = rsl;
+    val += ParaExchangeCoupling[idx]
+      * GreenFuncN(4,myRsi,myRsj,ip,eleIdx,eleCfg,eleNum,eleProjCnt,buffer,bufferInt);
+  }
     
-    v += myValue;
+  /* Inter All */
+  for(idx=0;idx<NInterAll;idx++) {
+    myRsi[0] = InterAll[idx][0] + InterAll[idx][3]*Nsite;
+    myRsj[0] = InterAll[idx][2] + InterAll[idx][3]*Nsite;
+    myRsi[1] = InterAll[idx][4] + InterAll[idx][7]*Nsite;
+    myRsj[1] = InterAll[idx][6] + InterAll[idx][7]*Nsite;
+    myRsi[2] = rsi;
+    myRsj[2] = rsj;
+    myRsi[3] = rsk;
+    myRsj[3] = rsl;
+    val += ParaInterAll[idx]
+      * GreenFuncN(4,myRsi,myRsj,ip,eleIdx,eleCfg,eleNum,eleProjCnt,buffer,bufferInt);
   }
-  val += v;
-
-  ReleaseWorkSpaceInt();
-  ReleaseWorkSpaceComplex();
-  ReleaseWorkSpaceThreadInt();
-  ReleaseWorkSpaceThreadComplex();
 
   return val;
 }
 
+/* Serial CalculateHamiltonian with the given PfM and InvM */
+/* buffer size = NQPFull+2*Nsize, bufferInt size = NProj */
+double complex calculateHamiltonian_child(const double complex ip, int *eleIdx, const int *eleCfg,
+                                  int *eleNum, const int *eleProjCnt,
+                                  double complex *pfM, double complex *invM,
+                                  double complex *buffer, int *bufferInt) {
+  const int *n0 = eleNum;
+  const int *n1 = eleNum + Nsite;
+  double complex e=0.0, tmp;
+  int idx;
+  int ri,rj,s,rk,rl,t;
+
+  /* CoulombIntra */
+  for(idx=0;idx<NCoulombIntra;idx++) {
+    ri = CoulombIntra[idx];
+    e += ParaCoulombIntra[idx] * n0[ri] * n1[ri];
+  }
+
+  /* CoulombInter */
+  for(idx=0;idx<NCoulombInter;idx++) {
+    ri = CoulombInter[idx][0];
+    rj = CoulombInter[idx][1];
+    e += ParaCoulombInter[idx] * (n0[ri]+n1[ri]) * (n0[rj]+n1[rj]);
+  }
+
+  /* HundCoupling */
+  for(idx=0;idx<NHundCoupling;idx++) {
+    ri = HundCoupling[idx][0];
+    rj = HundCoupling[idx][1];
+    e -= ParaHundCoupling[idx] * (n0[ri]*n0[rj] + n1[ri]*n1[rj]);
+    /* Caution: negative sign */
+  }
+
+  /* Transfer */
+  for(idx=0;idx<NTransfer;idx++) {
+    ri = Transfer[idx][0];
+    rj = Transfer[idx][2];
+    s  = Transfer[idx][3];
+
+    e -= ParaTransfer[idx]
+      * greenFunc1_child(ri,rj,s,ip,eleIdx,eleCfg,eleNum,eleProjCnt,bufferInt,buffer,pfM,invM);
+    /* Caution: negative sign */
+  }
+
+  /* Pair Hopping */
+  for(idx=0;idx<NPairHopping;idx++) {
+    ri = PairHopping[idx][0];
+    rj = PairHopping[idx][1];
+
+    e += ParaPairHopping[idx]
+      * greenFunc2_child(ri,rj,ri,rj,0,1,ip,eleIdx,eleCfg,eleNum,eleProjCnt,bufferInt,buffer,pfM,invM);
+  }
+
+  /* Exchange Coupling */
+  for(idx=0;idx<NExchangeCoupling;idx++) {
+    ri = ExchangeCoupling[idx][0];
+    rj = ExchangeCoupling[idx][1];
+
+    tmp =  greenFunc2_child(ri,rj,rj,ri,0,1,ip,eleIdx,eleCfg,eleNum,eleProjCnt,bufferInt,buffer,pfM,invM);
+    tmp += greenFunc2_child(ri,rj,rj,ri,1,0,ip,eleIdx,eleCfg,eleNum,eleProjCnt,bufferInt,buffer,pfM,invM);
+    e += ParaExchangeCoupling[idx] * tmp;
+  }
+
+  /* Inter All */
+  for(idx=0;idx<NInterAll;idx++) {
+    ri = InterAll[idx][0];
+    rj = InterAll[idx][2];
+    s  = InterAll[idx][3];
+    rk = InterAll[idx][4];
+    rl = InterAll[idx][6];
+    t  = InterAll[idx][7];
+
+    e += ParaInterAll[idx]
+      * greenFunc2_child(ri,rj,rk,rl,s,t,ip,eleIdx,eleCfg,eleNum,eleProjCnt,bufferInt,buffer,pfM,invM);
+  }
+
+  return e;
+}
 
 /* copy invM and pfM */
 void copyMAll(complex double *invM_from, complex double *pfM_from, complex double *invM_to, complex double *pfM_to) {
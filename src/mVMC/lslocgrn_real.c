@@ -34,6 +34,7 @@ along with this program. If not, see http://www.gnu.org/licenses/.
 #include <complex.h>
 #include "global.h"
 #include "locgrn_real.h"
+#include "lslocgrn.h"
 #include "workspace.c"
 #include "calham_real.c"
 #include "pfupdate_real.c"
@@ -48,8 +49,12 @@ void LSLocalQ_real(const double h1, const double ip, int *eleIdx, int *eleCfg, i
 
   e0 = CalculateHamiltonian0_real(eleNum); /* V */
 
+  /* <psi|H CisAjs|x>/<psi|x> of the hoppings used in this sample */
+  MakeLSHop(eleNum);
+  calculateLSHop_real(ip,eleIdx,eleCfg,eleNum,eleProjCnt);
+
   h2 = h1*e0; /* HV = (V+K+W)V */
-  h2 += calculateHK_real(h1,ip,eleIdx,eleCfg,eleNum,eleProjCnt);
+  h2 += calculateHK_real(h1,eleNum);
   h2 += calculateHW_real(h1,ip,eleIdx,eleCfg,eleNum,eleProjCnt);
 
   /* calculate local Q (IQ) */
@@ -63,17 +68,66 @@ void LSLocalQ_real(const double h1, const double ip, int *eleIdx, int *eleCfg, i
   return;
 }
 
-///
-/// \param h1
+/// Calculate <psi|H CisAjs|x>/<psi|x> of all the hoppings in LSHop.
+/// Each thread keeps its own electron configuration, InvM_real and PfM_real.
 /// \param ip
 /// \param eleIdx
 /// \param eleCfg
 /// \param eleNum
 /// \param eleProjCnt
+/// \version 1.0
+void calculateLSHop_real(const double ip, int *eleIdx, int *eleCfg, int *eleNum, int *eleProjCnt) {
+  const int nsize=Nsize;
+  const int nsite2=Nsite2;
+  int idx,rsi,rsj;
+
+  int *myEleIdx, *myEleCfg, *myEleNum, *myBufferInt;
+  double *myInvM, *myPfM, *myBuffer;
+
+  if(NLSHop==0) return;
+
+  RequestWorkSpaceThreadInt(Nsize+2*Nsite2+2*NProj);
+  RequestWorkSpaceThreadDouble(NQPFull*(Nsize*Nsize+1)+NQPFull+4*Nsize);
+
+#pragma omp parallel default(shared)\
+  private(idx,rsi,rsj,myEleIdx,myEleCfg,myEleNum,myBufferInt,myInvM,myPfM,myBuffer)
+  {
+    myEleIdx = GetWorkSpaceThreadInt(Nsize);
+    myEleCfg = GetWorkSpaceThreadInt(Nsite2);
+    myEleNum = GetWorkSpaceThreadInt(Nsite2);
+    myBufferInt = GetWorkSpaceThreadInt(2*NProj);
+    myInvM = GetWorkSpaceThreadDouble(NQPFull*Nsize*Nsize);
+    myPfM = GetWorkSpaceThreadDouble(NQPFull);
+    myBuffer = GetWorkSpaceThreadDouble(NQPFull+4*Nsize);
+
+#pragma loop noalias
+    for(idx=0;idx<nsize;idx++) myEleIdx[idx] = eleIdx[idx];
+#pragma loop noalias
+    for(idx=0;idx<nsite2;idx++) myEleCfg[idx] = eleCfg[idx];
+#pragma loop noalias
+    for(idx=0;idx<nsite2;idx++) myEleNum[idx] = eleNum[idx];
+
+#pragma omp for schedule(dynamic)
+    for(idx=0;idx<NLSHop;idx++) {
+      rsi = LSHop[2*idx];
+      rsj = LSHop[2*idx+1];
+      LSHopVal_real[idx] = calHCA_child_real(rsi%Nsite,rsj%Nsite,rsi/Nsite,ip,
+                                             myEleIdx,myEleCfg,myEleNum,eleProjCnt,
+                                             myInvM,myPfM,myBuffer,myBufferInt);
+    }
+  }
+
+  ReleaseWorkSpaceThreadInt();
+  ReleaseWorkSpaceThreadDouble();
+  return;
+}
+
+///
+/// \param h1
+/// \param eleNum
 /// \return val
 /// \version 1.0
-double calculateHK_real(const double h1, const double ip, int *eleIdx, int *eleCfg,
-                           int *eleNum, int *eleProjCnt) {
+double calculateHK_real(const double h1, const int *eleNum) {
   int idx,ri,rj,s;
   double val=0.0;
 
@@ -82,32 +136,25 @@ double calculateHK_real(const double h1, const double ip, int *eleIdx, int *eleC
     rj = Transfer[idx][2];
     s  = Transfer[idx][3];
 
-    val -= creal(ParaTransfer[idx]) * calHCA_real(ri,rj,s,h1,ip,eleIdx,eleCfg,eleNum,eleProjCnt);
+    val -= creal(ParaTransfer[idx]) * calHCA_real(ri,rj,s,h1,eleNum);
     /* Caution: negative sign */
   }
 
   return val;
 }
 
-/// calculate <psi| H C_is A_js |x>/<psi|x>
+/// calculate <psi| H C_is A_js |x>/<psi|x> from the hoppings evaluated by calculateLSHop_real
 /// \param ri
 /// \param rj
 /// \param s
 /// \param h1
-/// \param ip
-/// \param eleIdx
-/// \param eleCfg
 /// \param eleNum
-/// \param eleProjCnt
 /// \return val
 /// \version 1.0
 double calHCA_real(const int ri, const int rj, const int s,
-                      const double h1, const double ip, int *eleIdx, int *eleCfg,
-                      int *eleNum, int *eleProjCnt) {
+                   const double h1, const int *eleNum) {
   int rsi=ri+s*Nsite;
   int rsj=rj+s*Nsite;
-  double val;
-  double g;
 
   /* check */
   if(rsi==rsj) {
@@ -118,11 +165,37 @@ double calHCA_real(const int ri, const int rj, const int s,
     if(eleNum[rsi]==1) return 0.0;
   }
 
+  return LSHopVal_real[LSHopIdx[rsi*Nsite+rj]];
+}
+
+/// calculate <psi| H C_is A_js |x>/<psi|x>
+/// Assuming ri!=rj, eleNum[rsi]=0, eleNum[rsj]=1
+/// buffer size = NQPFull+4*Nsize, bufferInt size = 2*NProj
+/// \param ri
+/// \param rj
+/// \param s
+/// \param ip
+/// \param eleIdx
+/// \param eleCfg
+/// \param eleNum
+/// \param eleProjCnt
+/// \param invM
+/// \param pfM
+/// \param buffer
+/// \param bufferInt
+/// \return val
+/// \version 1.0
+double calHCA_child_real(const int ri, const int rj, const int s,
+                         const double ip, int *eleIdx, int *eleCfg, int *eleNum, int *eleProjCnt,
+                         double *invM, double *pfM, double *buffer, int *bufferInt) {
+  double val;
+  double g;
+
   g = checkGF1_real(ri,rj,s,ip,eleIdx,eleCfg,eleNum);
   if(fabs(g)>1.0e-12) {
-    val = calHCA1_real(ri,rj,s,ip,eleIdx,eleCfg,eleNum,eleProjCnt);
+    val = calHCA1_real(ri,rj,s,ip,eleIdx,eleCfg,eleNum,eleProjCnt,invM,pfM,buffer,bufferInt);
   } else {
-    val = calHCA2_real(ri,rj,s,ip,eleIdx,eleCfg,eleNum,eleProjCnt);
+    val = calHCA2_real(ri,rj,s,ip,eleIdx,eleCfg,eleNum,eleProjCnt,buffer,bufferInt);
   }
 
   return val;
@@ -167,6 +240,7 @@ double checkGF1_real(const int ri, const int rj, const int s, const double ip,
 }
 
 /// calculate <psi| H C_is A_js |x>/<psi|x> = <psi|x'>/<psi|x> * <psi|H|x'>/<psi|x'>
+/// InvM and PfM of x' are made in invM and pfM, and are used for all the terms of H.
 /// \param ri
 /// \param rj
 /// \param s
@@ -175,29 +249,24 @@ double checkGF1_real(const int ri, const int rj, const int s, const double ip,
 /// \param eleCfg
 /// \param eleNum
 /// \param eleProjCnt
+/// \param invM
+/// \param pfM
+/// \param buffer
+/// \param bufferInt
 /// \return
 /// \version 1.0
 double calHCA1_real(const int ri, const int rj, const int s,
                const double ip, int *eleIdx, int *eleCfg,
-               int *eleNum, int *eleProjCnt) {
-  double *oldInvM; /* [NQPFull*Nsize*Nsize;] */
-  double *oldPfM;  /* [NQPFull] */
-  int *projCntNew;
-
+               int *eleNum, int *eleProjCnt,
+               double *invM, double *pfM, double *buffer, int *bufferInt) {
+  int *projCntNew = bufferInt; /* [NProj] */
   int rsi=ri+s*Nsite;
   int rsj=rj+s*Nsite;
-  int mj;
+  int mj,qpidx;
   double ipNew,z,e;
 
-  RequestWorkSpaceInt(NProj);
-  RequestWorkSpaceDouble(NQPFull*(Nsize*Nsize+1));
-
-  projCntNew = GetWorkSpaceInt(NProj);
-  oldInvM = GetWorkSpaceDouble(NQPFull*Nsize*Nsize);
-  oldPfM  = GetWorkSpaceDouble(NQPFull);
-
   /* copy InvM and PfM */
-  copyMAll_real(InvM_real,PfM_real,oldInvM,oldPfM);
+  copyMAll_real(InvM_real,PfM_real,invM,pfM);
 
   /* The mj-th electron with spin s hops to site ri */
   mj = eleCfg[rsj];
@@ -210,10 +279,13 @@ double calHCA1_real(const int ri, const int rj, const int s,
   UpdateProjCnt(rj, ri, s, projCntNew, eleProjCnt, eleNum);
   z = ProjRatio(projCntNew,eleProjCnt);
 
-  UpdateMAll_real(mj,s,eleIdx,0,NQPFull);
-  ipNew = CalculateIP_real(PfM_real,0,NQPFull,MPI_COMM_SELF);
+  for(qpidx=0;qpidx<NQPFull;qpidx++) {
+    updateMAll_child_real(mj, s, eleIdx, 0, NQPFull, qpidx, buffer, buffer+Nsize, pfM, invM);
+  }
+  ipNew = CalculateIP_real(pfM,0,NQPFull,MPI_COMM_SELF);
 
-  e = CalculateHamiltonian_real(ipNew,eleIdx,eleCfg,eleNum,projCntNew);
+  e = calculateHamiltonian_child_real(ipNew,eleIdx,eleCfg,eleNum,projCntNew,
+                                      pfM,invM,buffer,bufferInt+NProj);
 
   /* revert hopping */
   eleIdx[mj+s*Ne] = rj;
@@ -222,11 +294,6 @@ double calHCA1_real(const int ri, const int rj, const int s,
   eleNum[rsj] = 1;
   eleNum[rsi] = 0;
 
-  /* restore InvM and PfM */
-  copyMAll_real(oldInvM,oldPfM,InvM_real,PfM_real);
-
-  ReleaseWorkSpaceInt();
-  ReleaseWorkSpaceDouble();
   return e*z*ipNew/ip;
 }
 
@@ -234,38 +301,17 @@ double calHCA1_real(const int ri, const int rj, const int s,
 /* Assuming ri!=rj, eleNum[rsi]=1, eleNum[rsj]=0 */
 double calHCA2_real(const int ri, const int rj, const int s,
                        const double ip, int *eleIdx, int *eleCfg,
-                       int *eleNum, int *eleProjCnt) {
-  const int nsize=Nsize;
-  const int nsite2=Nsite2;
-
+                       int *eleNum, int *eleProjCnt,
+                       double *buffer, int *bufferInt) {
   int idx;
   int rk,rl,sk;
-  //    double complex val=0.0;
   double val=0.0;
   int rsi = ri+s*Nsite;
   int rsj = rj+s*Nsite;
+  int myRsi[3], myRsj[3];
 
   double g;
 
-  double *buffer;
-  int *bufferInt;
-
-  int *myEleIdx, *myEleNum, *myBufferInt, *myRsi, *myRsj;
-  double *myBuffer;
-  //    double complex myValue=0;
-  //    double complex v=0.0;
-  double myValue=0;
-  double v=0.0;
-
-
-  RequestWorkSpaceInt(NProj);      /* for GreenFunc1 */
-  RequestWorkSpaceDouble(NQPFull); /* for GreenFunc1 */
-  RequestWorkSpaceThreadInt(Nsize+Nsite2+NProj+6);
-  RequestWorkSpaceThreadDouble(NQPFull+3*Nsize);
-
-  bufferInt = GetWorkSpaceInt(NProj);
-  buffer = GetWorkSpaceDouble(NQPFull);
-
   /* H0 term */
   /* <psi|H0 CA|x>/<psi|x> = H0(x') <psi|CA|x>/<psi|x> */
   g = GreenFunc1_real(ri,rj,s,ip,eleIdx,eleCfg,eleNum,eleProjCnt,bufferInt,buffer);
@@ -282,102 +328,70 @@ double calHCA2_real(const int ri, const int rj, const int s,
 
   /* end of H0 term */
 
-#pragma omp parallel default(shared)\
-  private(myEleIdx,myEleNum,myBufferInt,myBuffer,myValue,myRsi,myRsj)  \
-  reduction(+:v)
-  {
-    myEleIdx = GetWorkSpaceThreadInt(Nsize);
-    myEleNum = GetWorkSpaceThreadInt(Nsite2);
-    myBufferInt = GetWorkSpaceThreadInt(NProj);
-    myRsi = GetWorkSpaceThreadInt(3);
-    myRsj = GetWorkSpaceThreadInt(3);
-    myBuffer = GetWorkSpaceThreadDouble(NQPFull+3*Nsize);
-
-#pragma loop noalias
-    for(idx=0;idx<nsize;idx++) myEleIdx[idx] = eleIdx[idx];
-#pragma loop noalias
-    for(idx=0;idx<nsite2;idx++) myEleNum[idx] = eleNum[idx];
-
-    myValue = 0.0;
-
-    /* Transfer */
-#pragma omp for private(idx,rk,rl,sk) schedule(dynamic) nowait
-    for(idx=0;idx<NTransfer;idx++) {
-      rk = Transfer[idx][0];
-      rl = Transfer[idx][2];
-      sk = Transfer[idx][3];
-
-      myValue -= creal(ParaTransfer[idx])
-                       * GreenFunc2_real(rk,rl,ri,rj,sk,s,ip,myEleIdx,eleCfg,myEleNum,eleProjCnt,myBufferInt,myBuffer);
-      /* Caution: negative sign */
-    }
-
-    /* Pair Hopping */
-#pragma omp for private(idx,rk,rl) schedule(dynamic) nowait
-    for(idx=0;idx<NPairHopping;idx++) {
-      rk = PairHopping[idx][0];
-      rl = PairHopping[idx][1];
-      myRsi[0] = rk; /* s=0 */
-      myRsj[0] = rl; /* s=0 */
-      myRsi[1] = rk+Nsite; /* s=1 */
-      myRsj[1] = rl+Nsite; /* s=1 */
-      myRsi[2] = rsi;
-      myRsj[2] = rsj;
+  /* Transfer */
+  for(idx=0;idx<NTransfer;idx++) {
+    rk = Transfer[idx][0];
+    rl = Transfer[idx][2];
+    sk = Transfer[idx][3];
 
-      myValue += ParaPairHopping[idx]
-        * GreenFuncN_real(3,myRsi,myRsj,ip,myEleIdx,eleCfg,myEleNum,eleProjCnt,myBuffer,myBufferInt);
-    }
+    val -= creal(ParaTransfer[idx])
+      * GreenFunc2_real(rk,rl,ri,rj,sk,s,ip,eleIdx,eleCfg,eleNum,eleProjCnt,bufferInt,buffer);
+    /* Caution: negative sign */
+  }
 
-    /* Exchange Coupling */
-#pragma omp for private(idx,rk,rl) schedule(dynamic) nowait
-    for(idx=0;idx<NExchangeCoupling;idx++) {
-      rk = ExchangeCoupling[idx][0];
-      rl = ExchangeCoupling[idx][1];
-      myRsi[0] = rk; /* s=0 */
-      myRsj[0] = rl; /* s=0 */
-      myRsi[1] = rl+Nsite; /* s=1 */
-      myRsj[1] = rk+Nsite; /* s=1 */
-      myRsi[2] = rsi;
-      myRsj[2] = rsj;
-      myValue += ParaExchangeCoupling[idx]
-        * GreenFuncN_real(3,myRsi,myRsj,ip,myEleIdx,eleCfg,myEleNum,eleProjCnt,myBuffer,myBufferInt);
-
-      myRsi[0] = rk+Nsite; /* s=1 */
-      myRsj[0] = rl+Nsite; /* s=1 */
-      myRsi[1] = rl; /* s=0 */
-      myRsj[1] = rk; /* s=0 */
-      myRsi[2] = rsi;
-      myRsj[2] = rsj;
-      myValue += ParaExchangeCoupling[idx]
-        * GreenFuncN_real(3,myRsi,myRsj,ip,myEleIdx,eleCfg,myEleNum,eleProjCnt,myBuffer,myBufferInt);
-    }
+  /* Pair Hopping */
+  for(idx=0;idx<NPairHopping;idx++) {
+    rk = PairHopping[idx][0];
+    rl = PairHopping[idx][1];
+    myRsi[0] = rk; /* s=0 */
+    myRsj[0] = rl; /* s=0 */
+    myRsi[1] = rk+Nsite; /* s=1 */
+    myRsj[1] = rl+Nsite; /* s=1 */
+    myRsi[2] = rsi;
+    myRsj[2] = rsj;
 
-    /* Inter All */
-#pragma omp for private(idx) schedule(dynamic) nowait
-    for(idx=0;idx<NInterAll;idx++) {
-      myRsi[0] = InterAll[idx][0] + InterAll[idx][3]*Nsite;
-      myRsj[0] = InterAll[idx][2] + InterAll[idx][3]*Nsite;
-      myRsi[1] = InterAll[idx][4] + InterAll[idx][7]*Nsite;
-      myRsj[1] = InterAll[idx][6] + InterAll[idx][7]*Nsite;
-      myRsi[2] = rsi;
-      myRsj[2] = rsj;
-      myValue += creal(ParaInterAll[idx])
-        * GreenFuncN_real(3,myRsi,myRsj,ip,myEleIdx,eleCfg,myEleNum,eleProjCnt,myBuffer,myBufferInt);
-    }
+    val += ParaPairHopping[idx]
+      * GreenFuncN_real(3,myRsi,myRsj,ip,eleIdx,eleCfg,eleNum,eleProjCnt,buffer,bufferInt);
+  }
 
-    v += myValue;
+  /* Exchange Coupling */
+  for(idx=0;idx<NExchangeCoupling;idx++) {
+    rk = ExchangeCoupling[idx][0];
+    rl = ExchangeCoupling[idx][1];
+    myRsi[0] = rk; /* s=0 */
+    myRsj[0] = rl; /* s=0 */
+    myRsi[1] = rl+Nsite; /* s=1 */
+    myRsj[1] = rk+Nsite; /* s=1 */
+    myRsi[2] = rsi;
+    myRsj[2] = rsj;
+    val += ParaExchangeCoupling[idx]
+      * GreenFuncN_real(3,myRsi,myRsj,ip,eleIdx,eleCfg,eleNum,eleProjCnt,buffer,bufferInt);
+
+    myRsi[0] = rk+Nsite; /* s=1 */
+    myRsj[0] = rl+Nsite; /* s=1 */
+    myRsi[1] = rl; /* s=0 */
+    myRsj[1] = rk; /* s=0 */
+    myRsi[2] = rsi;
+    myRsj[2] = rsj;
+    val += ParaExchangeCoupling[idx]
+      * GreenFuncN_real(3,myRsi,myRsj,ip,eleIdx,eleCfg,eleNum,eleProjCnt,buffer,bufferInt);
   }
-  val += v;
 
-  ReleaseWorkSpaceInt();
-  ReleaseWorkSpaceDouble();
-  ReleaseWorkSpaceThreadInt();
-  ReleaseWorkSpaceThreadDouble();
+  /* Inter All */
+  for(idx=0;idx<NInterAll;idx++) {
+    myRsi[0] = InterAll[idx][0] + InterAll[idx][3]*Nsite;
+    myRsj[0] = InterAll[idx][2] + InterAll[idx][3]*Nsite;
+    myRsi[1] = InterAll[idx][4] + InterAll[idx][7]*Nsite;
+    myRsj[1] = InterAll[idx][6] + InterAll[idx][7]*Nsite;
+    myRsi[2] = rsi;
+    myRsj[2] = rsj;
+    val += creal(ParaInterAll[idx])
+      * GreenFuncN_real(3,myRsi,myRsj,ip,eleIdx,eleCfg,eleNum,eleProjCnt,buffer,bufferInt);
+  }
 
   return val;
 }
 
-
 /* copy invM and pfM */
 void copyMAll_real(double *invM_from, double *pfM_from, double *invM_to, double *pfM_to) {
   int i,n;
@@ -395,108 +409,129 @@ void copyMAll_real(double *invM_from, double *pfM_from, double *invM_to, double
 
 double calculateHW_real(const double h1, const double ip, int *eleIdx, int *eleCfg,
                            int *eleNum, int *eleProjCnt) {
+  const int nsize=Nsize;
+  const int nsite2=Nsite2;
   int idx,ri,rj,s,rk,rl,t;
   double val=0.0,tmp;
 
-  /* Pair Hopping */
-  for(idx=0;idx<NPairHopping;idx++) {
-    ri = PairHopping[idx][0];
-    rj = PairHopping[idx][1];
+  int *myEleIdx, *myEleCfg, *myEleNum, *myBufferInt;
+  double *myInvM, *myPfM, *myBuffer;
+  double myValue;
 
-    val += ParaPairHopping[idx]
-      * calHCACA_real(ri,rj,ri,rj,0,1,h1,ip,eleIdx,eleCfg,eleNum,eleProjCnt);
-  }
+  if(NPairHopping+NExchangeCoupling+NInterAll==0) return 0.0;
 
-  /* Exchange Coupling */
-  for(idx=0;idx<NExchangeCoupling;idx++) {
-    ri = ExchangeCoupling[idx][0];
-    rj = ExchangeCoupling[idx][1];
+  RequestWorkSpaceThreadInt(Nsize+2*Nsite2+2*NProj);
+  RequestWorkSpaceThreadDouble(NQPFull*(Nsize*Nsize+1)+NQPFull+4*Nsize);
 
-    tmp =  calHCACA_real(ri,rj,rj,ri,0,1,h1,ip,eleIdx,eleCfg,eleNum,eleProjCnt);
-    tmp += calHCACA_real(ri,rj,rj,ri,1,0,h1,ip,eleIdx,eleCfg,eleNum,eleProjCnt);
-    val += ParaExchangeCoupling[idx] * tmp;
-  }
+#pragma omp parallel default(shared)\
+  private(idx,ri,rj,s,rk,rl,t,tmp,myEleIdx,myEleCfg,myEleNum,myBufferInt,myInvM,myPfM,myBuffer,myValue) \
+  reduction(+:val)
+  {
+    myEleIdx = GetWorkSpaceThreadInt(Nsize);
+    myEleCfg = GetWorkSpaceThreadInt(Nsite2);
+    myEleNum = GetWorkSpaceThreadInt(Nsite2);
+    myBufferInt = GetWorkSpaceThreadInt(2*NProj);
+    myInvM = GetWorkSpaceThreadDouble(NQPFull*Nsize*Nsize);
+    myPfM = GetWorkSpaceThreadDouble(NQPFull);
+    myBuffer = GetWorkSpaceThreadDouble(NQPFull+4*Nsize);
 
-  /* Inter All */
-  for(idx=0;idx<NInterAll;idx++) {
-    ri = InterAll[idx][0];
-    rj = InterAll[idx][2];
-    s  = InterAll[idx][3];
-    rk = InterAll[idx][4];
-    rl = InterAll[idx][6];
-    t  = InterAll[idx][7];
+#pragma loop noalias
+    for(idx=0;idx<nsize;idx++) myEleIdx[idx] = eleIdx[idx];
+#pragma loop noalias
+    for(idx=0;idx<nsite2;idx++) myEleCfg[idx] = eleCfg[idx];
+#pragma loop noalias
+    for(idx=0;idx<nsite2;idx++) myEleNum[idx] = eleNum[idx];
 
-    val += creal(ParaInterAll[idx])
-      * calHCACA_real(ri,rj,rk,rl,s,t,h1,ip,eleIdx,eleCfg,eleNum,eleProjCnt);
+    myValue = 0.0;
+
+    /* Pair Hopping */
+#pragma omp for schedule(dynamic) nowait
+    for(idx=0;idx<NPairHopping;idx++) {
+      ri = PairHopping[idx][0];
+      rj = PairHopping[idx][1];
+
+      myValue += ParaPairHopping[idx]
+        * calHCACA_real(ri,rj,ri,rj,0,1,h1,ip,myEleIdx,myEleCfg,myEleNum,eleProjCnt,
+                        myInvM,myPfM,myBuffer,myBufferInt);
+    }
+
+    /* Exchange Coupling */
+#pragma omp for schedule(dynamic) nowait
+    for(idx=0;idx<NExchangeCoupling;idx++) {
+      ri = ExchangeCoupling[idx][0];
+      rj = ExchangeCoupling[idx][1];
+
+      tmp =  calHCACA_real(ri,rj,rj,ri,0,1,h1,ip,myEleIdx,myEleCfg,myEleNum,eleProjCnt,
+                           myInvM,myPfM,myBuffer,myBufferInt);
+      tmp += calHCACA_real(ri,rj,rj,ri,1,0,h1,ip,myEleIdx,myEleCfg,myEleNum,eleProjCnt,
+                           myInvM,myPfM,myBuffer,myBufferInt);
+      myValue += ParaExchangeCoupling[idx] * tmp;
+    }
+
+    /* Inter All */
+#pragma omp for schedule(dynamic) nowait
+    for(idx=0;idx<NInterAll;idx++) {
+      ri = InterAll[idx][0];
+      rj = InterAll[idx][2];
+      s  = InterAll[idx][3];
+      rk = InterAll[idx][4];
+      rl = InterAll[idx][6];
+      t  = InterAll[idx][7];
+
+      myValue += creal(ParaInterAll[idx])
+        * calHCACA_real(ri,rj,rk,rl,s,t,h1,ip,myEleIdx,myEleCfg,myEleNum,eleProjCnt,
+                        myInvM,myPfM,myBuffer,myBufferInt);
+    }
+
+    val += myValue;
   }
 
+  ReleaseWorkSpaceThreadInt();
+  ReleaseWorkSpaceThreadDouble();
   return val;
 }
 
 
+/* calculate <psi| H C_is A_js C_kt A_lt |x>/<psi|x> */
+/* The terms reduced to one hopping are read from LSHopVal_real. */
 double calHCACA_real(const int ri, const int rj, const int rk, const int rl,
                         const int si,const int sk,
                         const double h1, const double ip, int *eleIdx, int *eleCfg,
-                        int *eleNum, int *eleProjCnt) {
-  int rsi=ri+si*Nsite;
-  int rsj=rj+si*Nsite;
-  int rsk=rk+sk*Nsite;
-  int rsl=rl+sk*Nsite;
-
+                        int *eleNum, int *eleProjCnt,
+                        double *invM, double *pfM, double *buffer, int *bufferInt) {
   double val;
   double g;
+  int hop[3],sgn;
 
   /* check */
-  if(rsk==rsl) {
-    if(eleNum[rsk]==1) {
-      return calHCA_real(ri,rj,si,h1,ip,eleIdx,eleCfg,eleNum,eleProjCnt);
-    } else return 0;
-  } else if(rsj==rsk) {
-    if(eleNum[rsj]==1) return 0;
-    else {
-      return calHCA_real(ri,rl,si,h1,ip,eleIdx,eleCfg,eleNum,eleProjCnt);
-    }
-  } else if(rsj==rsl) {
-    return 0;
-  } else if(rsi==rsj) {
-    if(eleNum[rsi]==1) {
-      return calHCA_real(rk,rl,sk,h1,ip,eleIdx,eleCfg,eleNum,eleProjCnt);
-    } else return 0;
-  } else if(rsi==rsk) {
-    return 0;
-  } else if(rsi==rsl) {
-    if(eleNum[rsi]==1) {
-      return -calHCA_real(rk,rj,sk,h1,ip,eleIdx,eleCfg,eleNum,eleProjCnt);
-    } else return 0;
-  } else {
-    if(eleNum[rsl]==0) return 0.0;
-    if(eleNum[rsk]==1) return 0.0;
-    if(eleNum[rsj]==0) return 0.0;
-    if(eleNum[rsi]==1) return 0.0;
+  switch(ReduceHCACA(ri,rj,rk,rl,si,sk,eleNum,hop,&sgn)) {
+  case 0:
+    return 0.0;
+  case 1:
+    return sgn*calHCA_real(hop[0],hop[1],hop[2],h1,eleNum);
+  default:
+    break;
   }
 
-  g = checkGF2_real(ri,rj,rk,rl,si,sk,ip,eleIdx,eleCfg,eleNum);
+  g = checkGF2_real(ri,rj,rk,rl,si,sk,ip,eleIdx,eleCfg,eleNum,buffer);
   if(fabs(g)>1.0e-12) {
-    val = calHCACA1_real(ri,rj,rk,rl,si,sk,ip,eleIdx,eleCfg,eleNum,eleProjCnt);
+    val = calHCACA1_real(ri,rj,rk,rl,si,sk,ip,eleIdx,eleCfg,eleNum,eleProjCnt,invM,pfM,buffer,bufferInt);
   } else {
-    val = calHCACA2_real(ri,rj,rk,rl,si,sk,ip,eleIdx,eleCfg,eleNum,eleProjCnt);
+    val = calHCACA2_real(ri,rj,rk,rl,si,sk,ip,eleIdx,eleCfg,eleNum,eleProjCnt,buffer,bufferInt);
   }
 
   return val;
 }
 
+/* buffer size = NQPFull+2*Nsize */
 double checkGF2_real(const int ri, const int rj, const int rk, const int rl,
                 const int s, const int t, const double ip,
-                int *eleIdx, const int *eleCfg, int *eleNum) {
+                int *eleIdx, const int *eleCfg, int *eleNum, double *buffer) {
   double z;
   int mj,msj,ml,mtl;
   int rsi,rsj,rtk,rtl;
-  double *pfMNew;
-  double *buffer;
-
-  RequestWorkSpaceDouble(NQPFull+2*Nsize);
-  pfMNew = GetWorkSpaceDouble(NQPFull);
-  buffer = GetWorkSpaceDouble(2*Nsize);
+  double *pfMNew = buffer; /* [NQPFull] */
+  double *bufV = buffer+NQPFull; /* [2*Nsize] */
 
   rsi = ri + s*Nsite;
   rsj = rj + s*Nsite;
@@ -518,7 +553,7 @@ double checkGF2_real(const int ri, const int rj, const int rk, const int rl,
   eleNum[rsi] = 1;
 
   /* calculate Pfaffian */
-  CalculateNewPfMTwo_real(ml, t, mj, s, pfMNew, eleIdx, 0, NQPFull, buffer);
+  CalculateNewPfMTwo_real(ml, t, mj, s, pfMNew, eleIdx, 0, NQPFull, bufV);
   z = CalculateIP_real(pfMNew, 0, NQPFull, MPI_COMM_SELF);
 
   /* revert hopping */
@@ -529,34 +564,25 @@ double checkGF2_real(const int ri, const int rj, const int rk, const int rl,
   eleNum[rsj] = 1;
   eleNum[rsi] = 0;
 
-  ReleaseWorkSpaceDouble();
   return z/ip;
 }
 
+/* InvM and PfM after the two hoppings are made in invM and pfM. */
 double calHCACA1_real(const int ri, const int rj, const int rk, const int rl,
                  const int si,const int sk,
                  const double ip, int *eleIdx, int *eleCfg,
-                 int *eleNum, int *eleProjCnt) {
-  double *oldInvM; /* [NQPFull*Nsize*Nsize;] */
-  double *oldPfM;  /* [NQPFull] */
-  int *projCntNew;
-
+                 int *eleNum, int *eleProjCnt,
+                 double *invM, double *pfM, double *buffer, int *bufferInt) {
+  int *projCntNew = bufferInt; /* [NProj] */
   int rsi=ri+si*Nsite;
   int rsj=rj+si*Nsite;
   int rsk=rk+sk*Nsite;
   int rsl=rl+sk*Nsite;
-  int mj,ml;
+  int mj,ml,qpidx;
   double ipNew,z,e;
 
-  RequestWorkSpaceInt(NProj);
-  RequestWorkSpaceDouble(NQPFull*(Nsize*Nsize+1));
-
-  projCntNew = GetWorkSpaceInt(NProj);
-  oldInvM = GetWorkSpaceDouble(NQPFull*Nsize*Nsize);
-  oldPfM  = GetWorkSpaceDouble(NQPFull);
-
   /* copy InvM and PfM */
-  copyMAll_real(InvM_real,PfM_real,oldInvM,oldPfM);
+  copyMAll_real(InvM_real,PfM_real,invM,pfM);
 
   /* The ml-th electron with spin sk hops from rl to rk */
   ml = eleCfg[rsl];
@@ -578,10 +604,14 @@ double calHCACA1_real(const int ri, const int rj, const int rk, const int rl,
 
   z = ProjRatio(projCntNew,eleProjCnt);
 
-  UpdateMAllTwo_real(ml, sk, mj, si, rl, rj, eleIdx, 0, NQPFull);
-  ipNew = CalculateIP_real(PfM_real,0,NQPFull,MPI_COMM_SELF);
+  for(qpidx=0;qpidx<NQPFull;qpidx++) {
+    updateMAllTwo_child_real(ml, sk, mj, si, rl, rj, eleIdx, 0, NQPFull, qpidx,
+                             buffer, buffer+Nsize, buffer+2*Nsize, buffer+3*Nsize, pfM, invM);
+  }
+  ipNew = CalculateIP_real(pfM,0,NQPFull,MPI_COMM_SELF);
 
-  e = CalculateHamiltonian_real(ipNew,eleIdx,eleCfg,eleNum,projCntNew);
+  e = calculateHamiltonian_child_real(ipNew,eleIdx,eleCfg,eleNum,projCntNew,
+                                      pfM,invM,buffer,bufferInt+NProj);
 
   /* revert hopping */
   eleIdx[mj+si*Ne] = rj;
@@ -596,11 +626,6 @@ double calHCACA1_real(const int ri, const int rj, const int rk, const int rl,
   eleNum[rsl] = 1;
   eleNum[rsk] = 0;
 
-  /* restore InvM and PfM */
-  copyMAll_real(oldInvM,oldPfM,InvM_real,PfM_real);
-
-  ReleaseWorkSpaceInt();
-  ReleaseWorkSpaceDouble();
   return e*z*ipNew/ip;
 }
 
@@ -608,10 +633,8 @@ double calHCACA1_real(const int ri, const int rj, const int rk, const int rl,
 /* Assuming ri,rj,rk,rl are different, eleNum[rsi]=1, eleNum[rsj]=0, eleNum[rsk]=1, eleNum[rsl]=0  */
 double calHCACA2_real(const int ri, const int rj, const int rk, const int rl,
                          const int si,const int sk,
-                         const double ip, int *eleIdx, int *eleCfg, int *eleNum, int *eleProjCnt) {
-  const int nsize=Nsize;
-  const int nsite2=Nsite2;
-
+                         const double ip, int *eleIdx, int *eleCfg, int *eleNum, int *eleProjCnt,
+                         double *buffer, int *bufferInt) {
   const int rsi = ri+si*Nsite;
   const int rsj = rj+si*Nsite;
   const int rsk = rk+sk*Nsite;
@@ -619,25 +642,10 @@ double calHCACA2_real(const int ri, const int rj, const int rk, const int rl,
 
   int idx,r0,r1;
   double val=0.0;
+  int myRsi[4], myRsj[4];
 
   double g;
 
-  double *buffer;
-  int *bufferInt;
-
-  int *myEleIdx, *myEleNum, *myBufferInt, *myRsi, *myRsj;
-  double *myBuffer;
-  double myValue=0.0;
-  double v=0.0;
-
-  RequestWorkSpaceInt(NProj);      /* for GreenFunc2 */
-  RequestWorkSpaceDouble(NQPFull+2*Nsize); /* for GreenFunc2 */
-  RequestWorkSpaceThreadInt(Nsize+Nsite2+NProj+8);
-  RequestWorkSpaceThreadDouble(NQPFull+3*Nsize);
-
-  bufferInt = GetWorkSpaceInt(NProj);
-  buffer = GetWorkSpaceDouble(NQPFull+2*Nsize);
-
   /* H0 term */
   /* <psi|H0 CACA|x>/<psi|x> = H0(x') <psi|CACA|x>/<psi|x> */
   g = GreenFunc2_real(ri,rj,rk,rl,si,sk,ip,
@@ -659,114 +667,162 @@ double calHCACA2_real(const int ri, const int rj, const int rk, const int rl,
 
   /* end of H0 term */
 
-#pragma omp parallel default(shared)\
-  private(myEleIdx,myEleNum,myBufferInt,myBuffer,myValue,myRsi,myRsj)  \
-  reduction(+:v)
-  {
-    myEleIdx = GetWorkSpaceThreadInt(Nsize);
-    myEleNum = GetWorkSpaceThreadInt(Nsite2);
-    myBufferInt = GetWorkSpaceThreadInt(NProj);
-    myRsi = GetWorkSpaceThreadInt(4);
-    myRsj = GetWorkSpaceThreadInt(4);
-    myBuffer = GetWorkSpaceThreadDouble(NQPFull+4*Nsize);
+  /* Transfer */
+  for(idx=0;idx<NTransfer;idx++) {
+    myRsi[0] = Transfer[idx][0]+Transfer[idx][1]*Nsite;
+    myRsj[0] = Transfer[idx][2]+Transfer[idx][3]*Nsite;
+    myRsi[1] = rsi;
+    myRsj[1] = rsj;
+    myRsi[2] = rsk;
+    myRsj[2] = rsl;
+
+    val -= creal(ParaTransfer[idx])
+      * GreenFuncN_real(3,myRsi,myRsj,ip,eleIdx,eleCfg,eleNum,eleProjCnt,buffer,bufferInt);
+    /* Caution: negative sign */
+  }
 
-#pragma loop noalias
-    for(idx=0;idx<nsize;idx++) myEleIdx[idx] = eleIdx[idx];
-#pragma loop noalias
-    for(idx=0;idx<nsite2;idx++) myEleNum[idx] = eleNum[idx];
+  /* Pair Hopping */
+  for(idx=0;idx<NPairHopping;idx++) {
+    r0 = PairHopping[idx][0];
+    r1 = PairHopping[idx][1];
+    myRsi[0] = r0; /* s=0 */
+    myRsj[0] = r1; /* s=0 */
+    myRsi[1] = r0+Nsite; /* s=1 */
+    myRsj[1] = r1+Nsite; /* s=1 */
+    myRsi[2] = rsi;
+    myRsj[2] = rsj;
+    myRsi[3] = rsk;
+    myRsj[3] = rsl;
 
-    myValue = 0.0;
+    val += ParaPairHopping[idx]
+      * GreenFuncN_real(4,myRsi,myRsj,ip,eleIdx,eleCfg,eleNum,eleProjCnt,buffer,bufferInt);
+  }
 
-    /* Transfer */
-#pragma omp for private(idx) schedule(dynamic) nowait
-    for(idx=0;idx<NTransfer;idx++) {
-      myRsi[0] = Transfer[idx][0]+Transfer[idx][1]*Nsite;
-      myRsj[0] = Transfer[idx][2]+Transfer[idx][3]*Nsite;
-      myRsi[1] = rsi;
-      myRsj[1] = rsj;
-      myRsi[2] = rsk;
-      myRsj[2] = rsl;
-
-      myValue -= creal(ParaTransfer[idx])
-        * GreenFuncN_real(3,myRsi,myRsj,ip,myEleIdx,eleCfg,myEleNum,eleProjCnt,myBuffer,myBufferInt);
-      /* Caution: negative sign */
-    }
+  /* Exchange Coupling */
+  for(idx=0;idx<NExchangeCoupling;idx++) {
+    r0 = ExchangeCoupling[idx][0];
+    r1 = ExchangeCoupling[idx][1];
+    myRsi[0] = r0; /* s=0 */
+    myRsj[0] = r1; /* s=0 */
+    myRsi[1] = r1+Nsite; /* s=1 */
+    myRsj[1] = r0+Nsite; /* s=1 */
+    myRsi[2] = rsi;
+    myRsj[2] = rsj;
+    myRsi[3] = rsk;
+    myRsj[3] = rsl;
+    val += ParaExchangeCoupling[idx]
+      * GreenFuncN_real(4,myRsi,myRsj,ip,eleIdx,eleCfg,eleNum,eleProjCnt,buffer,bufferInt);
+
+    myRsi[0] = r0+Nsite; /* s=1 */
+    myRsj[0] = r1+Nsite; /* s=1 */
+    myRsi[1] = r1; /* s=0 */
+    myRsj[1] = r0; /* s=0 */
+    myRsi[2] = rsi;
+    myRsj[2] = rsj;
+    myRsi[3] = rsk;
+    myRsj[3] = rsl;
+    val += ParaExchangeCoupling[idx]
+      * GreenFuncN_real(4,myRsi,myRsj,ip,eleIdx,eleCfg,eleNum,eleProjCnt,buffer,bufferInt);
+  }
 
-    /* Pair Hopping */
-#pragma omp for private(idx,r0,r1) schedule(dynamic) nowait
-    for(idx=0;idx<NPairHopping;idx++) {
-      r0 = PairHopping[idx][0];
-      r1 = PairHopping[idx][1];
-      myRsi[0] = r0; /* s=0 */
-      myRsj[0] = r1; /* s=0 */
-      myRsi[1] = r0+Nsite; /* s=1 */
-      myRsj[1] = r1+Nsite; /* s=1 */
-      myRsi[2] = rsi;
-      myRsj[2] = rsj;
-      myRsi[3] = rsk;
-      myRsj[3] = rsl;
+  /* Inter All */
+  for(idx=0;idx<NInterAll;idx++) {
+    myRsi[0] = InterAll[idx][0] + InterAll[idx][3]*Nsite;
+    myRsj[0] = InterAll[idx][2] + InterAll[idx][3]*Nsite;
+    myRsi[1] = InterAll[idx][4] + InterAll[idx][7]*Nsite;
+    myRsj[1] = InterAll[idx][6] + InterAll[idx][7]*Nsite;
+    myRsi[2] = rsi;
+    myRsj[2] = rsj;
+    myRsi[3] = rsk;
+    myRsj[3] = rsl;
+    val += creal(ParaInterAll[idx])
+      * GreenFuncN_real(4,myRsi,myRsj,ip,eleIdx,eleCfg,eleNum,eleProjCnt,buffer,bufferInt);
+  }
 
-      myValue += ParaPairHopping[idx]
-        * GreenFuncN_real(4,myRsi,myRsj,ip,myEleIdx,eleCfg,myEleNum,eleProjCnt,myBuffer,myBufferInt);
-    }
+  return val;
+}
 
-    /* Exchange Coupling */
-#pragma omp for private(idx,r0,r1) schedule(dynamic) nowait
-    for(idx=0;idx<NExchangeCoupling;idx++) {
-      r0 = ExchangeCoupling[idx][0];
-      r1 = ExchangeCoupling[idx][1];
-      myRsi[0] = r0; /* s=0 */
-      myRsj[0] = r1; /* s=0 */
-      myRsi[1] = r1+Nsite; /* s=1 */
-      myRsj[1] = r0+Nsite; /* s=1 */
-      myRsi[2] = rsi;
-      myRsj[2] = rsj;
-      myRsi[3] = rsk;
-      myRsj[3] = rsl;
-      myValue += ParaExchangeCoupling[idx]
-        * GreenFuncN_real(4,myRsi,myRsj,ip,myEleIdx,eleCfg,myEleNum,eleProjCnt,myBuffer,myBufferInt);
-
-      myRsi[0] = r0+Nsite; /* s=1 */
-      myRsj[0] = r1+Nsite; /* s=1 */
-      myRsi[1] = r1; /* s=0 */
-      myRsj[1] = r0; /* s=0 */
-      myRsi[2] = rsi;
-      myRsj[2] = rsj;
-      myRsi[3] = rsk;
-      myRsj[3] = rsl;
-      myValue += ParaExchangeCoupling[idx]
-        * GreenFuncN_real(4,myRsi,myRsj,ip,myEleIdx,eleCfg,myEleNum,eleProjCnt,myBuffer,myBufferInt);
-    }
+/* Serial CalculateHamiltonian_real with the given PfM and InvM */
+/* buffer size = NQPFull+2*Nsize, bufferInt size = NProj */
+double calculateHamiltonian_child_real(const double ip, int *eleIdx, const int *eleCfg,
+                                       int *eleNum, const int *eleProjCnt,
+                                       double *pfM, double *invM,
+                                       double *buffer, int *bufferInt) {
+  const int *n0 = eleNum;
+  const int *n1 = eleNum + Nsite;
+  double e=0.0, tmp;
+  int idx;
+  int ri,rj,s,rk,rl,t;
 
-    /* Inter All */
-#pragma omp for private(idx) schedule(dynamic) nowait
-    for(idx=0;idx<NInterAll;idx++) {
-      myRsi[0] = InterAll[idx][0] + InterAll[idx][3]*Nsite;
-      myRsj[0] = InterAll[idx][2] + InterAll[idx][3]*Nsite;
-      myRsi[1] = InterAll[idx][4] + InterAll[idx][7]*Nsite;
-      myRsj[1] = InterAll[idx][6] + InterAll[idx][7]*Nsite;
-      myRsi[2] = rsi;
-      myRsj[2] = rsj;
-      myRsi[3] = rsk;
-      myRsj[3] = rsl;
-      myValue += creal(ParaInterAll[idx])
-        * GreenFuncN_real(4,myRsi,myRsj,ip,myEleIdx,eleCfg,myEleNum,eleProjCnt,myBuffer,myBufferInt);
-    }
+  /* CoulombIntra */
+  for(idx=0;idx<NCoulombIntra;idx++) {
+    ri = CoulombIntra[idx];
+    e += ParaCoulombIntra[idx] * n0[ri] * n1[ri];
+  }
 
-    v += myValue;
+  /* CoulombInter */
+  for(idx=0;idx<NCoulombInter;idx++) {
+    ri = CoulombInter[idx][0];
+    rj = CoulombInter[idx][1];
+    e += ParaCoulombInter[idx] * (n0[ri]+n1[ri]) * (n0[rj]+n1[rj]);
   }
-  val += v;
 
-  ReleaseWorkSpaceInt();
-  ReleaseWorkSpaceDouble();
-  ReleaseWorkSpaceThreadInt();
-  ReleaseWorkSpaceThreadDouble();
+  /* HundCoupling */
+  for(idx=0;idx<NHundCoupling;idx++) {
+    ri = HundCoupling[idx][0];
+    rj = HundCoupling[idx][1];
+    e -= ParaHundCoupling[idx] * (n0[ri]*n0[rj] + n1[ri]*n1[rj]);
+    /* Caution: negative sign */
+  }
 
-  return val;
-}
+  /* Transfer */
+  for(idx=0;idx<NTransfer;idx++) {
+    ri = Transfer[idx][0];
+    rj = Transfer[idx][2];
+    s  = Transfer[idx][3];
 
+    e -= creal(ParaTransfer[idx])
+      * greenFunc1_child_real(ri,rj,s,ip,eleIdx,eleCfg,eleNum,eleProjCnt,bufferInt,buffer,pfM,invM);
+    /* Caution: negative sign */
+  }
+
+  /* Pair Hopping */
+  for(idx=0;idx<NPairHopping;idx++) {
+    ri = PairHopping[idx][0];
+    rj = PairHopping[idx][1];
+
+    e += ParaPairHopping[idx]
+      * greenFunc2_child_real(ri,rj,ri,rj,0,1,ip,eleIdx,eleCfg,eleNum,eleProjCnt,bufferInt,buffer,pfM,invM);
+  }
+
+  /* Exchange Coupling */
+  for(idx=0;idx<NExchangeCoupling;idx++) {
+    ri = ExchangeCoupling[idx][0];
+    rj = ExchangeCoupling[idx][1];
+
+    tmp =  greenFunc2_child_real(ri,rj,rj,ri,0,1,ip,eleIdx,eleCfg,eleNum,eleProjCnt,bufferInt,buffer,pfM,invM);
+    tmp += greenFunc2_child_real(ri,rj,rj,ri,1,0,ip,eleIdx,eleCfg,eleNum,eleProjCnt,bufferInt,buffer,pfM,invM);
+    e += ParaExchangeCoupling[idx] * tmp;
+  }
+
+  /* Inter All */
+  for(idx=0;idx<NInterAll;idx++) {
+    ri = InterAll[idx][0];
+    rj = InterAll[idx][2];
+    s  = InterAll[idx][3];
+    rk = InterAll[idx][4];
+    rl = InterAll[idx][6];
+    t  = InterAll[idx][7];
+
+    e += creal(ParaInterAll[idx])
+      * greenFunc2_child_real(ri,rj,rk,rl,s,t,ip,eleIdx,eleCfg,eleNum,eleProjCnt,bufferInt,buffer,pfM,invM);
+  }
+
+  return e;
+}
 
 /* Calculate <psi|QCisAjs|x>/<psi|x> */
+/* The hoppings are evaluated in LSLocalQ_real for the same sample. */
 void LSLocalCisAjs_real(const double h1, const double ip, int *eleIdx, int *eleCfg, int *eleNum, int *eleProjCnt) {
   const int nCisAjs=NCisAjs;
   double *lsLCisAjs_real = LSLCisAjs_real;
@@ -786,7 +842,7 @@ void LSLocalCisAjs_real(const double h1, const double ip, int *eleIdx, int *eleC
     s  = CisAjsIdx[idx][3];
 
     /* calculate local HCisAjs */
-    LSLCisAjs_real[idx+nCisAjs] = calHCA_real(ri,rj,s,h1,ip,eleIdx,eleCfg,eleNum,eleProjCnt);
+    LSLCisAjs_real[idx+nCisAjs] = calHCA_real(ri,rj,s,h1,eleNum);
   }
   return;
 }
@@ -52,6 +52,8 @@ int getLWork() {
   M_DSKPFA(&uplo, &mthd, &n, &a, &lda, &pfaff, &iwork, &optSize2, &lwork, &info);
 
   lwork = (optSize1>optSize2) ? (int)optSize1 : (int)optSize2;
+  /* SkPfaInv_real requires work[2*n] */
+  if(lwork<2*n) lwork=2*n;
   return lwork;
 }
 
@@ -76,6 +78,8 @@ int getLWork_fcmp() {
 #endif
 
   lwork = (creal(optSize1)>creal(optSize2)) ? (int)creal(optSize1) : (int)creal(optSize2);
+  /* SkPfaInv_fcmp requires work[2*n] */
+  if(lwork<2*n) lwork=2*n;
   return lwork;
 }
 
@@ -93,6 +97,9 @@ int CalculateMAll_fsz(const int *eleIdx,const int *eleSpn, const int qpStart, co
   int             myInfo;
   double         *myRWork;
 
+  /* the delayed updates are discarded since InvM is recalculated */
+  NDelayStored = 0;
+
   RequestWorkSpaceThreadInt(Nsize);         //int
 
   RequestWorkSpaceThreadComplex(Nsize*Nsize+LapackLWork);
@@ -135,8 +142,10 @@ int calculateMAll_child_fsz(const int *eleIdx,const int *eleSpn, const int qpSta
   int msi,msj;
   int rsi,rsj;
 
+#ifdef _pfaffine
   char uplo='U', mthd='P';
-  int m,n,nsq,one,lda,info=0;
+#endif
+  int n,nsq,one,lda,info=0;
   //int nspn = 2*Ne+2*Nsite+2*Nsite+NProj; this is useful?
   double complex pfaff,minus_one;
 
@@ -151,7 +160,7 @@ int calculateMAll_child_fsz(const int *eleIdx,const int *eleSpn, const int qpSta
 
   double complex *bufM_i, *bufM_i2;
 
-  m=n=lda=Nsize;
+  n=lda=Nsize;
   nsq=n*n;
   one=1;
   minus_one=-1.0;
@@ -175,13 +184,9 @@ int calculateMAll_child_fsz(const int *eleIdx,const int *eleSpn, const int qpSta
   info=0; /* Fused Pfaffian/inverse computation. */
   M_ZSKPFA(&uplo, &mthd, &n, bufM, &lda, &pfaff, iwork, work/*, rwork*/, &lwork, &info);
 #else
-  /* Pfaffian/inverse computed separately. */
-  /* Copy bufM to invM before using bufM to compute Pfaffian. */
-  for(msi=0;msi<nsize*nsize;msi++)
-    invM[msi] = bufM[msi];
-
-  /* Calculate Pf M */
-  M_ZSKPFA(&uplo, &mthd, &n, bufM, &lda, &pfaff, iwork, work, &lwork, rwork, &info);
+  /* Fused Pfaffian/inverse computation (Parlett-Reid). */
+  /* inv(M) is stored in invM and bufM is destroyed. */
+  info = SkPfaInv_fcmp(n, bufM, lda, &pfaff, iwork, invM, lda, work);
 #endif
 
   if(info!=0) return info;
@@ -194,10 +199,6 @@ int calculateMAll_child_fsz(const int *eleIdx,const int *eleSpn, const int qpSta
   for(msi=0;msi<nsize*nsize;msi++)
     invM[msi] = -bufM[msi];
 #else
-  /* Calculate inverse. */
-  M_ZGETRF(&m, &n, invM, &lda, iwork, &info); /* ipiv = iwork */
-  M_ZGETRI(&n, invM, &lda, iwork, work, &lwork, &info);
-
   /* InvM -> InvM(T) -> -InvM */
   M_ZSCAL(&nsq, &minus_one, invM, &one);
 #endif
@@ -218,6 +219,9 @@ int CalculateMAll_fsz_real(const int *eleIdx,const int *eleSpn, const int qpStar
   int             myInfo;
   double         *myRWork;
 
+  /* the delayed updates are discarded since InvM is recalculated */
+  NDelayStored = 0;
+
   RequestWorkSpaceThreadInt(Nsize);         //int
   RequestWorkSpaceThreadDouble(Nsize*Nsize+LapackLWork);
 
@@ -254,8 +258,10 @@ int calculateMAll_child_fsz_real(const int *eleIdx,const int *eleSpn, const int
   int msi,msj;
   int rsi,rsj;
 
+#ifdef _pfaffine
   char uplo='U', mthd='P';
-  int m,n,lda,one,nsq,info=0;
+#endif
+  int n,lda,one,nsq,info=0;
   //int nspn = 2*Ne+2*Nsite+2*Nsite+NProj; this is useful?
   double pfaff,minus_one;
 
@@ -270,7 +276,7 @@ int calculateMAll_child_fsz_real(const int *eleIdx,const int *eleSpn, const int
 
   double *bufM_i, *bufM_i2;
 
-  m=n=lda=Nsize;
+  n=lda=Nsize;
   nsq=n*n;
   one=1;
   minus_one=-1.0;
@@ -292,15 +298,13 @@ int calculateMAll_child_fsz_real(const int *eleIdx,const int *eleSpn, const int
 
 #ifdef _pfaffine
   info=0; /* Fused Pfaffian/inverse computation. */
-#else
-  /* Pfaffian/inverse computed separately. */
-  /* Copy bufM to invM before using bufM to compute Pfaffian. */
-  for(msi=0;msi<nsize*nsize;msi++)
-    invM[msi] = bufM[msi];
-#endif
-
   /* Calculate Pf M */
   M_DSKPFA(&uplo, &mthd, &n, bufM, &lda, &pfaff, iwork, work, &lwork, &info);
+#else
+  /* Fused Pfaffian/inverse computation (Parlett-Reid). */
+  /* inv(M) is stored in invM and bufM is destroyed. */
+  info = SkPfaInv_real(n, bufM, lda, &pfaff, iwork, invM, lda, work);
+#endif
 
   if(info!=0) return info;
   if(!isfinite(pfaff)) return qpidx+1;
@@ -312,12 +316,6 @@ int calculateMAll_child_fsz_real(const int *eleIdx,const int *eleSpn, const int
   for(msi=0;msi<nsize*nsize;msi++)
     invM[msi] = -bufM[msi];
 #else
-  /* Calculate inverse. */
-  M_DGETRF(&m, &n, invM, &lda, iwork, &info); /* ipiv = iwork */
-  if(info!=0) return info;
-  M_DGETRI(&n, invM, &lda, iwork, work, &lwork, &info);
-  if(info!=0) return info;
-
   /* InvM -> InvM(T) -> -InvM */
   M_DSCAL(&nsq, &minus_one, invM, &one);
 #endif
@@ -342,6 +340,9 @@ int CalculateMAll_fcmp(const int *eleIdx, const int qpStart, const int qpEnd) {
   int             myInfo;
   double         *myRWork;
 
+  /* the delayed updates are discarded since InvM is recalculated */
+  NDelayStored = 0;
+
   RequestWorkSpaceThreadInt(Nsize);         //int
 
   RequestWorkSpaceThreadComplex(Nsize*Nsize+LapackLWork);
@@ -363,7 +364,7 @@ int CalculateMAll_fcmp(const int *eleIdx, const int qpStart, const int qpEnd) {
       if(info!=0) continue;
 
       myInfo = calculateMAll_child_fcmp(eleIdx, qpStart, qpEnd, qpidx,
-          myBufM, myIWork, myWork, LapackLWork,myRWork);
+          myBufM, myIWork, myWork, LapackLWork,myRWork, PfM, InvM);
       if(myInfo!=0) {
 #pragma omp critical
         info=myInfo;
@@ -378,28 +379,30 @@ int CalculateMAll_fcmp(const int *eleIdx, const int qpStart, const int qpEnd) {
 }
 
 int calculateMAll_child_fcmp(const int *eleIdx, const int qpStart, const int qpEnd, const int qpidx,
-    double complex *bufM, int *iwork, double complex *work, int lwork,double *rwork) {
+    double complex *bufM, int *iwork, double complex *work, int lwork,double *rwork,
+    double complex *PfM, double complex *InvM) {
 #pragma procedure serial
   /* const int qpNum = qpEnd-qpStart; */
   int msi,msj;
-  int rsi,rsj;
+  int rsi;
 
+#ifdef _pfaffine
   char uplo='U', mthd='P';
-  int m,n,nsq,lda,one,info=0;
+#endif
+  int n,nsq,lda,one,info=0;
   double complex pfaff,minus_one;
 
   /* optimization for Kei */
   const int nsize = Nsize;
 
-  const double complex *sltE = SlaterElm + (qpidx+qpStart)*Nsite2*Nsite2;
-  const double complex *sltE_i;
+  const double complex *sltE = SlaterElm + (qpidx+qpStart)*Nsite2*NSlaterElmCol;
 
   double complex *invM = InvM + qpidx*Nsize*Nsize;
   double complex *invM_i;
 
   double complex *bufM_i, *bufM_i2;
 
-  m=n=lda=Nsize;
+  n=lda=Nsize;
   nsq=n*n;
   one=1;
   minus_one=-1.0;
@@ -411,11 +414,10 @@ int calculateMAll_child_fcmp(const int *eleIdx, const int qpStart, const int qpE
   for(msi=0;msi<nsize;msi++) {
     rsi = eleIdx[msi] + (msi/Ne)*Nsite;
     bufM_i = bufM + msi*Nsize;
-    sltE_i = sltE + rsi*Nsite2;
+    GetSlaterElmRow_fcmp(bufM_i, sltE, rsi, eleIdx);
 #pragma loop norecurrence
     for(msj=0;msj<nsize;msj++) {
-      rsj = eleIdx[msj] + (msj/Ne)*Nsite;
-      bufM_i[msj] = -sltE_i[rsj];
+      bufM_i[msj] = -bufM_i[msj];
     }
   }
 
@@ -423,13 +425,9 @@ int calculateMAll_child_fcmp(const int *eleIdx, const int qpStart, const int qpE
   info=0; /* Fused Pfaffian/inverse computation. */
   M_ZSKPFA(&uplo, &mthd, &n, bufM, &lda, &pfaff, iwork, work/*, rwork*/, &lwork, &info);
 #else
-  /* Pfaffian/inverse computed separately. */
-  /* Copy bufM to invM before using bufM to compute Pfaffian. */
-  for(msi=0;msi<nsize*nsize;msi++)
-    invM[msi] = bufM[msi];
-
-  /* Calculate Pf M */
-  M_ZSKPFA(&uplo, &mthd, &n, bufM, &lda, &pfaff, iwork, work, &lwork, rwork, &info);
+  /* Fused Pfaffian/inverse computation (Parlett-Reid). */
+  /* inv(M) is stored in invM and bufM is destroyed. */
+  info = SkPfaInv_fcmp(n, bufM, lda, &pfaff, iwork, invM, lda, work);
 #endif
 
   if(info!=0) return info;
@@ -442,10 +440,6 @@ int calculateMAll_child_fcmp(const int *eleIdx, const int qpStart, const int qpE
   for(msi=0;msi<nsize*nsize;msi++)
     invM[msi] = -bufM[msi];
 #else
-  /* Calculate inverse. */
-  M_ZGETRF(&m, &n, invM, &lda, iwork, &info); /* ipiv = iwork */
-  M_ZGETRI(&n, invM, &lda, iwork, work, &lwork, &info);
-
   /* mVMC's handling InvM as row-major,
    * i.e. InvM needs a transpose, InvM -> -InvM according antisymmetric properties. */
   M_ZSCAL(&nsq, &minus_one, invM, &one);
@@ -466,6 +460,9 @@ int CalculateMAll_BF_fcmp(const int *eleIdx, const int qpStart, const int qpEnd)
   int myInfo;
   double *myRWork;
 
+  /* the delayed updates are discarded since InvM is recalculated */
+  NDelayStored = 0;
+
   RequestWorkSpaceThreadInt(Nsize);
   RequestWorkSpaceThreadComplex(Nsize*Nsize+LapackLWork);
 
@@ -518,8 +515,10 @@ int calculateMAll_BF_fcmp_child(
   int msi,msj;
   int rsi,rsj;
 
+#ifdef _pfaffine
   char uplo='U', mthd='P';
-  int m,n,lda,nsq,one,info=0;
+#endif
+  int n,lda,nsq,one,info=0;
   double complex pfaff,minus_one;
 
   /* optimization for Kei */
@@ -533,7 +532,7 @@ int calculateMAll_BF_fcmp_child(
 
   double complex*bufM_i, *bufM_i2;
 
-  m=n=lda=Nsize;
+  n=lda=Nsize;
   nsq=n*n;
   one=1;
   minus_one=-1.0;
@@ -557,13 +556,9 @@ int calculateMAll_BF_fcmp_child(
   info=0; /* Fused Pfaffian/inverse computation. */
   M_ZSKPFA(&uplo, &mthd, &n, bufM, &lda, &pfaff, iwork, work, &lwork/*, rwork*/, &info);
 #else
-  /* Pfaffian/inverse computed separately. */
-  /* Copy bufM to invM before using bufM to compute Pfaffian. */
-  for(msi=0;msi<nsize*nsize;msi++)
-    invM[msi] = bufM[msi];
-
-  /* Calculate Pf M */
-  M_ZSKPFA(&uplo, &mthd, &n, bufM, &lda, &pfaff, iwork, work, &lwork, rwork, &info);
+  /* Fused Pfaffian/inverse computation (Parlett-Reid). */
+  /* inv(M) is stored in invM and bufM is destroyed. */
+  info = SkPfaInv_fcmp(n, bufM, lda, &pfaff, iwork, invM, lda, work);
 #endif
 
   if(info!=0) return info;
@@ -576,12 +571,6 @@ int calculateMAll_BF_fcmp_child(
   for(msi=0;msi<nsize*nsize;msi++)
     invM[msi] = -bufM[msi];
 #else
-  /* Calculate inverse. */
-  M_ZGETRF(&m, &n, invM, &lda, iwork, &info); /* ipiv = iwork */
-  if(info!=0) return info;
-  M_ZGETRI(&n, invM, &lda, iwork, work, &lwork, &info);
-  if(info!=0) return info;
-
   /* InvM -> InvM(T) -> -InvM */
   M_ZSCAL(&nsq, &minus_one, invM, &one);
 #endif
@@ -604,6 +593,9 @@ int CalculateMAll_real(const int *eleIdx, const int qpStart, const int qpEnd) {
   int *myIWork;
   int myInfo;
 
+  /* the delayed updates are discarded since InvM is recalculated */
+  NDelayStored = 0;
+
   RequestWorkSpaceThreadInt(Nsize);
   RequestWorkSpaceThreadDouble(Nsize*Nsize+LapackLWork);
 
@@ -641,24 +633,25 @@ int calculateMAll_child_real(const int *eleIdx, const int qpStart, const int qpE
 #pragma procedure serial
   /* const int qpNum = qpEnd-qpStart; */
   int msi,msj;
-  int rsi,rsj;
+  int rsi;
 
+#ifdef _pfaffine
   char uplo='U', mthd='P';
-  int m,n,nsq,one,lda,info=0;
+#endif
+  int n,nsq,one,lda,info=0;
   double pfaff,minus_one;
 
   /* optimization for Kei */
   const int nsize = Nsize;
 
-  const double *sltE = SlaterElm_real + (qpidx+qpStart)*Nsite2*Nsite2;
-  const double *sltE_i;
+  const double *sltE = SlaterElm_real + (qpidx+qpStart)*Nsite2*NSlaterElmCol;
 
   double *invM = InvM_real + qpidx*Nsize*Nsize;
   double *invM_i;
 
   double *bufM_i, *bufM_i2;
 
-  m=n=lda=Nsize;
+  n=lda=Nsize;
   nsq=n*n;
   one=1;
   minus_one=-1.0;
@@ -670,26 +663,22 @@ int calculateMAll_child_real(const int *eleIdx, const int qpStart, const int qpE
   for(msi=0;msi<nsize;msi++) {
     rsi = eleIdx[msi] + (msi/Ne)*Nsite;
     bufM_i = bufM + msi*Nsize;
-    sltE_i = sltE + rsi*Nsite2;
+    GetSlaterElmRow_real(bufM_i, sltE, rsi, eleIdx);
 #pragma loop norecurrence
     for(msj=0;msj<nsize;msj++) {
-      rsj = eleIdx[msj] + (msj/Ne)*Nsite;
-      bufM_i[msj] = -sltE_i[rsj];
-
+      bufM_i[msj] = -bufM_i[msj];
     }
   }
 
 #ifdef _pfaffine
   info=0; /* Fused Pfaffian/inverse computation. */
-#else
-  /* Pfaffian/inverse computed separately. */
-  /* Copy bufM to invM before using bufM to compute Pfaffian. */
-  for(msi=0;msi<nsize*nsize;msi++)
-    invM[msi] = bufM[msi];
-#endif
-
   /* calculate Pf M */
   M_DSKPFA(&uplo, &mthd, &n, bufM, &lda, &pfaff, iwork, work, &lwork, &info);
+#else
+  /* Fused Pfaffian/inverse computation (Parlett-Reid). */
+  /* inv(M) is stored in invM and bufM is destroyed. */
+  info = SkPfaInv_real(n, bufM, lda, &pfaff, iwork, invM, lda, work);
+#endif
 
   if(info!=0) return info;
   if(!isfinite(pfaff)) return qpidx+1;
@@ -701,10 +690,6 @@ int calculateMAll_child_real(const int *eleIdx, const int qpStart, const int qpE
   for(msi=0;msi<nsize*nsize;msi++)
     invM[msi] = -bufM[msi];
 #else
-  /* Compute inverse */
-  M_DGETRF(&m, &n, invM, &lda, iwork, &info); /* ipiv = iwork */
-  M_DGETRI(&n, invM, &lda, iwork, work, &lwork, &info);
-
   // InvM -> InvM' = -InvM
   M_DSCAL(&nsq, &minus_one, invM, &one);
 #endif
@@ -723,6 +708,9 @@ int CalculateMAll_BF_real(const int *eleIdx, const int qpStart, const int qpEnd)
   int *myIWork;
   int myInfo;
 
+  /* the delayed updates are discarded since InvM is recalculated */
+  NDelayStored = 0;
+
   RequestWorkSpaceThreadInt(Nsize);
   RequestWorkSpaceThreadDouble(Nsize*Nsize+LapackLWork);
 
@@ -758,8 +746,10 @@ int calculateMAll_BF_real_child(const int *eleIdx, const int qpStart, const int
   int msi,msj;
   int rsi,rsj;
 
+#ifdef _pfaffine
   char uplo='U', mthd='P';
-  int m,n,nsq,one,lda,info=0;
+#endif
+  int n,nsq,one,lda,info=0;
   double pfaff,minus_one;
 
   /* optimization for Kei */
@@ -773,7 +763,7 @@ int calculateMAll_BF_real_child(const int *eleIdx, const int qpStart, const int
 
   double *bufM_i, *bufM_i2;
 
-  m=n=lda=Nsize;
+  n=lda=Nsize;
   nsq=n*n;
   one=1;
   minus_one=-1.0;
@@ -795,15 +785,13 @@ int calculateMAll_BF_real_child(const int *eleIdx, const int qpStart, const int
 
 #ifdef _pfaffine
   info=0; /* Fused Pfaffian/inverse computation. */
-#else
-  /* Pfaffian/inverse computed separately. */
-  /* Copy bufM to invM before using bufM to compute Pfaffian. */
-  for(msi=0;msi<nsize*nsize;msi++)
-    invM[msi] = bufM[msi];
-#endif
-
   /* Calculate Pf M */
   M_DSKPFA(&uplo, &mthd, &n, bufM, &lda, &pfaff, iwork, work, &lwork, &info);
+#else
+  /* Fused Pfaffian/inverse computation (Parlett-Reid). */
+  /* inv(M) is stored in invM and bufM is destroyed. */
+  info = SkPfaInv_real(n, bufM, lda, &pfaff, iwork, invM, lda, work);
+#endif
 
   if(info!=0) return info;
   if(!isfinite(pfaff)) return qpidx+1;
@@ -816,10 +804,6 @@ int calculateMAll_BF_real_child(const int *eleIdx, const int qpStart, const int
     invM[msi] = -bufM[msi];
 #else
   /* Compute inverse. */
-  M_DGETRF(&m, &n, invM, &lda, iwork, &info); /* ipiv = iwork */
-  if(info!=0) return info;
-  M_DGETRI(&n, invM, &lda, iwork, work, &lwork, &info);
-  if(info!=0) return info;
 
   // InvM -> InvM' = -InvM
   M_DSCAL(&nsq, &minus_one, invM, &one);
@@ -0,0 +1,123 @@
+/*
+mVMC - A numerical solver package for a wide range of quantum lattice models based on many-variable Variational Monte Carlo method
+Copyright (C) 2016 The University of Tokyo, All rights reserved.
+
+This program is developed based on the mVMC-mini program
+(https://github.com/fiber-miniapp/mVMC-mini)
+which follows "The BSD 3-Clause License".
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details. 
+
+You should have received a copy of the GNU General Public License 
+along with this program. If not, see http://www.gnu.org/licenses/. 
+*/
+/*-------------------------------------------------------------
+ * Variational Monte Carlo
+ * structure factors and momentum distribution computed on the fly
+ *-------------------------------------------------------------*/
+#include "global.h"
+#include "momentum.h"
+#include "locgrn.h"
+#include "locgrn_real.h"
+#ifndef _SRC_MOMENTUM
+#define _SRC_MOMENTUM
+
+/* The local values of a sample are accumulated into PhysMomentum[NMomentum][4]:
+     N(q)      = 1/Nsite |rho_up(q) + rho_down(q)|^2
+     Sz(q)     = 1/(4Nsite) |rho_up(q) - rho_down(q)|^2
+     n_s(k)    = 1/Nsite sum_{i,j} exp(i k.(r_i-r_j)) <CisAjs>
+   where rho_s(q) = sum_i exp(i q.r_i) n_is. */
+void CalculateMomentum(const double w, const double complex ip, int *eleIdx, int *eleCfg,
+                       int *eleNum, int *eleProjCnt) {
+  const int nsite=Nsite;
+  const int n=2*Nsite*Nsite;
+  int idx,iq,ri,rj,s;
+  int *myEleIdx, *myEleNum, *myProjCntNew;
+  double complex *myBuffer;
+  double *myBuffer_real;
+  const double complex *e;
+  const double complex *g;
+  double complex rho0,rho1,v,nk0,nk1;
+
+  if(NMomentumDist==1) {
+    RequestWorkSpaceThreadInt(Nsize+Nsite2+NProj);
+    RequestWorkSpaceThreadComplex(NQPFull+2*Nsize);
+    RequestWorkSpaceThreadDouble(NQPFull+2*Nsize);
+
+    #pragma omp parallel default(shared)\
+    private(myEleIdx,myEleNum,myProjCntNew,myBuffer,myBuffer_real,idx,ri,rj,s)
+    {
+      myEleIdx = GetWorkSpaceThreadInt(Nsize);
+      myEleNum = GetWorkSpaceThreadInt(Nsite2);
+      myProjCntNew = GetWorkSpaceThreadInt(NProj);
+      myBuffer = GetWorkSpaceThreadComplex(NQPFull+2*Nsize);
+      myBuffer_real = GetWorkSpaceThreadDouble(NQPFull+2*Nsize);
+
+      #pragma loop noalias
+      for(idx=0;idx<Nsize;idx++) myEleIdx[idx] = eleIdx[idx];
+      #pragma loop noalias
+      for(idx=0;idx<Nsite2;idx++) myEleNum[idx] = eleNum[idx];
+
+      /* LocalMomentumG[s][ri][rj] = <CisAjs> */
+      #pragma omp for schedule(dynamic)
+      for(idx=0;idx<n;idx++) {
+        s  = idx/(nsite*nsite);
+        ri = (idx/nsite)%nsite;
+        rj = idx%nsite;
+        if(FlagRealSlaterElm==1) {
+          LocalMomentumG[idx] = GreenFunc1_real(ri,rj,s,creal(ip),myEleIdx,eleCfg,myEleNum,eleProjCnt,
+                                                myProjCntNew,myBuffer_real);
+        } else {
+          LocalMomentumG[idx] = GreenFunc1(ri,rj,s,ip,myEleIdx,eleCfg,myEleNum,eleProjCnt,
+                                           myProjCntNew,myBuffer);
+        }
+      }
+    }
+
+    ReleaseWorkSpaceThreadInt();
+    ReleaseWorkSpaceThreadComplex();
+    ReleaseWorkSpaceThreadDouble();
+  }
+
+  #pragma omp parallel for default(shared) private(iq,ri,rj,e,g,rho0,rho1,v,nk0,nk1)
+  for(iq=0;iq<NMomentum;iq++) {
+    e = MomentumExp + iq*nsite;
+
+    rho0 = rho1 = 0.0;
+    for(ri=0;ri<nsite;ri++) {
+      rho0 += e[ri]*eleNum[ri];
+      rho1 += e[ri]*eleNum[ri+nsite];
+    }
+    PhysMomentum[4*iq]   += w*(conj(rho0+rho1)*(rho0+rho1))/(double)nsite;
+    PhysMomentum[4*iq+1] += w*0.25*(conj(rho0-rho1)*(rho0-rho1))/(double)nsite;
+
+    if(NMomentumDist==1) {
+      nk0 = nk1 = 0.0;
+      for(ri=0;ri<nsite;ri++) {
+        g = LocalMomentumG + ri*nsite;
+        v = 0.0;
+        for(rj=0;rj<nsite;rj++) v += g[rj]*conj(e[rj]);
+        nk0 += e[ri]*v;
+
+        g = LocalMomentumG + (ri+nsite)*nsite;
+        v = 0.0;
+        for(rj=0;rj<nsite;rj++) v += g[rj]*conj(e[rj]);
+        nk1 += e[ri]*v;
+      }
+      PhysMomentum[4*iq+2] += w*nk0/(double)nsite;
+      PhysMomentum[4*iq+3] += w*nk1/(double)nsite;
+    }
+  }
+
+  return;
+}
+
+#endif
@@ -40,37 +40,50 @@ void CalculateNewPfM(const int ma, const int s, double complex *pfMNew, const in
                      const int qpStart, const int qpEnd) {
   #pragma procedure serial
   const int qpNum = qpEnd-qpStart;
+  int qpidx;
+
+  #pragma loop noalias
+  for(qpidx=0;qpidx<qpNum;qpidx++) {
+    calculateNewPfM_child(ma, s, pfMNew, eleIdx, qpStart, qpEnd, qpidx, PfM, InvM);
+  }
+
+  return;
+}
+
+void calculateNewPfM_child(const int ma, const int s, double complex *pfMNew, const int *eleIdx,
+                           const int qpStart, const int qpEnd, const int qpidx,
+                           const double complex *PfM, const double complex *InvM) {
+  #pragma procedure serial
   const int msa = ma+s*Ne;
   const int rsa = eleIdx[msa] + s*Nsite;
+  /* the same-spin block of SlaterElm is not stored in the compact layout */
+  const int msjStart = (FlagSlaterElmCompact==1 && s==0) ? Ne : 0;
+  const int msjEnd = (FlagSlaterElmCompact==1 && s==1) ? Ne : Nsize;
+  const int dnOff = NSlaterElmCol-Nsite;
 
-  int qpidx;
   int msj,rsj;
   const double complex *sltE_a; /* update elements of msa-th row */
   const double complex *invM_a;
   double complex ratio;
 
   /* optimization for Kei */
-  const int nsize = Nsize;
   const int ne = Ne;
 
-  #pragma loop noalias
-  for(qpidx=0;qpidx<qpNum;qpidx++) {
-    sltE_a = SlaterElm + (qpidx+qpStart)*Nsite2*Nsite2 + rsa*Nsite2;
-    invM_a = InvM + qpidx*Nsize*Nsize + msa*Nsize;
+  sltE_a = SlaterElm + (qpidx+qpStart)*Nsite2*NSlaterElmCol + rsa*NSlaterElmCol;
+  invM_a = InvM + qpidx*Nsize*Nsize + msa*Nsize;
 
-    ratio = 0.0;
-    for(msj=0;msj<ne;msj++) {
-      rsj = eleIdx[msj];
-      ratio += invM_a[msj] * sltE_a[rsj];
-    }
-    for(msj=ne;msj<nsize;msj++) {
-      rsj = eleIdx[msj] + Nsite;
-      ratio += invM_a[msj] * sltE_a[rsj];
-    }
-
-    pfMNew[qpidx] = -ratio*PfM[qpidx];
+  ratio = 0.0;
+  for(msj=msjStart;msj<ne;msj++) {
+    rsj = eleIdx[msj];
+    ratio += invM_a[msj] * sltE_a[rsj];
+  }
+  for(msj=ne;msj<msjEnd;msj++) {
+    rsj = eleIdx[msj] + dnOff;
+    ratio += invM_a[msj] * sltE_a[rsj];
   }
 
+  pfMNew[qpidx] = -ratio*PfM[qpidx];
+
   return;
 }
 
@@ -80,6 +93,10 @@ void CalculateNewPfM2(const int ma, const int s, double complex *pfMNew, const i
   const int qpNum = qpEnd-qpStart;
   const int msa = ma+s*Ne;
   const int rsa = eleIdx[msa] + s*Nsite;
+  /* the same-spin block of SlaterElm is not stored in the compact layout */
+  const int msjStart = (FlagSlaterElmCompact==1 && s==0) ? Ne : 0;
+  const int msjEnd = (FlagSlaterElmCompact==1 && s==1) ? Ne : Nsize;
+  const int dnOff = NSlaterElmCol-Nsite;
 
   int qpidx;
   int msj,rsj;
@@ -88,24 +105,28 @@ void CalculateNewPfM2(const int ma, const int s, double complex *pfMNew, const i
   double complex ratio;
 
   /* optimization for Kei */
-  const int nsize = Nsize;
   const int ne = Ne;
 
+  if(NDelayStored>0) {
+    CalculateNewPfMDelay_fcmp(msa, rsa, pfMNew, eleIdx, NULL, qpStart, qpEnd);
+    return;
+  }
+
   #pragma omp parallel for default(shared)        \
     private(qpidx,msj,sltE_a,invM_a,ratio,rsj)
   #pragma loop noalias
   for(qpidx=0;qpidx<qpNum;qpidx++) {
-    sltE_a = SlaterElm + (qpidx+qpStart)*Nsite2*Nsite2 + rsa*Nsite2;
+    sltE_a = SlaterElm + (qpidx+qpStart)*Nsite2*NSlaterElmCol + rsa*NSlaterElmCol;
     invM_a = InvM + qpidx*Nsize*Nsize + msa*Nsize;
 
     ratio = 0.0;
-    for(msj=0;msj<ne;msj++) {
+    for(msj=msjStart;msj<ne;msj++) {
       rsj = eleIdx[msj];
       ratio += invM_a[msj] * sltE_a[rsj];
       //printf("DEBUG:msj=%d rsj=%d: invM=%lf %lf : slt=%lf %lf \n",msj,rsj,creal(invM_a[msj]),cimag(invM_a[msj]),creal(sltE_a[rsj]),cimag(sltE_a[rsj]));
     }
-    for(msj=ne;msj<nsize;msj++) {
-      rsj = eleIdx[msj] + Nsite;
+    for(msj=ne;msj<msjEnd;msj++) {
+      rsj = eleIdx[msj] + dnOff;
       ratio += invM_a[msj] * sltE_a[rsj];
     }
 
@@ -122,6 +143,11 @@ void UpdateMAll(const int ma, const int s, const int *eleIdx,
   int qpidx;
   double complex *vec1,*vec2;
 
+  if(NDelayUpdate>1) {
+    UpdateMAllDelay_fcmp(ma+s*Ne, eleIdx[ma+s*Ne]+s*Nsite, eleIdx, NULL, qpStart, qpEnd);
+    return;
+  }
+
   RequestWorkSpaceThreadComplex(2*Nsize);
 
   #pragma omp parallel default(shared) private(vec1,vec2)
@@ -132,7 +158,7 @@ void UpdateMAll(const int ma, const int s, const int *eleIdx,
     #pragma omp for private(qpidx)
     #pragma loop nounroll
     for(qpidx=0;qpidx<qpNum;qpidx++) {
-      updateMAll_child(ma, s, eleIdx, qpStart, qpEnd, qpidx, vec1, vec2);
+      updateMAll_child(ma, s, eleIdx, qpStart, qpEnd, qpidx, vec1, vec2, PfM, InvM);
     }
   }
 
@@ -142,11 +168,16 @@ void UpdateMAll(const int ma, const int s, const int *eleIdx,
 
 void updateMAll_child(const int ma, const int s, const int *eleIdx,
                       const int qpStart, const int qpEnd, const int qpidx,
-                      double complex *vec1, double complex *vec2) {
+                      double complex *vec1, double complex *vec2,
+                      double complex *PfM, double complex *InvM) {
   #pragma procedure serial
   /* const int qpNum = qpEnd-qpStart; */
   const int msa = ma+s*Ne;
   const int rsa = eleIdx[msa] + s*Nsite;
+  /* the same-spin block of SlaterElm is not stored in the compact layout */
+  const int msjStart = (FlagSlaterElmCompact==1 && s==0) ? Ne : 0;
+  const int msjEnd = (FlagSlaterElmCompact==1 && s==1) ? Ne : Nsize;
+  const int dnOff = NSlaterElmCol-Nsite;
   const int nsize = Nsize; /* optimization for Kei */
 
   int msi,msj,rsj;
@@ -160,7 +191,7 @@ void updateMAll_child(const int ma, const int s, const int *eleIdx,
   double complex invVec1_a;
   double complex tmp;
 
-  sltE_a = SlaterElm + (qpidx+qpStart)*Nsite2*Nsite2 + rsa*Nsite2;
+  sltE_a = SlaterElm + (qpidx+qpStart)*Nsite2*NSlaterElmCol + rsa*NSlaterElmCol;
 
   invM = InvM + qpidx*Nsize*Nsize;
   invM_a = invM + msa*Nsize;
@@ -170,8 +201,8 @@ void updateMAll_child(const int ma, const int s, const int *eleIdx,
   /* Calculate vec1[i] = sum_j invM[i][j] sltE[a][j] */
   /* Note that invM[i][j] = -invM[j][i] */
   #pragma loop noalias
-  for(msj=0;msj<nsize;msj++) {
-    rsj = eleIdx[msj] + (msj/Ne)*Nsite;
+  for(msj=msjStart;msj<msjEnd;msj++) {
+    rsj = eleIdx[msj] + (msj/Ne)*dnOff;
     sltE_aj = sltE_a[rsj];
     invM_j = invM + msj*Nsize;
 
@@ -0,0 +1,377 @@
+/*
+mVMC - A numerical solver package for a wide range of quantum lattice models based on many-variable Variational Monte Carlo method
+Copyright (C) 2016 The University of Tokyo, All rights reserved.
+
+This program is developed based on the mVMC-mini program
+(https://github.com/fiber-miniapp/mVMC-mini)
+which follows "The BSD 3-Clause License".
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details. 
+
+You should have received a copy of the GNU General Public License 
+along with this program. If not, see http://www.gnu.org/licenses/. 
+*/
+/*-------------------------------------------------------------
+ * Variational Monte Carlo
+ * delayed update of the inverse matrix for one-electron hopping
+ *-------------------------------------------------------------*/
+/* The update of InvM by the k-th accepted hopping is the skew-symmetric rank-2 matrix
+     InvM[i][j] += DelayU[k][i]*DelayV[k][j] - DelayV[k][i]*DelayU[k][j].
+   Up to NDelayUpdate updates are stored in DelayU and DelayV and applied to InvM
+   at once by ZGEMM (DGEMM). Until then, the rows of the current InvM needed by
+   the Pfaffian ratio are reconstructed from the stored vectors.
+   The routines reading the whole InvM must call FlushDelayMAll beforehand. */
+#include "pfupdate_delay.h"
+#ifndef _SRC_PFUPDATE_DELAY
+#define _SRC_PFUPDATE_DELAY
+
+void getDelaySlaterElmRow_fcmp(double complex *vec, const double complex *sltE, const int rsa,
+                               const int *eleIdx, const int *eleSpn);
+void getDelaySlaterElmRow_real(double *vec, const double *sltE, const int rsa,
+                               const int *eleIdx, const int *eleSpn);
+double complex calculateDelayRatio_fcmp(const int msa, const double complex *vec, const int qpidx);
+double calculateDelayRatio_real(const int msa, const double *vec, const int qpidx);
+void updateMAllDelay_child_fcmp(const int msa, const int rsa, const int *eleIdx, const int *eleSpn,
+                                const int qpStart, const int qpidx, double complex *vec);
+void updateMAllDelay_child_real(const int msa, const int rsa, const int *eleIdx, const int *eleSpn,
+                                const int qpStart, const int qpidx, double *vec);
+
+/* Apply the stored updates to InvM */
+void FlushDelayMAll_fcmp(const int qpStart, const int qpEnd) {
+  const int qpNum = qpEnd-qpStart;
+  const int n = Nsize;
+  const int k = NDelayStored;
+  const char transN='N', transT='T';
+  const double complex one=1.0, mOne=-1.0;
+  int qpidx;
+  double complex *u,*v,*invM;
+
+  if(k==0) return;
+
+  #pragma omp parallel for default(shared) private(qpidx,u,v,invM)
+  for(qpidx=0;qpidx<qpNum;qpidx++) {
+    u = DelayU + qpidx*NDelayUpdate*Nsize;
+    v = DelayV + qpidx*NDelayUpdate*Nsize;
+    invM = InvM + qpidx*Nsize*Nsize;
+    /* InvM is row-major: InvM^T += V U^T - U V^T in the column-major order */
+    M_ZGEMM(&transN,&transT,&n,&n,&k,&one,v,&n,u,&n,&one,invM,&n);
+    M_ZGEMM(&transN,&transT,&n,&n,&k,&mOne,u,&n,v,&n,&one,invM,&n);
+  }
+
+  NDelayStored = 0;
+  return;
+}
+
+void FlushDelayMAll_real(const int qpStart, const int qpEnd) {
+  const int qpNum = qpEnd-qpStart;
+  const int n = Nsize;
+  const int k = NDelayStored;
+  const char transN='N', transT='T';
+  const double one=1.0, mOne=-1.0;
+  int qpidx;
+  double *u,*v,*invM;
+
+  if(k==0) return;
+
+  #pragma omp parallel for default(shared) private(qpidx,u,v,invM)
+  for(qpidx=0;qpidx<qpNum;qpidx++) {
+    u = DelayU_real + qpidx*NDelayUpdate*Nsize;
+    v = DelayV_real + qpidx*NDelayUpdate*Nsize;
+    invM = InvM_real + qpidx*Nsize*Nsize;
+    /* InvM is row-major: InvM^T += V U^T - U V^T in the column-major order */
+    M_DGEMM(&transN,&transT,&n,&n,&k,&one,v,&n,u,&n,&one,invM,&n);
+    M_DGEMM(&transN,&transT,&n,&n,&k,&mOne,u,&n,v,&n,&one,invM,&n);
+  }
+
+  NDelayStored = 0;
+  return;
+}
+
+/* vec[msj] = SlaterElm[rsa][rsj]. eleSpn is NULL for the Sz-conserved case. */
+void getDelaySlaterElmRow_fcmp(double complex *vec, const double complex *sltE, const int rsa,
+                               const int *eleIdx, const int *eleSpn) {
+  const double complex *sltE_a = sltE + rsa*Nsite2;
+  int msj;
+
+  if(eleSpn==NULL) {
+    GetSlaterElmRow_fcmp(vec, sltE, rsa, eleIdx);
+  } else {
+    for(msj=0;msj<Nsize;msj++) vec[msj] = sltE_a[eleIdx[msj]+eleSpn[msj]*Nsite];
+  }
+  return;
+}
+
+void getDelaySlaterElmRow_real(double *vec, const double *sltE, const int rsa,
+                               const int *eleIdx, const int *eleSpn) {
+  const double *sltE_a = sltE + rsa*Nsite2;
+  int msj;
+
+  if(eleSpn==NULL) {
+    GetSlaterElmRow_real(vec, sltE, rsa, eleIdx);
+  } else {
+    for(msj=0;msj<Nsize;msj++) vec[msj] = sltE_a[eleIdx[msj]+eleSpn[msj]*Nsite];
+  }
+  return;
+}
+
+/* sum_j InvM[msa][j]*vec[j] with the current InvM */
+double complex calculateDelayRatio_fcmp(const int msa, const double complex *vec, const int qpidx) {
+  const int nsize = Nsize;
+  const double complex *invM_a = InvM + qpidx*Nsize*Nsize + msa*Nsize;
+  const double complex *u,*v;
+  double complex ratio,uVec,vVec;
+  int msj,k;
+
+  ratio = 0.0;
+  for(msj=0;msj<nsize;msj++) ratio += invM_a[msj] * vec[msj];
+
+  for(k=0;k<NDelayStored;k++) {
+    u = DelayU + (qpidx*NDelayUpdate+k)*Nsize;
+    v = DelayV + (qpidx*NDelayUpdate+k)*Nsize;
+    uVec = vVec = 0.0;
+    for(msj=0;msj<nsize;msj++) {
+      uVec += u[msj] * vec[msj];
+      vVec += v[msj] * vec[msj];
+    }
+    ratio += u[msa]*vVec - v[msa]*uVec;
+  }
+
+  return ratio;
+}
+
+double calculateDelayRatio_real(const int msa, const double *vec, const int qpidx) {
+  const int nsize = Nsize;
+  const double *invM_a = InvM_real + qpidx*Nsize*Nsize + msa*Nsize;
+  const double *u,*v;
+  double ratio,uVec,vVec;
+  int msj,k;
+
+  ratio = 0.0;
+  for(msj=0;msj<nsize;msj++) ratio += invM_a[msj] * vec[msj];
+
+  for(k=0;k<NDelayStored;k++) {
+    u = DelayU_real + (qpidx*NDelayUpdate+k)*Nsize;
+    v = DelayV_real + (qpidx*NDelayUpdate+k)*Nsize;
+    uVec = vVec = 0.0;
+    for(msj=0;msj<nsize;msj++) {
+      uVec += u[msj] * vec[msj];
+      vVec += v[msj] * vec[msj];
+    }
+    ratio += u[msa]*vVec - v[msa]*uVec;
+  }
+
+  return ratio;
+}
+
+/* Calculate new pfaffians with the stored updates.
+   The msa-th electron hops to rsa. eleSpn is NULL for the Sz-conserved case. */
+void CalculateNewPfMDelay_fcmp(const int msa, const int rsa, double complex *pfMNew,
+                               const int *eleIdx, const int *eleSpn,
+                               const int qpStart, const int qpEnd) {
+  const int qpNum = qpEnd-qpStart;
+  int qpidx;
+  double complex *vec;
+
+  RequestWorkSpaceThreadComplex(Nsize);
+
+  #pragma omp parallel default(shared) private(vec)
+  {
+    vec = GetWorkSpaceThreadComplex(Nsize);
+
+    #pragma omp for private(qpidx)
+    for(qpidx=0;qpidx<qpNum;qpidx++) {
+      getDelaySlaterElmRow_fcmp(vec, SlaterElm+(qpidx+qpStart)*Nsite2*NSlaterElmCol,
+                                rsa, eleIdx, eleSpn);
+      pfMNew[qpidx] = -calculateDelayRatio_fcmp(msa, vec, qpidx)*PfM[qpidx];
+    }
+  }
+
+  ReleaseWorkSpaceThreadComplex();
+  return;
+}
+
+void CalculateNewPfMDelay_real(const int msa, const int rsa, double *pfMNew,
+                               const int *eleIdx, const int *eleSpn,
+                               const int qpStart, const int qpEnd) {
+  const int qpNum = qpEnd-qpStart;
+  int qpidx;
+  double *vec;
+
+  RequestWorkSpaceThreadDouble(Nsize);
+
+  #pragma omp parallel default(shared) private(vec)
+  {
+    vec = GetWorkSpaceThreadDouble(Nsize);
+
+    #pragma omp for private(qpidx)
+    for(qpidx=0;qpidx<qpNum;qpidx++) {
+      getDelaySlaterElmRow_real(vec, SlaterElm_real+(qpidx+qpStart)*Nsite2*NSlaterElmCol,
+                                rsa, eleIdx, eleSpn);
+      pfMNew[qpidx] = -calculateDelayRatio_real(msa, vec, qpidx)*PfM_real[qpidx];
+    }
+  }
+
+  ReleaseWorkSpaceThreadDouble();
+  return;
+}
+
+/* Update PfM and store the update of InvM. The msa-th electron hops to rsa.
+   InvM is updated by ZGEMM (DGEMM) when NDelayUpdate hoppings are stored. */
+void UpdateMAllDelay_fcmp(const int msa, const int rsa, const int *eleIdx, const int *eleSpn,
+                          const int qpStart, const int qpEnd) {
+  const int qpNum = qpEnd-qpStart;
+  int qpidx;
+  double complex *vec;
+
+  RequestWorkSpaceThreadComplex(Nsize);
+
+  #pragma omp parallel default(shared) private(vec)
+  {
+    vec = GetWorkSpaceThreadComplex(Nsize);
+
+    #pragma omp for private(qpidx)
+    for(qpidx=0;qpidx<qpNum;qpidx++) {
+      updateMAllDelay_child_fcmp(msa, rsa, eleIdx, eleSpn, qpStart, qpidx, vec);
+    }
+  }
+
+  ReleaseWorkSpaceThreadComplex();
+
+  NDelayStored++;
+  if(NDelayStored==NDelayUpdate) FlushDelayMAll_fcmp(qpStart, qpEnd);
+  return;
+}
+
+void UpdateMAllDelay_real(const int msa, const int rsa, const int *eleIdx, const int *eleSpn,
+                          const int qpStart, const int qpEnd) {
+  const int qpNum = qpEnd-qpStart;
+  int qpidx;
+  double *vec;
+
+  RequestWorkSpaceThreadDouble(Nsize);
+
+  #pragma omp parallel default(shared) private(vec)
+  {
+    vec = GetWorkSpaceThreadDouble(Nsize);
+
+    #pragma omp for private(qpidx)
+    for(qpidx=0;qpidx<qpNum;qpidx++) {
+      updateMAllDelay_child_real(msa, rsa, eleIdx, eleSpn, qpStart, qpidx, vec);
+    }
+  }
+
+  ReleaseWorkSpaceThreadDouble();
+
+  NDelayStored++;
+  if(NDelayStored==NDelayUpdate) FlushDelayMAll_real(qpStart, qpEnd);
+  return;
+}
+
+/* The same update as updateMAll_child:
+   vec1 = InvM*vec, vec2 = -InvM[a]/vec1[a],
+   InvM += (vec1+e_a) vec2^T - vec2 (vec1+e_a)^T */
+void updateMAllDelay_child_fcmp(const int msa, const int rsa, const int *eleIdx, const int *eleSpn,
+                                const int qpStart, const int qpidx, double complex *vec) {
+  const int nsize = Nsize;
+  const int nStored = NDelayStored;
+  const char transT='T';
+  const int one=1;
+  const double complex cOne=1.0, cZero=0.0;
+  double complex *invM = InvM + qpidx*Nsize*Nsize;
+  double complex *invM_a = invM + msa*Nsize;
+  double complex *uNew = DelayU + (qpidx*NDelayUpdate+nStored)*Nsize;
+  double complex *vNew = DelayV + (qpidx*NDelayUpdate+nStored)*Nsize;
+  const double complex *u,*v;
+  double complex uVec,vVec,u_a,v_a,invVec1_a;
+  int msj,k;
+
+  getDelaySlaterElmRow_fcmp(vec, SlaterElm+(qpidx+qpStart)*Nsite2*NSlaterElmCol,
+                            rsa, eleIdx, eleSpn);
+
+  /* uNew = InvM*vec, vNew = InvM[a] with the stored updates */
+  M_ZGEMV(&transT,&nsize,&nsize,&cOne,invM,&nsize,vec,&one,&cZero,uNew,&one);
+  for(msj=0;msj<nsize;msj++) vNew[msj] = invM_a[msj];
+
+  for(k=0;k<nStored;k++) {
+    u = DelayU + (qpidx*NDelayUpdate+k)*Nsize;
+    v = DelayV + (qpidx*NDelayUpdate+k)*Nsize;
+    uVec = vVec = 0.0;
+    for(msj=0;msj<nsize;msj++) {
+      uVec += u[msj] * vec[msj];
+      vVec += v[msj] * vec[msj];
+    }
+    u_a = u[msa];
+    v_a = v[msa];
+    for(msj=0;msj<nsize;msj++) {
+      uNew[msj] += u[msj]*vVec - v[msj]*uVec;
+      vNew[msj] += u_a*v[msj] - v_a*u[msj];
+    }
+  }
+
+  /* Update Pfaffian */
+  PfM[qpidx] *= -uNew[msa];
+  invVec1_a = -1.0/uNew[msa];
+
+  for(msj=0;msj<nsize;msj++) vNew[msj] *= invVec1_a;
+  uNew[msa] += 1.0;
+
+  return;
+}
+
+void updateMAllDelay_child_real(const int msa, const int rsa, const int *eleIdx, const int *eleSpn,
+                                const int qpStart, const int qpidx, double *vec) {
+  const int nsize = Nsize;
+  const int nStored = NDelayStored;
+  const char transT='T';
+  const int one=1;
+  const double dOne=1.0, dZero=0.0;
+  double *invM = InvM_real + qpidx*Nsize*Nsize;
+  double *invM_a = invM + msa*Nsize;
+  double *uNew = DelayU_real + (qpidx*NDelayUpdate+nStored)*Nsize;
+  double *vNew = DelayV_real + (qpidx*NDelayUpdate+nStored)*Nsize;
+  const double *u,*v;
+  double uVec,vVec,u_a,v_a,invVec1_a;
+  int msj,k;
+
+  getDelaySlaterElmRow_real(vec, SlaterElm_real+(qpidx+qpStart)*Nsite2*NSlaterElmCol,
+                            rsa, eleIdx, eleSpn);
+
+  /* uNew = InvM*vec, vNew = InvM[a] with the stored updates */
+  M_DGEMV(&transT,&nsize,&nsize,&dOne,invM,&nsize,vec,&one,&dZero,uNew,&one);
+  for(msj=0;msj<nsize;msj++) vNew[msj] = invM_a[msj];
+
+  for(k=0;k<nStored;k++) {
+    u = DelayU_real + (qpidx*NDelayUpdate+k)*Nsize;
+    v = DelayV_real + (qpidx*NDelayUpdate+k)*Nsize;
+    uVec = vVec = 0.0;
+    for(msj=0;msj<nsize;msj++) {
+      uVec += u[msj] * vec[msj];
+      vVec += v[msj] * vec[msj];
+    }
+    u_a = u[msa];
+    v_a = v[msa];
+    for(msj=0;msj<nsize;msj++) {
+      uNew[msj] += u[msj]*vVec - v[msj]*uVec;
+      vNew[msj] += u_a*v[msj] - v_a*u[msj];
+    }
+  }
+
+  /* Update Pfaffian */
+  PfM_real[qpidx] *= -uNew[msa];
+  invVec1_a = -1.0/uNew[msa];
+
+  for(msj=0;msj<nsize;msj++) vNew[msj] *= invVec1_a;
+  uNew[msa] += 1.0;
+
+  return;
+}
+
+#endif
@@ -87,6 +87,11 @@ void CalculateNewPfM2_fsz(const int ma, const int s, double complex *pfMNew, con
   /* optimization for Kei */
   const int nsize = Nsize;
 
+  if(NDelayStored>0) {
+    CalculateNewPfMDelay_fcmp(msa, rsa, pfMNew, eleIdx, eleSpn, qpStart, qpEnd);
+    return;
+  }
+
   #pragma omp parallel for default(shared)        \
     private(qpidx,msj,sltE_a,invM_a,ratio,rsj)
   #pragma loop noalias
@@ -117,6 +122,11 @@ void UpdateMAll_fsz(const int ma, const int s, const int *eleIdx,const int *eleS
   int qpidx;
   double complex *vec1,*vec2;
 
+  if(NDelayUpdate>1) {
+    UpdateMAllDelay_fcmp(ma, eleIdx[ma]+s*Nsite, eleIdx, eleSpn, qpStart, qpEnd);
+    return;
+  }
+
   RequestWorkSpaceThreadComplex(2*Nsize);
 
   #pragma omp parallel default(shared) private(vec1,vec2)
@@ -81,6 +81,11 @@ void CalculateNewPfM2_fsz_real(const int ma, const int s, double *pfMNew, const
   /* optimization for Kei */
   const int nsize = Nsize;
 
+  if(NDelayStored>0) {
+    CalculateNewPfMDelay_real(msa, rsa, pfMNew, eleIdx, eleSpn, qpStart, qpEnd);
+    return;
+  }
+
   #pragma omp parallel for default(shared)        \
     private(qpidx,msj,sltE_a,invM_a,ratio,rsj)
   #pragma loop noalias
@@ -107,6 +112,11 @@ void UpdateMAll_fsz_real(const int ma, const int s, const int *eleIdx,const int
   int qpidx;
   double *vec1,*vec2;
 
+  if(NDelayUpdate>1) {
+    UpdateMAllDelay_real(ma, eleIdx[ma]+s*Nsite, eleIdx, eleSpn, qpStart, qpEnd);
+    return;
+  }
+
   RequestWorkSpaceThreadDouble(2*Nsize);
 
   #pragma omp parallel default(shared) private(vec1,vec2)
@@ -32,7 +32,8 @@ along with this program. If not, see http://www.gnu.org/licenses/.
 
 void updateMAll_child_real(const int ma, const int s, const int *eleIdx,
                       const int qpStart, const int qpEnd, const int qpidx,
-                      double *vec1, double *vec2);
+                      double *vec1, double *vec2,
+                      double *PfM_real, double *InvM_real);
 
 double calculateNewPfMBFN4_real_child(const int qpidx, const int n, const int *msa,
                                  const int *eleIdx, const double *bufM);
@@ -45,37 +46,50 @@ void CalculateNewPfM_real(const int ma, const int s, double *pfMNew_real, const
                      const int qpStart, const int qpEnd) {
   #pragma procedure serial
   const int qpNum = qpEnd-qpStart;
+  int qpidx;
+
+  #pragma loop noalias
+  for(qpidx=0;qpidx<qpNum;qpidx++) {
+    calculateNewPfM_child_real(ma, s, pfMNew_real, eleIdx, qpStart, qpEnd, qpidx, PfM_real, InvM_real);
+  }
+
+  return;
+}
+
+void calculateNewPfM_child_real(const int ma, const int s, double *pfMNew_real, const int *eleIdx,
+                                const int qpStart, const int qpEnd, const int qpidx,
+                                const double *PfM_real, const double *InvM_real) {
+  #pragma procedure serial
   const int msa = ma+s*Ne;
   const int rsa = eleIdx[msa] + s*Nsite;
+  /* the same-spin block of SlaterElm is not stored in the compact layout */
+  const int msjStart = (FlagSlaterElmCompact==1 && s==0) ? Ne : 0;
+  const int msjEnd = (FlagSlaterElmCompact==1 && s==1) ? Ne : Nsize;
+  const int dnOff = NSlaterElmCol-Nsite;
 
-  int qpidx;
   int msj,rsj;
   const double *sltE_a; /* update elements of msa-th row */
   const double *invM_a;
   double ratio;
 
   /* optimization for Kei */
-  const int nsize = Nsize;
   const int ne = Ne;
 
-  #pragma loop noalias
-  for(qpidx=0;qpidx<qpNum;qpidx++) {
-    sltE_a = SlaterElm_real + (qpidx+qpStart)*Nsite2*Nsite2 + rsa*Nsite2;
-    invM_a = InvM_real + qpidx*Nsize*Nsize + msa*Nsize;
+  sltE_a = SlaterElm_real + (qpidx+qpStart)*Nsite2*NSlaterElmCol + rsa*NSlaterElmCol;
+  invM_a = InvM_real + qpidx*Nsize*Nsize + msa*Nsize;
 
-    ratio = 0.0;
-    for(msj=0;msj<ne;msj++) {
-      rsj = eleIdx[msj];
-      ratio += invM_a[msj] * sltE_a[rsj];
-    }
-    for(msj=ne;msj<nsize;msj++) {
-      rsj = eleIdx[msj] + Nsite;
-      ratio += invM_a[msj] * sltE_a[rsj];
-    }
-
-    pfMNew_real[qpidx] = -ratio*PfM_real[qpidx];
+  ratio = 0.0;
+  for(msj=msjStart;msj<ne;msj++) {
+    rsj = eleIdx[msj];
+    ratio += invM_a[msj] * sltE_a[rsj];
+  }
+  for(msj=ne;msj<msjEnd;msj++) {
+    rsj = eleIdx[msj] + dnOff;
+    ratio += invM_a[msj] * sltE_a[rsj];
   }
 
+  pfMNew_real[qpidx] = -ratio*PfM_real[qpidx];
+
   return;
 }
 
@@ -85,6 +99,10 @@ void CalculateNewPfM2_real(const int ma, const int s, double *pfMNew_real, const
   const int qpNum = qpEnd-qpStart;
   const int msa = ma+s*Ne;
   const int rsa = eleIdx[msa] + s*Nsite;
+  /* the same-spin block of SlaterElm is not stored in the compact layout */
+  const int msjStart = (FlagSlaterElmCompact==1 && s==0) ? Ne : 0;
+  const int msjEnd = (FlagSlaterElmCompact==1 && s==1) ? Ne : Nsize;
+  const int dnOff = NSlaterElmCol-Nsite;
 
   int qpidx;
   int msj,rsj;
@@ -93,23 +111,27 @@ void CalculateNewPfM2_real(const int ma, const int s, double *pfMNew_real, const
   double ratio;
 
   /* optimization for Kei */
-  const int nsize = Nsize;
   const int ne = Ne;
 
+  if(NDelayStored>0) {
+    CalculateNewPfMDelay_real(msa, rsa, pfMNew_real, eleIdx, NULL, qpStart, qpEnd);
+    return;
+  }
+
   #pragma omp parallel for default(shared)        \
     private(qpidx,msj,sltE_a,invM_a,ratio,rsj)
   #pragma loop noalias
   for(qpidx=0;qpidx<qpNum;qpidx++) {
-    sltE_a = SlaterElm_real + (qpidx+qpStart)*Nsite2*Nsite2 + rsa*Nsite2;
+    sltE_a = SlaterElm_real + (qpidx+qpStart)*Nsite2*NSlaterElmCol + rsa*NSlaterElmCol;
     invM_a = InvM_real + qpidx*Nsize*Nsize + msa*Nsize;
 
     ratio = 0.0;
-    for(msj=0;msj<ne;msj++) {
+    for(msj=msjStart;msj<ne;msj++) {
       rsj = eleIdx[msj];
       ratio += invM_a[msj] * sltE_a[rsj];
     }
-    for(msj=ne;msj<nsize;msj++) {
-      rsj = eleIdx[msj] + Nsite;
+    for(msj=ne;msj<msjEnd;msj++) {
+      rsj = eleIdx[msj] + dnOff;
       ratio += invM_a[msj] * sltE_a[rsj];
     }
 
@@ -126,6 +148,11 @@ void UpdateMAll_real(const int ma, const int s, const int *eleIdx,
   int qpidx;
   double *vec1,*vec2;
 
+  if(NDelayUpdate>1) {
+    UpdateMAllDelay_real(ma+s*Ne, eleIdx[ma+s*Ne]+s*Nsite, eleIdx, NULL, qpStart, qpEnd);
+    return;
+  }
+
   RequestWorkSpaceThreadDouble(2*Nsize);
 
   #pragma omp parallel default(shared) private(vec1,vec2)
@@ -136,7 +163,7 @@ void UpdateMAll_real(const int ma, const int s, const int *eleIdx,
     #pragma omp for private(qpidx)
     #pragma loop nounroll
     for(qpidx=0;qpidx<qpNum;qpidx++) {
-      updateMAll_child_real(ma, s, eleIdx, qpStart, qpEnd, qpidx, vec1, vec2);
+      updateMAll_child_real(ma, s, eleIdx, qpStart, qpEnd, qpidx, vec1, vec2, PfM_real, InvM_real);
     }
   }
 
@@ -146,11 +173,16 @@ void UpdateMAll_real(const int ma, const int s, const int *eleIdx,
 
 void updateMAll_child_real(const int ma, const int s, const int *eleIdx,
                       const int qpStart, const int qpEnd, const int qpidx,
-                      double *vec1, double *vec2) {
+                      double *vec1, double *vec2,
+                      double *PfM_real, double *InvM_real) {
   #pragma procedure serial
   /* const int qpNum = qpEnd-qpStart; */
   const int msa = ma+s*Ne;
   const int rsa = eleIdx[msa] + s*Nsite;
+  /* the same-spin block of SlaterElm is not stored in the compact layout */
+  const int msjStart = (FlagSlaterElmCompact==1 && s==0) ? Ne : 0;
+  const int msjEnd = (FlagSlaterElmCompact==1 && s==1) ? Ne : Nsize;
+  const int dnOff = NSlaterElmCol-Nsite;
   const int nsize = Nsize; /* optimization for Kei */
 
   int msi,msj,rsj;
@@ -164,7 +196,7 @@ void updateMAll_child_real(const int ma, const int s, const int *eleIdx,
   double invVec1_a;
   double tmp;
 
-  sltE_a = SlaterElm_real + (qpidx+qpStart)*Nsite2*Nsite2 + rsa*Nsite2;
+  sltE_a = SlaterElm_real + (qpidx+qpStart)*Nsite2*NSlaterElmCol + rsa*NSlaterElmCol;
 
   invM = InvM_real + qpidx*Nsize*Nsize;
   invM_a = invM + msa*Nsize;
@@ -174,8 +206,8 @@ void updateMAll_child_real(const int ma, const int s, const int *eleIdx,
   /* Calculate vec1[i] = sum_j invM[i][j] sltE[a][j] */
   /* Note tah invM[i][j] = -invM[j][i] */
   #pragma loop noalias
-  for(msj=0;msj<nsize;msj++) {
-    rsj = eleIdx[msj] + (msj/Ne)*Nsite;
+  for(msj=msjStart;msj<msjEnd;msj++) {
+    rsj = eleIdx[msj] + (msj/Ne)*dnOff;
     sltE_aj = sltE_a[rsj];
     invM_j = invM + msj*Nsize;
 
@@ -32,11 +32,13 @@ along with this program. If not, see http://www.gnu.org/licenses/.
 void calculateNewPfMTwo_child_fcmp(const int ma, const int s, const int mb, const int t,
                               double complex *pfMNew, const int *eleIdx,
                               const int qpStart, const int qpEnd, const int qpidx,
-                              double complex *vec_a, double complex *vec_b);
+                              double complex *vec_a, double complex *vec_b,
+                              double complex *PfM, double complex *InvM);
 void updateMAllTwo_child_fcmp(const int ma, const int s, const int mb, const int t,
                          const int raOld, const int rbOld,
                          const int *eleIdx, const int qpStart, const int qpEnd, const int qpidx,
-                         double complex *vecP, double complex *vecQ, double complex *vecS, double complex *vecT);
+                         double complex *vecP, double complex *vecQ, double complex *vecS, double complex *vecT,
+                         double complex *PfM, double complex *InvM);
 
 /* Calculate new pfaffian. 
    The ma-th electron with spin s hops
@@ -60,7 +62,7 @@ void CalculateNewPfMTwo_fcmp(const int ma, const int s, const int mb, const int
 
   for(qpidx=0;qpidx<qpNum;qpidx++) {
     calculateNewPfMTwo_child_fcmp(ma, s, mb, t, pfMNew, eleIdx,
-                             qpStart, qpEnd, qpidx, vec_a, vec_b);
+                             qpStart, qpEnd, qpidx, vec_a, vec_b, PfM, InvM);
   }
 
   return;
@@ -79,6 +81,9 @@ void CalculateNewPfMTwo2_fcmp(const int ma, const int s, const int mb, const int
   int qpidx;
   double complex *vec_a,*vec_b;
 
+  /* the two-electron update reads the whole InvM */
+  FlushDelayMAll_fcmp(qpStart, qpEnd);
+
   if(msa==msb) {
     CalculateNewPfM2(mb, t, pfMNew, eleIdx, qpStart, qpEnd);
     return;
@@ -95,7 +100,7 @@ void CalculateNewPfMTwo2_fcmp(const int ma, const int s, const int mb, const int
     #pragma loop nounroll
     for(qpidx=0;qpidx<qpNum;qpidx++) {
       calculateNewPfMTwo_child_fcmp(ma, s, mb, t, pfMNew, eleIdx,
-                               qpStart, qpEnd, qpidx, vec_a, vec_b);
+                               qpStart, qpEnd, qpidx, vec_a, vec_b, PfM, InvM);
     }
   }
   
@@ -107,7 +112,8 @@ void CalculateNewPfMTwo2_fcmp(const int ma, const int s, const int mb, const int
 void calculateNewPfMTwo_child_fcmp(const int ma, const int s, const int mb, const int t,
                               double complex *pfMNew, const int *eleIdx,
                               const int qpStart, const int qpEnd, const int qpidx,
-                              double complex *vec_a, double complex *vec_b) {
+                              double complex *vec_a, double complex *vec_b,
+                              double complex *PfM, double complex *InvM) {
   #pragma procedure serial
   /* const int qpNum = qpEnd-qpStart; */
   const int msa = ma+s*Ne;
@@ -117,14 +123,11 @@ void calculateNewPfMTwo_child_fcmp(const int ma, const int s, const int mb, cons
   const int nsize = Nsize;
 
   int msi,msj;
-  int rsi;
 
   double complex p_a,p_b,q_a,q_b,bMa;
   double complex ratio,tmp;
 
   const double complex *sltE;
-  const double complex *sltE_a; /* update elements of msa-th row */
-  const double complex *sltE_b; /* update elements of msb-th row */
 
   double complex *invM;
   const double complex *invM_a, *invM_b, *invM_i;
@@ -132,16 +135,11 @@ void calculateNewPfMTwo_child_fcmp(const int ma, const int s, const int mb, cons
 
   double complex vec_ba,vec_ai,vec_bi;
 
-  sltE = SlaterElm + (qpidx+qpStart)*Nsite2*Nsite2;
-  sltE_a = sltE + rsa*Nsite2;
-  sltE_b = sltE + rsb*Nsite2;
+  sltE = SlaterElm + (qpidx+qpStart)*Nsite2*NSlaterElmCol;
 
-  #pragma loop noalias
-  for(msi=0;msi<nsize;msi++) {
-    rsi = eleIdx[msi] + (msi/Ne)*Nsite;
-    vec_a[msi] = sltE_a[rsi];
-    vec_b[msi] = sltE_b[rsi];
-  }
+  /* update elements of msa-th and msb-th rows */
+  GetSlaterElmRow_fcmp(vec_a, sltE, rsa, eleIdx);
+  GetSlaterElmRow_fcmp(vec_b, sltE, rsb, eleIdx);
   vec_ba = vec_b[msa];
 
   invM = InvM + qpidx*Nsize*Nsize;
@@ -193,6 +191,9 @@ void UpdateMAllTwo_fcmp(const int ma, const int s, const int mb, const int t,
   int qpidx;
   double complex *vec1,*vec2,*vec3,*vec4;
 
+  /* the two-electron update reads the whole InvM */
+  FlushDelayMAll_fcmp(qpStart, qpEnd);
+
   RequestWorkSpaceThreadComplex(4*Nsize);
 
 #pragma omp parallel default(shared) private(vec1,vec2,vec3,vec4,qpidx)
@@ -206,7 +207,7 @@ void UpdateMAllTwo_fcmp(const int ma, const int s, const int mb, const int t,
     #pragma loop nounroll
     for(qpidx=0;qpidx<qpNum;qpidx++) {
       updateMAllTwo_child_fcmp(ma, s, mb, t, raOld, rbOld, eleIdx, qpStart, qpEnd, qpidx,
-                          vec1, vec2, vec3, vec4);
+                          vec1, vec2, vec3, vec4, PfM, InvM);
     }
   }
 
@@ -217,7 +218,8 @@ void UpdateMAllTwo_fcmp(const int ma, const int s, const int mb, const int t,
 void updateMAllTwo_child_fcmp(const int ma, const int s, const int mb, const int t,
                          const int raOld, const int rbOld,
                          const int *eleIdx, const int qpStart, const int qpEnd, const int qpidx,
-                         double complex *vecP, double complex *vecQ, double complex *vecS, double complex *vecT) {
+                         double complex *vecP, double complex *vecQ, double complex *vecS, double complex *vecT,
+                         double complex *PfM, double complex *InvM) {
   #pragma procedure serial
   const int msa = ma+s*Ne;
   const int msb = mb+t*Ne;
@@ -227,10 +229,8 @@ void updateMAllTwo_child_fcmp(const int ma, const int s, const int mb, const int
   const int rsbOld = raOld + t*Nsite;
   const int nsize = Nsize;
 
-  const double complex *sltE = SlaterElm + (qpidx+qpStart)*Nsite2*Nsite2;;
-  const double complex *sltE_a = sltE + rsa*Nsite2; /* update elements of msa-th row */
-  const double complex *sltE_b = sltE + rsb*Nsite2; /* update elements of msb-th row */
-  const double complex mOld_ab = sltE[rsaOld*Nsite2 + rsbOld];
+  const double complex *sltE = SlaterElm + (qpidx+qpStart)*Nsite2*NSlaterElmCol;
+  const double complex mOld_ab = GetSlaterElm_fcmp(sltE, rsaOld, rsbOld);
 
   double complex *invM = InvM + qpidx*Nsize*Nsize;
   double complex *invM_a = invM + msa*Nsize;
@@ -243,7 +243,6 @@ void updateMAllTwo_child_fcmp(const int ma, const int s, const int mb, const int
   double complex p_i,p_j,q_i,q_j,s_i,s_j,t_i,t_j;
 
   int msi,msj;
-  int rsi;
 
   /* initialize vecP[i], vecQ[i] */
   /* vecS[i], vecT[i] are temporally used as
@@ -252,10 +251,9 @@ void updateMAllTwo_child_fcmp(const int ma, const int s, const int mb, const int
   for(msi=0;msi<nsize;msi++) {
     vecP[msi]=0.0;
     vecQ[msi]=0.0;
-    rsi = eleIdx[msi] + (msi/Ne)*Nsite;
-    vecS[msi]=sltE_a[rsi];
-    vecT[msi]=sltE_b[rsi];
   }
+  GetSlaterElmRow_fcmp(vecS, sltE, rsa, eleIdx);
+  GetSlaterElmRow_fcmp(vecT, sltE, rsb, eleIdx);
   /* Set vecS[b] = mOld_ab, which is (a,b)-elements of the old M. */
   vecS[msb] = mOld_ab;
 
@@ -84,6 +84,9 @@ void CalculateNewPfMTwo2_fsz(const int ma, const int s, const int mb, const int
   int qpidx;
   double complex *vec_a,*vec_b;
 
+  /* the two-electron update reads the whole InvM */
+  FlushDelayMAll_fcmp(qpStart, qpEnd);
+
   if(msa==msb) {
     CalculateNewPfM2_fsz(mb, t, pfMNew, eleIdx,eleSpn, qpStart, qpEnd);
     return;
@@ -198,6 +201,9 @@ void UpdateMAllTwo_fsz(const int ma, const int s, const int mb, const int t,
   int qpidx;
   double complex *vec1,*vec2,*vec3,*vec4;
 
+  /* the two-electron update reads the whole InvM */
+  FlushDelayMAll_fcmp(qpStart, qpEnd);
+
   RequestWorkSpaceThreadComplex(4*Nsize);
 
 #pragma omp parallel default(shared) private(vec1,vec2,vec3,vec4,qpidx)
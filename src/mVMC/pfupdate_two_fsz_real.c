@@ -70,6 +70,9 @@ void CalculateNewPfMTwo2_fsz_real(const int ma, const int s, const int mb, const
   int qpidx;
   double *vec_a,*vec_b;
 
+  /* the two-electron update reads the whole InvM */
+  FlushDelayMAll_real(qpStart, qpEnd);
+
   if(msa==msb) {
     CalculateNewPfM2_fsz_real(mb, t, pfMNew, eleIdx,eleSpn, qpStart, qpEnd);
     return;
@@ -184,6 +187,9 @@ void UpdateMAllTwo_fsz_real(const int ma, const int s, const int mb, const int t
   int qpidx;
   double *vec1,*vec2,*vec3,*vec4;
 
+  /* the two-electron update reads the whole InvM */
+  FlushDelayMAll_real(qpStart, qpEnd);
+
   RequestWorkSpaceThreadDouble(4*Nsize);
 
 #pragma omp parallel default(shared) private(vec1,vec2,vec3,vec4,qpidx)
@@ -33,12 +33,14 @@ along with this program. If not, see http://www.gnu.org/licenses/.
 void calculateNewPfMTwo_child_real(const int ma, const int s, const int mb, const int t,
                               double *pfMNew_real, const int *eleIdx,
                               const int qpStart, const int qpEnd, const int qpidx,
-                              double *vec_a, double *vec_b);
+                              double *vec_a, double *vec_b,
+                              double *PfM_real, double *InvM_real);
 
 void updateMAllTwo_child_real(const int ma, const int s, const int mb, const int t,
                          const int raOld, const int rbOld,
                          const int *eleIdx, const int qpStart, const int qpEnd, const int qpidx,
-                         double *vecP, double *vecQ, double *vecS, double *vecT);
+                         double *vecP, double *vecQ, double *vecS, double *vecT,
+                         double *PfM_real, double *InvM_real);
 
 /* Calculate new pfaffian. 
    The ma-th electron with spin s hops
@@ -62,7 +64,7 @@ void CalculateNewPfMTwo_real(const int ma, const int s, const int mb, const int
 
   for(qpidx=0;qpidx<qpNum;qpidx++) {
     calculateNewPfMTwo_child_real(ma, s, mb, t, pfMNew_real, eleIdx,
-                             qpStart, qpEnd, qpidx, vec_a, vec_b);
+                             qpStart, qpEnd, qpidx, vec_a, vec_b, PfM_real, InvM_real);
   }
 
   return;
@@ -81,6 +83,9 @@ void CalculateNewPfMTwo2_real(const int ma, const int s, const int mb, const int
   int qpidx;
   double *vec_a,*vec_b;
 
+  /* the two-electron update reads the whole InvM */
+  FlushDelayMAll_real(qpStart, qpEnd);
+
   if(msa==msb) {
     CalculateNewPfM2_real(mb, t, pfMNew_real, eleIdx, qpStart, qpEnd);
     return;
@@ -97,7 +102,7 @@ void CalculateNewPfMTwo2_real(const int ma, const int s, const int mb, const int
     #pragma loop nounroll
     for(qpidx=0;qpidx<qpNum;qpidx++) {
       calculateNewPfMTwo_child_real(ma, s, mb, t, pfMNew_real, eleIdx,
-                               qpStart, qpEnd, qpidx, vec_a, vec_b);
+                               qpStart, qpEnd, qpidx, vec_a, vec_b, PfM_real, InvM_real);
     }
   }
   
@@ -108,7 +113,8 @@ void CalculateNewPfMTwo2_real(const int ma, const int s, const int mb, const int
 void calculateNewPfMTwo_child_real(const int ma, const int s, const int mb, const int t,
                               double *pfMNew_real, const int *eleIdx,
                               const int qpStart, const int qpEnd, const int qpidx,
-                              double *vec_a, double *vec_b) {
+                              double *vec_a, double *vec_b,
+                              double *PfM_real, double *InvM_real) {
   #pragma procedure serial
   /* const int qpNum = qpEnd-qpStart; */
   const int msa = ma+s*Ne;
@@ -118,14 +124,11 @@ void calculateNewPfMTwo_child_real(const int ma, const int s, const int mb, cons
   const int nsize = Nsize;
 
   int msi,msj;
-  int rsi;
 
   double p_a,p_b,q_a,q_b,bMa;
   double ratio,tmp;
 
   const double *sltE;
-  const double *sltE_a; /* update elements of msa-th row */
-  const double *sltE_b; /* update elements of msb-th row */
 
   double *invM;
   const double *invM_a, *invM_b, *invM_i;
@@ -133,16 +136,11 @@ void calculateNewPfMTwo_child_real(const int ma, const int s, const int mb, cons
 
   double vec_ba,vec_ai,vec_bi;
 
-  sltE = SlaterElm_real + (qpidx+qpStart)*Nsite2*Nsite2;//TBC
-  sltE_a = sltE + rsa*Nsite2;
-  sltE_b = sltE + rsb*Nsite2;
+  sltE = SlaterElm_real + (qpidx+qpStart)*Nsite2*NSlaterElmCol;//TBC
 
-  #pragma loop noalias
-  for(msi=0;msi<nsize;msi++) {
-    rsi = eleIdx[msi] + (msi/Ne)*Nsite;
-    vec_a[msi] = sltE_a[rsi];
-    vec_b[msi] = sltE_b[rsi];
-  }
+  /* update elements of msa-th and msb-th rows */
+  GetSlaterElmRow_real(vec_a, sltE, rsa, eleIdx);
+  GetSlaterElmRow_real(vec_b, sltE, rsb, eleIdx);
   vec_ba = vec_b[msa];
 
   invM = InvM_real + qpidx*Nsize*Nsize; //TBC
@@ -193,6 +191,9 @@ void UpdateMAllTwo_real(const int ma, const int s, const int mb, const int t,
   int qpidx;
   double *vec1,*vec2,*vec3,*vec4;
 
+  /* the two-electron update reads the whole InvM */
+  FlushDelayMAll_real(qpStart, qpEnd);
+
   RequestWorkSpaceThreadDouble(4*Nsize);
 
 #pragma omp parallel default(shared) private(vec1,vec2,vec3,vec4,qpidx)
@@ -206,7 +207,7 @@ void UpdateMAllTwo_real(const int ma, const int s, const int mb, const int t,
     #pragma loop nounroll
     for(qpidx=0;qpidx<qpNum;qpidx++) {
       updateMAllTwo_child_real(ma, s, mb, t, raOld, rbOld, eleIdx, qpStart, qpEnd, qpidx,
-                          vec1, vec2, vec3, vec4);
+                          vec1, vec2, vec3, vec4, PfM_real, InvM_real);
     }
   }
 
@@ -217,7 +218,8 @@ void UpdateMAllTwo_real(const int ma, const int s, const int mb, const int t,
 void updateMAllTwo_child_real(const int ma, const int s, const int mb, const int t,
                          const int raOld, const int rbOld,
                          const int *eleIdx, const int qpStart, const int qpEnd, const int qpidx,
-                         double *vecP, double *vecQ, double *vecS, double *vecT) {
+                         double *vecP, double *vecQ, double *vecS, double *vecT,
+                         double *PfM_real, double *InvM_real) {
   #pragma procedure serial
   const int msa = ma+s*Ne;
   const int msb = mb+t*Ne;
@@ -227,10 +229,8 @@ void updateMAllTwo_child_real(const int ma, const int s, const int mb, const int
   const int rsbOld = raOld + t*Nsite;
   const int nsize = Nsize;
 
-  const double *sltE = SlaterElm_real + (qpidx+qpStart)*Nsite2*Nsite2;; //TBC
-  const double *sltE_a = sltE + rsa*Nsite2; /* update elements of msa-th row */
-  const double *sltE_b = sltE + rsb*Nsite2; /* update elements of msb-th row */
-  const double mOld_ab = sltE[rsaOld*Nsite2 + rsbOld];
+  const double *sltE = SlaterElm_real + (qpidx+qpStart)*Nsite2*NSlaterElmCol; //TBC
+  const double mOld_ab = GetSlaterElm_real(sltE, rsaOld, rsbOld);
 
   double *invM = InvM_real + qpidx*Nsize*Nsize;
   double *invM_a = invM + msa*Nsize;
@@ -243,7 +243,6 @@ void updateMAllTwo_child_real(const int ma, const int s, const int mb, const int
   double p_i,p_j,q_i,q_j,s_i,s_j,t_i,t_j;
 
   int msi,msj;
-  int rsi;
 
   /* initialize vecP[i], vecQ[i] */
   /* vecS[i], vecT[i] are temporally used as
@@ -252,10 +251,9 @@ void updateMAllTwo_child_real(const int ma, const int s, const int mb, const int
   for(msi=0;msi<nsize;msi++) {
     vecP[msi]=0.0;
     vecQ[msi]=0.0;
-    rsi = eleIdx[msi] + (msi/Ne)*Nsite;
-    vecS[msi]=sltE_a[rsi];
-    vecT[msi]=sltE_b[rsi];
   }
+  GetSlaterElmRow_real(vecS, sltE, rsa, eleIdx);
+  GetSlaterElmRow_real(vecT, sltE, rsb, eleIdx);
   /* Set vecS[b] = mOld_ab, which is (a,b)-elements of the old M. */
   vecS[msb] = mOld_ab;
 
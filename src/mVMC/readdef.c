@@ -89,11 +89,33 @@ int GetInfoInterAll(FILE *fp, int **ArrayIdx, double complex *ArrayValue,
 int GetInfoOptTrans(FILE *fp, int **Array, double *ArrayPara, int *ArrayOpt, int **ArraySgn,
                     int _iFlagOptTrans, int *iOptCount, int _fidx, int _APFlag, int Nsite, int NArray, char *defname);
 
+int GetInfoMomentum(FILE *fp, double complex *ArrayExp, int Nsite, int NArray, char *defname) {
+  char ctmp2[256];
+  int idx = 0, info = 0;
+  int x0 = 0, x1 = 0;
+  double dPhase = 0.0;
+  if (NArray == 0) return 0;
+  while (fgets(ctmp2, sizeof(ctmp2) / sizeof(char), fp) != NULL) {
+    if (sscanf(ctmp2, "%d %d %lf\n", &x0, &x1, &dPhase) != 3) continue;
+    if (x0 < 0 || x0 >= NArray || CheckSite(x1, Nsite) != 0) {
+      fprintf(stderr, "Error: Momentum or site index is incorrect. \n");
+      info = 1;
+      break;
+    }
+    ArrayExp[x0 * Nsite + x1] = cexp(2.0 * M_PI * I * dPhase); // exp(i q.r) with the phase q.r/2pi
+    idx++;
+  }
+  if (idx != NArray * Nsite) info = ReadDefFileError(defname);
+  return info;
+}
+
 int GetInfoTwoBodyG(FILE *fp, int **ArrayIdx, int **ArrayIdxTwoBodyGLz, int **ArrayToIdx, int **ArrayIdxOneBodyG,
                     int _NLanczosMode, int Nsite, int NArray, char *defname);
 
 int GetInfoTwoBodyGEx(FILE *fp, int **ArrayIdx, int Nsite, int NArray, char *defname);
 
+int GetInfoMomentum(FILE *fp, double complex *ArrayExp, int Nsite, int NArray, char *defname);
+
 int GetInfoOrbitalGeneral(FILE *fp, int **Array, int *ArrayOpt, int **ArraySgn, int *iOptCount,
                           int _fidx, int _iComplexFlag, int _iFlagOrbitalGeneral, int _APFlag, int Nsite, int NArray,
                           char *defname);
@@ -460,6 +482,10 @@ int ReadDefFileNInt(char *xNameListFile, MPI_Comm comm) {
             }
             break;
 
+          case KWMomentum:
+            cerr = ReadBuffInt(fp, &bufInt[IdxNMomentum]);
+            break;
+
           case KWBFRange:
 #ifdef _NOTBACKFLOW
             fprintf(stderr, "Error: Back Flow is not supported.\n");
@@ -548,6 +574,196 @@ int ReadDefFileNInt(char *xNameListFile, MPI_Comm comm) {
       }
     }
 
+    //Check NVMCWalker
+    if (bufInt[IdxVMCWalker] < 1) {
+      bufInt[IdxVMCWalker] = 1;
+    } else if (bufInt[IdxVMCWalker] > 1) {
+#ifdef _pf_block_update
+      fprintf(stdout, "Warning: NVMCWalker (in modpara.def) is not supported with block Pfaffian updates.\n");
+      fprintf(stdout, "         NVMCWalker set as 1.\n");
+      bufInt[IdxVMCWalker] = 1;
+#else
+      if (bufInt[IdxSplitSize] > 1 || bufInt[IdxNBF] > 0 || iFlgOrbitalGeneral == 1) {
+        fprintf(stdout, "Warning: NVMCWalker (in modpara.def) must be 1 when NSplitSize > 1, backflow or general orbitals are used.\n");
+        fprintf(stdout, "         NVMCWalker set as 1.\n");
+        bufInt[IdxVMCWalker] = 1;
+      } else if (bufInt[IdxVMCWalker] > bufInt[IdxVMCSample]) {
+        fprintf(stdout, "Warning: NVMCWalker (in modpara.def) must not exceed NVMCSample.\n");
+        fprintf(stdout, "         NVMCWalker set as %d.\n", bufInt[IdxVMCSample]);
+        bufInt[IdxVMCWalker] = bufInt[IdxVMCSample];
+      }
+#endif
+    }
+
+    //Check NVMCBatch
+    if (bufInt[IdxVMCBatch] < 1) {
+      bufInt[IdxVMCBatch] = 1;
+    } else if (bufInt[IdxVMCBatch] > 1) {
+#ifdef _pf_block_update
+      fprintf(stdout, "Warning: NVMCBatch (in modpara.def) is not supported with block Pfaffian updates.\n");
+      fprintf(stdout, "         NVMCBatch set as 1.\n");
+      bufInt[IdxVMCBatch] = 1;
+#endif
+    }
+
+    //Check NVMCCalFuse
+    if (bufInt[IdxVMCCalFuse] != 0) {
+#ifdef _pf_block_update
+      fprintf(stdout, "Warning: NVMCCalFuse (in modpara.def) is not supported with block Pfaffian updates.\n");
+      fprintf(stdout, "         NVMCCalFuse set as 0.\n");
+      bufInt[IdxVMCCalFuse] = 0;
+#else
+      if (bufInt[IdxSplitSize] > 1 || bufInt[IdxNBF] > 0 || iFlgOrbitalGeneral == 1
+          || bufInt[IdxVMCWalker] > 1) {
+        fprintf(stdout, "Warning: NVMCCalFuse (in modpara.def) must be 0 when NSplitSize > 1, NVMCWalker > 1, backflow or general orbitals are used.\n");
+        fprintf(stdout, "         NVMCCalFuse set as 0.\n");
+        bufInt[IdxVMCCalFuse] = 0;
+      } else {
+        bufInt[IdxVMCCalFuse] = 1;
+      }
+#endif
+    }
+
+    //Check NVMCTempering
+    if (bufInt[IdxVMCTempering] < 1) {
+      fprintf(stdout, "Warning: NVMCTempering (in modpara.def) must be positive.\n");
+      fprintf(stdout, "         NVMCTempering set as 1.\n");
+      bufInt[IdxVMCTempering] = 1;
+    } else if (bufInt[IdxVMCTempering] > 1) {
+#ifdef _pf_block_update
+      fprintf(stdout, "Warning: NVMCTempering (in modpara.def) is not supported with block Pfaffian updates.\n");
+      fprintf(stdout, "         NVMCTempering set as 1.\n");
+      bufInt[IdxVMCTempering] = 1;
+#else
+      if (bufInt[IdxSplitSize] > 1 || bufInt[IdxNBF] > 0 || iFlgOrbitalGeneral == 1
+          || bufInt[IdxVMCWalker] > 1 || bufInt[IdxVMCCalFuse] != 0 || NSRCG == 2) {
+        fprintf(stdout, "Warning: NVMCTempering (in modpara.def) must be 1 when NSplitSize > 1, NVMCWalker > 1, NVMCCalFuse = 1, NSRCG = 2, backflow or general orbitals are used.\n");
+        fprintf(stdout, "         NVMCTempering set as 1.\n");
+        bufInt[IdxVMCTempering] = 1;
+      } else if (bufDouble[IdxVMCTemperingBeta] <= 0.0 || bufDouble[IdxVMCTemperingBeta] >= 1.0) {
+        fprintf(stdout, "Warning: DVMCTemperingBeta (in modpara.def) must be in (0,1).\n");
+        fprintf(stdout, "         DVMCTemperingBeta set as 0.5.\n");
+        bufDouble[IdxVMCTemperingBeta] = 0.5;
+      }
+#endif
+    }
+
+    //Check NVMCAutoCorr
+    if (bufInt[IdxVMCAutoCorr] < 0 || bufInt[IdxVMCAutoCorr] > 2) {
+      fprintf(stdout, "Warning: NVMCAutoCorr (in modpara.def) must be 0, 1 or 2.\n");
+      fprintf(stdout, "         NVMCAutoCorr set as 0.\n");
+      bufInt[IdxVMCAutoCorr] = 0;
+    }
+    if (bufInt[IdxVMCAutoCorr] == 2 && bufDouble[IdxVMCAutoCorrTarget] < 0.5) {
+      fprintf(stderr, "Error: DVMCAutoCorrTarget (in modpara.def) must be 0.5 or larger when NVMCAutoCorr = 2.\n");
+      info = 1;
+    }
+
+    //Check NGreenTransSym
+    if (bufInt[IdxGreenTransSym] < 0 || bufInt[IdxGreenTransSym] > 2) {
+      fprintf(stdout, "Warning: NGreenTransSym (in modpara.def) must be 0, 1 or 2.\n");
+      fprintf(stdout, "         NGreenTransSym set as 0.\n");
+      bufInt[IdxGreenTransSym] = 0;
+    } else if (bufInt[IdxGreenTransSym] > 0) {
+      if (abs(bufInt[IdxMPTrans]) < 2 || bufInt[IdxNBF] > 0 || iFlgOrbitalGeneral == 1) {
+        fprintf(stdout, "Warning: NGreenTransSym (in modpara.def) must be 0 when |NMPTrans| < 2, backflow or general orbitals are used.\n");
+        fprintf(stdout, "         NGreenTransSym set as 0.\n");
+        bufInt[IdxGreenTransSym] = 0;
+      } else if (bufInt[IdxNOneBodyG] > 0 && (bufInt[IdxNTwoBodyGEx] > 0 || bufInt[IdxLanczosMode] > 1)) {
+        fprintf(stdout, "Warning: The one-body Green functions are not reduced by NGreenTransSym\n");
+        fprintf(stdout, "         when NLanczosMode = 2 or TwoBodyGEx is given.\n");
+      }
+    }
+
+    //Check NMomentumDist
+    if (bufInt[IdxMomentumDist] < 0 || bufInt[IdxMomentumDist] > 1) {
+      fprintf(stdout, "Warning: NMomentumDist (in modpara.def) must be 0 or 1.\n");
+      fprintf(stdout, "         NMomentumDist set as 0.\n");
+      bufInt[IdxMomentumDist] = 0;
+    }
+    if (bufInt[IdxNMomentum] > 0 && (bufInt[IdxNBF] > 0 || iFlgOrbitalGeneral == 1)) {
+      fprintf(stdout, "Warning: Momentum is not supported with backflow or general orbitals.\n");
+      fprintf(stdout, "         Momentum is ignored.\n");
+      bufInt[IdxNMomentum] = 0;
+    }
+
+    //Check NSRCG
+    if (NSRCG == 2 && bufDouble[IdxSROptStaDel] <= 0.0) {
+      fprintf(stderr, "Error: DSROptStaDel (in modpara.def) must be positive when NSRCG = 2.\n");
+      info = 1;
+    }
+
+    //Check NStore
+    if (NStoreO == 2 && NSRCG == 2) {
+      fprintf(stdout, "Warning: NStore = 2 (in modpara.def) is not supported when NSRCG = 2.\n");
+      fprintf(stdout, "         NStore set as 1.\n");
+      NStoreO = 1;
+    }
+
+    //Check NDelayUpdate
+    if (bufInt[IdxDelayUpdate] < 0) {
+      fprintf(stdout, "Warning: NDelayUpdate (in modpara.def) must be non-negative.\n");
+      fprintf(stdout, "         NDelayUpdate set as 0.\n");
+      bufInt[IdxDelayUpdate] = 0;
+    } else if (bufInt[IdxDelayUpdate] > 0 && bufInt[IdxNBF] > 0) {
+      fprintf(stdout, "Warning: NDelayUpdate (in modpara.def) must be 0 when backflow is used.\n");
+      fprintf(stdout, "         NDelayUpdate set as 0.\n");
+      bufInt[IdxDelayUpdate] = 0;
+    } else if (bufInt[IdxDelayUpdate] > 2*bufInt[IdxNe]) {
+      fprintf(stdout, "Warning: NDelayUpdate (in modpara.def) must not exceed 2*Ne.\n");
+      fprintf(stdout, "         NDelayUpdate set as %d.\n", 2*bufInt[IdxNe]);
+      bufInt[IdxDelayUpdate] = 2*bufInt[IdxNe];
+    }
+#ifdef _pf_block_update
+    if (bufInt[IdxDelayUpdate] != 0) {
+      fprintf(stdout, "Warning: NDelayUpdate (in modpara.def) is not supported with block Pfaffian updates.\n");
+      fprintf(stdout, "         NDelayUpdate set as 0.\n");
+      bufInt[IdxDelayUpdate] = 0;
+    }
+#endif
+
+    //Check NBlockUpdateSize
+    if (bufInt[IdxBlockUpdateSize] < 0) {
+      bufInt[IdxBlockUpdateSize] = -1; /* auto */
+    } else if (bufInt[IdxBlockUpdateSize] > 100) {
+      fprintf(stdout, "Warning: NBlockUpdateSize (in modpara.def) must not exceed 100.\n");
+      fprintf(stdout, "         NBlockUpdateSize set as 0 (default).\n");
+      bufInt[IdxBlockUpdateSize] = 0;
+    }
+
+    //Check NStoreBlock
+    if (bufInt[IdxStoreOBlock] < 0) {
+      fprintf(stdout, "Warning: NStoreBlock (in modpara.def) must be non-negative.\n");
+      fprintf(stdout, "         NStoreBlock set as 0.\n");
+      bufInt[IdxStoreOBlock] = 0;
+    } else if (bufInt[IdxStoreOBlock] > bufInt[IdxVMCSample]) {
+      fprintf(stdout, "Warning: NStoreBlock (in modpara.def) must not exceed NVMCSample.\n");
+      fprintf(stdout, "         NStoreBlock set as %d.\n", bufInt[IdxVMCSample]);
+      bufInt[IdxStoreOBlock] = bufInt[IdxVMCSample];
+    }
+
+    //Check NSROptAdaptive
+    if (bufInt[IdxSROptAdaptive] != 0 && bufInt[IdxSROptAdaptive] != 1) {
+      fprintf(stdout, "Warning: NSROptAdaptive (in modpara.def) must be 0 or 1.\n");
+      fprintf(stdout, "         NSROptAdaptive set as 0.\n");
+      bufInt[IdxSROptAdaptive] = 0;
+    }
+    if (bufInt[IdxSROptAdaptive] == 1 && bufDouble[IdxSROptAdaptTol] <= 0.0) {
+      fprintf(stderr, "Error: DSROptAdaptTol (in modpara.def) must be positive when NSROptAdaptive = 1.\n");
+      info = 1;
+    }
+
+    //Check NLocGrnBatch
+    if (bufInt[IdxLocGrnBatch] < -1 || bufInt[IdxLocGrnBatch] > 1) {
+      fprintf(stdout, "Warning: NLocGrnBatch (in modpara.def) must be -1, 0 or 1.\n");
+      fprintf(stdout, "         NLocGrnBatch set as -1.\n");
+      bufInt[IdxLocGrnBatch] = -1;
+    } else if (bufInt[IdxLocGrnBatch] == 1 && (bufInt[IdxNBF] > 0 || iFlgOrbitalGeneral == 1)) {
+      fprintf(stdout, "Warning: NLocGrnBatch (in modpara.def) must be 0 when backflow or general orbitals are used.\n");
+      fprintf(stdout, "         NLocGrnBatch set as 0.\n");
+      bufInt[IdxLocGrnBatch] = 0;
+    }
+
     //Check LocSpn
     if (bufInt[IdxNLocSpin] > 0) {
       if (bufInt[IdxNLocSpin] == 2 * bufInt[IdxNe] && bufInt[IdxExUpdatePath] != 2) {
@@ -616,6 +832,27 @@ int ReadDefFileNInt(char *xNameListFile, MPI_Comm comm) {
   NVMCInterval = bufInt[IdxVMCInterval];
   NVMCSample = bufInt[IdxVMCSample];
   NExUpdatePath = bufInt[IdxExUpdatePath];
+  NVMCWalker = bufInt[IdxVMCWalker];
+  NVMCBatch = bufInt[IdxVMCBatch];
+  NVMCCalFuse = bufInt[IdxVMCCalFuse];
+  NVMCTempering = bufInt[IdxVMCTempering];
+  DVMCTemperingBeta = bufDouble[IdxVMCTemperingBeta];
+  NVMCAutoCorr = bufInt[IdxVMCAutoCorr];
+  NGreenTransSym = bufInt[IdxGreenTransSym];
+  NMomentum = (NVMCCalMode == 1) ? bufInt[IdxNMomentum] : 0;
+  NMomentumDist = bufInt[IdxMomentumDist];
+  DVMCAutoCorrTarget = bufDouble[IdxVMCAutoCorrTarget];
+  NDelayUpdate = (bufInt[IdxDelayUpdate] > 1) ? bufInt[IdxDelayUpdate] : 0;
+  NDelayStored = 0;
+  NBlockUpdateSize = bufInt[IdxBlockUpdateSize];
+  NStoreOBlock = (NSRCG == 0 && NStoreO == 0) ? bufInt[IdxStoreOBlock] : 0;
+  NStoreOBlockStored = 0;
+  NLocGrnBatch = bufInt[IdxLocGrnBatch];
+#ifdef _lapack
+  FlagSROptDist = 0;
+#else
+  FlagSROptDist = (NSRCG == 0 && NStoreO != 0) ? 1 : 0;
+#endif
   RndSeed = bufInt[IdxRndSeed];
   NSplitSize = bufInt[IdxSplitSize];
   NLocSpn = bufInt[IdxNLocSpin];
@@ -640,6 +877,9 @@ int ReadDefFileNInt(char *xNameListFile, MPI_Comm comm) {
   NBackFlowIdx = bufInt[IdxNBF];
   Nz = bufInt[IdxNNz];
   NSROptCGMaxIter = bufInt[IdxSROptCGMaxIter];
+  NSROptAdaptive = bufInt[IdxSROptAdaptive];
+  DSROptAdaptTol = bufDouble[IdxSROptAdaptTol];
+  FlagSROptReweight = 0;
   DSROptRedCut = bufDouble[IdxSROptRedCut];
   DSROptStaDel = bufDouble[IdxSROptStaDel];
   DSROptStepDt = bufDouble[IdxSROptStepDt];
@@ -681,6 +921,19 @@ int ReadDefFileNInt(char *xNameListFile, MPI_Comm comm) {
   }
   /* [e] For BackFlow */
 
+  /* Without spin projection, the same-spin blocks of SlaterElm vanish
+     in the Sz-conserved case. The pfupdates library needs the full layout. */
+#ifdef _pf_block_update
+  FlagSlaterElmCompact = 0;
+#else
+  FlagSlaterElmCompact = (NSPGaussLeg == 1 && iFlgOrbitalGeneral == 0 && NBackFlowIdx == 0) ? 1 : 0;
+#endif
+  NSlaterElmCol = (FlagSlaterElmCompact == 1) ? Nsite : Nsite2;
+
+  /* The real-arithmetic path owns SlaterElm_real and InvM_real.
+     The Sz-unconserved and backflow samplers still go through the complex arrays. */
+  FlagRealSlaterElm = (AllComplexFlag == 0 && iFlgOrbitalGeneral == 0 && NProjBF == 0) ? 1 : 0;
+
   NPara = NProj + NSlater + NOptTrans + NProjBF;
   NQPFix = NSPGaussLeg * NMPTrans;
   NQPFull = NQPFix * NQPOptTrans;
@@ -878,6 +1131,11 @@ int ReadDefFileIdxPara(char *xNameListFile, MPI_Comm comm) {
             info = 1;
           break;
 
+        case KWMomentum:
+          /*momentum.def---------------------------------------*/
+          if (GetInfoMomentum(fp, MomentumExp, Nsite, NMomentum, defname) != 0) info = 1;
+          break;
+
         case KWInterAll:
           /*interall.def---------------------------------------*/
           if (GetInfoInterAll(fp, InterAll, ParaInterAll, Nsite, NInterAll, defname) != 0) info = 1;
@@ -987,8 +1245,15 @@ int ReadDefFileIdxPara(char *xNameListFile, MPI_Comm comm) {
   SafeMpiBcast_fcmp(ParaTransfer, NTransfer + NInterAll, comm);
   SafeMpiBcast(ParaCoulombIntra, NTotalDefDouble, comm);
   SafeMpiBcast_fcmp(ParaQPTrans, NQPTrans, comm);
+  SafeMpiBcast_fcmp(MomentumExp, NMomentum * Nsite, comm);
 #endif /* _mpi_use */
 
+  /* set FlagLocGrnBatch on every process before SetMemory */
+  InitLocGrnBatch();
+  if (rank == 0 && FlagLocGrnBatch == 1) {
+    fprintf(stdout, "remark: Local Green functions in the Hamiltonian are evaluated in a batch.\n");
+  }
+
   /* set FlagShift */
   if (NVMCCalMode == 0) {
     SetFlagShift();
@@ -1483,6 +1748,19 @@ void SetDefaultValuesModPara(int *bufInt, double *bufDouble) {
   bufInt[IdxNInterAll] = 0;
   bufInt[IdxNQPOptTrans] = 1;
   bufInt[IdxSROptCGMaxIter] = 0;
+  bufInt[IdxVMCWalker] = 1;
+  bufInt[IdxVMCBatch] = 1;
+  bufInt[IdxVMCCalFuse] = 0;
+  bufInt[IdxVMCTempering] = 1;
+  bufInt[IdxVMCAutoCorr] = 0;
+  bufInt[IdxGreenTransSym] = 0;
+  bufInt[IdxNMomentum] = 0;
+  bufInt[IdxMomentumDist] = 0;
+  bufInt[IdxDelayUpdate] = 0;
+  bufInt[IdxBlockUpdateSize] = 0;
+  bufInt[IdxStoreOBlock] = 0;
+  bufInt[IdxSROptAdaptive] = 0;
+  bufInt[IdxLocGrnBatch] = -1;
   bufInt[IdxNBF] = 0;
   bufInt[IdxNrange] = 0;
   bufInt[IdxNNz] = 0;
@@ -1493,6 +1771,9 @@ void SetDefaultValuesModPara(int *bufInt, double *bufDouble) {
   bufDouble[IdxSROptStaDel] = 0.02;
   bufDouble[IdxSROptStepDt] = 0.02;
   bufDouble[IdxSROptCGTol] = 1.0e-10;
+  bufDouble[IdxSROptAdaptTol] = 2.0e-2;
+  bufDouble[IdxVMCTemperingBeta] = 0.5;
+  bufDouble[IdxVMCAutoCorrTarget] = 1.0;
   NStoreO = 1;
   NSRCG = 0;
 }
@@ -1588,6 +1869,10 @@ int GetInfoFromModPara(int *bufInt, double *bufDouble) {
               bufDouble[IdxSROptStaDel] = (double) dtmp;
             } else if (CheckWords(ctmp, "DSROptStepDt") == 0) {
               bufDouble[IdxSROptStepDt] = (double) dtmp;
+            } else if (CheckWords(ctmp, "NSROptAdaptive") == 0) {
+              bufInt[IdxSROptAdaptive] = (int) dtmp;
+            } else if (CheckWords(ctmp, "DSROptAdaptTol") == 0) {
+              bufDouble[IdxSROptAdaptTol] = (double) dtmp;
             } else if (CheckWords(ctmp, "NSROptCGMaxIter") == 0) {
               bufInt[IdxSROptCGMaxIter] = (int) dtmp;
             } else if (CheckWords(ctmp, "DSROptCGTol") == 0) {
@@ -1598,6 +1883,30 @@ int GetInfoFromModPara(int *bufInt, double *bufDouble) {
               bufInt[IdxVMCInterval] = (int) dtmp;
             } else if (CheckWords(ctmp, "NVMCSample") == 0) {
               bufInt[IdxVMCSample] = (int) dtmp;
+            } else if (CheckWords(ctmp, "NVMCWalker") == 0) {
+              bufInt[IdxVMCWalker] = (int) dtmp;
+            } else if (CheckWords(ctmp, "NVMCBatch") == 0) {
+              bufInt[IdxVMCBatch] = (int) dtmp;
+            } else if (CheckWords(ctmp, "NVMCCalFuse") == 0) {
+              bufInt[IdxVMCCalFuse] = (int) dtmp;
+            } else if (CheckWords(ctmp, "NVMCTempering") == 0) {
+              bufInt[IdxVMCTempering] = (int) dtmp;
+            } else if (CheckWords(ctmp, "DVMCTemperingBeta") == 0) {
+              bufDouble[IdxVMCTemperingBeta] = (double) dtmp;
+            } else if (CheckWords(ctmp, "NVMCAutoCorr") == 0) {
+              bufInt[IdxVMCAutoCorr] = (int) dtmp;
+            } else if (CheckWords(ctmp, "DVMCAutoCorrTarget") == 0) {
+              bufDouble[IdxVMCAutoCorrTarget] = (double) dtmp;
+            } else if (CheckWords(ctmp, "NGreenTransSym") == 0) {
+              bufInt[IdxGreenTransSym] = (int) dtmp;
+            } else if (CheckWords(ctmp, "NMomentumDist") == 0) {
+              bufInt[IdxMomentumDist] = (int) dtmp;
+            } else if (CheckWords(ctmp, "NDelayUpdate") == 0) {
+              bufInt[IdxDelayUpdate] = (int) dtmp;
+            } else if (CheckWords(ctmp, "NBlockUpdateSize") == 0) {
+              bufInt[IdxBlockUpdateSize] = (int) dtmp;
+            } else if (CheckWords(ctmp, "NLocGrnBatch") == 0) {
+              bufInt[IdxLocGrnBatch] = (int) dtmp;
             } else if (CheckWords(ctmp, "NExUpdatePath") == 0) {
               bufInt[IdxExUpdatePath] = (int) dtmp;
             } else if (CheckWords(ctmp, "RndSeed") == 0) {
@@ -1606,6 +1915,8 @@ int GetInfoFromModPara(int *bufInt, double *bufDouble) {
               bufInt[IdxSplitSize] = (int) dtmp;
             } else if (CheckWords(ctmp, "NStore") == 0) {
               NStoreO = (int) dtmp;
+            } else if (CheckWords(ctmp, "NStoreBlock") == 0) {
+              bufInt[IdxStoreOBlock] = (int) dtmp;
             } else if (CheckWords(ctmp, "NSRCG") == 0) {
               NSRCG = (int) dtmp;
             } else {
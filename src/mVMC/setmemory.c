@@ -216,6 +216,7 @@ void SetMemoryDef() {
   
   ParaQPOptTrans = pDouble;
   ParaQPTrans = (double complex*)malloc(sizeof(double complex)*(NQPTrans));
+  MomentumExp = (double complex*)malloc(sizeof(double complex)*(NMomentum*Nsite));
 
   // LanczosGreen
   if(NLanczosMode>1){
@@ -237,6 +238,7 @@ void FreeMemoryDef() {
   free(CisAjsCktAltDCIdx);
   free(CisAjsCktAltIdx);
   free(CisAjsIdx);
+  free(MomentumExp);
   free(QPTransSgn);
   free(QPTrans);
   free(OrbitalIdx);
@@ -256,7 +258,7 @@ void FreeMemoryDef() {
 }
 
 void SetMemory() {
-  int i;
+  int i,nHop;
 
   /***** Variational Parameters *****/
   //printf("DEBUG:opt=%d %d %d %d %d Ne=%d\n", AllComplexFlag,NPara,NProj,NSlater,NOrbitalIdx,Ne);
@@ -276,6 +278,7 @@ void SetMemory() {
   EleSpn            = (int*)malloc(sizeof(int)*( NVMCSample*2*Ne ));//fsz
 //[e] MERGE BY TM
   logSqPfFullSlater = (double*)malloc(sizeof(double)*(NVMCSample));
+  if(NVMCAutoCorr>0) SampleLocEnergy = (double*)malloc(sizeof(double)*(NVMCSample));
   if (NBackFlowIdx > 0) {
     EleProjBFCnt = (int*)malloc(sizeof(int)*( NVMCSample*4*4*Nsite*Nrange));
     SmpSltElmBF_real = (double *)malloc(sizeof(double)*(NVMCSample*NQPFull*(2*Nsite)*(2*Nsite)));
@@ -312,15 +315,54 @@ void SetMemory() {
   BurnEleSpn        = BurnEleProjCnt + NProj; //fsz
 
   /***** Slater Elements ******/
-  SlaterElm = (double complex*)malloc( sizeof(double complex)*(NQPFull*(2*Nsite)*(2*Nsite)) );
-  InvM = (double complex*)malloc( sizeof(double complex)*(NQPFull*(Nsize*Nsize+1)) );
-  PfM = InvM + NQPFull*Nsize*Nsize;
+  /* the complex arrays are not used when the real-arithmetic path owns its buffers */
+  if(FlagRealSlaterElm==0) {
+    SlaterElm = (double complex*)malloc( sizeof(double complex)*(NQPFull*Nsite2*NSlaterElmCol) );
+    InvM = (double complex*)malloc( sizeof(double complex)*(NQPFull*(Nsize*Nsize+1)) );
+    PfM = InvM + NQPFull*Nsize*Nsize;
+  } else {
+    SlaterElm = NULL;
+    InvM = NULL;
+    PfM = NULL;
+  }
 // for real TBC
-  SlaterElm_real = (double*)malloc(sizeof(double)*(NQPFull*(2*Nsite)*(2*Nsite)) );
+  SlaterElm_real = (double*)malloc(sizeof(double)*(NQPFull*Nsite2*NSlaterElmCol) );
 
   InvM_real      = (double*)malloc(sizeof(double)*(NQPFull*(Nsize*Nsize+1)) );
   PfM_real       = InvM_real + NQPFull*Nsize*Nsize;
 
+  /***** Delayed updates of InvM *****/
+  if(NDelayUpdate>1) {
+    if(AllComplexFlag==0) {
+      DelayU_real = (double*)malloc(sizeof(double)*2*NQPFull*NDelayUpdate*Nsize);
+      DelayV_real = DelayU_real + NQPFull*NDelayUpdate*Nsize;
+    } else {
+      DelayU = (double complex*)malloc(sizeof(double complex)*2*NQPFull*NDelayUpdate*Nsize);
+      DelayV = DelayU + NQPFull*NDelayUpdate*Nsize;
+    }
+  }
+
+  /***** Multi-walker sampling *****/
+  if(NVMCWalker>1) {
+    WalkerEleIdx = (int*)malloc(sizeof(int)*NVMCWalker*(Nsize+2*Nsite+2*Nsite+NProj));
+    if(AllComplexFlag==0) {
+      WalkerInvM_real = (double*)malloc(sizeof(double)*NVMCWalker*(NQPFull*(Nsize*Nsize+1)));
+    } else {
+      WalkerInvM = (double complex*)malloc(sizeof(double complex)*NVMCWalker*(NQPFull*(Nsize*Nsize+1)));
+    }
+  }
+
+  /***** Batched local Green functions *****/
+  if(FlagLocGrnBatch==1) {
+    LocGrnTermIdx = (int*)malloc(sizeof(int)*4*NLocGrnTerm);
+    LocGrnTerm = (double complex*)malloc(sizeof(double complex)*3*NLocGrnTerm);
+    if(AllComplexFlag==0) {
+      LocGrnBuf_real = (double*)malloc(sizeof(double)*2*Nsize*Nsite2);
+    } else {
+      LocGrnBuf = (double complex*)malloc(sizeof(double complex)*2*Nsize*Nsite2);
+    }
+  }
+
   /***** Quantum Projection *****/
   QPFullWeight = (double complex*)malloc(sizeof(double complex)*(NQPFull+NQPFix+5*NSPGaussLeg));
   QPFixWeight= QPFullWeight + NQPFull;
@@ -333,36 +375,66 @@ void SetMemory() {
   /***** Stocastic Reconfiguration *****/
   if(NVMCCalMode==0){
     //SR components are described by real and complex components of O
-    if(NSRCG==0){
-      SROptOO = (double complex*)malloc( sizeof(double complex)*((2*SROptSize)*(2*SROptSize+2))) ; //TBC
-      SROptHO = SROptOO + (2*SROptSize)*(2*SROptSize); //TBC
-      SROptO  = SROptHO + (2*SROptSize);  //TBC
+    // The imaginary direction of a parameter with OptFlag=0 (a real parameter) is always zero
+    // in S and g, so that it is dropped from the complex O stored in SROptOO and SROptO_Store.
+    // SROptO keeps all the 2*SROptSize directions and is compacted by compactSROptO.
+    SROptCmpIdx = (int*)malloc(sizeof(int)*2*SROptSize);
+    SROptCmpSize = 0;
+    for(i=0;i<2*SROptSize;i++){
+      if(i<2 || i%2==0 || OptFlag[i-2]==1) SROptCmpIdx[i] = SROptCmpSize++;
+      else SROptCmpIdx[i] = -1;
+    }
+    if(NSRCG==0 && FlagSROptDist==0 && AllComplexFlag!=0){
+      SROptOO = (double complex*)malloc( sizeof(double complex)*(SROptCmpSize*(SROptCmpSize+1)+2*SROptSize)) ; //TBC
+      SROptHO = SROptOO + SROptCmpSize*SROptCmpSize; //TBC
+      SROptO  = SROptHO + SROptCmpSize;  //TBC
     }else{
-      // OO contains only <O_i> and <O_i O_i> in SR-CG
-      SROptOO = (double complex*)malloc( sizeof(double complex)*(2*SROptSize)*4) ; //TBC
-      SROptHO = SROptOO + 2*SROptSize*2; //TBC
-      SROptO  = SROptHO + 2*SROptSize;  //TBC
+      // OO contains only <O_i> and <O_i O_i> in SR-CG and FlagSROptDist=1
+      // and only SROptO is used for real parameters
+      SROptOO = (double complex*)malloc( sizeof(double complex)*(SROptCmpSize*3+2*SROptSize)) ; //TBC
+      SROptHO = SROptOO + SROptCmpSize*2; //TBC
+      SROptO  = SROptHO + SROptCmpSize;  //TBC
     }
 //for real
-    if(NSRCG==0){
+    if(NSRCG==0 && FlagSROptDist==0){
       SROptOO_real = (double*)malloc( sizeof(double )*SROptSize*(SROptSize+2)) ; //TBC
       SROptHO_real = SROptOO_real + (SROptSize)*(SROptSize); //TBC
       SROptO_real  = SROptHO_real + (SROptSize);  //TBC
     }else{
-      // OO contains only <O_i> and <O_i O_i> in SR-CG
+      // OO contains only <O_i> and <O_i O_i> in SR-CG and FlagSROptDist=1
       SROptOO_real = (double*)malloc( sizeof(double )*SROptSize*4) ; //TBC
       SROptHO_real = SROptOO_real + SROptSize*2; //TBC
       SROptO_real  = SROptHO_real + SROptSize;  //TBC
     }
 
-    if(NSRCG==1 || NStoreO!=0){
+    if(NSRCG!=0 || NStoreO!=0){
       //if(AllComplexFlag==0 && iFlgOrbitalGeneral==0){ //real & sz=0
-      if(AllComplexFlag==0){ //real & sz=0
+      if(NStoreO==2){
+        if(AllComplexFlag==0){
+          SROptO_Store_float_real = (float *)malloc(sizeof(float)*(SROptSize*NVMCSample) );
+        }else{
+          SROptO_Store_float      = (float complex*)malloc( sizeof(float complex)*(SROptCmpSize*NVMCSample) );
+        }
+      }else if(AllComplexFlag==0){ //real & sz=0
         SROptO_Store_real = (double *)malloc(sizeof(double)*(SROptSize*NVMCSample) );
       }else{
-        SROptO_Store      = (double complex*)malloc( sizeof(double complex)*(2*SROptSize*NVMCSample) );
+        SROptO_Store      = (double complex*)malloc( sizeof(double complex)*(SROptCmpSize*NVMCSample) );
+      }
+    }
+    if(NStoreOBlock>0){
+      if(AllComplexFlag==0){
+        SROptO_Block_real = (double *)malloc(sizeof(double)*(SROptSize*NStoreOBlock) );
+      }else{
+        SROptO_Block      = (double complex*)malloc( sizeof(double complex)*(SROptCmpSize*NStoreOBlock) );
       }
     }
+    if(NSRCG==1){
+      SROptCGWarmX = (double*)malloc(sizeof(double)*(2*NPara));
+      for(i=0;i<2*NPara;i++) SROptCGWarmX[i] = 0.0;
+    }
+    if(NSROptAdaptive==1){
+      SROptHeunPara = (double complex*)malloc(sizeof(double complex)*(2*NPara));
+    }
     SROptData = (double complex*)malloc( sizeof(double complex)*(NSROptItrSmp*(2+NPara)) );
   }
 
@@ -374,6 +446,23 @@ void SetMemory() {
     PhysCisAjsCktAltDC = PhysCisAjsCktAlt + NCisAjsCktAlt;
     LocalCisAjs = PhysCisAjsCktAltDC + NCisAjsCktAltDC;
 
+    if(NMomentum>0){
+      PhysMomentum = (double complex*)malloc(sizeof(double complex)*(4*NMomentum));
+      if(NMomentumDist==1) {
+        LocalMomentumG = (double complex*)malloc(sizeof(double complex)*(2*Nsite*Nsite));
+      }
+    }
+
+    if(NGreenTransSym>0){
+      CisAjsTransIdx = (int*)malloc(sizeof(int)*3*(NCisAjs+NCisAjsCktAltDC));
+      CisAjsTransSgn = CisAjsTransIdx + NCisAjs;
+      CisAjsTransRep = CisAjsTransSgn + NCisAjs;
+      CisAjsCktAltDCTransIdx = CisAjsTransRep + NCisAjs;
+      CisAjsCktAltDCTransSgn = CisAjsCktAltDCTransIdx + NCisAjsCktAltDC;
+      CisAjsCktAltDCTransRep = CisAjsCktAltDCTransSgn + NCisAjsCktAltDC;
+      LocalGreenTrans = (double complex*)malloc(sizeof(double complex)*(NCisAjs+NCisAjsCktAltDC));
+    }
+
     if(NLanczosMode>0){
       QQQQ = (double complex*)malloc(sizeof(double complex)
         *(NLSHam*NLSHam*NLSHam*NLSHam + NLSHam*NLSHam) );
@@ -383,6 +472,15 @@ void SetMemory() {
       *(NLSHam*NLSHam*NLSHam*NLSHam + NLSHam*NLSHam) );
       LSLQ_real = QQQQ_real + NLSHam*NLSHam*NLSHam*NLSHam;
 
+      /* the distinct hoppings of a sample, see lslocgrn.c */
+      nHop = NTransfer + NPairHopping + 2*NExchangeCoupling + NInterAll + NCisAjs;
+      LSHopIdx = (int*)malloc(sizeof(int)*(Nsite2*Nsite + 2*nHop));
+      LSHop = LSHopIdx + Nsite2*Nsite;
+      for(i=0;i<Nsite2*Nsite;i++) LSHopIdx[i] = -1;
+      NLSHop = 0;
+      LSHopVal = (double complex*)malloc(sizeof(double complex)*nHop);
+      LSHopVal_real = (double*)malloc(sizeof(double)*nHop);
+
       if(NLanczosMode>1){
         QCisAjsQ = (double complex*)malloc(sizeof(double complex)
           *(NLSHam*NLSHam*NCisAjs + NLSHam*NLSHam*NCisAjsCktAltDC + NLSHam*NCisAjs) );
@@ -407,9 +505,20 @@ void FreeMemory() {
 
   if(NVMCCalMode==1){
     free(PhysCisAjs);
+    if(NMomentum>0){
+      free(PhysMomentum);
+      if(NMomentumDist==1) free(LocalMomentumG);
+    }
+    if(NGreenTransSym>0){
+      free(LocalGreenTrans);
+      free(CisAjsTransIdx);
+    }
     if(NLanczosMode>0){
       free(QQQQ);
       free(QQQQ_real);
+      free(LSHopIdx);
+      free(LSHopVal);
+      free(LSHopVal_real);
       if(NLanczosMode>1){
         free(QCisAjsQ);
         free(QCisAjsQ_real);
@@ -420,16 +529,42 @@ void FreeMemory() {
   if(NVMCCalMode==0){
     free(SROptData);
     free(SROptOO);
+    free(SROptCmpIdx);
+    if(NSRCG==1) free(SROptCGWarmX);
+    if(NSROptAdaptive==1) free(SROptHeunPara);
+    if(NStoreOBlock>0){
+      if(AllComplexFlag==0) free(SROptO_Block_real);
+      else free(SROptO_Block);
+    }
   }
 
   free(QPFullWeight);
 
+  if(FlagLocGrnBatch==1) {
+    free(LocGrnBuf_real);
+    free(LocGrnBuf);
+    free(LocGrnTerm);
+    free(LocGrnTermIdx);
+  }
+
+  if(NVMCWalker>1) {
+    free(WalkerInvM_real);
+    free(WalkerInvM);
+    free(WalkerEleIdx);
+  }
+
+  if(NDelayUpdate>1) {
+    free(DelayU_real);
+    free(DelayU);
+  }
+
   free(InvM);
   free(SlaterElm);
 
   free(BurnEleIdx);
   free(TmpEleIdx);
   free(logSqPfFullSlater);
+  if(NVMCAutoCorr>0) free(SampleLocEnergy);
   free(EleProjCnt);
   free(EleIdx);
   free(EleCfg);
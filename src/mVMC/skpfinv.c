@@ -0,0 +1,47 @@
+/*
+mVMC - A numerical solver package for a wide range of quantum lattice models based on many-variable Variational Monte Carlo method
+Copyright (C) 2016 The University of Tokyo, All rights reserved.
+
+This program is developed based on the mVMC-mini program
+(https://github.com/fiber-miniapp/mVMC-mini)
+which follows "The BSD 3-Clause License".
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details. 
+
+You should have received a copy of the GNU General Public License 
+along with this program. If not, see http://www.gnu.org/licenses/. 
+*/
+/*-------------------------------------------------------------
+ * Variational Monte Carlo
+ * fused Pfaffian and inverse of skew-symmetric matrices
+ *-------------------------------------------------------------
+ * The matrix is reduced by the Parlett-Reid algorithm with
+ * partial pivoting (the same as mthd='P' of PFAPACK),
+ *   P^T A P = L D L^T,
+ * where L is unit lower triangular with 2x2 identity blocks on
+ * the diagonal and D is block diagonal with 2x2 skew blocks.
+ * Then Pf(A) = det(P) prod_k D[k][k+1] and
+ *   A^{-1} = P L^{-T} D^{-1} L^{-1} P^T,
+ * so the inverse is obtained from the Pfaffian factorization
+ * without a separate LU decomposition.
+ *-------------------------------------------------------------*/
+#include "./include/skpfinv.h"
+#ifndef _SRC_SKPFINV
+#define _SRC_SKPFINV
+#include <complex.h>
+#include <math.h>
+
+#define MVMC_SKPFINV_REAL
+#include "skpfinv_impl.c"
+#undef MVMC_SKPFINV_REAL
+#include "skpfinv_impl.c"
+
+#endif
@@ -0,0 +1,175 @@
+/*
+mVMC - A numerical solver package for a wide range of quantum lattice models based on many-variable Variational Monte Carlo method
+Copyright (C) 2016 The University of Tokyo, All rights reserved.
+
+This program is developed based on the mVMC-mini program
+(https://github.com/fiber-miniapp/mVMC-mini)
+which follows "The BSD 3-Clause License".
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details. 
+
+You should have received a copy of the GNU General Public License 
+along with this program. If not, see http://www.gnu.org/licenses/. 
+*/
+
+#ifdef MVMC_SKPFINV_REAL
+  #define fn_SkPfaInv SkPfaInv_real
+  #define SKPF_T double
+  #define PIVOT_ABS(x) fabs(x)
+#else // MVMC_SKPFINV_REAL
+  #define fn_SkPfaInv SkPfaInv_fcmp
+  #define SKPF_T double complex
+  /* the squared modulus gives the same pivot and avoids cabs */
+  #define PIVOT_ABS(x) (creal(x)*creal(x) + cimag(x)*cimag(x))
+#endif // MVMC_SKPFINV_REAL
+
+/* Calculate Pf(A) and inv(A) of a skew-symmetric matrix A.
+   a   : column-major n x n skew-symmetric matrix (destroyed on exit)
+   inv : column-major n x n inverse of A on exit
+   iwork : int[n], work : [2*n]
+   return value is 0 on success, k+1 if A is found to be singular at step k. */
+int fn_SkPfaInv(const int n, SKPF_T *a, const int lda, SKPF_T *pfaff,
+                int *iwork, SKPF_T *inv, const int ldinv, SKPF_T *work) {
+  int i,j,k,m,kp,r,s;
+  double amax,aabs;
+  SKPF_T d,dinv,t,tmp;
+  SKPF_T *a_k, *a_k1, *a_j, *a_m, *inv_j;
+  SKPF_T *u = work;
+  SKPF_T *v = work + n;
+  SKPF_T pf=1.0;
+
+  *pfaff = 0.0;
+  if(n%2!=0) return 1;
+
+  for(i=0;i<n;i++) iwork[i] = i;
+
+  /* Parlett-Reid reduction. Only the lower triangle is referenced. */
+  for(k=0;k<n-1;k+=2) {
+    a_k = a + k*lda;
+    a_k1 = a + (k+1)*lda;
+
+    /* pivot search in column k */
+    kp = k+1;
+    amax = 0.0;
+    for(i=k+1;i<n;i++) {
+      aabs = PIVOT_ABS(a_k[i]);
+      if(aabs>amax) { amax=aabs; kp=i; }
+    }
+
+    /* interchange rows and columns k+1 and kp */
+    if(kp!=k+1) {
+      r = k+1;
+      s = kp;
+      for(j=0;j<r;j++) {
+        tmp = a[r+j*lda]; a[r+j*lda] = a[s+j*lda]; a[s+j*lda] = tmp;
+      }
+      for(j=r+1;j<s;j++) {
+        tmp = a[j+r*lda]; a[j+r*lda] = -a[s+j*lda]; a[s+j*lda] = -tmp;
+      }
+      a[s+r*lda] = -a[s+r*lda];
+      for(i=s+1;i<n;i++) {
+        tmp = a[i+r*lda]; a[i+r*lda] = a[i+s*lda]; a[i+s*lda] = tmp;
+      }
+      i = iwork[r]; iwork[r] = iwork[s]; iwork[s] = i;
+      pf = -pf;
+    }
+
+    d = a_k[k+1];
+    if(d==0.0) return k+1;
+    pf *= -d;
+    dinv = 1.0/d;
+
+    /* rank-2 update of the trailing block:
+       A[i][j] += (A[i][k] A[j][k+1] - A[i][k+1] A[j][k])/d */
+    for(j=k+2;j<n;j++) {
+      u[j] = a_k1[j]*dinv;  /* -L[j][k]   */
+      v[j] = a_k[j]*dinv;   /*  L[j][k+1] */
+    }
+    for(j=k+2;j<n-1;j++) {
+      a_j = a + j*lda;
+      for(i=j+1;i<n;i++) {
+        a_j[i] += a_k[i]*u[j] - a_k1[i]*v[j];
+      }
+    }
+
+    /* store L in columns k and k+1, and D[k+1][k] on the diagonal */
+    for(i=k+2;i<n;i++) {
+      a_k[i] = -u[i];
+      a_k1[i] = v[i];
+    }
+    a_k[k] = d;
+    a_k[k+1] = 0.0;
+  }
+
+  *pfaff = pf;
+
+  /* W = L^{-1} in place. The diagonal of L is unit and not referenced. */
+  for(j=n-2;j>=0;j--) {
+    a_j = a + j*lda;
+    for(i=j+1;i<n;i++) {
+      u[i] = a_j[i];
+      a_j[i] = -a_j[i];
+    }
+    for(m=j+1;m<n-1;m++) {
+      t = u[m];
+      if(t==0.0) continue;
+      a_m = a + m*lda;
+      for(i=m+1;i<n;i++) {
+        a_j[i] -= a_m[i]*t;
+      }
+    }
+  }
+
+  /* C = W^T D^{-1} W (lower triangle), accumulated block by block:
+     C[i][j] += (W[k][i] W[k+1][j] - W[k+1][i] W[k][j])/D[k+1][k] */
+  for(j=0;j<n;j++) {
+    inv_j = inv + j*ldinv;
+    for(i=j;i<n;i++) inv_j[i] = 0.0;
+  }
+  for(k=0;k<n-1;k+=2) {
+    dinv = 1.0/a[k+k*lda];
+    for(i=0;i<k;i++) {
+      u[i] = a[k+i*lda];
+      v[i] = a[k+1+i*lda];
+    }
+    u[k] = 1.0; u[k+1] = 0.0;
+    v[k] = 0.0; v[k+1] = 1.0;
+    for(j=0;j<k+1;j++) {
+      inv_j = inv + j*ldinv;
+      t = v[j]*dinv;
+      tmp = u[j]*dinv;
+      for(i=j+1;i<k+2;i++) {
+        inv_j[i] += u[i]*t - v[i]*tmp;
+      }
+    }
+  }
+
+  /* inv(A) = P C P^T, using a as a buffer */
+  for(j=0;j<n;j++) {
+    inv_j = inv + j*ldinv;
+    a[iwork[j]+iwork[j]*lda] = 0.0;
+    for(i=j+1;i<n;i++) {
+      a[iwork[i]+iwork[j]*lda] = inv_j[i];
+      a[iwork[j]+iwork[i]*lda] = -inv_j[i];
+    }
+  }
+  for(j=0;j<n;j++) {
+    a_j = a + j*lda;
+    inv_j = inv + j*ldinv;
+    for(i=0;i<n;i++) inv_j[i] = a_j[i];
+  }
+
+  return 0;
+}
+
+#undef fn_SkPfaInv
+#undef SKPF_T
+#undef PIVOT_ABS
@@ -42,6 +42,8 @@ void UpdateSlaterElm_fcmp() {
   double complex slt_ij,slt_ji;
   int *xqp, *xqpSgn, *xqpOpt, *xqpOptSgn;
   double complex *sltE,*sltE_i0,*sltE_i1;
+  const int nCol = NSlaterElmCol;
+  const int dnOff = NSlaterElmCol-Nsite; /* column offset of the down-spin block */
 
   #pragma omp parallel for default(shared)        \
     private(qpidx,optidx,mpidx,spidx,                      \
@@ -64,7 +66,7 @@ void UpdateSlaterElm_fcmp() {
     cc        = SPGLCosCos[spidx];
     ss        = SPGLSinSin[spidx];
     
-    sltE      = SlaterElm + qpidx*Nsite2*Nsite2;
+    sltE      = SlaterElm + qpidx*Nsite2*nCol;
     
     for(ri=0;ri<Nsite;ri++) {
       ori     = xqpOpt[ri];           // ri (OptTrans) -> ori (Trans)-> tri
@@ -72,22 +74,23 @@ void UpdateSlaterElm_fcmp() {
       sgni    = xqpSgn[ori]*xqpOptSgn[ri];
       rsi0    = ri;
       rsi1    = ri+Nsite;
-      sltE_i0 = sltE + rsi0*Nsite2;
-      sltE_i1 = sltE + rsi1*Nsite2;
+      sltE_i0 = sltE + rsi0*nCol;
+      sltE_i1 = sltE + rsi1*nCol;
       
       for(rj=0;rj<Nsite;rj++) {
         orj = xqpOpt[rj];
         trj = xqp[orj];
         sgnj = xqpSgn[orj]*xqpOptSgn[rj];
         rsj0 = rj;
-        rsj1 = rj+Nsite;
+        rsj1 = rj+dnOff;
         
         slt_ij = Slater[ OrbitalIdx[tri][trj] ] * (double)(OrbitalSgn[tri][trj]*sgni*sgnj);
         slt_ji = Slater[ OrbitalIdx[trj][tri] ] * (double)(OrbitalSgn[trj][tri]*sgni*sgnj);
         
-        sltE_i0[rsj0] = -(slt_ij - slt_ji)*cs;   // up   - up
         sltE_i0[rsj1] =   slt_ij*cc + slt_ji*ss; // up   - down
         sltE_i1[rsj0] = -slt_ij*ss - slt_ji*cc;  // down - up
+        if(FlagSlaterElmCompact==1) continue;    // cs=0 without spin projection
+        sltE_i0[rsj0] = -(slt_ij - slt_ji)*cs;   // up   - up
         sltE_i1[rsj1] =  (slt_ij - slt_ji)*cs;   // down - down 
       }
     }
@@ -96,6 +99,126 @@ void UpdateSlaterElm_fcmp() {
   return;
 }
 
+/* Real version of UpdateSlaterElm_fcmp, used when all the variational parameters are real.
+   SlaterElm_real is built directly from the real part of Slater. */
+void UpdateSlaterElm_real() {
+  int ri,ori,tri,sgni,rsi0,rsi1;
+  int rj,orj,trj,sgnj,rsj0,rsj1;
+  int qpidx,mpidx,spidx,optidx;
+  double cs,cc,ss;
+  double slt_ij,slt_ji;
+  int *xqp, *xqpSgn, *xqpOpt, *xqpOptSgn;
+  double *sltE,*sltE_i0,*sltE_i1;
+  const int nCol = NSlaterElmCol;
+  const int dnOff = NSlaterElmCol-Nsite; /* column offset of the down-spin block */
+
+  #pragma omp parallel for default(shared)        \
+    private(qpidx,optidx,mpidx,spidx,                      \
+            xqpOpt,xqpOptSgn,xqp,xqpSgn,cs,cc,ss,sltE,     \
+            ri,ori,tri,sgni,rsi0,rsi1,sltE_i0,sltE_i1,      \
+            rj,orj,trj,sgnj,rsj0,rsj1,slt_ij,slt_ji)
+  #pragma loop noalias
+  for(qpidx=0;qpidx<NQPFull;qpidx++) {
+    optidx    = qpidx / NQPFix;
+    mpidx     = (qpidx%NQPFix) / NSPGaussLeg;
+    spidx     = qpidx % NSPGaussLeg;
+
+    xqpOpt    = QPOptTrans[optidx];
+    xqpOptSgn = QPOptTransSgn[optidx];
+    xqp       = QPTrans[mpidx];
+    xqpSgn    = QPTransSgn[mpidx];
+    cs        = creal(SPGLCosSin[spidx]);
+    cc        = creal(SPGLCosCos[spidx]);
+    ss        = creal(SPGLSinSin[spidx]);
+
+    sltE      = SlaterElm_real + qpidx*Nsite2*nCol;
+
+    for(ri=0;ri<Nsite;ri++) {
+      ori     = xqpOpt[ri];
+      tri     = xqp[ori];
+      sgni    = xqpSgn[ori]*xqpOptSgn[ri];
+      rsi0    = ri;
+      rsi1    = ri+Nsite;
+      sltE_i0 = sltE + rsi0*nCol;
+      sltE_i1 = sltE + rsi1*nCol;
+
+      for(rj=0;rj<Nsite;rj++) {
+        orj = xqpOpt[rj];
+        trj = xqp[orj];
+        sgnj = xqpSgn[orj]*xqpOptSgn[rj];
+        rsj0 = rj;
+        rsj1 = rj+dnOff;
+
+        slt_ij = creal(Slater[ OrbitalIdx[tri][trj] ]) * (double)(OrbitalSgn[tri][trj]*sgni*sgnj);
+        slt_ji = creal(Slater[ OrbitalIdx[trj][tri] ]) * (double)(OrbitalSgn[trj][tri]*sgni*sgnj);
+
+        sltE_i0[rsj1] =   slt_ij*cc + slt_ji*ss; // up   - down
+        sltE_i1[rsj0] = -slt_ij*ss - slt_ji*cc;  // down - up
+        if(FlagSlaterElmCompact==1) continue;    // cs=0 without spin projection
+        sltE_i0[rsj0] = -(slt_ij - slt_ji)*cs;   // up   - up
+        sltE_i1[rsj1] =  (slt_ij - slt_ji)*cs;   // down - down
+      }
+    }
+  }
+
+  return;
+}
+
+/* SlaterElm[rsi][rsj] of a quantum projection sltE. */
+/* In the compact layout, the same-spin elements are zero and not stored. */
+double complex GetSlaterElm_fcmp(const double complex *sltE, const int rsi, const int rsj) {
+  if(FlagSlaterElmCompact==0) return sltE[rsi*Nsite2+rsj];
+  if((rsi<Nsite)==(rsj<Nsite)) return 0.0;
+  return sltE[rsi*Nsite+rsj%Nsite];
+}
+
+double GetSlaterElm_real(const double *sltE, const int rsi, const int rsj) {
+  if(FlagSlaterElmCompact==0) return sltE[rsi*Nsite2+rsj];
+  if((rsi<Nsite)==(rsj<Nsite)) return 0.0;
+  return sltE[rsi*Nsite+rsj%Nsite];
+}
+
+/* vec[msj] = SlaterElm[rsa][rsj] with rsj = eleIdx[msj] + (msj/Ne)*Nsite */
+void GetSlaterElmRow_fcmp(double complex *vec, const double complex *sltE, const int rsa, const int *eleIdx) {
+  const int ne = Ne;
+  const int nsize = Nsize;
+  const int dnOff = NSlaterElmCol-Nsite;
+  const double complex *sltE_a = sltE + rsa*NSlaterElmCol;
+  int msj;
+
+  if(FlagSlaterElmCompact==1 && rsa<Nsite) {
+    for(msj=0;msj<ne;msj++) vec[msj] = 0.0;
+  } else {
+    for(msj=0;msj<ne;msj++) vec[msj] = sltE_a[eleIdx[msj]];
+  }
+  if(FlagSlaterElmCompact==1 && rsa>=Nsite) {
+    for(msj=ne;msj<nsize;msj++) vec[msj] = 0.0;
+  } else {
+    for(msj=ne;msj<nsize;msj++) vec[msj] = sltE_a[eleIdx[msj]+dnOff];
+  }
+  return;
+}
+
+void GetSlaterElmRow_real(double *vec, const double *sltE, const int rsa, const int *eleIdx) {
+  const int ne = Ne;
+  const int nsize = Nsize;
+  const int dnOff = NSlaterElmCol-Nsite;
+  const double *sltE_a = sltE + rsa*NSlaterElmCol;
+  int msj;
+
+  if(FlagSlaterElmCompact==1 && rsa<Nsite) {
+    for(msj=0;msj<ne;msj++) vec[msj] = 0.0;
+  } else {
+    for(msj=0;msj<ne;msj++) vec[msj] = sltE_a[eleIdx[msj]];
+  }
+  if(FlagSlaterElmCompact==1 && rsa>=Nsite) {
+    for(msj=ne;msj<nsize;msj++) vec[msj] = 0.0;
+  } else {
+    for(msj=ne;msj<nsize;msj++) vec[msj] = sltE_a[eleIdx[msj]+dnOff];
+  }
+  return;
+}
+
 // Calculating Tr[Inv[M]*D_k(X)]
 void SlaterElmDiff_fcmp(double complex *srOptO, const double complex ip, int *eleIdx) {
   const int nBuf=NSlater*NQPFull;
@@ -243,6 +366,139 @@ void SlaterElmDiff_fcmp(double complex *srOptO, const double complex ip, int *el
   return;
 }
 
+/* Real version of SlaterElmDiff_fcmp using InvM_real and PfM_real. */
+/* srOptO[orbidx] = Tr[Inv[M]*D_orbidx(X)] without the imaginary components */
+void SlaterElmDiff_real(double *srOptO, const double ip, int *eleIdx) {
+  const int nBuf=NSlater*NQPFull;
+  const int nsize = Nsize;
+  const int ne = Ne;
+  const int nQPFull = NQPFull;
+  const int nMPTrans = NMPTrans;
+  const int nSlater = NSlater;
+  const int nTrans = NMPTrans * NQPOptTrans;
+
+  const double invIP = 1.0/ip;
+  int msi,msj,ri,rj,ori,orj,tri,trj,sgni,sgnj;
+  int mpidx,spidx,orbidx,qpidx,optidx,i;
+  double cs,cc,ss; // including Pf
+  int *xqp,*xqpSgn,*xqpOpt,*xqpOptSgn;
+  double *invM,*invM_i;
+
+  int *orbitalIdx_i;
+  int *transOrbIdx; /* transOrbIdx[mpidx][msi][msj] */
+  int *transOrbSgn; /* transOrbSgn[mpidx][msi][msj] */
+  int *tOrbIdx,*tOrbIdx_i;
+  int *tOrbSgn,*tOrbSgn_i;
+  double *buf, *buffer;
+  double tmp;
+
+  RequestWorkSpaceInt(2*nTrans*Nsize*Nsize);
+  RequestWorkSpaceDouble(NQPFull*NSlater);
+
+  transOrbIdx = GetWorkSpaceInt(nTrans*Nsize*Nsize);
+  transOrbSgn = GetWorkSpaceInt(nTrans*Nsize*Nsize);
+  buffer = GetWorkSpaceDouble(NQPFull*NSlater);
+
+  for(i=0;i<nBuf;i++) buffer[i]=0.0;
+
+  #pragma omp parallel for default(shared)                        \
+    private(qpidx,optidx,mpidx,msi,msj,xqp,xqpSgn,xqpOpt,xqpOptSgn,\
+            ri,ori,tri,sgni,rj,orj,trj,sgnj,                       \
+            tOrbIdx,tOrbIdx_i,tOrbSgn,tOrbSgn_i,orbitalIdx_i)
+  #pragma loop noalias
+  for(qpidx=0;qpidx<nTrans;qpidx++) {
+    optidx    = qpidx / nMPTrans;
+    mpidx     = qpidx % nMPTrans;
+    xqpOpt    = QPOptTrans[optidx];
+    xqpOptSgn = QPOptTransSgn[optidx];
+    xqp       = QPTrans[mpidx];
+    xqpSgn    = QPTransSgn[mpidx];
+    tOrbIdx   = transOrbIdx + qpidx*nsize*nsize;
+    tOrbSgn   = transOrbSgn + qpidx*nsize*nsize;
+    for(msi=0;msi<nsize;msi++) {
+      ri           = eleIdx[msi];
+      ori          = xqpOpt[ri];
+      tri          = xqp[ori];
+      sgni         = xqpSgn[ori]*xqpOptSgn[ri];
+      tOrbIdx_i    = tOrbIdx + msi*nsize;
+      tOrbSgn_i    = tOrbSgn + msi*nsize;
+      orbitalIdx_i = OrbitalIdx[tri];
+      for(msj=0;msj<nsize;msj++) {
+        rj             = eleIdx[msj];
+        orj            = xqpOpt[rj];
+        trj            = xqp[orj];
+        sgnj           = xqpSgn[orj]*xqpOptSgn[rj];
+        tOrbIdx_i[msj] = orbitalIdx_i[trj];
+        tOrbSgn_i[msj] = sgni*sgnj*OrbitalSgn[tri][trj];
+      }
+    }
+  }
+
+  #pragma omp parallel for default(shared)        \
+    private(qpidx,mpidx,spidx,cs,cc,ss,                   \
+            tOrbIdx,tOrbSgn,invM,buf,msi,msj,             \
+            tOrbIdx_i,tOrbSgn_i,invM_i,orbidx)
+  #pragma loop noalias
+  for(qpidx=0;qpidx<nQPFull;qpidx++) {
+    mpidx = qpidx / NSPGaussLeg;
+    spidx = qpidx % NSPGaussLeg;
+
+    cs = PfM_real[qpidx] * creal(SPGLCosSin[spidx]);
+    cc = PfM_real[qpidx] * creal(SPGLCosCos[spidx]);
+    ss = PfM_real[qpidx] * creal(SPGLSinSin[spidx]);
+
+    tOrbIdx = transOrbIdx + mpidx*nsize*nsize;
+    tOrbSgn = transOrbSgn + mpidx*nsize*nsize;
+    invM    = InvM_real   + qpidx*Nsize*Nsize;
+    buf     = buffer      + qpidx*NSlater;
+
+    #pragma loop norecurrence
+    for(msi=0;msi<ne;msi++) {
+      tOrbIdx_i = tOrbIdx + msi*nsize;
+      tOrbSgn_i = tOrbSgn + msi*nsize;
+      invM_i    = invM + msi*nsize;
+      for(msj=0;msj<ne;msj++) {                // up-up
+        orbidx       = tOrbIdx_i[msj];
+        buf[orbidx] += invM_i[msj]*cs*tOrbSgn_i[msj];
+      }
+      for(msj=ne;msj<nsize;msj++) {            // up-down
+        orbidx       = tOrbIdx_i[msj];
+        buf[orbidx] -= invM_i[msj]*cc*tOrbSgn_i[msj];
+      }
+    }
+    #pragma loop norecurrence
+    for(msi=ne;msi<nsize;msi++) {
+      tOrbIdx_i = tOrbIdx + msi*nsize;
+      tOrbSgn_i = tOrbSgn + msi*nsize;
+      invM_i    = invM + msi*nsize;
+      for(msj=0;msj<ne;msj++) {                // down-up
+        orbidx       = tOrbIdx_i[msj];
+        buf[orbidx] += invM_i[msj]*ss*tOrbSgn_i[msj];
+      }
+      for(msj=ne;msj<nsize;msj++) {            // down-down
+        orbidx       = tOrbIdx_i[msj];
+        buf[orbidx] -= invM_i[msj]*cs*tOrbSgn_i[msj];
+      }
+    }
+  }
+
+  /* store SROptO[] */
+  for(orbidx=0;orbidx<nSlater;orbidx++) srOptO[orbidx] = 0.0;
+  #pragma loop noalias
+  for(qpidx=0;qpidx<nQPFull;qpidx++) {
+    tmp = creal(QPFullWeight[qpidx]);
+    buf = buffer + qpidx*nSlater;
+    for(orbidx=0;orbidx<nSlater;orbidx++) {
+      srOptO[orbidx] += tmp * buf[orbidx];
+    }
+  }
+  for(orbidx=0;orbidx<nSlater;orbidx++) srOptO[orbidx] *= invIP;
+
+  ReleaseWorkSpaceInt();
+  ReleaseWorkSpaceDouble();
+  return;
+}
+
 void SlaterElmBFDiff_fcmp(double complex*srOptO, const double complex ip, int *eleIdx, int *eleNum, int *eleCfg, int *eleProjConst,const int * eleProjBFCnt){
   const int nBuf=NSlater*NQPFull;
   const int nsize = Nsize;
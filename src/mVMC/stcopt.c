@@ -34,7 +34,7 @@ int StochasticOpt(MPI_Comm comm) {
   const int nPara=NPara;
   const int srOptSize=SROptSize;
   const double complex *srOptOO=SROptOO;
-  //const double         *srOptOO= SROptOO_real;
+  const double         *srOptOO_real=SROptOO_real;
 
   double *r; /* the parameter change */
   int nSmat;
@@ -51,8 +51,7 @@ int StochasticOpt(MPI_Comm comm) {
   int simax;
   int info=0;
 
-// for real
-  int int_x,int_y,j,i;
+  int j;
 
   double complex *para=Para;
 
@@ -63,30 +62,31 @@ int StochasticOpt(MPI_Comm comm) {
   r = (double*)calloc(2*SROptSize, sizeof(double));
 
   StartTimer(50);
-//[s] for only real variables TBC
-  if(AllComplexFlag==0){ //real &  sz=0
-  //if(AllComplexFlag==0 && iFlgOrbitalGeneral==0){ //real &  sz=0
-    #pragma omp parallel for default(shared) private(i,int_x,int_y,j)
-    #pragma loop noalias
-    for(i=0;i<2*SROptSize*(2*SROptSize+2);i++){
-      int_x  = i%(2*SROptSize);
-      int_y  = (i-int_x)/(2*SROptSize);
-      if(int_x%2==0 && int_y%2==0){
-        j          = int_x/2+(int_y/2)*SROptSize;
-        SROptOO[i] = SROptOO_real[j];// only real part TBC
-      }else{
-        SROptOO[i] = 0.0+0.0*I;
-      }
-    }
-  }
-//[e]
-  #pragma omp parallel for default(shared) private(pi)
+  #pragma omp parallel for default(shared) private(pi,j)
   #pragma loop noalias
   for(pi=0;pi<2*nPara;pi++) {
     //for(pi=0;pi<nPara;pi++) {
     /* r[i] is temporarily used for diagonal elements of S */
     /* S[i][i] = OO[pi+1][pi+1] - OO[0][pi+1] * OO[0][pi+1]; */
-    r[pi]   = creal(srOptOO[(pi+2)*(2*srOptSize)+(pi+2)]) - creal(srOptOO[pi+2]) * creal(srOptOO[pi+2]);
+    if(AllComplexFlag==0){
+      /* real parameters are stored in SROptOO_real without the imaginary directions */
+      j = pi/2+1;
+      if(pi%2==1){
+        r[pi] = 0.0;
+      }else if(FlagSROptDist==1){
+        r[pi] = srOptOO_real[srOptSize+j] - srOptOO_real[j] * srOptOO_real[j];
+      }else{
+        r[pi] = srOptOO_real[j*srOptSize+j] - srOptOO_real[j] * srOptOO_real[j];
+      }
+    }else if((j=SROptCmpIdx[pi+2])<0){
+      /* the imaginary direction of a real parameter is not stored */
+      r[pi] = 0.0;
+    }else if(FlagSROptDist==1){
+      /* the diagonal elements are stored after <O> */
+      r[pi] = creal(srOptOO[SROptCmpSize+j]) - creal(srOptOO[j]) * creal(srOptOO[j]);
+    }else{
+      r[pi] = creal(srOptOO[j*SROptCmpSize+j]) - creal(srOptOO[j]) * creal(srOptOO[j]);
+    }
     //printf("DEBUG: pi=%d: %lf %lf \n",pi,creal(srOptOO[pi]),cimag(srOptOO[pi]));
 #ifdef _DEBUG_STCOPT
   fprintf(stderr, "DEBUG in %s (%d): r[%d] = %lf\n", __FILE__, __LINE__, pi, r[pi]);
@@ -115,7 +115,7 @@ int StochasticOpt(MPI_Comm comm) {
     }
 // s:this part will be skipped if OptFlag[pi]!=1
     sDiag = r[pi];
-    if(sDiag < diagCutThreshold) { /* fixed by diagCut */
+    if(sDiag < diagCutThreshold || (AllComplexFlag==0 && pi%2==1)) { /* fixed by diagCut */
       cutNum++;
     } else { /* optimized */
       smatToParaIdx[si] = pi; // si -> restricted parameters , pi -> full paramer 0 <-> 2*NPara
@@ -190,3 +190,86 @@ int StochasticOpt(MPI_Comm comm) {
   StopTimer(52);
   return info;
 }
+
+/* Heun step with the adaptive step width (NSROptAdaptive=1).
+   The parameters p0 at the start of the step are kept in SROptHeunPara.
+   The first SR update r1 = Para - p0 is calculated at p0 (Euler step).
+   The second one r2 is calculated at p0 + r1 from the same samples reweighted
+   by |psi(p0+r1)/psi(p0)|^2 (FlagSROptReweight=1), so that the sampling noise
+   common to r1 and r2 cancels in the local error max|r2-r1|/2.
+   The step is accepted as p0 + (r1+r2)/2 when the error does not exceed
+   DSROptAdaptTol. Otherwise, r1 is scaled to the shortened DSROptStepDt and
+   the second stage is tried again. */
+void SROptHeunStart() {
+  int i;
+  for(i=0;i<NPara;i++) SROptHeunPara[i] = Para[i];
+  return;
+}
+
+/* called after the first SR update is applied and synchronized */
+void SROptHeunPredict() {
+  const double complex *p0 = SROptHeunPara;
+  double complex *r1 = SROptHeunPara + NPara;
+  int i;
+  for(i=0;i<NPara;i++) r1[i] = Para[i] - p0[i];
+  /* the energy of the step is measured at p0 */
+  SROptHeunEtot[0] = Etot;
+  SROptHeunEtot[1] = Etot2;
+  return;
+}
+
+/* called after the second SR update is applied and synchronized.
+   Para is the same in all the processes, and thus the result is the same.
+   Returns 1 if the step is accepted, 0 if it is rejected. */
+int SROptHeunCorrect(const int step, MPI_Comm comm) {
+  const double complex *p0 = SROptHeunPara;
+  double complex *r1 = SROptHeunPara + NPara;
+  double complex r2;
+  double err=0.0, x, ratio;
+  int i, accept;
+  int rank;
+  MPI_Comm_rank(comm,&rank);
+
+  for(i=0;i<NPara;i++) {
+    r2 = Para[i] - p0[i] - r1[i];
+    x = 0.5*cabs(r2 - r1[i]);
+    if(x > err) err = x;
+  }
+  accept = (err <= DSROptAdaptTol) ? 1 : 0;
+
+  if(rank==0) {
+    fprintf(FileSRdt, "%6d % .5e % .5e %6d\n", step, DSROptStepDt, err, accept);
+  }
+
+  /* the error of the Euler step is O(dt^2) */
+  ratio = (err > 0.0) ? 0.9*sqrt(DSROptAdaptTol/err) : 2.0;
+  if(ratio > 2.0) ratio = 2.0;
+  if(ratio < 0.2) ratio = 0.2;
+  DSROptStepDt *= ratio;
+
+  for(i=0;i<NPara;i++) {
+    if(accept==1) {
+      r2 = Para[i] - p0[i] - r1[i];
+      Para[i] = p0[i] + 0.5*(r1[i] + r2);
+    } else {
+      /* r1 is proportional to DSROptStepDt */
+      r1[i] *= ratio;
+      Para[i] = p0[i] + r1[i];
+    }
+  }
+
+  return accept;
+}
+
+/* called at the end of the Heun step. The parameters are restored to p0
+   if no trial is accepted. */
+void SROptHeunEnd(const int accept) {
+  const double complex *p0 = SROptHeunPara;
+  int i;
+  if(accept==0) {
+    for(i=0;i<NPara;i++) Para[i] = p0[i];
+  }
+  Etot  = SROptHeunEtot[0];
+  Etot2 = SROptHeunEtot[1];
+  return;
+}
@@ -22,6 +22,7 @@ along with this program. If not, see http://www.gnu.org/licenses/.
 
 // #define _DEBUG_STCOPT_CG
 // #define _DEBUG_STCOPT_CG_PRINT_SMAT
+#include "splitloop.h"
 
 inline double xdot(const int n, const double * const p, const double * const q) {
   int i;
@@ -24,6 +24,7 @@ along with this program. If not, see http://www.gnu.org/licenses/.
   #define fn_StochasticOptCG StochasticOptCG_real
   #define fn_StochasticOptCG_Init StochasticOptCG_Init_real
   #define fn_StochasticOptCG_Main StochasticOptCG_Main_real
+  #define fn_StochasticOptMinSR_Main StochasticOptMinSR_Main_real
   #define fn_operate_by_S operate_by_S_real
   #define fn_print_Smat_stderr print_Smat_stderr_real
 
@@ -31,12 +32,18 @@ along with this program. If not, see http://www.gnu.org/licenses/.
   #define CIMAG(x) (0.0)
 
   #define OFFSET (1)
+  #define O_SIZE (SROptSize)
+  #define O_IDX(pi) ((pi)+1)
   #define USE_IMAG (0)
-  #define SIZE_VecCG (nSmat*8 + NVMCSample*(nSmat+1))
+  #define N_ColO (NVMCSample)
+  #define STORE_O (SROptO_Store_real)
+  #define STORE_O_F (SROptO_Store_float_real)
+  #define SIZE_VecCG (nSmat*12 + 2*N_ColO + ((NStoreO==2) ? nSmat*D_StoreOChunk : 0))
 #else // MVMC_SRCG_REAL
   #define fn_StochasticOptCG StochasticOptCG_fcmp
   #define fn_StochasticOptCG_Init StochasticOptCG_Init_fcmp
   #define fn_StochasticOptCG_Main StochasticOptCG_Main_fcmp
+  #define fn_StochasticOptMinSR_Main StochasticOptMinSR_Main_fcmp
   #define fn_operate_by_S operate_by_S_fcmp
   #define fn_print_Smat_stderr print_Smat_stderr_fcmp
 
@@ -44,8 +51,13 @@ along with this program. If not, see http://www.gnu.org/licenses/.
   #define CIMAG(x) cimag(x)
 
   #define OFFSET (2)
+  #define O_SIZE (SROptCmpSize) /* the imaginary directions of real parameters are dropped */
+  #define O_IDX(pi) (SROptCmpIdx[(pi)+2])
   #define USE_IMAG (1)
-  #define SIZE_VecCG (nSmat*8 + 2*NVMCSample*(nSmat+1))
+  #define N_ColO (2*NVMCSample)
+  #define STORE_O ((double *)SROptO_Store)
+  #define STORE_O_F ((float *)SROptO_Store_float)
+  #define SIZE_VecCG (nSmat*12 + 2*N_ColO + ((NStoreO==2) ? nSmat*D_StoreOChunk : 0))
 #endif
 
 /*
@@ -54,31 +66,36 @@ along with this program. If not, see http://www.gnu.org/licenses/.
   g :: nSmat
   sdiag :: nSmat
   stcO :: nSmat
-  stcOs_real :: nSmat*NVMCSample
-  stcOs_imag :: nSmat*NVMCSample (Complex) or 0 (Real)
-  y_real :: NVMCSample
-  y_imag :: NVMCSample (Complex) or 0 (Real)
-  z_local :: nSmat
-  q :: nSmat
-  d :: nSmat
+  y :: N_ColO*2
+  z_local :: nSmat*2
+  q :: nSmat*2 (S*d and S*x)
+  d :: nSmat*2 (d and a copy of x)
   r :: nSmat
+  s :: nSmat (preconditioned residual)
+  oBuf :: nSmat*D_StoreOChunk (only for NStoreO=2)
+
+  stcOs :: nSmat*N_ColO is not in VecCG. SROptO_Store is compacted in place
+  by fn_StochasticOptCG_Init. The columns are O_real (and O_imag) of each sample.
+  For NStoreO=2, SROptO_Store_float is compacted in the same way, and
+  fn_operate_by_S converts D_StoreOChunk columns at once to double in oBuf.
 */
 
 int fn_StochasticOptCG(MPI_Comm comm);
 void fn_StochasticOptCG_Init(const int nSmat, int *const smatToParaIdx, double *VecCG); 
 int fn_StochasticOptCG_Main(const int nSmat, double *VecCG, MPI_Comm comm);
-int fn_operate_by_S(const int nSmat, double *x, double *z, double *VecCG, MPI_Comm comm);
+int fn_StochasticOptMinSR_Main(const int nSmat, double *VecCG, MPI_Comm comm);
+int fn_operate_by_S(const int nSmat, const int nVec, double *x, double *z, double *VecCG, MPI_Comm comm);
 void fn_print_Smat_stderr(const int nSmat, double *VecCG, MPI_Comm comm);
 
 int fn_StochasticOptCG(MPI_Comm comm) {
   const int nPara=OFFSET*NPara;
-  const int srOptSize=SROptSize;
+  const int srOptSize=O_SIZE;
 #ifdef MVMC_SRCG_REAL
   const double *srOptO=SROptOO_real;
   const double *srOptOOdiag=SROptOO_real + srOptSize;
 #else
   const double complex *srOptO=SROptOO;
-  const double complex *srOptOOdiag=SROptOO + 2*srOptSize;
+  const double complex *srOptOOdiag=SROptOO + srOptSize;
 #endif
 
   double sDiagElm[nPara]; /* the parameter change */
@@ -95,6 +112,7 @@ int fn_StochasticOptCG(MPI_Comm comm) {
   double rmax;
   int simax;
   int info=0;
+  double timeSolve;
 
   double complex *para=Para;
   double *VecCG;
@@ -117,7 +135,9 @@ int fn_StochasticOptCG(MPI_Comm comm) {
   for(pi=0;pi<nPara;pi++) {
     /* calculate diagonal elements of S */
     /* S[pi][pi] = OO[pi+offset][pi+offset] - O[pi+offset] * O[pi+offset]; */
-    sDiagElm[pi] = CREAL(srOptOOdiag[pi+OFFSET]) - CREAL(srOptO[pi+OFFSET]) * CREAL(srOptO[pi+OFFSET]);
+    /* the imaginary directions of real parameters are not stored (O_IDX<0) */
+    sDiagElm[pi] = (O_IDX(pi)<0) ? 0.0
+      : CREAL(srOptOOdiag[O_IDX(pi)]) - CREAL(srOptO[O_IDX(pi)]) * CREAL(srOptO[O_IDX(pi)]);
   }
 #ifdef _DEBUG_STCOPT_CG
   for(pi=0;pi<nPara;pi++) {
@@ -178,7 +198,20 @@ int fn_StochasticOptCG(MPI_Comm comm) {
   abort();
 #endif
 
-  info = fn_StochasticOptCG_Main(nSmat, VecCG, comm);
+  timeSolve = MPI_Wtime();
+  if(NSRCG==2) {
+    info = fn_StochasticOptMinSR_Main(nSmat, VecCG, comm);
+  } else {
+    /* warm start from the solution of the previous step */
+    #pragma omp parallel for default(shared) private(si)
+    for(si=0;si<nSmat;si++) {
+      VecCG[si] = SROptCGWarmX[smatToParaIdx[si]];
+    }
+    info = fn_StochasticOptCG_Main(nSmat, VecCG, comm);
+    for(pi=0;pi<nPara;pi++) SROptCGWarmX[pi] = 0.0;
+    for(si=0;si<nSmat;si++) SROptCGWarmX[smatToParaIdx[si]] = VecCG[si];
+  }
+  timeSolve = MPI_Wtime() - timeSolve;
 #ifdef _DEBUG_STCOPT_CG
   for(si=0; si<nSmat; ++si){
     fprintf(stderr, "%lg\n", VecCG[si]);
@@ -199,8 +232,8 @@ int fn_StochasticOptCG(MPI_Comm comm) {
       }
     }
 
-    fprintf(FileSRinfo, "%5d %5d %5d %5d % .5e % .5e % .5e %5d, %d\n",NPara,nSmat,optNum,cutNum,
-            sDiagMax,sDiagMin,rmax,smatToParaIdx[simax], info);
+    fprintf(FileSRinfo, "%5d %5d %5d %5d % .5e % .5e % .5e %5d %5d %.5e\n",NPara,nSmat,optNum,cutNum,
+            sDiagMax,sDiagMin,rmax,smatToParaIdx[simax],info,timeSolve);
     //fprintf(FileSRinfo, "%5d %5d %5d %5d % .5e %5d, %d\n",NPara,nSmat,optNum,cutNum,
     //        rmax,smatToParaIdx[simax], info);
   }
@@ -254,20 +287,19 @@ int fn_StochasticOptCG(MPI_Comm comm) {
 }
 
 /* calculate the parameter change r[nSmat] from SOpt.
-   Solve S*x = g */
+   Solve S*x = g by the CG method with the Jacobi preconditioner diag(S).
+   x is given as the initial guess. */
 int fn_StochasticOptCG_Main(const int nSmat, double *VecCG, MPI_Comm comm) {
   int si;
-  int rank, size;
   int iter;
   int max_iter = (NSROptCGMaxIter > 0 ? NSROptCGMaxIter : nSmat);
-  double delta, beta;
+  double delta, beta, rr;
   double alpha;
   double cg_thresh = DSROptCGTol*DSROptCGTol * (double)nSmat * (double)nSmat;
   //double cg_thresh = DSROptRedCut;
 
-  double *x, *g, *sdiag, *stcO, *stcOs_real;
-  double *stcOs_imag, *y_real, *y_imag, *z_local;
-  double *q, *d, *r;
+  double *x, *g, *sdiag, *stcO, *y, *z_local;
+  double *q, *sx, *d, *xCopy, *r, *s;
 
 #ifdef _DEBUG_STCOPT_CG
   fprintf(stderr, "DEBUG in %s (%d): Start stcOptCG_Main\n", __FILE__, __LINE__);
@@ -277,36 +309,49 @@ int fn_StochasticOptCG_Main(const int nSmat, double *VecCG, MPI_Comm comm) {
   g = x + nSmat;
   sdiag = g + nSmat;
   stcO = sdiag + nSmat;
-  stcOs_real = stcO + nSmat;
-  stcOs_imag = stcOs_real + NVMCSample*nSmat;
-  y_real = stcOs_imag + USE_IMAG*NVMCSample*nSmat;
-  y_imag = y_real + NVMCSample;
-  z_local = y_imag + USE_IMAG*NVMCSample;
-  q = z_local + nSmat;
-  d = q + nSmat;
-  r = d + nSmat;
-  
-  MPI_Comm_rank(comm,&rank);
-  MPI_Comm_size(comm,&size);
+  y = stcO + nSmat;
+  z_local = y + 2*N_ColO;
+  q = z_local + 2*nSmat;
+  sx = q + nSmat;
+  d = q + 2*nSmat;
+  xCopy = d + nSmat;
+  r = d + 2*nSmat;
+  s = r + nSmat;
+
+  /* r = g - S*x */
+  fn_operate_by_S(nSmat, 1, x, r, VecCG, comm);
 
   #pragma omp parallel for default(shared) private(si)
   #pragma loop noalias
   for(si=0;si<nSmat;++si) {
-    d[si] = r[si] = g[si];
+    r[si] = g[si] - r[si];
+    /* the diagonal element of S is (1+DSROptStaDel)*sdiag */
+    s[si] = r[si]/((1.0+DSROptStaDel)*sdiag[si]);
+    d[si] = s[si];
   }
 
-  delta = xdot(nSmat, r, r);
+  delta = xdot(nSmat, r, s);
+  rr = xdot(nSmat, r, r);
 
   for(iter=0; iter < max_iter; iter++){
     //check convergence 
-    //if(rank==0) printf("%d: %d %.3e\n",rank, iter,delta);
 #ifdef _DEBUG_STCOPT_CG
-    fprintf(stderr, "delta = %lg, cg_thresh = %lg\n", delta, cg_thresh);
+    fprintf(stderr, "rr = %lg, cg_thresh = %lg\n", rr, cg_thresh);
 #endif
-    if (delta < cg_thresh) break;
+    if (rr < cg_thresh) break;
 
-    // compute vector q=S*d
-    fn_operate_by_S(nSmat, d, q, VecCG, comm);
+    if((iter+1) % 20 == 0){
+      // compute q=S*d and sx=S*x at once to recompute the residual
+      #pragma omp parallel for default(shared) private(si)
+      #pragma loop noalias
+      for(si=0;si<nSmat;++si) {
+        xCopy[si] = x[si];
+      }
+      fn_operate_by_S(nSmat, 2, d, q, VecCG, comm);
+    }else{
+      // compute vector q=S*d
+      fn_operate_by_S(nSmat, 1, d, q, VecCG, comm);
+    }
     alpha = delta/xdot(nSmat,d,q);
   
     // update solution vector x=x+alpha*d
@@ -317,11 +362,10 @@ int fn_StochasticOptCG_Main(const int nSmat, double *VecCG, MPI_Comm comm) {
     }
     // update residual vector r=r-alpha*q, q=S*d
     if((iter+1) % 20 == 0){
-      fn_operate_by_S(nSmat, x, r, VecCG, comm);
       #pragma omp parallel for default(shared) private(si)
       #pragma loop noalias
       for(si=0;si<nSmat;++si) {
-        r[si] = g[si] - r[si];
+        r[si] = g[si] - sx[si] - alpha*q[si];
       }
     }else{
       #pragma omp parallel for default(shared) private(si)
@@ -330,15 +374,22 @@ int fn_StochasticOptCG_Main(const int nSmat, double *VecCG, MPI_Comm comm) {
         r[si] = r[si] - alpha*q[si];
       }
     }
-    beta = xdot(nSmat,r,r)/delta;
+    // apply the preconditioner
+    #pragma omp parallel for default(shared) private(si)
+    #pragma loop noalias
+    for(si=0;si<nSmat;++si) {
+      s[si] = r[si]/((1.0+DSROptStaDel)*sdiag[si]);
+    }
+    rr = xdot(nSmat,r,r);
+    beta = xdot(nSmat,r,s)/delta;
 
-    //update the norm of residual vector r
+    //update the inner product of r and s
     delta = beta*delta;
     // update direction vector d
     #pragma omp parallel for default(shared) private(si)
     #pragma loop noalias
     for(si=0;si<nSmat;++si) {
-      d[si] = r[si] + beta*d[si];
+      d[si] = s[si] + beta*d[si];
     }
   }
 
@@ -350,74 +401,203 @@ int fn_StochasticOptCG_Main(const int nSmat, double *VecCG, MPI_Comm comm) {
   return iter;
 }
 
-/* calculate  z = S*x */
+/* calculate the parameter change r[nSmat] in the sample space (NSRCG=2).
+   S = D + Y J Y^T with D = DSROptStaDel*sdiag, Y = [O_s/sqrt(Wc), <O>] and J = diag(1,..,1,-1).
+   By the Woodbury identity,
+     x = D^{-1} g - D^{-1} Y K^{-1} Y^T D^{-1} g,  K = J + Y^T D^{-1} Y.
+   K is the (Ns+1)x(Ns+1) matrix of all the samples Ns in comm.
+   The rows of O_s are redistributed by MPI_Alltoallv so that each process
+   owns a block of the parameters for all the samples.
+   K is reduced to and solved by the process 0 only, and the solution is
+   broadcast. Every process holds the local part of K (m*m doubles with
+   m = Ns+1 or 2Ns+1), and the process 0 holds one more copy for DSYSV.
+   Returns the info of DSYSV. */
+int fn_StochasticOptMinSR_Main(const int nSmat, double *VecCG, MPI_Comm comm) {
+  const int nCol = N_ColO; /* the number of the local columns of O_s */
+  const double sqrtInvW = sqrt(1.0/creal(Wc));
+  int rank,size;
+  int si,sj,c,q,pos;
+  int siStart,siEnd,nLoc,ldLoc,nColTotal,m,lwork,info=0;
+  int one=1;
+  double dOne=1.0, dZero=0.0, dMOne=-1.0, optLWork;
+  char uplo='U', transT='T', transN='N';
+
+  double *x, *g, *sdiag, *stcO, *stcOs;
+  double *invSqrtD, *sendBuf, *y, *kMat=NULL, *h, *kBuf, *xLoc, *work;
+  int *rowStart, *rowCnt, *sendCnt, *sendDispl, *recvCnt, *recvDispl, *ipiv;
+
+  x = VecCG;
+  g = x + nSmat;
+  sdiag = g + nSmat;
+  stcO = sdiag + nSmat;
+  stcOs = STORE_O;
+
+  MPI_Comm_rank(comm,&rank);
+  MPI_Comm_size(comm,&size);
+
+  SplitLoop(&siStart,&siEnd,nSmat,rank,size);
+  nLoc = siEnd-siStart;
+  ldLoc = (nLoc>0) ? nLoc : 1;
+  nColTotal = nCol*size;
+  m = nColTotal+1;
+
+  rowStart  = (int*)malloc(sizeof(int)*(6*size));
+  rowCnt    = rowStart + size;
+  sendCnt   = rowCnt + size;
+  sendDispl = sendCnt + size;
+  recvCnt   = sendDispl + size;
+  recvDispl = recvCnt + size;
+  ipiv      = (int*)malloc(sizeof(int)*m);
+  invSqrtD  = (double*)malloc(sizeof(double)*(nSmat + nSmat*nCol + ldLoc*m + m*m+m + ldLoc));
+  sendBuf   = invSqrtD + nSmat;
+  y         = sendBuf + nSmat*nCol;
+  kBuf      = y + ldLoc*m;
+  h         = kBuf + m*m;
+  xLoc      = h + m;
+  if(rank==0) kMat = (double*)malloc(sizeof(double)*(m*m+m));
+
+  for(si=0;si<nSmat;si++) {
+    invSqrtD[si] = 1.0/sqrt(DSROptStaDel*sdiag[si]);
+  }
+
+  /* send the rows of O_s/sqrt(D Wc) owned by the q-th process */
+  pos = 0;
+  for(q=0;q<size;q++) {
+    SplitLoop(&rowStart[q],&sj,nSmat,q,size);
+    rowCnt[q] = sj-rowStart[q];
+    sendCnt[q] = rowCnt[q]*nCol;
+    sendDispl[q] = pos;
+    recvCnt[q] = nLoc*nCol;
+    recvDispl[q] = q*nLoc*nCol;
+    for(c=0;c<nCol;c++) {
+      for(si=rowStart[q];si<rowStart[q]+rowCnt[q];si++) {
+        sendBuf[pos++] = sqrtInvW*invSqrtD[si]*stcOs[si+c*nSmat];
+      }
+    }
+  }
+  /* y = D^{-1/2} Y (column-major, nLoc x m) */
+  MPI_Alltoallv(sendBuf, sendCnt, sendDispl, MPI_DOUBLE,
+                y, recvCnt, recvDispl, MPI_DOUBLE, comm);
+  for(si=0;si<nLoc;si++) {
+    y[si+nColTotal*ldLoc] = invSqrtD[siStart+si]*stcO[siStart+si];
+    xLoc[si] = invSqrtD[siStart+si]*g[siStart+si];
+  }
+
+  /* K = y^T y and h = y^T D^{-1/2} g summed over the processes */
+  for(si=0;si<m*m+m;si++) kBuf[si] = 0.0;
+  if(nLoc>0) {
+    M_DSYRK(&uplo, &transT, &m, &nLoc, &dOne, y, &ldLoc, &dZero, kBuf, &m);
+    M_DGEMV(&transT, &nLoc, &m, &dOne, y, &ldLoc, xLoc, &one, &dZero, kBuf+m*m, &one);
+  }
+  SafeMpiReduce(kBuf, kMat, m*m+m, comm);
+
+  if(rank==0) {
+    for(si=0;si<nColTotal;si++) kMat[si+si*m] += 1.0;
+    kMat[nColTotal+nColTotal*m] -= 1.0;
+
+    /* solve K t = h. K is symmetric and indefinite. */
+    lwork = -1;
+    M_DSYSV(&uplo, &m, &one, kMat, &m, ipiv, kMat+m*m, &m, &optLWork, &lwork, &info);
+    lwork = (int)optLWork;
+    work = (double*)malloc(sizeof(double)*lwork);
+    M_DSYSV(&uplo, &m, &one, kMat, &m, ipiv, kMat+m*m, &m, work, &lwork, &info);
+    free(work);
+    for(si=0;si<m;si++) h[si] = kMat[m*m+si];
+    free(kMat);
+  }
+  MPI_Bcast(&info, 1, MPI_INT, 0, comm);
+  if(info==0) SafeMpiBcast(h, m, comm);
+
+  if(info!=0) {
+    if(rank==0) fprintf(stderr, "StcOpt: minSR DSYSV info=%d\n",info);
+    for(si=0;si<nSmat;si++) x[si] = 0.0;
+  } else {
+    /* x = D^{-1/2} (D^{-1/2} g - y t) */
+    if(nLoc>0) {
+      M_DGEMV(&transN, &nLoc, &m, &dMOne, y, &ldLoc, h, &one, &dOne, xLoc, &one);
+    }
+    for(si=0;si<nLoc;si++) xLoc[si] *= invSqrtD[siStart+si];
+    MPI_Allgatherv(xLoc, nLoc, MPI_DOUBLE, x, rowCnt, rowStart, MPI_DOUBLE, comm);
+  }
+
+  free(invSqrtD);
+  free(ipiv);
+  free(rowStart);
+  return info;
+}
+
+/* calculate  z = S*x for nVec (<=2) vectors */
 /* S is the overlap matrix*/
 /* S[i][j] = OO[i+1][j+1] - OO[i+1][0] * OO[0][j+1]; */
-int fn_operate_by_S(int nSmat, double *x, double *z, double *VecCG, MPI_Comm comm) {
-  int rank,size,info=0;
-  int si;
-  int incx = 1, incy = 1;
+/* x and z are nSmat x nVec matrices (column major).
+   x is the same in all the processes, and thus it is not broadcast. */
+int fn_operate_by_S(const int nSmat, const int nVec, double *x, double *z, double *VecCG, MPI_Comm comm) {
+  int info=0;
+  int si,iv;
   double coef;
   double one = 1.0, zero = 0.0;
-  double invW = 1.0/Wc;
+  double invW = 1.0/creal(Wc);
   char transT='T';
   char transN='N';
 
-  double *sdiag, *stcO, *stcOs_real, *stcOs_imag;
-  double *y_real, *y_imag;
+  const int nCol = N_ColO;
+  double *sdiag, *stcO, *stcOs, *y;
   double *z_local;
 
   sdiag = VecCG + 2*nSmat;
   stcO = sdiag + nSmat;
-  stcOs_real = stcO + nSmat;
-  stcOs_imag = stcOs_real + NVMCSample*nSmat;
-  y_real = stcOs_imag + USE_IMAG*NVMCSample*nSmat;
-  y_imag = y_real + NVMCSample;
-  z_local = y_imag + USE_IMAG*NVMCSample;
-
-  MPI_Comm_rank(comm,&rank);
-  MPI_Comm_size(comm,&size);
+  stcOs = STORE_O;
+  y = stcO + nSmat;
+  z_local = y + 2*N_ColO;
 
-  MPI_Bcast(x, nSmat, MPI_DOUBLE, 0, comm);
-  
   StartTimer(53);
-  #pragma omp parallel for default(shared) private(si)
-  #pragma loop noalias
-  for(si=0;si<nSmat;++si) {
-    z[si] = 0.0;
-    z_local[si] = 0.0;
-  }
 
-  // y_real[sample] = sum{si} x[si] * O_real[si][sample]
-  M_DGEMV(&transT, &nSmat, &NVMCSample, &one, stcOs_real, &nSmat, x, &incx, &zero, y_real, &incy);
-#ifndef MVMC_SRCG_REAL
-  // y_imag[sample] = sum{si} x[si] * O_imag[si][sample]
-  M_DGEMV(&transT, &nSmat, &NVMCSample, &one, stcOs_imag, &nSmat, x, &incx, &zero, y_imag, &incy);
-#endif
+  if(NStoreO==2) {
+    const float *stcOsF = STORE_O_F;
+    double *oBuf = VecCG + nSmat*12 + 2*N_ColO;
+    double beta;
+    int col,nc,i;
+
+    for(col=0;col<nCol;col+=D_StoreOChunk) {
+      nc = (nCol-col < D_StoreOChunk) ? nCol-col : D_StoreOChunk;
+      #pragma omp parallel for default(shared) private(i)
+      #pragma loop noalias
+      for(i=0;i<nSmat*nc;i++) {
+        oBuf[i] = (double)stcOsF[i+col*nSmat];
+      }
 
-  // z_local[si] = sum{sample} O_real[si][sample] * y_real[sample] + O_imag[si][sample] * y_imag[sample]
-  M_DGEMV(&transN, &nSmat, &NVMCSample, &one, stcOs_real, &nSmat, y_real, &incx, &zero, z_local, &incy);
+      M_DGEMM(&transT, &transN, &nc, &nVec, &nSmat, &one, oBuf, &nSmat, x, &nSmat,
+              &zero, y+col, &nCol);
 
-#ifndef MVMC_SRCG_REAL
-  M_DGEMV(&transN, &nSmat, &NVMCSample, &one, stcOs_imag, &nSmat, y_imag, &incx, &one, z_local, &incy);
-#endif
+      beta = (col==0) ? 0.0 : 1.0;
+      M_DGEMM(&transN, &transN, &nSmat, &nVec, &nc, &one, oBuf, &nSmat, y+col, &nCol,
+              &beta, z_local, &nSmat);
+    }
+  } else {
+    // y[iv][col] = sum{si} x[iv][si] * O[si][col]
+    M_DGEMM(&transT, &transN, &nCol, &nVec, &nSmat, &one, stcOs, &nSmat, x, &nSmat,
+            &zero, y, &nCol);
+
+    // z_local[iv][si] = sum{col} O[si][col] * y[iv][col]
+    M_DGEMM(&transN, &transN, &nSmat, &nVec, &nCol, &one, stcOs, &nSmat, y, &nCol,
+            &zero, z_local, &nSmat);
+  }
 
-  MPI_Barrier(comm);
   /* compute <OO>*x */
-  SafeMpiAllReduce(z_local, z, nSmat, comm);
- 
-  /* compute <O>*x */
-  coef = xdot(nSmat, stcO, x);
+  SafeMpiAllReduce(z_local, z, nSmat*nVec, comm);
 
-  /* y = S*x */
-  #pragma omp parallel for default(shared) private(si)
-  #pragma loop noalias
-  for(si=0;si<nSmat;++si) {
-    z[si] = invW*z[si] - coef*stcO[si];
-    /* modify diagonal elements */
-    // z[si] += DSROptStaDel * x[si];
+  for(iv=0;iv<nVec;iv++) {
+    /* compute <O>*x */
+    coef = xdot(nSmat, stcO, x+iv*nSmat);
 
-    z[si] += sdiag[si]*DSROptStaDel*x[si];
+    /* y = S*x */
+    #pragma omp parallel for default(shared) private(si)
+    #pragma loop noalias
+    for(si=0;si<nSmat;++si) {
+      z[si+iv*nSmat] = invW*z[si+iv*nSmat] - coef*stcO[si];
+      /* modify diagonal elements */
+      z[si+iv*nSmat] += sdiag[si]*DSROptStaDel*x[si+iv*nSmat];
+    }
   }
 
   StopTimer(53);
@@ -431,18 +611,20 @@ void fn_StochasticOptCG_Init(const int nSmat, int *const smatToParaIdx, double *
   int si,pi,idx,offset;
 
   double *x, *g;
-  double *sdiag, *stcO, *stcOs_real;
+  double *sdiag, *stcO, *stcOs;
 
 #ifdef MVMC_SRCG_REAL
   const double *srOptO=SROptOO_real;
-  const double *srOptOOdiag=SROptOO_real + SROptSize;
+  const double *srOptOOdiag=SROptOO_real + O_SIZE;
   const double *srOptO_Store = SROptO_Store_real;
+  const float *srOptO_StoreF = SROptO_Store_float_real;
   const double *srOptHO=SROptHO_real;
 #else
-  double *stcOs_imag;
+  double *tmpImag;
   const double complex *srOptO=SROptOO;
-  const double complex *srOptOOdiag=SROptOO + 2*SROptSize;
+  const double complex *srOptOOdiag=SROptOO + O_SIZE;
   const double complex *srOptO_Store = SROptO_Store;
+  const float complex *srOptO_StoreF = SROptO_Store_float;
   const double complex *srOptHO=SROptHO;
 #endif
   const double srOptHO_0 = CREAL(srOptHO[0]);
@@ -455,9 +637,9 @@ void fn_StochasticOptCG_Init(const int nSmat, int *const smatToParaIdx, double *
   g = x + nSmat;
   sdiag = g + nSmat;
   stcO = sdiag + nSmat;
-  stcOs_real = stcO + nSmat;
+  stcOs = STORE_O;
 #ifndef MVMC_SRCG_REAL
-  stcOs_imag = stcOs_real + NVMCSample*nSmat;
+  tmpImag = stcO + nSmat + 2*N_ColO; /* z_local */
 #endif
 
   #pragma omp parallel for default(shared) private(si)
@@ -466,17 +648,48 @@ void fn_StochasticOptCG_Init(const int nSmat, int *const smatToParaIdx, double *
     VecCG[si] = 0.0;
   }
 
-  for(i=0;i<NVMCSample;++i) {
-    offset = i*OFFSET*SROptSize;
-    #pragma omp parallel for default(shared) private(si,pi,idx)
-    #pragma loop noalias
-    for(si=0;si<nSmat;++si) {
-      pi = smatToParaIdx[si];
-      
-      idx = si + i*nSmat; /* column major */
-      stcOs_real[idx] = CREAL(srOptO_Store[offset+pi+OFFSET]);
+  /* compact SROptO_Store in place: stcOs[si][col] (column major).
+     The destination never exceeds the source that is not read yet,
+     since si < O_IDX(smatToParaIdx[si]) and nSmat < O_SIZE. */
+  if(NStoreO==2) {
+    float *stcOsF = STORE_O_F;
+    for(i=0;i<NVMCSample;++i) {
+      offset = i*O_SIZE;
+      for(si=0;si<nSmat;++si) {
+        pi = smatToParaIdx[si];
+#ifdef MVMC_SRCG_REAL
+        idx = si + i*nSmat;
+        stcOsF[idx] = srOptO_StoreF[offset+O_IDX(pi)];
+#else
+        idx = si + 2*i*nSmat;
+        tmpImag[si] = cimagf(srOptO_StoreF[offset+O_IDX(pi)]);
+        stcOsF[idx] = crealf(srOptO_StoreF[offset+O_IDX(pi)]);
+#endif
+      }
 #ifndef MVMC_SRCG_REAL
-      stcOs_imag[idx] = CIMAG(srOptO_Store[offset+pi+OFFSET]);
+      for(si=0;si<nSmat;++si) {
+        stcOsF[si + (2*i+1)*nSmat] = (float)tmpImag[si];
+      }
+#endif
+    }
+  } else {
+    for(i=0;i<NVMCSample;++i) {
+      offset = i*O_SIZE;
+      for(si=0;si<nSmat;++si) {
+        pi = smatToParaIdx[si];
+#ifdef MVMC_SRCG_REAL
+        idx = si + i*nSmat;
+        stcOs[idx] = srOptO_Store[offset+O_IDX(pi)];
+#else
+        idx = si + 2*i*nSmat;
+        tmpImag[si] = CIMAG(srOptO_Store[offset+O_IDX(pi)]);
+        stcOs[idx] = CREAL(srOptO_Store[offset+O_IDX(pi)]);
+#endif
+      }
+#ifndef MVMC_SRCG_REAL
+      for(si=0;si<nSmat;++si) {
+        stcOs[si + (2*i+1)*nSmat] = tmpImag[si];
+      }
 #endif
     }
   }
@@ -488,10 +701,10 @@ void fn_StochasticOptCG_Init(const int nSmat, int *const smatToParaIdx, double *
   for(si=0;si<nSmat;++si) {
     pi = smatToParaIdx[si];
     
-    stcO[si] = CREAL(srOptO[pi+OFFSET]);
-    g[si] = -dt*(CREAL(srOptHO[pi+OFFSET]) - srOptHO_0 * CREAL(srOptO[pi+OFFSET]));
+    stcO[si] = CREAL(srOptO[O_IDX(pi)]);
+    g[si] = -dt*(CREAL(srOptHO[O_IDX(pi)]) - srOptHO_0 * CREAL(srOptO[O_IDX(pi)]));
 
-    sdiag[si] = CREAL(srOptOOdiag[pi+OFFSET]) - CREAL(srOptO[pi+OFFSET]) * CREAL(srOptO[pi+OFFSET]);
+    sdiag[si] = CREAL(srOptOOdiag[O_IDX(pi)]) - CREAL(srOptO[O_IDX(pi)]) * CREAL(srOptO[O_IDX(pi)]);
   }
 
 #ifdef _DEBUG_STCOPT_CG
@@ -512,7 +725,7 @@ void fn_print_Smat_stderr(const int nSmat, double *VecCG, MPI_Comm comm){
 
   for(si=0; si<nSmat; ++si){
     xs[si] = 1.0;
-    fn_operate_by_S(nSmat, xs, S+si*nSmat, VecCG, comm);
+    fn_operate_by_S(nSmat, 1, xs, S+si*nSmat, VecCG, comm);
     xs[si] = 0.0;
   }
 
@@ -530,12 +743,18 @@ void fn_print_Smat_stderr(const int nSmat, double *VecCG, MPI_Comm comm){
 #undef fn_StochasticOptCG
 #undef fn_StochasticOptCG_Init
 #undef fn_StochasticOptCG_Main
+#undef fn_StochasticOptMinSR_Main
 #undef fn_operate_by_S
 #undef fn_print_Smat_stderr
 
 #undef CREAL
 #undef CIMAG
 #undef OFFSET
+#undef O_SIZE
+#undef O_IDX
 #undef USE_IMAG
 #undef SIZE_VecCG
+#undef N_ColO
+#undef STORE_O
+#undef STORE_O_F
 
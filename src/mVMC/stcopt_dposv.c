@@ -52,21 +52,27 @@ int stcOptMain(double *g, const int nSmat, const int * const smatToParaIdx, MPI_
 /* calculate and store S and g in the equation to be solved, Sx=g */
 void stcOptInit(double *const S, double *const g, const int nSmat, const int *const smatToParaIdx) {
   const double ratioDiag = 1.0 + DSROptStaDel;
+  const int *cmpIdx=SROptCmpIdx; /* position of each direction in the compact complex O */
   int si,sj,pi,pj,idx,offset;
   double tmp;
+
+  if(AllComplexFlag==0) {
+    stcOptInit_real(S, g, nSmat, smatToParaIdx);
+    return;
+  }
   
   /* calculate the overlap matrix S */
   /* S[i][j] = OO[i+1][j+1] - OO[0][i+1] * OO[0][j+1]; */
   for(si=0;si<nSmat;++si) {
     pi = smatToParaIdx[si];
     //offset = (pi+1)*SROptSize;
-    offset = (pi+2)*(2*SROptSize);
-    tmp = creal(SROptOO[pi+2]);
+    offset = cmpIdx[pi+2]*SROptCmpSize;
+    tmp = creal(SROptOO[cmpIdx[pi+2]]);
 
     for(sj=0;sj<nSmat;++sj) {
       pj = smatToParaIdx[sj];
       idx = si + nSmat*sj; /* column major */
-      S[idx] = creal(SROptOO[offset+(pj+2)]) - tmp * creal(SROptOO[pj+2]);
+      S[idx] = creal(SROptOO[offset+cmpIdx[pj+2]]) - tmp * creal(SROptOO[cmpIdx[pj+2]]);
     }
 
     /* modify diagonal elements */
@@ -78,7 +84,43 @@ void stcOptInit(double *const S, double *const g, const int nSmat, const int *co
   /* energy gradient = 2.0*( HO[i+1] - HO[0] * OO[i+1]) */
   for(si=0;si<nSmat;++si) {
     pi = smatToParaIdx[si];
-    g[si] = -DSROptStepDt*2.0*(creal(SROptHO[pi+2]) - creal(SROptHO[0]) * creal(SROptOO[pi+2]));
+    g[si] = -DSROptStepDt*2.0*(creal(SROptHO[cmpIdx[pi+2]]) - creal(SROptHO[0]) * creal(SROptOO[cmpIdx[pi+2]]));
+  }
+
+  return;
+}
+
+/* real parameters are stored in SROptOO_real without the imaginary directions.
+   smatToParaIdx contains only the real directions (even pi). */
+void stcOptInit_real(double *const S, double *const g, const int nSmat, const int *const smatToParaIdx) {
+  const double ratioDiag = 1.0 + DSROptStaDel;
+  const int srOptSize = SROptSize;
+  int si,sj,pi,pj,idx,offset;
+  double tmp;
+
+  /* calculate the overlap matrix S */
+  /* S[i][j] = OO[i+1][j+1] - OO[0][i+1] * OO[0][j+1]; */
+  for(si=0;si<nSmat;++si) {
+    pi = smatToParaIdx[si]/2+1;
+    offset = pi*srOptSize;
+    tmp = SROptOO_real[pi];
+
+    for(sj=0;sj<nSmat;++sj) {
+      pj = smatToParaIdx[sj]/2+1;
+      idx = si + nSmat*sj; /* column major */
+      S[idx] = SROptOO_real[offset+pj] - tmp * SROptOO_real[pj];
+    }
+
+    /* modify diagonal elements */
+    idx = si + nSmat*si;
+    S[idx] *= ratioDiag;
+  }
+
+  /* calculate the energy gradient * (-dt) */
+  /* energy gradient = 2.0*( HO[i+1] - HO[0] * OO[i+1]) */
+  for(si=0;si<nSmat;++si) {
+    pi = smatToParaIdx[si]/2+1;
+    g[si] = -DSROptStepDt*2.0*(SROptHO_real[pi] - SROptHO_real[0] * SROptOO_real[pi]);
   }
 
   return;
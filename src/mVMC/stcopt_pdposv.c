@@ -30,6 +30,12 @@ along with this program. If not, see http://www.gnu.org/licenses/.
 #ifndef _SRC_STCOPT_PDPOSV
 #define _SRC_STCOPT_PDPOSV
 
+void stcOptDistOO(double *s, const int nSmat, const int *smatToParaIdx,
+                  int mb, int nb, int nprow, int npcol,
+                  const int myprow, const int mypcol, MPI_Comm comm);
+void stcOptPackO(double *o, const int nLoc, const int nBlk, const int iproc, const int nprocs,
+                 const int *smatToParaIdx);
+
 /* calculate the parameter change r[nSmat] from SOpt.
    The result is gathered in rank 0. */
 int stcOptMain(double *r, const int nSmat, const int *smatToParaIdx, MPI_Comm comm) {
@@ -74,10 +80,14 @@ int stcOptMain(double *r, const int nSmat, const int *smatToParaIdx, MPI_Comm co
 
   const int srOptSize = SROptSize;//TBC
   const double dSROptStepDt = DSROptStepDt;
-  const double srOptHO_0 = creal(SROptHO[0]);
+  const double srOptHO_0 = (AllComplexFlag==0) ? SROptHO_real[0] : creal(SROptHO[0]);
  // const double complex srOptHO_0 = SROptHO[0];
+  const double invW = 1.0/creal(Wc);
   double complex *srOptOO=SROptOO;
   double complex *srOptHO=SROptHO;
+  double *srOptOO_real=SROptOO_real;
+  double *srOptHO_real=SROptHO_real;
+  double oo;
 
   StartTimer(55);
 
@@ -136,7 +146,12 @@ int stcOptMain(double *r, const int nSmat, const int *smatToParaIdx, MPI_Comm co
   StartTimer(56);
   /* calculate the overlap matrix S */
   //printf("YDEBUG: %d %d %lf \n",mlocc,mlocr,ratioDiag);
-  #pragma omp parallel for default(shared) private(ic,ir,pi,pj,idx)
+  if(FlagSROptDist==1) {
+    /* s = Wc * xOO[i+1][j+1] of the local tiles */
+    stcOptDistOO(s,nSmat,smatToParaIdx,mb,nb,nprow,npcol,myprow,mypcol,comm);
+  }
+
+  #pragma omp parallel for default(shared) private(ic,ir,pi,pj,idx,oo)
   #pragma loop noalias
   for(ic=0;ic<mlocc;ic++) {
     pj = icToParaIdx[ic]; /* Para index (global) */
@@ -145,7 +160,15 @@ int stcOptMain(double *r, const int nSmat, const int *smatToParaIdx, MPI_Comm co
       idx = ir + ic*mlocr; /* local index (row major) */
 
       /* S[i][j] = xOO[i+1][j+1] - xOO[0][i+1] * xOO[0][j+1]; */
-      s[idx] = creal(srOptOO[(pi+2)*(2*srOptSize)+(pj+2)]) - creal(srOptOO[pi+2]) * creal(srOptOO[pj+2]);
+      if(AllComplexFlag==0) {
+        /* real parameters are stored in SROptOO_real without the imaginary directions */
+        oo = (FlagSROptDist==1) ? s[idx]*invW : srOptOO_real[(pi/2+1)*srOptSize+(pj/2+1)];
+        s[idx] = oo - srOptOO_real[pi/2+1] * srOptOO_real[pj/2+1];
+      } else {
+        /* the directions are stored in the compact complex O (SROptCmpIdx) */
+        oo = (FlagSROptDist==1) ? s[idx]*invW : creal(srOptOO[SROptCmpIdx[pi+2]*SROptCmpSize+SROptCmpIdx[pj+2]]);
+        s[idx] = oo - creal(srOptOO[SROptCmpIdx[pi+2]]) * creal(srOptOO[SROptCmpIdx[pj+2]]);
+      }
       /* modify diagonal elements */
       //printf("DEBUG: idx=%d %d %d s[]=%lf \n",idx,pi,pj,s[idx]);
       //printf("XDEBUG %d %d %lf \n",ic,ir,s[idx]);
@@ -163,7 +186,11 @@ int stcOptMain(double *r, const int nSmat, const int *smatToParaIdx, MPI_Comm co
       
       /* energy gradient = 2.0*( xHO[i+1] - xHO[0] * xOO[0][i+1]) */
       /* g[i] = -dt * (energy gradient) */
-      g[ir] = -dSROptStepDt*2.0*(creal(srOptHO[pi+2]) - srOptHO_0 * creal(srOptOO[pi+2]));
+      if(AllComplexFlag==0) {
+        g[ir] = -dSROptStepDt*2.0*(srOptHO_real[pi/2+1] - srOptHO_0 * srOptOO_real[pi/2+1]);
+      } else {
+        g[ir] = -dSROptStepDt*2.0*(creal(srOptHO[SROptCmpIdx[pi+2]]) - srOptHO_0 * creal(srOptOO[SROptCmpIdx[pi+2]]));
+      }
       //printf("ZDEBUG: %d %lf \n",ir,g[ir]);
     }
   }
@@ -237,6 +264,90 @@ int stcOptMain(double *r, const int nSmat, const int *smatToParaIdx, MPI_Comm co
   return info;
 }
 
+/* calculate the local tiles of xOO[i+1][j+1] * Wc directly from SROptO_Store (FlagSROptDist=1).
+   The contribution of the samples of each process is reduced to the owner of the tiles
+   one by one, so that no process holds the full matrix. */
+void stcOptDistOO(double *s, const int nSmat, const int *smatToParaIdx,
+                  int mb, int nb, int nprow, int npcol,
+                  const int myprow, const int mypcol, MPI_Comm comm) {
+  const int nRow = (AllComplexFlag==0) ? NVMCSample : 2*NVMCSample;
+  double *oRow, *oCol, *buf;
+  int *gridIdx; /* [size][2] (prow,pcol) of each process */
+  int myIdx[2];
+  int rank,size,p;
+  int n=nSmat, zero=0;
+  int mrMax,mcMax,mr,mc,pr,pc;
+  char transT='T', transN='N';
+  double one=1.0, dzero=0.0;
+
+  MPI_Comm_rank(comm,&rank);
+  MPI_Comm_size(comm,&size);
+
+  gridIdx = (int*)malloc(sizeof(int)*2*size);
+  myIdx[0] = myprow; myIdx[1] = mypcol;
+  MPI_Allgather(myIdx, 2, MPI_INT, gridIdx, 2, MPI_INT, comm);
+
+  /* the process (0,0) has the largest tiles */
+  mrMax = M_NUMROC(&n, &mb, &zero, &zero, &nprow);
+  mcMax = M_NUMROC(&n, &nb, &zero, &zero, &npcol);
+  oRow = (double*)malloc(sizeof(double)*(nRow*mrMax+nRow*mcMax+mrMax*mcMax+1));
+  oCol = oRow + nRow*mrMax;
+  buf  = oCol + nRow*mcMax;
+
+  for(p=0;p<size;p++) {
+    pr = gridIdx[2*p];
+    pc = gridIdx[2*p+1];
+    mr = M_NUMROC(&n, &mb, &pr, &zero, &nprow);
+    mc = M_NUMROC(&n, &nb, &pc, &zero, &npcol);
+    if(mr*mc==0) continue;
+
+    stcOptPackO(oRow, mr, mb, pr, nprow, smatToParaIdx);
+    stcOptPackO(oCol, mc, nb, pc, npcol, smatToParaIdx);
+
+    /* buf[ir][ic] = sum_k Re(O_k[pi]^* O_k[pj]) of the local samples */
+    M_DGEMM(&transT, &transN, &mr, &mc, &nRow, &one, oRow, &nRow, oCol, &nRow,
+            &dzero, buf, &mr);
+
+    MPI_Reduce(buf, s, mr*mc, MPI_DOUBLE, MPI_SUM, p, comm);
+  }
+
+  free(oRow);
+  free(gridIdx);
+  return;
+}
+
+/* o[il][k] = O_k of the il-th local index of the process iproc.
+   The real and imaginary parts are stored in separate rows.
+   The single-precision store (NStoreO=2) is converted to double here. */
+void stcOptPackO(double *o, const int nLoc, const int nBlk, const int iproc, const int nprocs,
+                 const int *smatToParaIdx) {
+  const int nSample=NVMCSample;
+  const int srOptSize=SROptSize;
+  int il,si,pi,k;
+  double complex x;
+
+  #pragma omp parallel for default(shared) private(il,si,pi,k,x)
+  for(il=0;il<nLoc;il++) {
+    si = (il/nBlk)*nprocs*nBlk + iproc*nBlk + (il%nBlk);
+    pi = smatToParaIdx[si];
+    if(AllComplexFlag==0) {
+      for(k=0;k<nSample;k++) {
+        if(pi%2!=0) o[k+il*nSample] = 0.0;
+        else if(NStoreO==2) o[k+il*nSample] = (double)SROptO_Store_float_real[k*srOptSize+pi/2+1];
+        else o[k+il*nSample] = SROptO_Store_real[k*srOptSize+pi/2+1];
+      }
+    } else {
+      for(k=0;k<nSample;k++) {
+        x = (NStoreO==2) ? (double complex)SROptO_Store_float[k*SROptCmpSize+SROptCmpIdx[pi+2]]
+                         : SROptO_Store[k*SROptCmpSize+SROptCmpIdx[pi+2]];
+        o[2*k+il*(2*nSample)]   = creal(x);
+        o[2*k+1+il*(2*nSample)] = cimag(x);
+      }
+    }
+  }
+  return;
+}
+
 int StochasticOptDiag(MPI_Comm comm) {
   const int nPara=NPara;
   //const int srOptSize=SROptSize;
@@ -371,7 +482,6 @@ int stcOptMainDiag(double *const r, int const nSmat, int *const smatToParaIdx,
   int ig, jg, ix, jx, incg, incx;
 
   int info;
-  const int srOptSize=SROptSize;
   const double ratioDiag = 1.0+DSROptStaDel;
   const double dSROptStepDt = DSROptStepDt;
   const double dSROptRedCut = DSROptRedCut;
@@ -460,7 +570,8 @@ int stcOptMainDiag(double *const r, int const nSmat, int *const smatToParaIdx,
       idx = ir + ic*mlocr; /* local index (row major) */
 
       /* S[i][j] = xOO[i+1][j+1] - xOO[0][i+1] * xOO[0][j+1]; */
-      s[idx] = creal(srOptOO[(pi+2)*2*srOptSize+(pj+2)]) - creal(srOptOO[pi+2]) * creal(srOptOO[pj+2]);
+      s[idx] = creal(srOptOO[SROptCmpIdx[pi+2]*SROptCmpSize+SROptCmpIdx[pj+2]])
+        - creal(srOptOO[SROptCmpIdx[pi+2]]) * creal(srOptOO[SROptCmpIdx[pj+2]]);
       /* modify diagonal elements */
       //if(pi==pj) s[idx] *= ratioDiag;
       if(pi==pj) s[idx] += 0.1;
@@ -477,7 +588,7 @@ int stcOptMainDiag(double *const r, int const nSmat, int *const smatToParaIdx,
       
       /* energy gradient = 2.0*( xHO[i+1] - xHO[0] * xOO[0][i+1]) */
       /* g[i] = (energy gradient) */
-      g[ir] = 2.0*(creal(srOptHO[pi+2]) - srOptHO_0 * creal(srOptOO[pi+2]));
+      g[ir] = 2.0*(creal(srOptHO[SROptCmpIdx[pi+2]]) - srOptHO_0 * creal(srOptOO[SROptCmpIdx[pi+2]]));
       x[ir] = 0.0;
     }
   }
@@ -34,13 +34,26 @@ along with this program. If not, see http://www.gnu.org/licenses/.
 #include "lslocgrn_real.c"
 #include "lslocgrn.c"
 #include "calgrn.c"
+#include "momentum.h"
 
 //#define _DEBUG_VMCCAL
 //#define _DEBUG_VMCCAL_DETAIL
 
+/* tolerance of |InvM*M-1| for reusing InvM of VMCMakeSample (NVMCCalFuse=1) */
+#define D_InvMDriftTol 1.0e-8
+
 void clearPhysQuantity();
+void calculatePhysQuantity(const int sample, const int rank);
+double calculateReweight(const int sample, const double complex ip, const int *eleProjCnt);
+void calculateOOStore(const int sampleSize);
+void clearOStore();
+int refreshMAll(const int *eleIdx, const int row);
+double calculateInvMDrift_fcmp(const int *eleIdx, const int row, const int qpidx);
+double calculateInvMDrift_real(const int *eleIdx, const int row, const int qpidx);
 
 void calculateOptTransDiff(double complex *srOptO, const double complex ipAll);
+void compactSROptO(double complex *srOptO);
+void calculateOptTransDiff_real(double *srOptO, const double ipAll);
 void calculateOO_matvec(double complex *srOptOO, double complex *srOptHO, const double complex *srOptO,
                  const double complex w, const double complex e, const int srOptSize);
 void calculateOO(double complex *srOptOO, double complex *srOptHO, const double complex *srOptO,
@@ -51,6 +64,15 @@ void calculateOO_Store_real(double *srOptOO_real, double *srOptHO_real,  double
                  const double w, const double e,  int srOptSize, int sampleSize);
 void calculateOO_Store(double complex *srOptOO, double complex *srOptHO,  double complex *srOptO,
                  const double w, const double complex e,  int srOptSize, int sampleSize);
+void calculateOO_Block(double complex *srOptOO, double complex *srOptHO, const double complex *srOptO,
+                 const double w, const double complex e, const int srOptSize);
+void calculateOO_Block_real(double *srOptOO, double *srOptHO, const double *srOptO,
+                 const double w, const double e, const int srOptSize);
+void flushOO_Block();
+void storeO(double complex *srOptHO, const double complex *srOptO, const int sample,
+            const double w, const double complex e, const int srOptSize);
+void storeO_real(double *srOptHO, const double *srOptO, const int sample,
+                 const double w, const double e, const int srOptSize);
 
 void calculateQQQQ_real(double *qqqq, const double *lslq, const double w, const int nLSHam);
 
@@ -69,29 +91,22 @@ void calculateQCACAQ_real(double *qcacaq, const double *lslca, const double w,
                           int **cacaIdx);
 
 void VMCMainCal(MPI_Comm comm) {
-  int *eleIdx,*eleCfg,*eleNum,*eleProjCnt;
-  double complex e,ip;
-  double w;
-  double sqrtw;
-  double complex we;
+  int *eleIdx;
 
   const int qpStart=0;
   const int qpEnd=NQPFull;
-  int sample,sampleStart,sampleEnd,sampleSize;
-  int i,info,tmp_i;
-
-  /* optimazation for Kei */
-  const int nProj=NProj;
-  double complex *srOptO = SROptO;
-  double         *srOptO_real = SROptO_real;
+  int sample,sampleStart,sampleEnd;
+  int info;
 
-  int rank,size,int_i;
+  int rank,size;
   MPI_Comm_size(comm,&size);
   MPI_Comm_rank(comm,&rank);
 #ifdef _DEBUG_VMCCAL
   printf("  Debug: SplitLoop\n");
 #endif
   SplitLoop(&sampleStart,&sampleEnd,NVMCSample,rank,size);
+  /* only the replica with beta=1 samples the target distribution */
+  if(TemperingRung!=0) sampleEnd = sampleStart;
 
   /* initialization */
   StartTimer(24);
@@ -100,9 +115,6 @@ void VMCMainCal(MPI_Comm comm) {
   for(sample=sampleStart;sample<sampleEnd;sample++) {
 
     eleIdx = EleIdx + sample*Nsize;
-    eleCfg = EleCfg + sample*Nsite2;
-    eleNum = EleNum + sample*Nsite2;
-    eleProjCnt = EleProjCnt + sample*NProj;
 
     StartTimer(40);
 #ifdef _DEBUG_VMCCAL
@@ -110,8 +122,6 @@ void VMCMainCal(MPI_Comm comm) {
 #endif
     if(AllComplexFlag==0){
       info = CalculateMAll_real(eleIdx,qpStart,qpEnd); // InvM_real,PfM_real will change
-#pragma omp parallel for default(shared) private(tmp_i)
-      for(tmp_i=0;tmp_i<NQPFull*(Nsize*Nsize+1);tmp_i++)  InvM[tmp_i]= InvM_real[tmp_i]; // InvM will be used in  SlaterElmDiff_fcmp
     }else{
       info = CalculateMAll_fcmp(eleIdx,qpStart,qpEnd); // InvM,PfM will change
     }
@@ -121,63 +131,219 @@ void VMCMainCal(MPI_Comm comm) {
       fprintf(stderr,"warning: VMCMainCal rank:%d sample:%d info:%d (CalculateMAll)\n",rank,sample,info);
       continue;
     }
+
+    calculatePhysQuantity(sample,rank);
+  } /* end of for(sample) */
+
+  calculateOOStore(sampleEnd-sampleStart);
+
+  return;
+}
+
+/* Initialization of the measurement fused with VMCMakeSample (NVMCCalFuse=1) */
+void VMCMainCalFusedStart() {
+  StartTimer(24);
+  clearPhysQuantity();
+  StopTimer(24);
+  return;
+}
+
+/* Calculate physical quantities of the sample-th configuration within VMCMakeSample.
+   InvM and PfM updated by the sampler are reused instead of CalculateMAll,
+   and they are recalculated only when the round-off error is detected. */
+void VMCMainCalFused(const int sample, MPI_Comm comm) {
+  int *eleIdx = EleIdx + sample*Nsize;
+  int info;
+  int rank;
+  MPI_Comm_rank(comm,&rank);
+
+  StopTimer(3);
+  StartTimer(4);
+
+  StartTimer(40);
+  info = refreshMAll(eleIdx, sample%Nsize);
+  StopTimer(40);
+
+  if(info!=0) {
+    fprintf(stderr,"warning: VMCMainCalFused rank:%d sample:%d info:%d (CalculateMAll)\n",rank,sample,info);
+  } else {
+    calculatePhysQuantity(sample,rank);
+  }
+
+  StopTimer(4);
+  StartTimer(3);
+  return;
+}
+
+/* Finalization of the measurement fused with VMCMakeSample (NVMCCalFuse=1) */
+void VMCMainCalFusedEnd() {
+  calculateOOStore(NVMCSample);
+  return;
+}
+
+/* Recalculate InvM and PfM if the row-th row of InvM*M deviates from the identity
+   more than D_InvMDriftTol for any quantum projection. */
+int refreshMAll(const int *eleIdx, const int row) {
+  const int qpStart=0;
+  const int qpEnd=NQPFull;
+  int qpidx;
+  int nDrift=0;
+  int info=0;
+
+  if(AllComplexFlag==0){
+#pragma omp parallel for default(shared) private(qpidx) reduction(+:nDrift)
+    for(qpidx=0;qpidx<NQPFull;qpidx++) {
+      if(!(calculateInvMDrift_real(eleIdx,row,qpidx) < D_InvMDriftTol)) nDrift++;
+    }
+    if(nDrift>0) info = CalculateMAll_real(eleIdx,qpStart,qpEnd);
+  }else{
+#pragma omp parallel for default(shared) private(qpidx) reduction(+:nDrift)
+    for(qpidx=0;qpidx<NQPFull;qpidx++) {
+      if(!(calculateInvMDrift_fcmp(eleIdx,row,qpidx) < D_InvMDriftTol)) nDrift++;
+    }
+    if(nDrift>0) info = CalculateMAll_fcmp(eleIdx,qpStart,qpEnd);
+  }
+
+  return info;
+}
+
+/* max_j |(InvM*M)_{row,j} - delta_{row,j}| for the qpidx-th quantum projection */
+/* M_{ij} = SlaterElm[rsi][rsj] and InvM is stored in row-major order */
+double calculateInvMDrift_fcmp(const int *eleIdx, const int row, const int qpidx) {
+  const int nsize=Nsize;
+  const double complex *sltE = SlaterElm + qpidx*Nsite2*NSlaterElmCol;
+  const double complex *invM_row = InvM + qpidx*Nsize*Nsize + row*Nsize;
+  int msj,msk,rsj,rsk;
+  double complex r;
+  double drift=0.0;
+
+  for(msj=0;msj<nsize;msj++) {
+    rsj = eleIdx[msj] + (msj/Ne)*Nsite;
+    r = (msj==row) ? -1.0 : 0.0;
+    for(msk=0;msk<nsize;msk++) {
+      rsk = eleIdx[msk] + (msk/Ne)*Nsite;
+      r += invM_row[msk] * GetSlaterElm_fcmp(sltE, rsk, rsj);
+    }
+    if(!(cabs(r) <= drift)) drift = cabs(r);
+  }
+
+  return drift;
+}
+
+double calculateInvMDrift_real(const int *eleIdx, const int row, const int qpidx) {
+  const int nsize=Nsize;
+  const double *sltE = SlaterElm_real + qpidx*Nsite2*NSlaterElmCol;
+  const double *invM_row = InvM_real + qpidx*Nsize*Nsize + row*Nsize;
+  int msj,msk,rsj,rsk;
+  double r;
+  double drift=0.0;
+
+  for(msj=0;msj<nsize;msj++) {
+    rsj = eleIdx[msj] + (msj/Ne)*Nsite;
+    r = (msj==row) ? -1.0 : 0.0;
+    for(msk=0;msk<nsize;msk++) {
+      rsk = eleIdx[msk] + (msk/Ne)*Nsite;
+      r += invM_row[msk] * GetSlaterElm_real(sltE, rsk, rsj);
+    }
+    if(!(fabs(r) <= drift)) drift = fabs(r);
+  }
+
+  return drift;
+}
+
+/* Calculate physical quantities of the sample-th configuration */
+/* InvM and PfM (InvM_real and PfM_real) must be those of the configuration */
+void calculatePhysQuantity(const int sample, const int rank) {
+  int *eleIdx,*eleCfg,*eleNum,*eleProjCnt;
+  double complex e,ip;
+  double w;
+
+  const int qpStart=0;
+  const int qpEnd=NQPFull;
+  int i;
+
+  /* optimazation for Kei */
+  const int nProj=NProj;
+  double complex *srOptO = SROptO;
+  double         *srOptO_real = SROptO_real;
+
+  eleIdx = EleIdx + sample*Nsize;
+  eleCfg = EleCfg + sample*Nsite2;
+  eleNum = EleNum + sample*Nsite2;
+  eleProjCnt = EleProjCnt + sample*NProj;
+
 #ifdef _DEBUG_VMCCAL
-    printf("  Debug: sample=%d: CalculateIP \n",sample);
+  printf("  Debug: sample=%d: CalculateIP \n",sample);
 #endif
-    if(AllComplexFlag==0){
-      ip = CalculateIP_real(PfM_real,qpStart,qpEnd,MPI_COMM_SELF);
-    }else{
-      ip = CalculateIP_fcmp(PfM,qpStart,qpEnd,MPI_COMM_SELF);
-    } 
+  if(AllComplexFlag==0){
+    ip = CalculateIP_real(PfM_real,qpStart,qpEnd,MPI_COMM_SELF);
+  }else{
+    ip = CalculateIP_fcmp(PfM,qpStart,qpEnd,MPI_COMM_SELF);
+  } 
 
 #ifdef _DEBUG_VMCCAL
-    printf("  Debug: sample=%d: LogProjVal \n",sample);
+  printf("  Debug: sample=%d: LogProjVal \n",sample);
 #endif
-    /* calculate reweight */
-    //w = exp(2.0*(log(fabs(ip))+x) - logSqPfFullSlater[sample]);
-    w =1.0;
+  /* calculate reweight */
+  w = calculateReweight(sample,ip,eleProjCnt);
 #ifdef _DEBUG_VMCCAL
-    printf("  Debug: sample=%d: isfinite \n",sample);
+  printf("  Debug: sample=%d: isfinite \n",sample);
 #endif
-    if( !isfinite(w) ) {
-      fprintf(stderr,"warning: VMCMainCal rank:%d sample:%d w=%e\n",rank,sample,w);
-      continue;
-    }
+  if( !isfinite(w) ) {
+    fprintf(stderr,"warning: VMCMainCal rank:%d sample:%d w=%e\n",rank,sample,w);
+    return;
+  }
 
-    StartTimer(41);
-    /* calculate energy */
+  StartTimer(41);
+  /* calculate energy */
 #ifdef _DEBUG_VMCCAL
-    printf("  Debug: sample=%d: calculateHam \n",sample);
+  printf("  Debug: sample=%d: calculateHam \n",sample);
 #endif
-    if(AllComplexFlag==0){
+  if(AllComplexFlag==0){
 #ifdef _DEBUG_VMCCAL
-      printf("  Debug: sample=%d: calculateHam_real \n",sample);
+    printf("  Debug: sample=%d: calculateHam_real \n",sample);
 #endif
-      e = CalculateHamiltonian_real(creal(ip),eleIdx,eleCfg,eleNum,eleProjCnt);
-    }else{
+    e = CalculateHamiltonian_real(creal(ip),eleIdx,eleCfg,eleNum,eleProjCnt);
+  }else{
 #ifdef _DEBUG_VMCCAL
-      printf("  Debug: sample=%d: calculateHam_cmp \n",sample);
+    printf("  Debug: sample=%d: calculateHam_cmp \n",sample);
 #endif
-      e = CalculateHamiltonian(ip,eleIdx,eleCfg,eleNum,eleProjCnt);
-    }
-    //printf("MDEBUG: %lf %lf \n",creal(e),cimag(e));
-    StopTimer(41);
+    e = CalculateHamiltonian(ip,eleIdx,eleCfg,eleNum,eleProjCnt);
+  }
+  //printf("MDEBUG: %lf %lf \n",creal(e),cimag(e));
+  StopTimer(41);
 
 #ifdef _DEBUG_VMCCAL
-    printf("  Debug: sample=%d: e = %lf %lf \n",sample, creal(e), cimag(e));
+  printf("  Debug: sample=%d: e = %lf %lf \n",sample, creal(e), cimag(e));
 #endif
-    if( !isfinite(creal(e) + cimag(e)) ) {
-      fprintf(stderr,"warning: VMCMainCal rank:%d sample:%d e=%e\n",rank,sample,creal(e)); //TBC
-      continue;
-    }
+  if( !isfinite(creal(e) + cimag(e)) ) {
+    fprintf(stderr,"warning: VMCMainCal rank:%d sample:%d e=%e\n",rank,sample,creal(e)); //TBC
+    return;
+  }
+  if(NVMCAutoCorr>0) SampleLocEnergy[sample] = creal(e);
 
-    Wc += w;
-    Etot  += w * e;
-    Etot2 += w * conj(e) * e;
+  Wc += w;
+  Etot  += w * e;
+  Etot2 += w * conj(e) * e;
 #ifdef _DEBUG_VMCCAL
-    printf("  Debug: sample=%d: calculateOpt \n",sample);
+  printf("  Debug: sample=%d: calculateOpt \n",sample);
 #endif
-    if(NVMCCalMode==0) {
+  if(NVMCCalMode==0) {
+    if(AllComplexFlag==0){
+      /* Calculate O for correlation fauctors */
+      srOptO_real[0] = 1.0;
+#pragma loop noalias
+      for(i=0;i<nProj;i++) srOptO_real[i+1] = (double)(eleProjCnt[i]);
+
+      StartTimer(42);
+      /* SlaterElmDiff */
+      SlaterElmDiff_real(SROptO_real+NProj+1,creal(ip),eleIdx);
+      StopTimer(42);
+
+      if(FlagOptTrans>0) {
+        calculateOptTransDiff_real(SROptO_real+NProj+NSlater+1, creal(ip));
+      }
+    }else{
       /* Calculate O for correlation fauctors */
       srOptO[0] = 1.0+0.0*I;//   real 
       srOptO[1] = 0.0+0.0*I;//   real 
@@ -189,115 +355,142 @@ void VMCMainCal(MPI_Comm comm) {
 
       StartTimer(42);
       /* SlaterElmDiff */
-      SlaterElmDiff_fcmp(SROptO+2*NProj+2,ip,eleIdx); //TBC: using InvM not InvM_real
+      SlaterElmDiff_fcmp(SROptO+2*NProj+2,ip,eleIdx);
       StopTimer(42);
 
       if(FlagOptTrans>0) { // this part will be not used
         calculateOptTransDiff(SROptO+2*NProj+2*NSlater+2, ip); //TBC
       }
-      //[s] this part will be used for real varaibles
-      if(AllComplexFlag==0){
-#pragma loop noalias
-        for(i=0;i<SROptSize;i++){ 
-          srOptO_real[i] = creal(srOptO[2*i]);       
-        }
-      }
-      //[e]
+    }
 
-      StartTimer(43);
-      /* Calculate OO and HO */
-      if(NSRCG==0 && NStoreO==0){
+    StartTimer(43);
+    if(AllComplexFlag!=0) compactSROptO(SROptO);
+    /* Calculate OO and HO */
+    if(NSRCG==0 && NStoreO==0){
+      if(NStoreOBlock>0){
         if(AllComplexFlag==0){
-          calculateOO_real(SROptOO_real,SROptHO_real,SROptO_real,w,creal(e),SROptSize);
+          calculateOO_Block_real(SROptOO_real,SROptHO_real,SROptO_real,w,creal(e),SROptSize);
         }else{
-          calculateOO(SROptOO,SROptHO,SROptO,w,e,SROptSize);
-        } 
-      }else{
-        we    = w*e;
-        sqrtw = sqrt(w); 
-        if(AllComplexFlag==0){
-          #pragma omp parallel for default(shared) private(int_i)
-          for(int_i=0;int_i<SROptSize;int_i++){
-            // SROptO_Store for fortran
-            SROptO_Store_real[int_i+sample*SROptSize]  = sqrtw*SROptO_real[int_i];
-            SROptHO_real[int_i]                       += creal(we)*SROptO_real[int_i]; 
-          }
-        }else{
-          #pragma omp parallel for default(shared) private(int_i)
-          for(int_i=0;int_i<SROptSize*2;int_i++){
-            // SROptO_Store for fortran
-            SROptO_Store[int_i+sample*(2*SROptSize)]  = sqrtw*SROptO[int_i];
-            SROptHO[int_i]                           += we*SROptO[int_i]; 
-          }
+          calculateOO_Block(SROptOO,SROptHO,SROptO,w,e,SROptCmpSize);
         }
+      }else if(AllComplexFlag==0){
+        calculateOO_real(SROptOO_real,SROptHO_real,SROptO_real,w,creal(e),SROptSize);
+      }else{
+        calculateOO(SROptOO,SROptHO,SROptO,w,e,SROptCmpSize);
       } 
-      StopTimer(43);
+    }else if(AllComplexFlag==0){
+      storeO_real(SROptHO_real,SROptO_real,sample,w,creal(e),SROptSize);
+    }else{
+      storeO(SROptHO,SROptO,sample,w,e,SROptCmpSize);
+    } 
+    StopTimer(43);
 
-    } else if(NVMCCalMode==1) {
-      StartTimer(42);
-      /* Calculate Green Function */
+  } else if(NVMCCalMode==1) {
+    StartTimer(42);
+    /* Calculate Green Function */
 #ifdef _DEBUG_VMCCAL
-      fprintf(stdout, "Debug: Start: CalcGreenFunc\n");
+    fprintf(stdout, "Debug: Start: CalcGreenFunc\n");
 #endif
-      CalculateGreenFunc(w,ip,eleIdx,eleCfg,eleNum,eleProjCnt);
-      StopTimer(42);
+    CalculateGreenFunc(w,ip,eleIdx,eleCfg,eleNum,eleProjCnt);
+    /* Calculate structure factors and momentum distribution */
+    if(NMomentum>0) CalculateMomentum(w,ip,eleIdx,eleCfg,eleNum,eleProjCnt);
+    StopTimer(42);
 
-      if(NLanczosMode>0){
+    if(NLanczosMode>0){
 #ifdef _DEBUG_VMCCAL
-  fprintf(stdout, "Debug: Start: Lanczos\n");
+fprintf(stdout, "Debug: Start: Lanczos\n");
 #endif
-        // ignoring Lanczos: to be added
-        /* Calculate local QQQQ */
-        StartTimer(43);
+      // ignoring Lanczos: to be added
+      /* Calculate local QQQQ */
+      StartTimer(43);
+      if(AllComplexFlag==0) {
+        LSLocalQ_real(creal(e),creal(ip),eleIdx,eleCfg,eleNum,eleProjCnt, LSLQ_real);
+        calculateQQQQ_real(QQQQ_real,LSLQ_real,w,NLSHam);
+      }else{
+        LSLocalQ(e,ip,eleIdx,eleCfg,eleNum,eleProjCnt, LSLQ);
+        calculateQQQQ(QQQQ,LSLQ,w,NLSHam);
+      }
+      StopTimer(43);
+
+      // LanczosGreen
+      if(NLanczosMode>1){
+        // Calculate local QcisAjsQ
+        StartTimer(44);
         if(AllComplexFlag==0) {
-          LSLocalQ_real(creal(e),creal(ip),eleIdx,eleCfg,eleNum,eleProjCnt, LSLQ_real);
-          calculateQQQQ_real(QQQQ_real,LSLQ_real,w,NLSHam);
-        }else{
-          LSLocalQ(e,ip,eleIdx,eleCfg,eleNum,eleProjCnt, LSLQ);
-          calculateQQQQ(QQQQ,LSLQ,w,NLSHam);
+          
+          LSLocalCisAjs_real(creal(e),creal(ip),eleIdx,eleCfg,eleNum,eleProjCnt);
+          calculateQCAQ_real(QCisAjsQ_real,LSLCisAjs_real,LSLQ_real,w,NLSHam,NCisAjs);
+          calculateQCACAQ_real(QCisAjsCktAltQ_real,LSLCisAjs_real,w,NLSHam,NCisAjs,
+                          NCisAjsCktAltDC, CisAjsCktAltLzIdx);
+          
         }
-        StopTimer(43);
-
-        // LanczosGreen
-        if(NLanczosMode>1){
-          // Calculate local QcisAjsQ
-          StartTimer(44);
-          if(AllComplexFlag==0) {
-            
-            LSLocalCisAjs_real(creal(e),creal(ip),eleIdx,eleCfg,eleNum,eleProjCnt);
-            calculateQCAQ_real(QCisAjsQ_real,LSLCisAjs_real,LSLQ_real,w,NLSHam,NCisAjs);
-            calculateQCACAQ_real(QCisAjsCktAltQ_real,LSLCisAjs_real,w,NLSHam,NCisAjs,
-                            NCisAjsCktAltDC, CisAjsCktAltLzIdx);
-            
-          }
-          else{
-            LSLocalCisAjs(e,ip,eleIdx,eleCfg,eleNum,eleProjCnt);
-            calculateQCAQ(QCisAjsQ,LSLCisAjs,LSLQ,w,NLSHam,NCisAjs);
-            calculateQCACAQ(QCisAjsCktAltQ,LSLCisAjs,w,NLSHam,NCisAjs,
-                            NCisAjsCktAltDC,CisAjsCktAltLzIdx);
-          }
-          StopTimer(44);
+        else{
+          LSLocalCisAjs(e,ip,eleIdx,eleCfg,eleNum,eleProjCnt);
+          calculateQCAQ(QCisAjsQ,LSLCisAjs,LSLQ,w,NLSHam,NCisAjs);
+          calculateQCACAQ(QCisAjsCktAltQ,LSLCisAjs,w,NLSHam,NCisAjs,
+                          NCisAjsCktAltDC,CisAjsCktAltLzIdx);
         }
+        StopTimer(44);
       }
     }
-  } /* end of for(sample) */
+  }
+  return;
+}
+
+/* The weight of the sample-th configuration. The samples drawn from |psi|^2 are
+   reused with |psi/psi_sample|^2 by the second stage of a Heun step (FlagSROptReweight=1),
+   where psi_sample is the amplitude saved in logSqPfFullSlater when the sample was made. */
+double calculateReweight(const int sample, const double complex ip, const int *eleProjCnt) {
+  if(FlagSROptReweight==0) return 1.0;
+  return exp(2.0*(log(cabs(ip))+LogProjVal(eleProjCnt)) - logSqPfFullSlater[sample]);
+}
+
+/* clear the stored O of all the samples */
+void clearOStore() {
+  int i;
+  const int n = ((AllComplexFlag==0) ? SROptSize : SROptCmpSize)*NVMCSample;
+  if(NStoreO==2){
+    if(AllComplexFlag==0){
+#pragma omp parallel for default(shared) private(i)
+      for(i=0;i<n;i++) SROptO_Store_float_real[i] = 0.0;
+    }else{
+#pragma omp parallel for default(shared) private(i)
+      for(i=0;i<n;i++) SROptO_Store_float[i] = 0.0;
+    }
+  }else{
+    if(AllComplexFlag==0){
+#pragma omp parallel for default(shared) private(i)
+      for(i=0;i<n;i++) SROptO_Store_real[i] = 0.0;
+    }else{
+#pragma omp parallel for default(shared) private(i)
+      for(i=0;i<n;i++) SROptO_Store[i] = 0.0;
+    }
+  }
+  return;
+}
 
 // calculate OO and HO at NVMCCalMode==0
+void calculateOOStore(const int sampleSize) {
   if(NVMCCalMode==0){
+    if(NStoreOBlock>0){
+      StartTimer(45);
+      flushOO_Block();
+      StopTimer(45);
+    }
     if(NSRCG!=0 || NStoreO!=0){
-      sampleSize=sampleEnd-sampleStart;
+      /* the replicas with beta<1 keep no samples, but SR-CG reads all the stored rows */
+      if(TemperingRung!=0) clearOStore();
       if(AllComplexFlag==0){
         StartTimer(45);
-        calculateOO_Store_real(SROptOO_real,SROptHO_real,SROptO_Store_real,creal(w),creal(e),SROptSize,sampleSize);
+        calculateOO_Store_real(SROptOO_real,SROptHO_real,SROptO_Store_real,1.0,0.0,SROptSize,sampleSize);
         StopTimer(45);
       }else{
         StartTimer(45);
-        calculateOO_Store(SROptOO,SROptHO,SROptO_Store,w,e,2*SROptSize,sampleSize);
+        calculateOO_Store(SROptOO,SROptHO,SROptO_Store,1.0,0.0,SROptCmpSize,sampleSize);
         StopTimer(45);
       }
     }
   }
-
   return;
 }
 
@@ -305,8 +498,7 @@ void VMC_BF_MainCal(MPI_Comm comm) {
   int *eleIdx, *eleCfg, *eleNum, *eleProjCnt, *eleProjBFCnt;
   double complex e, ip; //db is double?
   double w, db;
-  double we, sqrtw;
-  int int_i, sampleSize, tmp_i;
+  int sampleSize, tmp_i;
   const int qpStart = 0;
   const int qpEnd = NQPFull;
   int sample, sampleStart, sampleEnd;
@@ -353,7 +545,7 @@ void VMC_BF_MainCal(MPI_Comm comm) {
     StartTimer(40);
     if (AllComplexFlag == 0) {
 #pragma omp parallel for default(shared) private(tmp_i)
-      for (tmp_i = 0; tmp_i < NQPFull * (2 * Nsite) * (2 * Nsite); tmp_i++)
+      for (tmp_i = 0; tmp_i < NQPFull * Nsite2 * NSlaterElmCol; tmp_i++)
         SlaterElm_real[tmp_i] = creal(SlaterElm[tmp_i]);
 
       info = CalculateMAll_BF_real(eleIdx, qpStart, qpEnd);  // InvM_real,PfM_real will change
@@ -376,11 +568,8 @@ void VMC_BF_MainCal(MPI_Comm comm) {
       ip = CalculateIP_fcmp(PfM, qpStart, qpEnd, MPI_COMM_SELF);
     }
 
-    LogProjVal(eleProjCnt);
     /* calculate reweight */
-    // TODO: check ~ Is it OK to fix w ?
-    //w = exp(2.0*(log(fabs(ip))+x) - logSqPfFullSlater[sample]);
-    w = 1.0;
+    w = calculateReweight(sample, ip, eleProjCnt);
     /*
        if(log(fabs(1.0-w)) > -5) {
        printf("w=%.3e\n",w);
@@ -405,6 +594,7 @@ void VMC_BF_MainCal(MPI_Comm comm) {
       fprintf(stderr, "waring: VMCMainCal rank:%d sample:%d e=%e\n", rank, sample, creal(e));
       continue;
     }
+    if (NVMCAutoCorr > 0) SampleLocEnergy[sample] = creal(e);
 
     Wc += w;
     Etot += w * e;
@@ -453,31 +643,24 @@ for(i=0;i<nProj;i++) srOptO[i+1] = (double)(eleProjCnt[i]);
       //[e]
 
       StartTimer(43);
+      if (AllComplexFlag != 0) compactSROptO(SROptO);
       /* Calculate OO and HO */
       if (NSRCG==0 && NStoreO == 0) {
-        if (AllComplexFlag == 0) {
+        if (NStoreOBlock > 0) {
+          if (AllComplexFlag == 0) {
+            calculateOO_Block_real(SROptOO_real, SROptHO_real, SROptO_real, w, creal(e), SROptSize);
+          } else {
+            calculateOO_Block(SROptOO, SROptHO, SROptO, w, e, SROptCmpSize);
+          }
+        } else if (AllComplexFlag == 0) {
           calculateOO_real(SROptOO_real, SROptHO_real, SROptO_real, w, creal(e), SROptSize);
         } else {
-          calculateOO(SROptOO, SROptHO, SROptO, w, e, SROptSize);
+          calculateOO(SROptOO, SROptHO, SROptO, w, e, SROptCmpSize);
         }
+      } else if (AllComplexFlag == 0) {
+        storeO_real(SROptHO_real, SROptO_real, sample, w, creal(e), SROptSize);
       } else {
-        we = w * e;
-        sqrtw = sqrt(w);
-        if (AllComplexFlag == 0) {
-#pragma omp parallel for default(shared) private(int_i)
-          for (int_i = 0; int_i < SROptSize; int_i++) {
-            // SROptO_Store for fortran
-            SROptO_Store_real[int_i + sample * SROptSize] = sqrtw * SROptO_real[int_i];
-            SROptHO_real[int_i] += creal(we) * SROptO_real[int_i];
-          }
-        } else {
-#pragma omp parallel for default(shared) private(int_i)
-          for (int_i = 0; int_i < SROptSize * 2; int_i++) {
-            // SROptO_Store for fortran
-            SROptO_Store[int_i + sample * (2 * SROptSize)] = sqrtw * SROptO[int_i];
-            SROptHO[int_i] += we * SROptO[int_i];
-          }
-        }
+        storeO(SROptHO, SROptO, sample, w, e, SROptCmpSize);
       }
       StopTimer(43);
 
@@ -523,6 +706,11 @@ for(i=0;i<nProj;i++) srOptO[i+1] = (double)(eleProjCnt[i]);
 
   // calculate OO and HO at NVMCCalMode==0
   if(NVMCCalMode==0){
+    if(NStoreOBlock>0){
+      StartTimer(45);
+      flushOO_Block();
+      StopTimer(45);
+    }
     if(NStoreO!=0 || NSRCG!=0){
       sampleSize=sampleEnd-sampleStart;
       if(AllComplexFlag==0){
@@ -531,7 +719,7 @@ for(i=0;i<nProj;i++) srOptO[i+1] = (double)(eleProjCnt[i]);
         StopTimer(45);
       }else{
         StartTimer(45);
-        calculateOO_Store(SROptOO,SROptHO,SROptO_Store,w,e,2*SROptSize,sampleSize);
+        calculateOO_Store(SROptOO,SROptHO,SROptO_Store,w,e,SROptCmpSize,sampleSize);
         StopTimer(45);
       }
     }
@@ -553,18 +741,22 @@ void clearPhysQuantity(){
   //Wc = Etot = Etot2 = 0.0;
   Dbtot = Dbtot2 = 0.0;
 //[e] MERGE BY TM
+  if(NVMCAutoCorr>0) {
+    #pragma omp parallel for default(shared) private(i)
+    for(i=0;i<NVMCSample;i++) SampleLocEnergy[i] = 0.0;
+  }
   if(NVMCCalMode==0) {
     /* SROptOO, SROptHO, SROptO */
-    if(NSRCG!=0){
-      n = (2*SROptSize)*4; // TBC
+    if(NSRCG!=0 || FlagSROptDist!=0 || AllComplexFlag==0){
+      n = SROptCmpSize*3+2*SROptSize; // TBC
     }else{
-      n = (2*SROptSize)*(2*SROptSize+2); // TBC
+      n = SROptCmpSize*(SROptCmpSize+1)+2*SROptSize; // TBC
     }
     vec = SROptOO;
     #pragma omp parallel for default(shared) private(i)
     for(i=0;i<n;i++) vec[i] = 0.0+0.0*I;
 // only for real variables
-    if(NSRCG!=0){
+    if(NSRCG!=0 || FlagSROptDist!=0){
       n = (SROptSize)*4; // TBC
     }else{
       n = (SROptSize)*(SROptSize+2); // TBC
@@ -579,6 +771,14 @@ void clearPhysQuantity(){
 #pragma omp parallel for default(shared) private(i)
     for(i=0;i<n;i++) vec[i] = 0.0+0.0*I;
 
+    if(NMomentum>0) {
+      /* N(q), Sz(q), n_up(k), n_down(k) */
+      n = 4*NMomentum;
+      vec = PhysMomentum;
+#pragma omp parallel for default(shared) private(i)
+      for(i=0;i<n;i++) vec[i] = 0.0+0.0*I;
+    }
+
     if(NLanczosMode>0) {
       /* QQQQ, LSLQ */
         //[TODO]: Check the value n
@@ -612,6 +812,18 @@ void clearPhysQuantity(){
   return;
 }
 
+/* drop the imaginary directions of the parameters with OptFlag=0 from srOptO[2*SROptSize].
+   The first SROptCmpSize elements are the compact O accumulated in SROptOO and SROptO_Store. */
+void compactSROptO(double complex *srOptO) {
+  int i;
+  if(SROptCmpSize==2*SROptSize) return;
+  /* SROptCmpIdx[i] <= i, so that the loop must be sequential */
+  for(i=2;i<2*SROptSize;i++) {
+    if(SROptCmpIdx[i]>=0) srOptO[SROptCmpIdx[i]] = srOptO[i];
+  }
+  return;
+}
+
 void calculateOptTransDiff(double complex *srOptO, const double complex ipAll) {
   int i,j;
   double complex ip;
@@ -629,10 +841,27 @@ void calculateOptTransDiff(double complex *srOptO, const double complex ipAll) {
   return;
 }
 
+void calculateOptTransDiff_real(double *srOptO, const double ipAll) {
+  int i,j;
+  double ip;
+  double *pfM;
+
+  for(i=0;i<NQPOptTrans;++i) {
+    ip = 0.0;
+    pfM = PfM_real + i*NQPFix;
+    for(j=0;j<NQPFix;++j) {
+      ip += creal(QPFixWeight[j]) * pfM[j];
+    }
+    srOptO[i] = ip/ipAll;
+  }
+
+  return;
+}
+
 void calculateOO_Store_real(double *srOptOO_real, double *srOptHO_real, double *srOptO_Store_real,
                  const double w, const double e, int srOptSize, int sampleSize) {
 
-  int i,j;
+  int i,j,k;
   char jobz, uplo;
   double alpha,beta,o;
   
@@ -641,7 +870,21 @@ void calculateOO_Store_real(double *srOptOO_real, double *srOptHO_real, double *
   
   jobz = 'N';
   uplo = 'T';
-  if(NSRCG==0){
+  if(NSRCG==0 && FlagSROptDist==0 && NStoreO==2){
+    /* convert D_StoreOChunk samples at once to double and accumulate OO */
+    double *buf = (double*)malloc(sizeof(double)*srOptSize*D_StoreOChunk);
+    for(j=0; j<sampleSize; j+=D_StoreOChunk){
+      k = (sampleSize-j < D_StoreOChunk) ? sampleSize-j : D_StoreOChunk;
+#pragma omp parallel for default(shared) private(i)
+#pragma loop noalias
+      for(i=0; i<srOptSize*k; ++i){
+        buf[i] = (double)SROptO_Store_float_real[i+j*srOptSize];
+      }
+      beta = (j==0) ? 0.0 : 1.0;
+      M_DGEMM(&jobz,&uplo,&srOptSize,&srOptSize,&k,&alpha,buf,&srOptSize,buf,&srOptSize,&beta,srOptOO_real,&srOptSize);
+    }
+    free(buf);
+  }else if(NSRCG==0 && FlagSROptDist==0){
     M_DGEMM(&jobz,&uplo,&srOptSize,&srOptSize,&sampleSize,&alpha,srOptO_Store_real,&srOptSize,srOptO_Store_real,&srOptSize,&beta,srOptOO_real,&srOptSize);
   }else{
 #pragma omp parallel for default(shared) private(i)
@@ -654,7 +897,7 @@ void calculateOO_Store_real(double *srOptOO_real, double *srOptHO_real, double *
 #pragma omp parallel for default(shared) private(i,o)
 #pragma loop noalias
     for(i=0; i<srOptSize; ++i){
-      o = srOptO_Store_real[i+j*srOptSize];
+      o = (NStoreO==2) ? (double)SROptO_Store_float_real[i+j*srOptSize] : srOptO_Store_real[i+j*srOptSize];
       srOptOO_real[i] += o;
       srOptOO_real[i+srOptSize] += o*o;
     }}
@@ -668,7 +911,7 @@ void calculateOO_Store_real(double *srOptOO_real, double *srOptHO_real, double *
 void calculateOO_Store(double complex *srOptOO, double complex *srOptHO, double complex *srOptO_Store,
                  const double w, const double complex e, int srOptSize, int sampleSize) {
 
-  int i,j;
+  int i,j,k;
   char jobz, uplo;
   double complex alpha,beta,o;
   
@@ -677,7 +920,21 @@ void calculateOO_Store(double complex *srOptOO, double complex *srOptHO, double
   
   jobz = 'N';
   uplo = 'C';
-  if(NSRCG==0){
+  if(NSRCG==0 && FlagSROptDist==0 && NStoreO==2){
+    /* convert D_StoreOChunk samples at once to double and accumulate OO */
+    double complex *buf = (double complex*)malloc(sizeof(double complex)*srOptSize*D_StoreOChunk);
+    for(j=0; j<sampleSize; j+=D_StoreOChunk){
+      k = (sampleSize-j < D_StoreOChunk) ? sampleSize-j : D_StoreOChunk;
+#pragma omp parallel for default(shared) private(i)
+#pragma loop noalias
+      for(i=0; i<srOptSize*k; ++i){
+        buf[i] = (double complex)SROptO_Store_float[i+j*srOptSize];
+      }
+      beta = (j==0) ? 0.0 : 1.0;
+      M_ZGEMM(&jobz,&uplo,&srOptSize,&srOptSize,&k,&alpha,buf,&srOptSize,buf,&srOptSize,&beta,srOptOO,&srOptSize);
+    }
+    free(buf);
+  }else if(NSRCG==0 && FlagSROptDist==0){
     M_ZGEMM(&jobz,&uplo,&srOptSize,&srOptSize,&sampleSize,&alpha,srOptO_Store,&srOptSize,srOptO_Store,&srOptSize,&beta,srOptOO,&srOptSize);
   }else{
 #pragma omp parallel for default(shared) private(i)
@@ -690,7 +947,7 @@ void calculateOO_Store(double complex *srOptOO, double complex *srOptHO, double
 #pragma omp parallel for default(shared) private(i,o)
 #pragma loop noalias
     for(i=0; i<srOptSize; ++i){
-      o = srOptO_Store[i+j*srOptSize];
+      o = (NStoreO==2) ? (double complex)SROptO_Store_float[i+j*srOptSize] : srOptO_Store[i+j*srOptSize];
       srOptOO[i] += o;
       srOptOO[i+srOptSize] += creal(o)*creal(o)+cimag(o)*cimag(o);
     } }
@@ -732,7 +989,7 @@ void calculateOO_matvec(double complex *srOptOO, double complex *srOptHO, const
   double complex we=w*e;
 
   int m,n,incx,incy,lda;
-  m=n=lda=2*srOptSize;
+  m=n=lda=srOptSize;
   incx=incy=1;
 
 //   OO[i][j] += w*O[i]*O[j] 
@@ -749,20 +1006,20 @@ void calculateOO(double complex *srOptOO, double complex *srOptHO, const double
   #pragma omp parallel for default(shared) private(j,tmp)
   //    private(i,j,tmp,srOptOO)
 #pragma loop noalias
-  for(j=0;j<2*srOptSize;j++) {
-    tmp                            = w * srOptO[j];
-    srOptOO[0*(2*srOptSize)+j]    += tmp;      // update O
-    srOptOO[1*(2*srOptSize)+j]    += 0.0;      // update 
-    srOptHO[j]                    += e * tmp;  // update HO
+  for(j=0;j<srOptSize;j++) {
+    tmp                        = w * srOptO[j];
+    srOptOO[0*srOptSize+j]    += tmp;      // update O
+    srOptOO[1*srOptSize+j]    += 0.0;      // update 
+    srOptHO[j]                += e * tmp;  // update HO
   }
   
   #pragma omp parallel for default(shared) private(i,j,tmp)
 #pragma loop noalias
-  for(i=2;i<2*srOptSize;i++) {
+  for(i=2;i<srOptSize;i++) {
     tmp            = w * srOptO[i];
-    for(j=0;j<2*srOptSize;j++) {
-      srOptOO[i*(2*srOptSize)+j] += w*(srOptO[j])*conj(srOptO[i]); // TBC
-      //srOptOO[j+i*(2*srOptSize)] += w*(srOptO[j])*(srOptO[i]); // TBC
+    for(j=0;j<srOptSize;j++) {
+      srOptOO[i*srOptSize+j] += w*(srOptO[j])*conj(srOptO[i]); // TBC
+      //srOptOO[j+i*srOptSize] += w*(srOptO[j])*(srOptO[i]); // TBC
     }
   }
 
@@ -785,6 +1042,124 @@ void calculateOO_real(double *srOptOO, double *srOptHO, const double *srOptO,
   return;
 }
 
+/* Store sqrt(w)*O in SROptO_Block and accumulate OO by ZHERK every NStoreOBlock samples.
+   srOptSize is the length of the compact complex O (SROptCmpSize).
+   Only the upper triangle of OO is calculated. It is completed in WeightAverageSROpt. */
+void calculateOO_Block(double complex *srOptOO, double complex *srOptHO, const double complex *srOptO,
+                 const double w, const double complex e, const int srOptSize) {
+  const int n=srOptSize;
+  const double complex we=w*e;
+  const double sqrtw=sqrt(w);
+  double complex *o = SROptO_Block + NStoreOBlockStored*n;
+  int i;
+
+#pragma omp parallel for default(shared) private(i)
+#pragma loop noalias
+  for(i=0;i<n;i++) {
+    o[i]        = sqrtw*srOptO[i];
+    srOptHO[i] += we*srOptO[i];
+  }
+
+  NStoreOBlockStored++;
+  if(NStoreOBlockStored==NStoreOBlock) flushOO_Block();
+  return;
+}
+
+void calculateOO_Block_real(double *srOptOO, double *srOptHO, const double *srOptO,
+                 const double w, const double e, const int srOptSize) {
+  const int n=srOptSize;
+  const double we=w*e;
+  const double sqrtw=sqrt(w);
+  double *o = SROptO_Block_real + NStoreOBlockStored*n;
+  int i;
+
+#pragma omp parallel for default(shared) private(i)
+#pragma loop noalias
+  for(i=0;i<n;i++) {
+    o[i]        = sqrtw*srOptO[i];
+    srOptHO[i] += we*srOptO[i];
+  }
+
+  NStoreOBlockStored++;
+  if(NStoreOBlockStored==NStoreOBlock) flushOO_Block();
+  return;
+}
+
+/* Store sqrt(w)*O of the sample in SROptO_Store (SROptO_Store_float for NStoreO=2)
+   and accumulate HO. srOptSize is the length of the compact complex O (SROptCmpSize). */
+void storeO(double complex *srOptHO, const double complex *srOptO, const int sample,
+            const double w, const double complex e, const int srOptSize) {
+  const int n=srOptSize;
+  const double complex we=w*e;
+  const double sqrtw=sqrt(w);
+  int i;
+
+  if(NStoreO==2){
+    float complex *o = SROptO_Store_float + sample*n;
+#pragma omp parallel for default(shared) private(i)
+#pragma loop noalias
+    for(i=0;i<n;i++) {
+      o[i]        = (float complex)(sqrtw*srOptO[i]);
+      srOptHO[i] += we*srOptO[i];
+    }
+  }else{
+    double complex *o = SROptO_Store + sample*n;
+#pragma omp parallel for default(shared) private(i)
+#pragma loop noalias
+    for(i=0;i<n;i++) {
+      o[i]        = sqrtw*srOptO[i];
+      srOptHO[i] += we*srOptO[i];
+    }
+  }
+  return;
+}
+
+void storeO_real(double *srOptHO, const double *srOptO, const int sample,
+                 const double w, const double e, const int srOptSize) {
+  const int n=srOptSize;
+  const double we=w*e;
+  const double sqrtw=sqrt(w);
+  int i;
+
+  if(NStoreO==2){
+    float *o = SROptO_Store_float_real + sample*n;
+#pragma omp parallel for default(shared) private(i)
+#pragma loop noalias
+    for(i=0;i<n;i++) {
+      o[i]        = (float)(sqrtw*srOptO[i]);
+      srOptHO[i] += we*srOptO[i];
+    }
+  }else{
+    double *o = SROptO_Store_real + sample*n;
+#pragma omp parallel for default(shared) private(i)
+#pragma loop noalias
+    for(i=0;i<n;i++) {
+      o[i]        = sqrtw*srOptO[i];
+      srOptHO[i] += we*srOptO[i];
+    }
+  }
+  return;
+}
+
+/* OO += O O^dagger for the samples stored in SROptO_Block (upper triangle) */
+void flushOO_Block() {
+  const int k=NStoreOBlockStored;
+  const double one=1.0;
+  char uplo='U', trans='N';
+  int n;
+
+  if(k==0) return;
+  if(AllComplexFlag==0){
+    n = SROptSize;
+    M_DSYRK(&uplo,&trans,&n,&k,&one,SROptO_Block_real,&n,&one,SROptOO_real,&n);
+  }else{
+    n = SROptCmpSize;
+    M_ZHERK(&uplo,&trans,&n,&k,&one,SROptO_Block,&n,&one,SROptOO,&n);
+  }
+  NStoreOBlockStored = 0;
+  return;
+}
+
 void calculateQQQQ_real(double *qqqq, const double *lslq, const double w, const int nLSHam) {
   const int n=nLSHam*nLSHam*nLSHam*nLSHam;
   int rq,rp,ri,rj;
@@ -37,8 +37,6 @@ void VMCMainCal_fsz(MPI_Comm comm) {
   int *eleIdx,*eleCfg,*eleNum,*eleProjCnt,*eleSpn; //fsz
   double complex e,ip;
   double w;
-  double sqrtw;
-  double complex we;
   double Sz;
 
   const int qpStart=0;
@@ -52,7 +50,7 @@ void VMCMainCal_fsz(MPI_Comm comm) {
   double         *srOptO_real = SROptO_real;
   int tmp_i;
 
-  int rank,size,int_i;
+  int rank,size;
   MPI_Comm_size(comm,&size);
   MPI_Comm_rank(comm,&rank);
 #ifdef __DEBUG_DETAILDETAIL
@@ -101,9 +99,8 @@ void VMCMainCal_fsz(MPI_Comm comm) {
 #ifdef _DEBUG_DETAIL
     printf("  Debug: sample=%d: LogProjVal \n",sample);
 #endif
-    //LogProjVal(eleProjCnt);
     /* calculate reweight */
-    w =1.0;
+    w = calculateReweight(sample,ip,eleProjCnt);
 #ifdef _DEBUG_DETAIL
     printf("  Debug: sample=%d: isfinite \n",sample);
 #endif
@@ -140,6 +137,7 @@ void VMCMainCal_fsz(MPI_Comm comm) {
       fprintf(stderr,"warning: VMCMainCal rank:%d sample:%d e=%e\n",rank,sample,creal(e)); //TBC
       continue;
     }
+    if(NVMCAutoCorr>0) SampleLocEnergy[sample] = creal(e);
 
     Wc    += w;
     Etot  += w * e;
@@ -177,38 +175,25 @@ void VMCMainCal_fsz(MPI_Comm comm) {
       //[e]
       
       StartTimer(43);
+      if(AllComplexFlag!=0) compactSROptO(SROptO);
       /* Calculate OO and HO */
       if(NSRCG==0 && NStoreO==0){
-        //calculateOO(SROptOO,SROptHO,SROptO,w,e,SROptSize);
-        if(AllComplexFlag==0){
+        //calculateOO(SROptOO,SROptHO,SROptO,w,e,SROptCmpSize);
+        if(NStoreOBlock>0){
+          if(AllComplexFlag==0){
+            calculateOO_Block_real(SROptOO_real,SROptHO_real,SROptO_real,w,creal(e),SROptSize);
+          }else{
+            calculateOO_Block(SROptOO,SROptHO,SROptO,w,e,SROptCmpSize);
+          }
+        }else if(AllComplexFlag==0){
           calculateOO_real(SROptOO_real,SROptHO_real,SROptO_real,w,creal(e),SROptSize);
         }else{
-          calculateOO(SROptOO,SROptHO,SROptO,w,e,SROptSize);
+          calculateOO(SROptOO,SROptHO,SROptO,w,e,SROptCmpSize);
         } 
+      }else if(AllComplexFlag==0){
+        storeO_real(SROptHO_real,SROptO_real,sample,w,creal(e),SROptSize);
       }else{
-        we    = w*e;
-        sqrtw = sqrt(w); 
-        /*#pragma omp parallel for default(shared) private(int_i)
-        for(int_i=0;int_i<SROptSize*2;int_i++){
-        // SROptO_Store for fortran
-          SROptO_Store[int_i+sample*(2*SROptSize)]  = sqrtw*SROptO[int_i];
-          SROptHO[int_i]                           += we*SROptO[int_i]; 
-        }*/
-        if(AllComplexFlag==0){
-          #pragma omp parallel for default(shared) private(int_i)
-          for(int_i=0;int_i<SROptSize;int_i++){
-            // SROptO_Store for fortran
-            SROptO_Store_real[int_i+sample*SROptSize]  = sqrtw*SROptO_real[int_i];
-            SROptHO_real[int_i]                       += creal(we)*SROptO_real[int_i]; 
-          }
-        }else{
-          #pragma omp parallel for default(shared) private(int_i)
-          for(int_i=0;int_i<SROptSize*2;int_i++){
-            // SROptO_Store for fortran
-            SROptO_Store[int_i+sample*(2*SROptSize)]  = sqrtw*SROptO[int_i];
-            SROptHO[int_i]                           += we*SROptO[int_i]; 
-          }
-        }
+        storeO(SROptHO,SROptO,sample,w,e,SROptCmpSize);
       } 
       StopTimer(43);
     } else if(NVMCCalMode==1) {
@@ -225,10 +210,15 @@ void VMCMainCal_fsz(MPI_Comm comm) {
 
 // calculate OO and HO at NVMCCalMode==0
   if(NVMCCalMode==0){
+    if(NStoreOBlock>0){
+      StartTimer(45);
+      flushOO_Block();
+      StopTimer(45);
+    }
     if(NStoreO!=0 || NSRCG!=0){
       sampleSize=sampleEnd-sampleStart;
       /*StartTimer(45);
-      calculateOO_Store(SROptOO,SROptHO,SROptO_Store,w,e,2*SROptSize,sampleSize);
+      calculateOO_Store(SROptOO,SROptHO,SROptO_Store,w,e,SROptCmpSize,sampleSize);
       StopTimer(45);*/
       if(AllComplexFlag==0){
         StartTimer(45);
@@ -236,7 +226,7 @@ void VMCMainCal_fsz(MPI_Comm comm) {
         StopTimer(45);
       }else{
         StartTimer(45);
-        calculateOO_Store(SROptOO,SROptHO,SROptO_Store,w,e,2*SROptSize,sampleSize);
+        calculateOO_Store(SROptOO,SROptHO,SROptO_Store,w,e,SROptCmpSize,sampleSize);
         StopTimer(45);
       }
     }
@@ -34,23 +34,29 @@ along with this program. If not, see http://www.gnu.org/licenses/.
 void OutputTime(int step) {
   time_t tx;
   double pHop,pEx,pLSF;
+  double rate;
 
   tx = time(NULL);
   if(step==0) {
-    fprintf(FileTime, "%05d  acc_hop acc_ex  acc_lsf n_hop    n_ex      n_lsf   : %s", step, ctime(&tx));
+    fprintf(FileTime, "%05d  acc_hop acc_ex  acc_lsf n_hop    n_ex      n_lsf     prop/sec   : %s", step, ctime(&tx));
   } else {
     pHop = (Counter[0] == 0) ? 0.0 : (double)Counter[1] / (double)Counter[0];
     pEx  = (Counter[2] == 0) ? 0.0 : (double)Counter[3] / (double)Counter[2];
     pLSF = (Counter[4] == 0) ? 0.0 : (double)Counter[5] / (double)Counter[4];
-    fprintf(FileTime, "%05d  %.5lf %.5lf %.5lf %-8d %-8d  %-8d: %s", step, pHop,pEx,pLSF,
-            Counter[0], Counter[2],Counter[4], ctime(&tx));
+    /* proposals per second of VMCMakeSample in this step */
+    rate = (Timer[3] > TimerPrevSample) ?
+      (double)(Counter[0]+Counter[2]+Counter[4]) / (Timer[3]-TimerPrevSample) : 0.0;
+    fprintf(FileTime, "%05d  %.5lf %.5lf %.5lf %-8d %-8d  %-8d %.3e : %s", step, pHop,pEx,pLSF,
+            Counter[0], Counter[2],Counter[4], rate, ctime(&tx));
   }
+  TimerPrevSample = Timer[3];
 }
 
 void InitTimer() {
   int i;
   for(i=0;i<NTimer;i++) Timer[i]=0.0;
   for(i=0;i<NTimer;i++) TimerStart[i]=0.0;
+  TimerPrevSample=0.0;
   return;
 }
 
@@ -109,6 +115,9 @@ void OutputTimerParaOpt() {
   fprintf(fp,"      UpdateMAllTwo       [603] %12.5lf\n",Timer[603]);
   fprintf(fp,"    recal PfM and InvM     [34] %12.5lf\n",Timer[34]);
   fprintf(fp,"    save electron config   [35] %12.5lf\n",Timer[35]);
+#ifdef _pf_block_update
+  fprintf(fp,"    tune block update size [37] %12.5lf\n",Timer[37]);
+#endif
   fprintf(fp,"  VMCMainCal                [4] %12.5lf\n",Timer[4]);
   fprintf(fp,"    CalculateMAll          [40] %12.5lf\n",Timer[40]);
   fprintf(fp,"    LocEnergyCal           [41] %12.5lf\n",Timer[41]);
@@ -133,6 +142,9 @@ void OutputTimerParaOpt() {
   fprintf(fp,"  cal                      [24] %12.5lf\n",Timer[24]);
   fprintf(fp,"  SR                       [25] %12.5lf\n",Timer[25]);
   fprintf(fp,"  MAll                     [69] %12.5lf\n",Timer[69]);
+#ifdef _pf_block_update
+  fprintf(fp,"NBlockUpdateSize               %12d\n",NBlockUpdateSize);
+#endif
 
   fclose(fp);
 }
@@ -170,6 +182,9 @@ void OutputTimerPhysCal() {
   fprintf(fp,"      UpdateMAllTwo       [603] %12.5lf\n",Timer[603]);
   fprintf(fp,"    recal PfM and InvM     [34] %12.5lf\n",Timer[34]);
   fprintf(fp,"    save electron config   [35] %12.5lf\n",Timer[35]);
+#ifdef _pf_block_update
+  fprintf(fp,"    tune block update size [37] %12.5lf\n",Timer[37]);
+#endif
   fprintf(fp,"  VMCMainCal                [4] %12.5lf\n",Timer[4]);
   fprintf(fp,"    CalculateMAll          [40] %12.5lf\n",Timer[40]);
   fprintf(fp,"    LocEnergyCal           [41] %12.5lf\n",Timer[41]);
@@ -186,6 +201,9 @@ void OutputTimerPhysCal() {
   fprintf(fp,"  UpdateSlaterElm          [20] %12.5lf\n",Timer[20]);
   fprintf(fp,"  WeightAverage            [21] %12.5lf\n",Timer[21]);
   fprintf(fp,"  outputData               [22] %12.5lf\n",Timer[22]);
+#ifdef _pf_block_update
+  fprintf(fp,"NBlockUpdateSize               %12d\n",NBlockUpdateSize);
+#endif
 
   fclose(fp);
 }
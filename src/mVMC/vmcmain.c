@@ -35,6 +35,7 @@ along with this program. If not, see http://www.gnu.org/licenses/.
 // #define _DEBUG_DUMP_PARA
 
 int VMCParaOpt(MPI_Comm comm_parent, MPI_Comm comm_child1, MPI_Comm comm_child2);
+int VMCParaOptUpdate(const int step, MPI_Comm comm_parent, MPI_Comm comm_child1, MPI_Comm comm_child2);
 int VMCPhysCal(MPI_Comm comm_parent, MPI_Comm comm_child1, MPI_Comm comm_child2);
 void outputData();
 void printUsageError();
@@ -225,6 +226,7 @@ int main(int argc, char* argv[])
   if(rank0==0) fprintf(stdout,"Start: Read parameters from *def files.\n");
   ReadDefFileIdxPara(fileDefList, comm0);
   if(rank0==0) fprintf(stdout,"End  : Read parameters from *def files.\n");
+  CheckGreenTransSym(comm0);
   StopTimer(11);
   
   StartTimer(12);
@@ -253,8 +255,12 @@ int main(int argc, char* argv[])
   StopTimer(10);
 #endif
 
+  InitTempering(comm2);
+  SetWaveFunctionWalkComm(comm2);
+
   /* initialize Mersenne Twister */
   init_gen_rand(RndSeed+group1);
+  InitWalkerRandom(RndSeed+group1);
   /* get the size of work space for LAPACK and PFAPACK */
   LapackLWork = getLWork_fcmp(); //TBC
 
@@ -280,6 +286,7 @@ int main(int argc, char* argv[])
   if(rank0==0) fprintf(stdout,"Start: Initialize variables for quantum projection.\n");
   InitQPWeight();
   if(rank0==0) fprintf(stdout,"End  : Initialize variables for quantum projection.\n");
+  InitGreenTransSym();
   /* initialize output files */
   if(rank0==0) InitFile(fileDefList, rank0);
 
@@ -332,10 +339,12 @@ int VMCParaOpt(MPI_Comm comm_parent, MPI_Comm comm_child1, MPI_Comm comm_child2)
   int step;
   int info;
   int rank;
-  int tmp_i;//DEBUG
   int iprogress;
+  int trial, accept;
   MPI_Comm_rank(comm_parent, &rank);
 
+  NSROptDataSmp = 0;
+
   for(step=0;step<NSROptItrStep;step++) {
     //printf("0 DUBUG make:step=%d TwoSz=%d\n",step,TwoSz);
     if(rank==0){
@@ -350,179 +359,242 @@ int VMCParaOpt(MPI_Comm comm_parent, MPI_Comm comm_child1, MPI_Comm comm_child2)
       }
     }
     
-    StartTimer(20);
-    //printf("1 DUBUG make:step=%d \n",step);
-    if(iFlgOrbitalGeneral==0){//sz is conserved
-      UpdateSlaterElm_fcmp();
-    }else{
-      UpdateSlaterElm_fsz();
-    } 
-    //printf("2 DUBUG make:step=%d \n",step);
-    UpdateQPWeight();
-    StopTimer(20);
-    StartTimer(3);
+    /* NSROptAdaptive=1: a Heun step consists of two SR updates (stages).
+       The second stage reuses the samples of the first one, and it is tried
+       again with the shortened first update until the step is accepted. */
+    if(NSROptAdaptive==1) SROptHeunStart();
+    info = VMCParaOptUpdate(step, comm_parent, comm_child1, comm_child2);
+    if(info!=0) return info;
+
+    accept = 1;
+    if(NSROptAdaptive==1) {
+      SROptHeunPredict();
+      FlagSROptReweight = 1;
+      for(trial=0;trial<D_SROptHeunMaxTrial;trial++) {
+        info = VMCParaOptUpdate(step, comm_parent, comm_child1, comm_child2);
+        if(info!=0) return info;
+
+        StartTimer(23);
+        accept = SROptHeunCorrect(step, comm_parent);
+        SyncModifiedParameter(comm_parent);
+        StopTimer(23);
+        if(accept==1) break;
+      }
+      FlagSROptReweight = 0;
+      SROptHeunEnd(accept);
+      if(accept==0) SyncModifiedParameter(comm_parent);
+    }
+
+    /* a rejected Heun step restores the parameters of the previous step */
+    if(step >= NSROptItrStep-NSROptItrSmp && accept==1) {
+      StoreOptData(NSROptDataSmp);
+      NSROptDataSmp++;
+    }
+
+    FlushFile(step,rank);
+  }
+
+  /* all the Heun steps in the sampling steps were rejected */
+  if(NSROptDataSmp==0) {
+    StoreOptData(NSROptDataSmp);
+    NSROptDataSmp++;
+  }
+
+  if(rank==0) OutputTime(NSROptItrStep);
+
+  /* output zqp_opt */
+  if(rank==0) {
+    fprintf(stdout, "Start: Output opt params.\n");
+    OutputOptData();
+    fprintf(stdout, "End: Output opt params.\n");
+  }
+
+  return 0;
+}
+
+/* one sampling and one SR update of the variational parameters.
+   With FlagSROptReweight=1 (the second stage of a Heun step), the samples of
+   the first stage are measured again with the current parameters instead. */
+int VMCParaOptUpdate(const int step, MPI_Comm comm_parent, MPI_Comm comm_child1, MPI_Comm comm_child2) {
+  int info;
+  int rank;
+  int tmp_i;//DEBUG
+  MPI_Comm_rank(comm_parent, &rank);
+
+  StartTimer(20);
+  //printf("1 DUBUG make:step=%d \n",step);
+  if(FlagRealSlaterElm==1){//real & sz is conserved
+    UpdateSlaterElm_real();
+  }else if(iFlgOrbitalGeneral==0){//sz is conserved
+    UpdateSlaterElm_fcmp();
+  }else{
+    UpdateSlaterElm_fsz();
+  } 
+  //printf("2 DUBUG make:step=%d \n",step);
+  UpdateQPWeight();
+  StopTimer(20);
+  if(NVMCCalFuse==1 && FlagSROptReweight==0) VMCMainCalFusedStart();
+  StartTimer(3);
 #ifdef _DEBUG_DETAIL
-    printf("Debug: step %d, MakeSample.\n", step);
+  printf("Debug: step %d, MakeSample.\n", step);
 #endif
-    //if(AllComplexFlag==0 && iFlgOrbitalGeneral==0){ // real & sz=0
-    if(AllComplexFlag==0){ // real
-      // only for real TBC
-      StartTimer(69);
+  //if(AllComplexFlag==0 && iFlgOrbitalGeneral==0){ // real & sz=0
+  if(FlagSROptReweight==1){ // the samples of the first stage are kept
+  }else if(FlagRealSlaterElm==1){ // real & sz=0: SlaterElm_real is built by UpdateSlaterElm_real
+    if(NVMCWalker>1) {
+      VMCMakeSampleWalker_real(comm_child1);
+    } else {
+      VMCMakeSample_real(comm_child1);
+    }
+  }else if(AllComplexFlag==0){ // real
+    // only for real TBC
+    StartTimer(69);
 #pragma omp parallel for default(shared) private(tmp_i)
-      for(tmp_i=0;tmp_i<NQPFull*(2*Nsite)*(2*Nsite);tmp_i++) SlaterElm_real[tmp_i]= creal(SlaterElm[tmp_i]);
+    for(tmp_i=0;tmp_i<NQPFull*Nsite2*NSlaterElmCol;tmp_i++) SlaterElm_real[tmp_i]= creal(SlaterElm[tmp_i]);
 #pragma omp parallel for default(shared) private(tmp_i)
-      for(tmp_i=0;tmp_i<NQPFull*(Nsize*Nsize+1);tmp_i++)     InvM_real[tmp_i]= creal(InvM[tmp_i]);
-      StopTimer(69);
-      if(iFlgOrbitalGeneral==0){ // Orbital
-        if(NProjBF ==0){
-          // SlaterElm_real will be used in CalculateMAll, note that SlaterElm will not change before SR
-          VMCMakeSample_real(comm_child1);
-        }else{
-          VMC_BF_MakeSample_real(comm_child1);
-        }
-      }else{//OrbitalPara, OrbitalGeneral
-        VMCMakeSample_fsz_real(comm_child1);
-      }
-      // only for real TBC
-      StartTimer(69);
+    for(tmp_i=0;tmp_i<NQPFull*(Nsize*Nsize+1);tmp_i++)     InvM_real[tmp_i]= creal(InvM[tmp_i]);
+    StopTimer(69);
+    if(iFlgOrbitalGeneral==0){ // BackFlow
+      // SlaterElm_real will be used in CalculateMAll, note that SlaterElm will not change before SR
+      VMC_BF_MakeSample_real(comm_child1);
+    }else{//OrbitalPara, OrbitalGeneral
+      VMCMakeSample_fsz_real(comm_child1);
+    }
+    // only for real TBC
+    StartTimer(69);
 #pragma omp parallel for default(shared) private(tmp_i)
-      for(tmp_i=0;tmp_i<NQPFull*(Nsize*Nsize+1);tmp_i++)     InvM[tmp_i]      = InvM_real[tmp_i]+0.0*I;
-      StopTimer(69);
-      // only for real TBC
-    }else{// complex
-      if(NProjBF ==0) {
-        if(iFlgOrbitalGeneral==0){// sz =0 & complex
-          VMCMakeSample(comm_child1);//VMCMakeSample(comm_child1);
-        }else{
-          VMCMakeSample_fsz(comm_child1);//VMCMakeSample(comm_child1);
-        } 
-      }
-      else {
-        VMC_BF_MakeSample(comm_child1);
-      }
-    } 
-    StopTimer(3);
-    StartTimer(4);
+    for(tmp_i=0;tmp_i<NQPFull*(Nsize*Nsize+1);tmp_i++)     InvM[tmp_i]      = InvM_real[tmp_i]+0.0*I;
+    StopTimer(69);
+    // only for real TBC
+  }else{// complex
+    if(NProjBF ==0) {
+      if(iFlgOrbitalGeneral==0){// sz =0 & complex
+        if(NVMCWalker>1) {
+          VMCMakeSampleWalker();
+        } else {
+          VMCMakeSample(comm_child1);
+        }
+      }else{
+        VMCMakeSample_fsz(comm_child1);//VMCMakeSample(comm_child1);
+      } 
+    }
+    else {
+      VMC_BF_MakeSample(comm_child1);
+    }
+  } 
+  StopTimer(3);
+  StartTimer(4);
 #ifdef _DEBUG_DETAIL
-    printf("Debug: step %d, MainCal.\n", step);
+  printf("Debug: step %d, MainCal.\n", step);
 #endif
-    if(NProjBF ==0) {
-      if(iFlgOrbitalGeneral==0){//sz is conserved
+  if(NProjBF ==0) {
+    if(iFlgOrbitalGeneral==0){//sz is conserved
+      if(NVMCCalFuse==1 && FlagSROptReweight==0) {
+        VMCMainCalFusedEnd();
+      } else {
         VMCMainCal(comm_child1);
-      }else{//fsz
-        VMCMainCal_fsz(comm_child1); 
       }
-    }else{
-      VMC_BF_MainCal(comm_child1);
+    }else{//fsz
+      VMCMainCal_fsz(comm_child1); 
     }
-    StopTimer(4);
-    StartTimer(21);
+  }else{
+    VMC_BF_MainCal(comm_child1);
+  }
+  StopTimer(4);
+  StartTimer(21);
 #ifdef _DEBUG_DETAIL
-    printf("Debug: step %d, AverageWE.\n", step);
+  printf("Debug: step %d, AverageWE.\n", step);
 #endif
-    WeightAverageWE(comm_parent);
-    StartTimer(25);//DEBUG
+  WeightAverageWE(comm_parent);
+  StartTimer(25);//DEBUG
 #ifdef _DEBUG_DETAIL
-    printf("Debug: step %d, SROpt.\n", step);
+  printf("Debug: step %d, SROpt.\n", step);
 #endif
-    //if(AllComplexFlag==0 && iFlgOrbitalGeneral==0){ //real & sz =0
-    if(AllComplexFlag==0){ //real 
-      WeightAverageSROpt_real(comm_parent);
-    }else{
-      WeightAverageSROpt(comm_parent);
-    }
-    StopTimer(25);
+  //if(AllComplexFlag==0 && iFlgOrbitalGeneral==0){ //real & sz =0
+  if(AllComplexFlag==0){ //real 
+    WeightAverageSROpt_real(comm_parent);
+  }else{
+    WeightAverageSROpt(comm_parent);
+  }
+  StopTimer(25);
+  if(FlagSROptReweight==0) {
     ReduceCounter(comm_child2);
-    StopTimer(21);
-    StartTimer(22);
-    /* output zvo_out and zvo_var */
-    if(rank==0) outputData();
-    StopTimer(22);
+    if(NVMCAutoCorr>0) CalculateAutoCorr(step, comm_parent, comm_child1);
+  }
+  StopTimer(21);
+  StartTimer(22);
+  /* output zvo_out and zvo_var once per step */
+  if(rank==0 && FlagSROptReweight==0) outputData();
+  StopTimer(22);
 
 #ifdef _DEBUG_DUMP_SROPTO_STORE
-    if(rank==0){
-      if(AllComplexFlag==0){ //real & sz=0
-      //if(AllComplexFlag==0 && iFlgOrbitalGeneral==0){ //real & sz=0
-        for(i=0;i<SROptSize*NVMCSample;i++){
-          fprintf(stderr, "DEBUG: SROptO_Store_real[%d]=%lf +I*%lf\n",i,creal(SROptO_Store_real[i]),cimag(SROptO_Store_real[i]));
-        } 
-      }else{
-        for(i=0;i<2*SROptSize*NVMCSample;i++){
-          fprintf(stderr, "DEBUG: SROptO_Store[%d]=%lf +I*%lf\n",i,creal(SROptO_Store[i]),cimag(SROptO_Store[i]));
-        } 
-      }
+  if(rank==0 && NStoreO!=2){
+    if(AllComplexFlag==0){ //real & sz=0
+    //if(AllComplexFlag==0 && iFlgOrbitalGeneral==0){ //real & sz=0
+      for(i=0;i<SROptSize*NVMCSample;i++){
+        fprintf(stderr, "DEBUG: SROptO_Store_real[%d]=%lf +I*%lf\n",i,creal(SROptO_Store_real[i]),cimag(SROptO_Store_real[i]));
+      } 
+    }else{
+      for(i=0;i<SROptCmpSize*NVMCSample;i++){
+        fprintf(stderr, "DEBUG: SROptO_Store[%d]=%lf +I*%lf\n",i,creal(SROptO_Store[i]),cimag(SROptO_Store[i]));
+      } 
     }
+  }
 #endif
 
 #ifdef _DEBUG_DUMP_SROPTOO
-    if(rank==0){
-      if(AllComplexFlag==0){ //real
-      //if(AllComplexFlag==0 && iFlgOrbitalGeneral==0){ //real & sz=0
-        for(i=0;i<(NSRCG==0 ? SROptSize*SROptSize: SROptSize*2);i++){
-          fprintf(stderr, "DEBUG: SROptOO_real[%d]=%lf +I*%lf\n",i,creal(SROptOO_real[i]),cimag(SROptOO_real[i]));
-        } 
-        for(i=0;i<SROptSize;i++){
-          fprintf(stderr, "DEBUG: SROptHO_real[%d]=%lf +I*%lf\n",i,creal(SROptHO_real[i]),cimag(SROptHO_real[i]));
-        } 
-        for(i=0;i<SROptSize;i++){
-          fprintf(stderr, "DEBUG: SROptO_real[%d]=%lf +I*%lf\n",i,creal(SROptO_real[i]),cimag(SROptO_real[i]));
-        } 
-      }else{
-        for(i=0;i<(NSRCG==0 ? 2*SROptSize*(2*SROptSize): 2*SROptSize*2);i++){
-          fprintf(stderr, "DEBUG: SROptOO[%d]=%lf +I*%lf\n",i,creal(SROptOO[i]),cimag(SROptOO[i]));
-        } 
-        for(i=0;i<2*SROptSize;i++){
-          fprintf(stderr, "DEBUG: SROptHO[%d]=%lf +I*%lf\n",i,creal(SROptHO[i]),cimag(SROptHO[i]));
-        } 
-        for(i=0;i<2*SROptSize;i++){
-          fprintf(stderr, "DEBUG: SROptO[%d]=%lf +I*%lf\n",i,creal(SROptO[i]),cimag(SROptO[i]));
-        } 
-      }
+  if(rank==0){
+    if(AllComplexFlag==0){ //real
+    //if(AllComplexFlag==0 && iFlgOrbitalGeneral==0){ //real & sz=0
+      for(i=0;i<(NSRCG==0 && FlagSROptDist==0 ? SROptSize*SROptSize: SROptSize*2);i++){
+        fprintf(stderr, "DEBUG: SROptOO_real[%d]=%lf +I*%lf\n",i,creal(SROptOO_real[i]),cimag(SROptOO_real[i]));
+      } 
+      for(i=0;i<SROptSize;i++){
+        fprintf(stderr, "DEBUG: SROptHO_real[%d]=%lf +I*%lf\n",i,creal(SROptHO_real[i]),cimag(SROptHO_real[i]));
+      } 
+      for(i=0;i<SROptSize;i++){
+        fprintf(stderr, "DEBUG: SROptO_real[%d]=%lf +I*%lf\n",i,creal(SROptO_real[i]),cimag(SROptO_real[i]));
+      } 
+    }else{
+      for(i=0;i<(NSRCG==0 && FlagSROptDist==0 ? SROptCmpSize*SROptCmpSize: SROptCmpSize*2);i++){
+        fprintf(stderr, "DEBUG: SROptOO[%d]=%lf +I*%lf\n",i,creal(SROptOO[i]),cimag(SROptOO[i]));
+      } 
+      for(i=0;i<SROptCmpSize;i++){
+        fprintf(stderr, "DEBUG: SROptHO[%d]=%lf +I*%lf\n",i,creal(SROptHO[i]),cimag(SROptHO[i]));
+      } 
+      for(i=0;i<2*SROptSize;i++){
+        fprintf(stderr, "DEBUG: SROptO[%d]=%lf +I*%lf\n",i,creal(SROptO[i]),cimag(SROptO[i]));
+      } 
     }
+  }
 #endif
 
-    StartTimer(5);
-    if(NSRCG!=0){
-      info = StochasticOptCG(comm_parent);
-    }else{
-      info = StochasticOpt(comm_parent);
-    }
-    //info = StochasticOptDiag(comm_parent);
-    StopTimer(5);
+  StartTimer(5);
+  if(NSRCG!=0){
+    info = StochasticOptCG(comm_parent);
+  }else{
+    info = StochasticOpt(comm_parent);
+  }
+  //info = StochasticOptDiag(comm_parent);
+  StopTimer(5);
 
 #ifdef _DEBUG_DUMP_PARA
-    for(int i=0; i<NPara; ++i){
-      fprintf(stderr, "DEBUG: Para[%d] = %lf %lf\n", i, creal(Para[i]), cimag(Para[i]));
-    }
+  for(int i=0; i<NPara; ++i){
+    fprintf(stderr, "DEBUG: Para[%d] = %lf %lf\n", i, creal(Para[i]), cimag(Para[i]));
+  }
 #endif
 
-    // DEBUG
-    // abort();
-
-    if(info!=0) {
-      if(rank==0) fprintf(stderr, "Error: StcOpt info=%d step=%d\n",info,step);
-      return info;
-    }
-
-    StartTimer(23);
-    SyncModifiedParameter(comm_parent);
-    StopTimer(23);
-
-    if(step >= NSROptItrStep-NSROptItrSmp) {
-      StoreOptData(step-(NSROptItrStep-NSROptItrSmp));
-    }
+  // DEBUG
+  // abort();
 
-    FlushFile(step,rank);
+  if(info!=0) {
+    if(rank==0) fprintf(stderr, "Error: StcOpt info=%d step=%d\n",info,step);
+    return info;
   }
 
-  if(rank==0) OutputTime(NSROptItrStep);
-
-  /* output zqp_opt */
-  if(rank==0) {
-    fprintf(stdout, "Start: Output opt params.\n");
-    OutputOptData();
-    fprintf(stdout, "End: Output opt params.\n");
-  }
+  StartTimer(23);
+  SyncModifiedParameter(comm_parent);
+  StopTimer(23);
 
   return 0;
 }
@@ -535,7 +607,9 @@ int VMCPhysCal(MPI_Comm comm_parent, MPI_Comm comm_child1, MPI_Comm comm_child2)
 
   if(rank==0) fprintf(stdout, "Start: UpdateSlaterElm.\n");
   StartTimer(20);
-  if(iFlgOrbitalGeneral==0){//sz is conserved
+  if(FlagRealSlaterElm==1){//real & sz is conserved
+    UpdateSlaterElm_real();
+  }else if(iFlgOrbitalGeneral==0){//sz is conserved
     UpdateSlaterElm_fcmp();
   }else{
     UpdateSlaterElm_fsz();
@@ -548,23 +622,26 @@ int VMCPhysCal(MPI_Comm comm_parent, MPI_Comm comm_child1, MPI_Comm comm_child2)
     if(rank==0) OutputTime(ismp);
     FlushFile(0,rank);
     InitFilePhysCal(ismp, rank);    
+    if(NVMCCalFuse==1) VMCMainCalFusedStart();
     StartTimer(3);
     if(NProjBF ==0) {
       //if(AllComplexFlag==0 && iFlgOrbitalGeneral==0){//real & sz=0
-      if(AllComplexFlag==0){//real
+      if(FlagRealSlaterElm==1){//real & sz=0: SlaterElm_real is built by UpdateSlaterElm_real
+        if(NVMCWalker>1) {
+          VMCMakeSampleWalker_real(comm_child1);
+        } else {
+          VMCMakeSample_real(comm_child1);
+        }
+      }else if(AllComplexFlag==0){//real & fsz
         // only for real TBC
         StartTimer(69);
 #pragma omp parallel for default(shared) private(tmp_i)
-        for(tmp_i=0;tmp_i<NQPFull*(2*Nsite)*(2*Nsite);tmp_i++) SlaterElm_real[tmp_i]= creal(SlaterElm[tmp_i]);
+        for(tmp_i=0;tmp_i<NQPFull*Nsite2*NSlaterElmCol;tmp_i++) SlaterElm_real[tmp_i]= creal(SlaterElm[tmp_i]);
 #pragma omp parallel for default(shared) private(tmp_i)
         for(tmp_i=0;tmp_i<NQPFull*(Nsize*Nsize+1);tmp_i++)     InvM_real[tmp_i]= creal(InvM[tmp_i]);
         StopTimer(69);
         // SlaterElm_real will be used in CalculateMAll, note that SlaterElm will not change before SR
-        if(iFlgOrbitalGeneral==0){
-          VMCMakeSample_real(comm_child1);
-        }else{
-          VMCMakeSample_fsz_real(comm_child1);
-        }
+        VMCMakeSample_fsz_real(comm_child1);
         // only for real TBC
         StartTimer(69);
 #pragma omp parallel for default(shared) private(tmp_i)
@@ -573,7 +650,11 @@ int VMCPhysCal(MPI_Comm comm_parent, MPI_Comm comm_child1, MPI_Comm comm_child2)
         // only for real TBC
       }else{
         if(iFlgOrbitalGeneral==0){
-          VMCMakeSample(comm_child1);
+          if(NVMCWalker>1) {
+            VMCMakeSampleWalker();
+          } else {
+            VMCMakeSample(comm_child1);
+          }
         }else{
           VMCMakeSample_fsz(comm_child1);
         }
@@ -582,7 +663,7 @@ int VMCPhysCal(MPI_Comm comm_parent, MPI_Comm comm_child1, MPI_Comm comm_child2)
       if(AllComplexFlag==0){
         // only for real TBC
         StartTimer(69);
-        for(tmp_i=0;tmp_i<NQPFull*(2*Nsite)*(2*Nsite);tmp_i++) SlaterElm_real[tmp_i]= creal(SlaterElm[tmp_i]);
+        for(tmp_i=0;tmp_i<NQPFull*Nsite2*NSlaterElmCol;tmp_i++) SlaterElm_real[tmp_i]= creal(SlaterElm[tmp_i]);
 #pragma omp parallel for default(shared) private(tmp_i)
         for(tmp_i=0;tmp_i<NQPFull*(Nsize*Nsize+1);tmp_i++)     InvM_real[tmp_i]= creal(InvM[tmp_i]);
         StopTimer(69);
@@ -606,7 +687,11 @@ int VMCPhysCal(MPI_Comm comm_parent, MPI_Comm comm_child1, MPI_Comm comm_child2)
     if(rank==0) fprintf(stdout, "Start: Main calculation.\n");
     if(NProjBF ==0) {
       if(iFlgOrbitalGeneral==0){
-        VMCMainCal(comm_child1);
+        if(NVMCCalFuse==1) {
+          VMCMainCalFusedEnd();
+        } else {
+          VMCMainCal(comm_child1);
+        }
       }else{
         VMCMainCal_fsz(comm_child1);
       }
@@ -620,6 +705,7 @@ int VMCPhysCal(MPI_Comm comm_parent, MPI_Comm comm_child1, MPI_Comm comm_child2)
     WeightAverageWE(comm_parent);
     WeightAverageGreenFunc(comm_parent);
     ReduceCounter(comm_child2);
+    if(NVMCAutoCorr>0) CalculateAutoCorr(ismp, comm_parent, comm_child1);
 
     StopTimer(21);
     StartTimer(22);
@@ -699,6 +785,18 @@ void outputData() {
       fprintf(FileCisAjsCktAltDC, "\n");
     }
 
+    /* zvo_momentum.dat */
+    if (NMomentum > 0) {
+      for (i = 0; i < NMomentum; i++) {
+        fprintf(FileMomentum, "%d % .18e % .18e % .18e % .18e % .18e % .18e % .18e % .18e\n", i,
+                creal(PhysMomentum[4*i]), cimag(PhysMomentum[4*i]),
+                creal(PhysMomentum[4*i+1]), cimag(PhysMomentum[4*i+1]),
+                creal(PhysMomentum[4*i+2]), cimag(PhysMomentum[4*i+2]),
+                creal(PhysMomentum[4*i+3]), cimag(PhysMomentum[4*i+3]));
+      }
+      fprintf(FileMomentum, "\n");
+    }
+
     if (NLanczosMode > 0) {
       if (AllComplexFlag == 0) { //real
         PhysCalLanczos_real(
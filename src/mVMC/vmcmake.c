@@ -27,6 +27,7 @@ along with this program. If not, see http://www.gnu.org/licenses/.
  *-------------------------------------------------------------*/
 #include "global.h"
 #include "vmcmake.h"
+#include "vmccal.h"
 #include "slater.h"
 #ifndef _SRC_VMCMAKE
 #define _SRC_VMCMAKE
@@ -35,6 +36,7 @@ along with this program. If not, see http://www.gnu.org/licenses/.
 #include "matrix.c"
 #include "splitloop.h"
 #include "qp.h"
+#include "vmcmake_tempering.h"
 
 #ifdef _pf_block_update
 // Block-update extension.
@@ -57,10 +59,17 @@ void VMCMakeSample(MPI_Comm comm) {
   int qpStart,qpEnd;
   int rejectFlag;
   int rank,size;
+#ifndef _pf_block_update
+  int nBatch;
+#endif
   MPI_Comm_size(comm,&size);
   MPI_Comm_rank(comm,&rank);
 
   SplitLoop(&qpStart,&qpEnd,NQPFull,rank,size);
+#ifndef _pf_block_update
+  /* proposals are batched only when the quantum projection is split */
+  nBatch = (size>1) ? NVMCBatch : 1;
+#endif
 
   StartTimer(30);
   if(BurnFlag==0) {
@@ -74,20 +83,11 @@ void VMCMakeSample(MPI_Comm comm) {
   // TODO: Compute from qpStart to qpEnd to support loop splitting.
   void *pfOrbital[NQPFull];
   void *pfUpdator[NQPFull];
-  // Read block size from input.
-  const char *optBlockSize = getenv("VMC_BLOCK_UPDATE_SIZE");
-  if (optBlockSize)
-    NBlockUpdateSize = atoi(optBlockSize);
-  // Fall back to default if input is invalid.
-  if (NBlockUpdateSize < 1 || NBlockUpdateSize > 100)
-    if (NExUpdatePath == 0)
-      NBlockUpdateSize = 4;
-    else
-      NBlockUpdateSize = 20;
 
   // Set one universal EleSpn.
   for (mi=0; mi<Ne;  mi++) EleSpn[mi] = 0;
   for (mi=Ne;mi<Ne*2;mi++) EleSpn[mi] = 1;
+  SetBlockUpdateSize_fcmp(TmpEleIdx, EleSpn, (NExUpdatePath == 0) ? 4 : 20, comm);
   // Initialize.
   updated_tdi_v_init_z(NQPFull, Nsite, Nsite2, Nsize,
                        SlaterElm, Nsite2*Nsite2,
@@ -133,6 +133,14 @@ void VMCMakeSample(MPI_Comm comm) {
   for(outStep=0;outStep<nOutStep;outStep++) {
     for(inStep=0;inStep<nInStep;inStep++) {
 
+#ifndef _pf_block_update
+      if(nBatch>1) {
+        inStep += makeBatchUpdate((nBatch<nInStep-inStep) ? nBatch : nInStep-inStep,
+                                  &logIpOld,&nAccept,qpStart,qpEnd,comm) - 1;
+        continue;
+      }
+#endif
+
       updateType = getUpdateType(NExUpdatePath);
 
       if(updateType==HOPPING) { /* hopping */
@@ -171,7 +179,7 @@ void VMCMakeSample(MPI_Comm comm) {
 
         /* Metroplis */
         x = LogProjRatio(projCntNew,TmpEleProjCnt);
-        w = exp(2.0*(x+creal(logIpNew-logIpOld)));
+        w = exp(2.0*TemperingBeta*(x+creal(logIpNew-logIpOld)));
         if( !isfinite(w) ) w = -1.0; /* should be rejected */
 
         if(w > genrand_real2()) { /* accept */
@@ -243,7 +251,7 @@ void VMCMakeSample(MPI_Comm comm) {
 
         /* Metroplis */
         x = LogProjRatio(projCntNew,TmpEleProjCnt);
-        w = exp(2.0*(x+creal(logIpNew-logIpOld))); //TBC
+        w = exp(2.0*TemperingBeta*(x+creal(logIpNew-logIpOld))); //TBC
         if( !isfinite(w) ) w = -1.0; /* should be rejected */
 
         if(w > genrand_real2()) { /* accept */
@@ -293,15 +301,29 @@ void VMCMakeSample(MPI_Comm comm) {
         nAccept=0;
       }
     } /* end of instep */
+    /* apply the delayed updates before InvM is used outside the sampler */
+    FlushDelayMAll_fcmp(qpStart,qpEnd);
+
+    /* exchange the configurations with the neighboring replica */
+    if(NVMCTempering>1) {
+      StartTimer(34);
+      ExchangeReplica_fcmp(outStep,&logIpOld,qpStart,qpEnd,comm);
+      StopTimer(34);
+    }
 
     StartTimer(35);
-    /* save Electron Configuration */
-    if(outStep >= nOutStep-NVMCSample) {
+    /* save Electron Configuration (only the replica with beta=1) */
+    if(outStep >= nOutStep-NVMCSample && TemperingRung==0) {
       sample = outStep-(nOutStep-NVMCSample);
       saveEleConfig(sample,logIpOld,TmpEleIdx,TmpEleCfg,TmpEleNum,TmpEleProjCnt);
     }
     StopTimer(35);
 
+    /* calculate physical quantities with the current InvM */
+    if(NVMCCalFuse==1 && outStep >= nOutStep-NVMCSample) {
+      VMCMainCalFused(outStep-(nOutStep-NVMCSample),comm);
+    }
+
   } /* end of outstep */
 
   copyToBurnSample(TmpEleIdx,TmpEleCfg,TmpEleNum,TmpEleProjCnt);
@@ -315,56 +337,320 @@ void VMCMakeSample(MPI_Comm comm) {
   return;
 }
 
+#ifdef _pf_block_update
+/* Set NBlockUpdateSize at the first call.
+   0: defaultSize. -1: the fastest size in trial sweeps. */
+void SetBlockUpdateSize_fcmp(int *eleIdx, int *eleSpn, const int defaultSize, MPI_Comm comm) {
+  if(NBlockUpdateSize==0) {
+    NBlockUpdateSize = defaultSize;
+  } else if(NBlockUpdateSize<0) {
+    StartTimer(37);
+    NBlockUpdateSize = tuneBlockUpdateSize_fcmp(eleIdx, eleSpn, comm);
+    StopTimer(37);
+  }
+  return;
+}
+
+void SetBlockUpdateSize_real(int *eleIdx, int *eleSpn, const int defaultSize, MPI_Comm comm) {
+  if(NBlockUpdateSize==0) {
+    NBlockUpdateSize = defaultSize;
+  } else if(NBlockUpdateSize<0) {
+    StartTimer(37);
+    NBlockUpdateSize = tuneBlockUpdateSize_real(eleIdx, eleSpn, comm);
+    StopTimer(37);
+  }
+  return;
+}
+
+/* xorshift generator for the trial sweeps, so that the tuning does not
+   consume random numbers of the sampling */
+static uint32_t tuneRand32(uint32_t *x) {
+  *x ^= *x << 13;
+  *x ^= *x >> 17;
+  *x ^= *x << 5;
+  return *x;
+}
+
+/* Time two trial sweeps of Nsite hoppings for the block sizes 1,2,4,...,64
+   and return the fastest one. Every size is timed with the same proposals.
+   The timings are summed over comm (the processes of a Markov chain) and
+   CommTempering (the chains), so that all the processes choose the same size.
+   The electron configuration is not changed. PfM and InvM are overwritten. */
+int tuneBlockUpdateSize_fcmp(int *eleIdx, int *eleSpn, MPI_Comm comm) {
+  const int nTrial = 2*Nsite;
+  int nSize=0,size,bestIdx,msi,rj,osj,step,i;
+  int sizeList[7];
+  double timeList[7];
+  double start,w;
+  uint32_t rnd;
+  int trialEleIdx[Nsize];
+  int occ[Nsite2];
+  double complex pfMNew[NQPFull];
+  void *pfOrbital[NQPFull];
+  void *pfUpdator[NQPFull];
+
+  for(size=1;size<=64 && size<=Nsize;size*=2) sizeList[nSize++] = size;
+
+  for(i=0;i<nSize;i++) {
+    for(osj=0;osj<Nsite2;osj++) occ[osj] = 0;
+    for(msi=0;msi<Nsize;msi++) {
+      trialEleIdx[msi] = eleIdx[msi];
+      occ[eleIdx[msi]+eleSpn[msi]*Nsite] = 1;
+    }
+    rnd = 2463534242u;
+
+    start = MPI_Wtime();
+    updated_tdi_v_init_z(NQPFull, Nsite, Nsite2, Nsize,
+                         SlaterElm, Nsite2*Nsite2,
+                         InvM, Nsize*Nsize,
+                         trialEleIdx, eleSpn,
+                         sizeList[i],
+                         pfUpdator, pfOrbital);
+    updated_tdi_v_get_pfa_z(NQPFull, PfM, pfUpdator);
+
+    for(step=0;step<nTrial;step++) {
+      msi = tuneRand32(&rnd)%Nsize;
+      rj = tuneRand32(&rnd)%Nsite;
+      osj = rj+eleSpn[msi]*Nsite;
+      if(occ[osj]) continue;
+
+      updated_tdi_v_push_z(NQPFull, osj, msi, 1, pfUpdator);
+      updated_tdi_v_get_pfa_z(NQPFull, pfMNew, pfUpdator);
+      w = cabs(pfMNew[0]/PfM[0]);
+      w = w*w;
+      if(isfinite(w) && w > tuneRand32(&rnd)*(1.0/4294967296.0)) { /* accept */
+        updated_tdi_v_get_pfa_z(NQPFull, PfM, pfUpdator);
+        occ[trialEleIdx[msi]+eleSpn[msi]*Nsite] = 0;
+        occ[osj] = 1;
+        trialEleIdx[msi] = rj;
+      } else { /* reject */
+        updated_tdi_v_pop_z(NQPFull, 0, pfUpdator);
+      }
+    }
+
+    updated_tdi_v_free_z(NQPFull, pfUpdator, pfOrbital);
+    timeList[i] = MPI_Wtime() - start;
+  }
+
+  /* all processes choose the same size */
+  MPI_Allreduce(MPI_IN_PLACE, timeList, nSize, MPI_DOUBLE, MPI_SUM, comm);
+  MPI_Allreduce(MPI_IN_PLACE, timeList, nSize, MPI_DOUBLE, MPI_SUM, CommTempering);
+  bestIdx = 0;
+  for(i=1;i<nSize;i++) {
+    if(timeList[i] < timeList[bestIdx]) bestIdx = i;
+  }
+  return sizeList[bestIdx];
+}
+
+int tuneBlockUpdateSize_real(int *eleIdx, int *eleSpn, MPI_Comm comm) {
+  const int nTrial = 2*Nsite;
+  int nSize=0,size,bestIdx,msi,rj,osj,step,i;
+  int sizeList[7];
+  double timeList[7];
+  double start,w;
+  uint32_t rnd;
+  int trialEleIdx[Nsize];
+  int occ[Nsite2];
+  double pfMNew[NQPFull];
+  void *pfOrbital[NQPFull];
+  void *pfUpdator[NQPFull];
+
+  for(size=1;size<=64 && size<=Nsize;size*=2) sizeList[nSize++] = size;
+
+  for(i=0;i<nSize;i++) {
+    for(osj=0;osj<Nsite2;osj++) occ[osj] = 0;
+    for(msi=0;msi<Nsize;msi++) {
+      trialEleIdx[msi] = eleIdx[msi];
+      occ[eleIdx[msi]+eleSpn[msi]*Nsite] = 1;
+    }
+    rnd = 2463534242u;
+
+    start = MPI_Wtime();
+    updated_tdi_v_init_d(NQPFull, Nsite, Nsite2, Nsize,
+                         SlaterElm_real, Nsite2*Nsite2,
+                         InvM_real, Nsize*Nsize,
+                         trialEleIdx, eleSpn,
+                         sizeList[i],
+                         pfUpdator, pfOrbital);
+    updated_tdi_v_get_pfa_d(NQPFull, PfM_real, pfUpdator);
+
+    for(step=0;step<nTrial;step++) {
+      msi = tuneRand32(&rnd)%Nsize;
+      rj = tuneRand32(&rnd)%Nsite;
+      osj = rj+eleSpn[msi]*Nsite;
+      if(occ[osj]) continue;
+
+      updated_tdi_v_push_d(NQPFull, osj, msi, 1, pfUpdator);
+      updated_tdi_v_get_pfa_d(NQPFull, pfMNew, pfUpdator);
+      w = pfMNew[0]/PfM_real[0];
+      w = w*w;
+      if(isfinite(w) && w > tuneRand32(&rnd)*(1.0/4294967296.0)) { /* accept */
+        updated_tdi_v_get_pfa_d(NQPFull, PfM_real, pfUpdator);
+        occ[trialEleIdx[msi]+eleSpn[msi]*Nsite] = 0;
+        occ[osj] = 1;
+        trialEleIdx[msi] = rj;
+      } else { /* reject */
+        updated_tdi_v_pop_d(NQPFull, 0, pfUpdator);
+      }
+    }
+
+    updated_tdi_v_free_d(NQPFull, pfUpdator, pfOrbital);
+    timeList[i] = MPI_Wtime() - start;
+  }
+
+  /* all processes choose the same size */
+  MPI_Allreduce(MPI_IN_PLACE, timeList, nSize, MPI_DOUBLE, MPI_SUM, comm);
+  MPI_Allreduce(MPI_IN_PLACE, timeList, nSize, MPI_DOUBLE, MPI_SUM, CommTempering);
+  bestIdx = 0;
+  for(i=1;i<nSize;i++) {
+    if(timeList[i] < timeList[bestIdx]) bestIdx = i;
+  }
+  return sizeList[bestIdx];
+}
+#endif
+
+/* Propose nBatch moves from the current configuration and reduce
+   the partial inner products of all of them by one MPI_Allreduce.
+   The proposals are judged in order. Since rejected moves do not change
+   the configuration, the chain follows the same transition probability
+   as the sequential Metropolis update. It is not the identical chain,
+   because all proposals of a batch are drawn before the acceptance tests
+   and the random numbers are consumed in a different order.
+   The proposals after the first accepted one are discarded.
+   Returns the number of consumed Monte Carlo steps. */
+int makeBatchUpdate(const int nBatch, double complex *logIpOld, int *nAccept,
+                    const int qpStart, const int qpEnd, MPI_Comm comm) {
+  const int qpNum = qpEnd-qpStart;
+  int *updateType,*mi,*mj,*ri,*rj,*s,*rejectFlag,*projCntNew;
+  double *rnd;
+  double complex *ip,*ipRdc;
+  double complex pfMNew[NQPFull];
+  double complex logIpNew;
+  double x,w;
+  int batch,qpidx,i,t,nStep=nBatch;
+  int *projCnt;
+
+  /* projCntNew grows as nBatch*NProj and does not fit on the stack */
+  RequestWorkSpaceInt(nBatch*(7+NProj));
+  RequestWorkSpaceDouble(nBatch);
+  RequestWorkSpaceComplex(2*nBatch);
+  updateType = GetWorkSpaceInt(nBatch);
+  mi = GetWorkSpaceInt(nBatch);
+  mj = GetWorkSpaceInt(nBatch);
+  ri = GetWorkSpaceInt(nBatch);
+  rj = GetWorkSpaceInt(nBatch);
+  s  = GetWorkSpaceInt(nBatch);
+  rejectFlag = GetWorkSpaceInt(nBatch);
+  projCntNew = GetWorkSpaceInt(nBatch*NProj);
+  rnd = GetWorkSpaceDouble(nBatch);
+  ip    = GetWorkSpaceComplex(nBatch);
+  ipRdc = GetWorkSpaceComplex(nBatch);
+
+  StartTimer(31);
+  for(batch=0;batch<nBatch;batch++) {
+    updateType[batch] = getUpdateType(NExUpdatePath);
+    rejectFlag[batch] = 1;
+    ip[batch] = 0.0;
+    projCnt = projCntNew + batch*NProj;
+
+    if(updateType[batch]==HOPPING) {
+      makeCandidate_hopping(mi+batch, ri+batch, rj+batch, s+batch, rejectFlag+batch,
+                            TmpEleIdx, TmpEleCfg);
+      if(rejectFlag[batch]) continue;
+
+      updateEleConfig(mi[batch],ri[batch],rj[batch],s[batch],TmpEleIdx,TmpEleCfg,TmpEleNum);
+      UpdateProjCnt(ri[batch],rj[batch],s[batch],projCnt,TmpEleProjCnt,TmpEleNum);
+      CalculateNewPfM2(mi[batch],s[batch],pfMNew,TmpEleIdx,qpStart,qpEnd);
+      revertEleConfig(mi[batch],ri[batch],rj[batch],s[batch],TmpEleIdx,TmpEleCfg,TmpEleNum);
+
+    } else if(updateType[batch]==EXCHANGE) {
+      makeCandidate_exchange(mi+batch, ri+batch, rj+batch, s+batch, rejectFlag+batch,
+                             TmpEleIdx, TmpEleCfg, TmpEleNum);
+      if(rejectFlag[batch]) continue;
+
+      t = 1-s[batch];
+      mj[batch] = TmpEleCfg[rj[batch]+t*Nsite];
+      updateEleConfig(mi[batch],ri[batch],rj[batch],s[batch],TmpEleIdx,TmpEleCfg,TmpEleNum);
+      UpdateProjCnt(ri[batch],rj[batch],s[batch],projCnt,TmpEleProjCnt,TmpEleNum);
+      updateEleConfig(mj[batch],rj[batch],ri[batch],t,TmpEleIdx,TmpEleCfg,TmpEleNum);
+      UpdateProjCnt(rj[batch],ri[batch],t,projCnt,projCnt,TmpEleNum);
+      CalculateNewPfMTwo2_fcmp(mi[batch],s[batch],mj[batch],t,pfMNew,TmpEleIdx,qpStart,qpEnd);
+      revertEleConfig(mj[batch],rj[batch],ri[batch],t,TmpEleIdx,TmpEleCfg,TmpEleNum);
+      revertEleConfig(mi[batch],ri[batch],rj[batch],s[batch],TmpEleIdx,TmpEleCfg,TmpEleNum);
+
+    } else {
+      continue;
+    }
+
+    for(qpidx=0;qpidx<qpNum;qpidx++) {
+      ip[batch] += QPFullWeight[qpidx+qpStart] * pfMNew[qpidx];
+    }
+    rnd[batch] = genrand_real2();
+  }
+  StopTimer(31);
+
+  StartTimer(62);
+  MPI_Allreduce(ip, ipRdc, nBatch, MPI_DOUBLE_COMPLEX, MPI_SUM, comm);
+  StopTimer(62);
+
+  for(batch=0;batch<nBatch;batch++) {
+    if(updateType[batch]==HOPPING) Counter[0]++;
+    else if(updateType[batch]==EXCHANGE) Counter[2]++;
+    if(rejectFlag[batch]) continue;
+
+    /* Metroplis */
+    projCnt = projCntNew + batch*NProj;
+    logIpNew = clog(ipRdc[batch]);
+    x = LogProjRatio(projCnt,TmpEleProjCnt);
+    w = exp(2.0*(x+creal(logIpNew-*logIpOld)));
+    if( !isfinite(w) ) w = -1.0; /* should be rejected */
+    if(w <= rnd[batch]) continue; /* reject */
+
+    /* accept */
+    StartTimer(63);
+    updateEleConfig(mi[batch],ri[batch],rj[batch],s[batch],TmpEleIdx,TmpEleCfg,TmpEleNum);
+    if(updateType[batch]==HOPPING) {
+      UpdateMAll(mi[batch],s[batch],TmpEleIdx,qpStart,qpEnd);
+      Counter[1]++;
+    } else {
+      t = 1-s[batch];
+      updateEleConfig(mj[batch],rj[batch],ri[batch],t,TmpEleIdx,TmpEleCfg,TmpEleNum);
+      UpdateMAllTwo_fcmp(mi[batch],s[batch],mj[batch],t,ri[batch],rj[batch],TmpEleIdx,qpStart,qpEnd);
+      Counter[3]++;
+    }
+    StopTimer(63);
+
+    for(i=0;i<NProj;i++) TmpEleProjCnt[i] = projCnt[i];
+    *logIpOld = logIpNew;
+    (*nAccept)++;
+
+    if(*nAccept>Nsite) {
+      // Recalculate PfM and InvM.
+      StartTimer(34);
+      CalculateMAll_fcmp(TmpEleIdx,qpStart,qpEnd);
+      *logIpOld = CalculateLogIP_fcmp(PfM,qpStart,qpEnd,comm);
+      StopTimer(34);
+      *nAccept=0;
+    }
+    nStep = batch+1;
+    break;
+  }
+
+  ReleaseWorkSpaceInt();
+  ReleaseWorkSpaceDouble();
+  ReleaseWorkSpaceComplex();
+  return nStep;
+}
+
 int makeInitialSample(int *eleIdx, int *eleCfg, int *eleNum, int *eleProjCnt,
                       const int qpStart, const int qpEnd, MPI_Comm comm) {
-  const int nsize = Nsize;
-  const int nsite2 = Nsite2;
   int flag=1,flagRdc,loop=0;
-  int ri,mi,si,msi,rsi;
   int rank,size;
   MPI_Comm_size(comm,&size);
   MPI_Comm_rank(comm,&rank);
   
   do {
-    /* initialize */
-    #pragma omp parallel for default(shared) private(msi)
-    for(msi=0;msi<nsize;msi++) eleIdx[msi] = -1;
-    #pragma omp parallel for default(shared) private(rsi)
-    for(rsi=0;rsi<nsite2;rsi++) eleCfg[rsi] = -1;
-    
-    /* local spin */
-    for(ri=0;ri<Nsite;ri++) {
-      if(LocSpn[ri]==1) {
-        do {
-          mi = gen_rand32()%Ne;
-          si = (genrand_real2()<0.5) ? 0 : 1;
-        } while(eleIdx[mi+si*Ne]!=-1);
-        eleCfg[ri+si*Nsite] = mi;
-        eleIdx[mi+si*Ne] = ri;
-      }
-    }
-    
-    /* itinerant electron */
-    for(si=0;si<2;si++) {
-      for(mi=0;mi<Ne;mi++) {
-        if(eleIdx[mi+si*Ne]== -1) {
-          do {
-            ri = gen_rand32()%Nsite;
-          } while (eleCfg[ri+si*Nsite]!= -1 || LocSpn[ri]==1);
-          eleCfg[ri+si*Nsite] = mi;
-          eleIdx[mi+si*Ne] = ri;
-        }
-      }
-    }
-    
-    /* EleNum */
-    #pragma omp parallel for default(shared) private(rsi)
-    #pragma loop noalias
-    for(rsi=0;rsi<nsite2;rsi++) {
-      eleNum[rsi] = (eleCfg[rsi] < 0) ? 0 : 1;
-    }
-    
-    MakeProjCnt(eleProjCnt,eleNum);
+    makeRandomEleConfig(eleIdx,eleCfg,eleNum,eleProjCnt);
 
     flag = CalculateMAll_fcmp(eleIdx,qpStart,qpEnd);
     //printf("DEBUG: maker4: PfM=%lf\n",creal(PfM[0]));
@@ -383,6 +669,53 @@ int makeInitialSample(int *eleIdx, int *eleCfg, int *eleNum, int *eleProjCnt,
   return 0;
 }
 
+/* Generate a random electron configuration and its projection counts.
+   The loops are not parallelized, since this is also called by each
+   walker inside the parallel region of VMCMakeSampleWalker. */
+void makeRandomEleConfig(int *eleIdx, int *eleCfg, int *eleNum, int *eleProjCnt) {
+  const int nsize = Nsize;
+  const int nsite2 = Nsite2;
+  int ri,mi,si,msi,rsi;
+
+  /* initialize */
+  for(msi=0;msi<nsize;msi++) eleIdx[msi] = -1;
+  for(rsi=0;rsi<nsite2;rsi++) eleCfg[rsi] = -1;
+  
+  /* local spin */
+  for(ri=0;ri<Nsite;ri++) {
+    if(LocSpn[ri]==1) {
+      do {
+        mi = gen_rand32()%Ne;
+        si = (genrand_real2()<0.5) ? 0 : 1;
+      } while(eleIdx[mi+si*Ne]!=-1);
+      eleCfg[ri+si*Nsite] = mi;
+      eleIdx[mi+si*Ne] = ri;
+    }
+  }
+  
+  /* itinerant electron */
+  for(si=0;si<2;si++) {
+    for(mi=0;mi<Ne;mi++) {
+      if(eleIdx[mi+si*Ne]== -1) {
+        do {
+          ri = gen_rand32()%Nsite;
+        } while (eleCfg[ri+si*Nsite]!= -1 || LocSpn[ri]==1);
+        eleCfg[ri+si*Nsite] = mi;
+        eleIdx[mi+si*Ne] = ri;
+      }
+    }
+  }
+  
+  /* EleNum */
+  #pragma loop noalias
+  for(rsi=0;rsi<nsite2;rsi++) {
+    eleNum[rsi] = (eleCfg[rsi] < 0) ? 0 : 1;
+  }
+  
+  MakeProjCnt(eleProjCnt,eleNum);
+  return;
+}
+
 void copyFromBurnSample(int *eleIdx, int *eleCfg, int *eleNum, int *eleProjCnt) {
   int i,n;
   const int *burnEleIdx = BurnEleIdx;
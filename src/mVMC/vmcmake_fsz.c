@@ -83,17 +83,8 @@ void VMCMakeSample_fsz(MPI_Comm comm) {
   // TODO: Compute from qpStart to qpEnd to support loop splitting.
   void *pfOrbital[NQPFull];
   void *pfUpdator[NQPFull];
-  // Read block size from input.
-  const char *optBlockSize = getenv("VMC_BLOCK_UPDATE_SIZE");
-  if (optBlockSize)
-    NBlockUpdateSize = atoi(optBlockSize);
-  // Fall back to default if input is invalid.
-  if (NBlockUpdateSize < 1 || NBlockUpdateSize > 100)
-    if (NExUpdatePath == 0)
-      NBlockUpdateSize = 4;
-    else
-      NBlockUpdateSize = 20;
 
+  SetBlockUpdateSize_fcmp(TmpEleIdx, TmpEleSpn, (NExUpdatePath == 0) ? 4 : 20, comm);
   // Initialize with free spin configuration.
   updated_tdi_v_init_z(NQPFull, Nsite, Nsite2, Nsize,
                        SlaterElm, Nsite2*Nsite2,
@@ -399,6 +390,8 @@ void VMCMakeSample_fsz(MPI_Comm comm) {
         nAccept=0;
       }
     } /* end of instep */
+    /* apply the delayed updates before InvM is used outside the sampler */
+    FlushDelayMAll_fcmp(qpStart,qpEnd);
 
     StartTimer(35);
     /* save Electron Configuration */
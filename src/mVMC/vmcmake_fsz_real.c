@@ -79,12 +79,8 @@ void VMCMakeSample_fsz_real(MPI_Comm comm) {
   // TODO: Compute from qpStart to qpEnd to support loop splitting.
   void *pfOrbital[NQPFull];
   void *pfUpdator[NQPFull];
-  // TODO: Make it input parameter.
-  if (NExUpdatePath == 0)
-    NBlockUpdateSize = 4;
-  else
-    NBlockUpdateSize = 20;
 
+  SetBlockUpdateSize_real(TmpEleIdx, TmpEleSpn, (NExUpdatePath == 0) ? 4 : 20, comm);
   // Initialize with free spin configuration.
   updated_tdi_v_init_d(NQPFull, Nsite, Nsite2, Nsize,
                        SlaterElm_real, Nsite2*Nsite2,
@@ -385,6 +381,8 @@ void VMCMakeSample_fsz_real(MPI_Comm comm) {
         nAccept=0;
       }
     } /* end of instep */
+    /* apply the delayed updates before InvM is used outside the sampler */
+    FlushDelayMAll_real(qpStart,qpEnd);
 
     StartTimer(35);
     /* save Electron Configuration */
@@ -36,11 +36,15 @@ which follows "The BSD 3-Clause License".
 #include "qp_real.h"
 #include "splitloop.h"
 #include "vmcmake.h"
+#include "vmcmake_tempering.h"
 #include "extract_wavefunction.h"
 
 #include <stdbool.h>
+#include <stdint.h>
+#include <inttypes.h>
 #include <string.h>
 #include <stdlib.h>
+#include <sys/types.h>
 
 #ifdef _pf_block_update
 // Block-update extension.
@@ -48,63 +52,31 @@ which follows "The BSD 3-Clause License".
 #endif
 
 
-int makeInitialSample_spin_left_ones(int *eleIdx, int *eleCfg, int *eleNum, int *eleProjCnt,
-                                     const int qpStart, const int qpEnd, MPI_Comm comm) {
-
-  const int nsize = Nsize;
-  const int nsite2 = Nsite2;
-  int flag = 1, flagRdc, loop = 0;
-  int ri, mi, si, msi, rsi;
-  int rank, size;
-  MPI_Comm_size(comm, &size);
-  MPI_Comm_rank(comm, &rank);
+/* Check that the configurations of the exhaustive enumeration are spin configurations */
+void checkSpinSystem(MPI_Comm comm) {
+  int ri;
 
   if (Ne * 2 != Nsite) {
-    fprintf(stderr, "error: makeInitialSample_spin_left_ones only works if every site contains exactly one electron, so Ne * 2 == Nsite\n");
+    fprintf(stderr, "error: the wave function walk only works if every site contains exactly one electron, so Ne * 2 == Nsite\n");
     fprintf(stderr, "we have: Ne=%d, Nsite=%d\n", Ne, Nsite);
-    MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    MPI_Abort(comm, EXIT_FAILURE);
   }
 
   for (ri = 0; ri < Nsite; ++ri) {
     if (LocSpn[ri] != 1) {
-      fprintf(stderr, "error: makeInitialSample_spin_left_ones only works if every site has local spins, so LocSpn[ri] == 1\n");
+      fprintf(stderr, "error: the wave function walk only works if every site has local spins, so LocSpn[ri] == 1\n");
       fprintf(stderr, "we have: LocSpn[%d] = %d\n", ri, LocSpn[ri]);
-      MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+      MPI_Abort(comm, EXIT_FAILURE);
     }
   }
-
-//#pragma omp parallel for default(shared) private(rsi)
-  for (int ei = 0; ei < Ne; ++ei) {
-    eleCfg[ei] = ei;
-    eleCfg[ei + Ne] = -1;
-    eleCfg[ei + Nsite + Ne] = ei;
-    eleCfg[ei + Nsite] = -1;
-
-    eleIdx[ei] = ei;
-    eleIdx[ei + Ne] = ei + Ne;
-
-    eleNum[ei] = 1;
-    eleNum[ei + Ne] = 0;
-    eleNum[ei + Nsite + Ne] = 1;
-    eleNum[ei + Nsite] = 0;
-  }
-  MakeProjCnt(eleProjCnt,eleNum);
-
-  return 0;
 }
 
 // #define _DEBUG
 
 // BASED ON: https://stackoverflow.com/a/1504565/3025981
 int GetPermutationSign(const int permutation[], const int length, MPI_Comm comm) {
-    bool elements_seen[64];
-    if (length > 64) {
-      fprintf(stderr, "GetPermutationSign: too many electrons: %d; "
-                      "at most 64 electrons are supported at the moment\n",
-                      length);
-      MPI_Abort(comm, EXIT_FAILURE);
-    }
-    memset(elements_seen, false, sizeof(elements_seen) / sizeof(bool));
+    bool elements_seen[length];
+    memset(elements_seen, false, sizeof(elements_seen));
 
     int cycles = 0;
     for (int index = 0; index < length; ++index) {
@@ -138,16 +110,10 @@ void RecordComputedWaveFunction(int const eleIdx[], int const eleCfg[], int cons
   FILE* globalOutputFile = WaveFunctionOutputFile();
   if (globalOutputFile == NULL) { return; }
 
-  // We're going to store the spin configuration in a uint64_t,
-  // so check that the 64 bits is enough
-  if (Nsite > 64) {
-    fprintf(stderr, "RecordComputedWaveFunction: Lattice too big: %d; "
-                    "at most 64 sites are supported at the moment\n",
-                    Nsite);
-    MPI_Abort(comm, EXIT_FAILURE);
-  }
-
-  uint64_t spin_conf = 0;
+  // The spin configuration is stored in 64-bit words
+  const int nWord = (Nsite + 63) / 64;
+  uint64_t spin_conf[nWord];
+  memset(spin_conf, 0, sizeof(spin_conf));
 
   // # ifdef _DEBUG
   // fprintf(globalOutputFile, "\t[");
@@ -183,7 +149,7 @@ void RecordComputedWaveFunction(int const eleIdx[], int const eleCfg[], int cons
 
   for (int position = 0; position < Nsite; ++position) {
     if (eleCfg[position] != -1 || eleCfg[position + Nsite] != -1) {
-      spin_conf |= ((uint64_t)(eleCfg[position] == -1)) << position;
+      spin_conf[position / 64] |= ((uint64_t)(eleCfg[position] == -1)) << (position % 64);
     }
     else {
       fprintf(stderr, "RecordComputedWaveFunction: incorrect spin configuration?\n");
@@ -191,89 +157,257 @@ void RecordComputedWaveFunction(int const eleIdx[], int const eleCfg[], int cons
     }
   }
 
-  fprintf(globalOutputFile, "%zu\t%f\n", spin_conf, ip * GetPermutationSign(eleIdx, 2 * Ne, comm));
+  for (int word = nWord - 1; word >= 0; --word) {
+    fprintf(globalOutputFile, (word > 0) ? "%" PRIu64 ":" : "%" PRIu64, spin_conf[word]);
+  }
+  fprintf(globalOutputFile, "\t%f\n", ip * GetPermutationSign(eleIdx, 2 * Ne, comm));
 }
 
-void swap_spins(int ri, int rj, int *eleIdx, int *eleCfg, int *eleNum, int *eleProjCnt,
-                int qpStart, int qpEnd, MPI_Comm comm) {
-  int s = eleCfg[ri] != -1 ? 0 : 1;
-  int t = 1 - s;
-  int mi = eleCfg[ri + s * Nsite];
-  int mj = eleCfg[rj + t * Nsite];
-  double pfMNew_real[NQPFull];
-  int projCntNew[NProj];
-  
-  // # ifdef _DEBUG
-  // fprintf(stderr, "swap_spins: ri = %d, rj = %d, s = %d, t = %d, mi = %d, mj = %d\n", ri, rj, s, t, mi, mj);
-  // # endif
+#define D_WalkBlock 4096 /* the number of configurations enumerated from one unranked configuration */
 
-  updateEleConfig(mi, ri, rj, s, eleIdx, eleCfg, eleNum);
-  UpdateProjCnt(ri, rj, s, projCntNew, eleProjCnt, eleNum);
-  /* The mj-th electron with spin t hops to ri */
-  updateEleConfig(mj, rj, ri, t, eleIdx, eleCfg, eleNum);
-  UpdateProjCnt(rj, ri, t, projCntNew, projCntNew, eleNum);
+/* binom[n*(Ne+1)+k] = binomial(n,k) for n <= Nsite, k <= Ne, saturated at UINT64_MAX */
+void makeBinomialTable(uint64_t *binom) {
+  int n, k;
+  uint64_t a, b;
+
+  for (n = 0; n <= Nsite; ++n) {
+    binom[n * (Ne + 1)] = 1;
+    for (k = 1; k <= Ne; ++k) {
+      if (n == 0) { binom[k] = 0; continue; }
+      a = binom[(n - 1) * (Ne + 1) + k - 1];
+      b = binom[(n - 1) * (Ne + 1) + k];
+      binom[n * (Ne + 1) + k] = (a > UINT64_MAX - b) ? UINT64_MAX : a + b;
+    }
+  }
+}
 
-  CalculateNewPfMTwo2_real(mi, s, mj, t, pfMNew_real, eleIdx, qpStart, qpEnd);
-  
-  CalculateLogIP_real(pfMNew_real, qpStart, qpEnd, comm);
-  
-  RecordComputedWaveFunction(eleIdx, eleCfg, eleNum, eleProjCnt, qpStart, qpEnd, comm,
-                             CalculateIP_real(pfMNew_real, qpStart, qpEnd, comm));
+/* The down spins of the idx-th configuration are on the sites c[0] < c[1] < ... < c[Ne-1] */
+void unrankSpinConfig(uint64_t idx, int *c, const uint64_t *binom) {
+  int k, r = Nsite - 1;
 
-  UpdateMAllTwo_real(mi, s, mj, t, ri, rj, eleIdx, qpStart, qpEnd);
+  for (k = Ne; k >= 1; --k) {
+    while (binom[r * (Ne + 1) + k] > idx) --r;
+    c[k - 1] = r;
+    idx -= binom[r * (Ne + 1) + k];
+    --r;
+  }
 }
 
-void walkRight(int n, int k, int pos, int *eleIdx, int *eleCfg, int *eleNum, int *eleProjCnt, int qpStart, int qpEnd, MPI_Comm comm);
-void walkLeft(int n, int k, int pos, int *eleIdx, int *eleCfg, int *eleNum, int *eleProjCnt, int qpStart, int qpEnd, MPI_Comm comm);
+/* The next configuration in the order of the index (colexicographic order) */
+void nextSpinConfig(int *c) {
+  int i, j = 0;
 
-// Walking bit algorithm
-// BASED ON: https://stackoverflow.com/a/36466454/3025981
-void walkRight(int n, int k, int pos, int *eleIdx, int *eleCfg, int *eleNum, int *eleProjCnt, 
-               int qpStart, int qpEnd, MPI_Comm comm) {
-  // # ifdef _DEBUG
-  // fprintf(stderr, "walkRight: n = %d, k = %d, pos = %d\n", n, k, pos);
-  // # endif
+  while (j < Ne - 1 && c[j] + 1 == c[j + 1]) ++j;
+  c[j]++;
+  for (i = 0; i < j; ++i) c[i] = i;
+}
+
+/* Set the electron configuration with the down spins on the sites c[] */
+void setSpinConfig(const int *c, int *eleIdx, int *eleCfg, int *eleNum) {
+  int ri, k = 0, mUp = 0, mDn = 0;
 
-  if (k == 1) {
-    for(int p = pos + 1; p < pos + n; ++p) {
-      swap_spins(p, p - 1, eleIdx, eleCfg, eleNum, eleProjCnt, qpStart, qpEnd, comm);
+  for (ri = 0; ri < Nsite; ++ri) {
+    if (k < Ne && c[k] == ri) {
+      ++k;
+      eleIdx[mDn + Ne] = ri;
+      eleCfg[ri] = -1;
+      eleCfg[ri + Nsite] = mDn;
+      eleNum[ri] = 0;
+      eleNum[ri + Nsite] = 1;
+      ++mDn;
+    } else {
+      eleIdx[mUp] = ri;
+      eleCfg[ri] = mUp;
+      eleCfg[ri + Nsite] = -1;
+      eleNum[ri] = 1;
+      eleNum[ri + Nsite] = 0;
+      ++mUp;
     }
-  } else {
-    for(int i = 1; i <= n - k; i++) {
-      if (i % 2 == 1) {
-        walkRight(n - i, k - 1, pos + i, eleIdx, eleCfg, eleNum, eleProjCnt, qpStart, qpEnd, comm);
-      } else {
-        walkLeft(n - i, k - 1, pos + i, eleIdx, eleCfg, eleNum, eleProjCnt, qpStart, qpEnd, comm);
-      }
-      swap_spins(pos + i - 1, pos + i + (i % 2 ? 0 : k - 1), eleIdx, eleCfg, eleNum, eleProjCnt, 
-                 qpStart, qpEnd, comm);
+  }
+}
+
+/* Pfaffians and inverse matrices of a configuration from scratch.
+   The Pfaffian of a singular matrix is set to zero. Return the number of singular matrices. */
+int calculateMAllWalk_real(const int *eleIdx, double *pfM, double *invM,
+                           double *bufM, int *iwork, double *work) {
+  int qpidx, nSingular = 0;
+
+  for (qpidx = 0; qpidx < NQPFull; ++qpidx) {
+    if (calculateMAll_child_real(eleIdx, 0, NQPFull, qpidx, bufM, iwork, work, LapackLWork, pfM, invM) != 0) {
+      pfM[qpidx] = 0.0;
+      nSingular++;
     }
   }
+  return nSingular;
 }
 
-void walkLeft(int n, int k, int pos, int *eleIdx, int *eleCfg, int *eleNum, int *eleProjCnt,
-              int qpStart, int qpEnd, MPI_Comm comm) {
-  // # ifdef _DEBUG
-  // fprintf(stderr, "walkLeft: n = %d, k = %d, pos = %d\n", n, k, pos);
-  // # endif
+/* Move the down spins on the sites cOld[] to the sites cNew[] by exchanges with up spins.
+   Each exchange updates the Pfaffians and inverse matrices by a rank-2 update. */
+void moveSpinConfig_real(const int *cOld, const int *cNew, int *eleIdx, int *eleCfg, int *eleNum,
+                         double *pfM, double *invM, double *vec) {
+  int rDn[Ne], rUp[Ne]; /* the sites where the spin flips to up and to down */
+  int i = 0, j = 0, n = 0, k = 0;
+  int ri, rj, mi, mj, qpidx;
+
+  while (i < Ne || j < Ne) {
+    if (j >= Ne || (i < Ne && cOld[i] < cNew[j])) {
+      rDn[n++] = cOld[i++];
+    } else if (i >= Ne || cNew[j] < cOld[i]) {
+      rUp[k++] = cNew[j++];
+    } else {
+      ++i;
+      ++j;
+    }
+  }
 
-  if (k == 1) {
-    for(int p = pos + n - 1; p > pos; --p) {
-      swap_spins(p, p - 1, eleIdx, eleCfg, eleNum, eleProjCnt, qpStart, qpEnd, comm);
+  for (k = 0; k < n; ++k) {
+    /* The mi-th electron with spin down hops to rj and the mj-th electron with spin up hops to ri */
+    ri = rDn[k];
+    rj = rUp[k];
+    mi = eleCfg[ri + Nsite];
+    mj = eleCfg[rj];
+    updateEleConfig(mi, ri, rj, 1, eleIdx, eleCfg, eleNum);
+    updateEleConfig(mj, rj, ri, 0, eleIdx, eleCfg, eleNum);
+    for (qpidx = 0; qpidx < NQPFull; ++qpidx) {
+      updateMAllTwo_child_real(mi, 1, mj, 0, ri, rj, eleIdx, 0, NQPFull, qpidx,
+                               vec, vec + Nsize, vec + 2 * Nsize, vec + 3 * Nsize, pfM, invM);
     }
-  } else {
-    for(int i = 1; i <= n - k; ++i) {
-      if (i % 2 == 0) {
-        walkRight(n - i, k - 1, pos, eleIdx, eleCfg, eleNum, eleProjCnt, qpStart, qpEnd, comm);
-      } else {
-        walkLeft(n - i, k - 1, pos, eleIdx, eleCfg, eleNum, eleProjCnt, qpStart, qpEnd, comm);
+  }
+}
+
+/* Enumerate the amplitudes <phi|L|x> of all the spin configurations x with Ne down spins.
+   The index space is divided into contiguous ranges over the processes of comm and
+   into blocks of D_WalkBlock configurations over the threads. The first configuration
+   of a block is unranked and its Pfaffians are calculated from scratch; the following
+   configurations are reached by spin exchanges with rank-2 updates. */
+void WalkWaveFunction_real(MPI_Comm comm) {
+  const char magic[8] = {'m','V','M','C','w','f','0','1'};
+  const long headerSize = 8 + 2 * sizeof(int32_t) + sizeof(uint64_t);
+  const int nInvM = NQPFull * (Nsize * Nsize + 1);
+  char const* filename = WaveFunctionOutputName();
+  uint64_t binom[(Nsite + 1) * (Ne + 1)];
+  uint64_t nConfig, idxStart, idxEnd;
+  long long block, nBlock;
+  int32_t header[2];
+  int rank, size;
+  FILE *fp;
+
+  int *myIWork, *myEle, *myC, *myCNew;
+  double *myBufM, *myWork, *myVec, *myInvM, *myAmp;
+
+  MPI_Comm_rank(comm, &rank);
+  MPI_Comm_size(comm, &size);
+  checkSpinSystem(comm);
+
+  makeBinomialTable(binom);
+  nConfig = binom[Nsite * (Ne + 1) + Ne];
+  if (nConfig == UINT64_MAX) {
+    fprintf(stderr, "error: WalkWaveFunction_real: binomial(%d,%d) exceeds 64 bits\n", Nsite, Ne);
+    MPI_Abort(comm, EXIT_FAILURE);
+  }
+  idxStart = (nConfig / (uint64_t)size) * (uint64_t)rank
+    + ((uint64_t)rank < nConfig % (uint64_t)size ? (uint64_t)rank : nConfig % (uint64_t)size);
+  idxEnd = idxStart + nConfig / (uint64_t)size + ((uint64_t)rank < nConfig % (uint64_t)size ? 1 : 0);
+  nBlock = (long long)((idxEnd - idxStart + D_WalkBlock - 1) / D_WalkBlock);
+
+  if (rank == 0) {
+    fprintf(stderr, "WalkWaveFunction_real: writing %llu amplitudes to '%s' ...\n",
+            (unsigned long long)nConfig, filename);
+    fp = fopen(filename, "wb");
+    if (fp == NULL) {
+      fprintf(stderr, "error: WalkWaveFunction_real: cannot open '%s'\n", filename);
+      MPI_Abort(comm, EXIT_FAILURE);
+    }
+    header[0] = Nsite;
+    header[1] = Ne;
+    fwrite(magic, sizeof(char), 8, fp);
+    fwrite(header, sizeof(int32_t), 2, fp);
+    fwrite(&nConfig, sizeof(uint64_t), 1, fp);
+    fclose(fp);
+  }
+  MPI_Barrier(comm);
+  fp = fopen(filename, "r+b");
+  if (fp == NULL) {
+    fprintf(stderr, "error: WalkWaveFunction_real: cannot open '%s'\n", filename);
+    MPI_Abort(comm, EXIT_FAILURE);
+  }
+
+  RequestWorkSpaceThreadInt(Nsize + Nsize + 2 * Nsite + 2 * Nsite + 2 * Ne);
+  RequestWorkSpaceThreadDouble(Nsize * Nsize + LapackLWork + 4 * Nsize + nInvM + D_WalkBlock);
+
+#pragma omp parallel default(shared) \
+  private(myIWork, myEle, myC, myCNew, myBufM, myWork, myVec, myInvM, myAmp, block)
+  {
+    int *eleIdx, *eleCfg, *eleNum, *tmpC;
+    double *pfM;
+    uint64_t idx, idx0, idx1;
+    int i, qpidx, nFresh;
+    double ip;
+
+    myIWork = GetWorkSpaceThreadInt(Nsize);
+    myEle   = GetWorkSpaceThreadInt(Nsize + 2 * Nsite + 2 * Nsite);
+    myC     = GetWorkSpaceThreadInt(Ne);
+    myCNew  = GetWorkSpaceThreadInt(Ne);
+    myBufM  = GetWorkSpaceThreadDouble(Nsize * Nsize);
+    myWork  = GetWorkSpaceThreadDouble(LapackLWork);
+    myVec   = GetWorkSpaceThreadDouble(4 * Nsize);
+    myInvM  = GetWorkSpaceThreadDouble(nInvM);
+    myAmp   = GetWorkSpaceThreadDouble(D_WalkBlock);
+    eleIdx = myEle;
+    eleCfg = eleIdx + Nsize;
+    eleNum = eleCfg + 2 * Nsite;
+    pfM = myInvM + NQPFull * Nsize * Nsize;
+
+#pragma omp for schedule(dynamic)
+    for (block = 0; block < nBlock; ++block) {
+      idx0 = idxStart + (uint64_t)block * D_WalkBlock;
+      idx1 = (idx0 + D_WalkBlock < idxEnd) ? idx0 + D_WalkBlock : idxEnd;
+
+      unrankSpinConfig(idx0, myC, binom);
+      setSpinConfig(myC, eleIdx, eleCfg, eleNum);
+      nFresh = calculateMAllWalk_real(eleIdx, pfM, myInvM, myBufM, myIWork, myWork);
+
+      for (idx = idx0; idx < idx1; ++idx) {
+        if (idx > idx0) {
+          for (i = 0; i < Ne; ++i) myCNew[i] = myC[i];
+          nextSpinConfig(myCNew);
+          if (nFresh > 0 || (idx - idx0) % Nsite == 0) {
+            /* recalculate after a singular matrix and at every Nsite configurations */
+            setSpinConfig(myCNew, eleIdx, eleCfg, eleNum);
+            nFresh = calculateMAllWalk_real(eleIdx, pfM, myInvM, myBufM, myIWork, myWork);
+          } else {
+            moveSpinConfig_real(myC, myCNew, eleIdx, eleCfg, eleNum, pfM, myInvM, myVec);
+          }
+          tmpC = myC; myC = myCNew; myCNew = tmpC;
+        }
+
+        ip = 0.0;
+        for (qpidx = 0; qpidx < NQPFull; ++qpidx) ip += creal(QPFullWeight[qpidx]) * pfM[qpidx];
+        if (!isfinite(ip)) {
+          /* an intermediate configuration of the exchanges was singular */
+          setSpinConfig(myC, eleIdx, eleCfg, eleNum);
+          nFresh = calculateMAllWalk_real(eleIdx, pfM, myInvM, myBufM, myIWork, myWork);
+          ip = 0.0;
+          for (qpidx = 0; qpidx < NQPFull; ++qpidx) ip += creal(QPFullWeight[qpidx]) * pfM[qpidx];
+        }
+        myAmp[idx - idx0] = ip * GetPermutationSign(eleIdx, 2 * Ne, comm);
+      }
+
+#pragma omp critical
+      {
+        fseeko(fp, (off_t)headerSize + (off_t)(idx0 * sizeof(double)), SEEK_SET);
+        fwrite(myAmp, sizeof(double), idx1 - idx0, fp);
       }
-      swap_spins(pos + n - i - (i % 2 ? 1 : k), pos + n - i, eleIdx, eleCfg, eleNum, eleProjCnt, 
-                 qpStart, qpEnd, comm);
     }
   }
+
+  ReleaseWorkSpaceThreadInt();
+  ReleaseWorkSpaceThreadDouble();
+
+  fclose(fp);
+  MPI_Barrier(comm);
+  if (rank == 0) fprintf(stderr, "WalkWaveFunction_real: done\n");
 }
-// END BASED
 
 void VMCMakeSample_real(MPI_Comm comm) {
   InitWaveFunctionExtraction(comm);
@@ -293,43 +427,46 @@ void VMCMakeSample_real(MPI_Comm comm) {
   int qpStart, qpEnd;
   int rejectFlag;
   int rank, size;
+#ifndef _pf_block_update
+  int nBatch;
+#endif
   MPI_Comm_size(comm, &size);
   MPI_Comm_rank(comm, &rank);
 
   SplitLoop(&qpStart, &qpEnd, NQPFull, rank, size);
+#ifndef _pf_block_update
+  /* proposals are batched only when the quantum projection is split */
+  nBatch = (size > 1) ? NVMCBatch : 1;
+#endif
 
 
-  StartTimer(30);
   if (GetShouldWalk()) {
-    makeInitialSample_spin_left_ones(TmpEleIdx, TmpEleCfg, TmpEleNum, TmpEleProjCnt,
-                                     qpStart, qpEnd, comm);
-  } else {
-    if (BurnFlag == 0) {
-      makeInitialSample(TmpEleIdx, TmpEleCfg, TmpEleNum, TmpEleProjCnt,
-                        qpStart, qpEnd, comm);
-    } else {
-      copyFromBurnSample(TmpEleIdx, TmpEleCfg, TmpEleNum, TmpEleProjCnt);
+    if (size > 1) {
+      fprintf(stderr, "error: the wave function walk requires NSplitSize = 1\n");
+      MPI_Abort(comm, EXIT_FAILURE);
     }
+    WalkWaveFunction_real(GetWaveFunctionWalkComm());
+    fprintf(stderr, "Walking complete; stopping the program now ...\n");
+    MPI_Abort(comm, 0);
+  }
+
+  StartTimer(30);
+  if (BurnFlag == 0) {
+    makeInitialSample_real(TmpEleIdx, TmpEleCfg, TmpEleNum, TmpEleProjCnt,
+                           qpStart, qpEnd, comm);
+  } else {
+    copyFromBurnSample(TmpEleIdx, TmpEleCfg, TmpEleNum, TmpEleProjCnt);
   }
 
 #ifdef _pf_block_update
   // TODO: Compute from qpStart to qpEnd to support loop splitting.
   void *pfOrbital[NQPFull];
   void *pfUpdator[NQPFull];
-  // Read block size from input.
-  const char *optBlockSize = getenv("VMC_BLOCK_UPDATE_SIZE");
-  if (optBlockSize)
-    NBlockUpdateSize = atoi(optBlockSize);
-  // Fall back to default if input is invalid.
-  if (NBlockUpdateSize < 1 || NBlockUpdateSize > 100)
-    if (NExUpdatePath == 0)
-      NBlockUpdateSize = 2;
-    else
-      NBlockUpdateSize = 20;
 
   // Set one universal EleSpn.
   for (mi=0; mi<Ne;  mi++) EleSpn[mi] = 0;
   for (mi=Ne;mi<Ne*2;mi++) EleSpn[mi] = 1;
+  SetBlockUpdateSize_real(TmpEleIdx, EleSpn, (NExUpdatePath == 0) ? 2 : 20, comm);
   // Initialize.
   updated_tdi_v_init_d(NQPFull, Nsite, Nsite2, Nsize,
                        SlaterElm_real, Nsite2*Nsite2,
@@ -345,17 +482,10 @@ void VMCMakeSample_real(MPI_Comm comm) {
   logIpOld = CalculateLogIP_real(PfM_real, qpStart, qpEnd, comm);
   RecordComputedWaveFunction(TmpEleIdx, TmpEleCfg, TmpEleNum, TmpEleProjCnt, qpStart, qpEnd, comm,
                              CalculateIP_real(PfM_real, qpStart, qpEnd, comm));
-  if (GetShouldWalk()) {
-    walkRight(Nsite, Ne, 0, TmpEleIdx, TmpEleCfg, TmpEleNum, TmpEleProjCnt,
-              qpStart, qpEnd, comm);
-    fprintf(stderr, "Walking complete; stopping the program now ...\n");
-    MPI_Abort(comm, 0);
-  }
-  
   if (!isfinite(logIpOld)) {
     if (rank == 0) fprintf(stderr, "waring: VMCMakeSample remakeSample logIpOld=%e\n", creal(logIpOld)); //TBC
-    makeInitialSample(TmpEleIdx, TmpEleCfg, TmpEleNum, TmpEleProjCnt,
-                      qpStart, qpEnd, comm);
+    makeInitialSample_real(TmpEleIdx, TmpEleCfg, TmpEleNum, TmpEleProjCnt,
+                           qpStart, qpEnd, comm);
 #ifdef _pf_block_update
     // Clear and reinitialize.
     updated_tdi_v_free_d(NQPFull, pfUpdator, pfOrbital);
@@ -385,6 +515,14 @@ void VMCMakeSample_real(MPI_Comm comm) {
   for (outStep = 0; outStep < nOutStep; outStep++) {
     for (inStep = 0; inStep < nInStep; inStep++) {
 
+#ifndef _pf_block_update
+      if (nBatch > 1) {
+        inStep += makeBatchUpdate_real((nBatch < nInStep - inStep) ? nBatch : nInStep - inStep,
+                                       &logIpOld, &nAccept, qpStart, qpEnd, comm) - 1;
+        continue;
+      }
+#endif
+
       updateType = getUpdateType(NExUpdatePath);
 
       if (updateType == HOPPING) { /* hopping */
@@ -425,7 +563,7 @@ void VMCMakeSample_real(MPI_Comm comm) {
 
         /* Metroplis */
         x = LogProjRatio(projCntNew, TmpEleProjCnt);
-        w = exp(2.0 * (x + (logIpNew - logIpOld)));
+        w = exp(2.0 * TemperingBeta * (x + (logIpNew - logIpOld)));
         if (!isfinite(w)) w = -1.0; /* should be rejected */
 
         if (w > genrand_real2()) { /* accept */
@@ -502,7 +640,7 @@ void VMCMakeSample_real(MPI_Comm comm) {
 
         /* Metroplis */
         x = LogProjRatio(projCntNew, TmpEleProjCnt);
-        w = exp(2.0 * (x + (logIpNew - logIpOld))); //TBC
+        w = exp(2.0 * TemperingBeta * (x + (logIpNew - logIpOld))); //TBC
         if (!isfinite(w)) w = -1.0; /* should be rejected */
 
         if (w > genrand_real2()) { /* accept */
@@ -556,15 +694,29 @@ void VMCMakeSample_real(MPI_Comm comm) {
         nAccept = 0;
       }
     } /* end of instep */
+    /* apply the delayed updates before InvM is used outside the sampler */
+    FlushDelayMAll_real(qpStart,qpEnd);
+
+    /* exchange the configurations with the neighboring replica */
+    if (NVMCTempering > 1) {
+      StartTimer(34);
+      ExchangeReplica_real(outStep, &logIpOld, qpStart, qpEnd, comm);
+      StopTimer(34);
+    }
 
     StartTimer(35);
-    /* save Electron Configuration */
-    if (outStep >= nOutStep - NVMCSample) {
+    /* save Electron Configuration (only the replica with beta=1) */
+    if (outStep >= nOutStep - NVMCSample && TemperingRung == 0) {
       sample = outStep - (nOutStep - NVMCSample);
       saveEleConfig(sample, logIpOld, TmpEleIdx, TmpEleCfg, TmpEleNum, TmpEleProjCnt);
     }
     StopTimer(35);
 
+    /* calculate physical quantities with the current InvM_real */
+    if (NVMCCalFuse == 1 && outStep >= nOutStep - NVMCSample) {
+      VMCMainCalFused(outStep - (nOutStep - NVMCSample), comm);
+    }
+
   } /* end of outstep */
 
   copyToBurnSample(TmpEleIdx, TmpEleCfg, TmpEleNum, TmpEleProjCnt);
@@ -579,6 +731,128 @@ void VMCMakeSample_real(MPI_Comm comm) {
   return;
 }
 
+/* Real version of makeBatchUpdate */
+int makeBatchUpdate_real(const int nBatch, double *logIpOld, int *nAccept,
+                         const int qpStart, const int qpEnd, MPI_Comm comm) {
+  const int qpNum = qpEnd - qpStart;
+  int *updateType, *mi, *mj, *ri, *rj, *s, *rejectFlag, *projCntNew;
+  double *rnd;
+  double *ip, *ipRdc;
+  double pfMNew_real[NQPFull];
+  double logIpNew;
+  double x, w;
+  int batch, qpidx, i, t, nStep = nBatch;
+  int *projCnt;
+
+  RequestWorkSpaceInt(nBatch * (7 + NProj));
+  RequestWorkSpaceDouble(3 * nBatch);
+  updateType = GetWorkSpaceInt(nBatch);
+  mi = GetWorkSpaceInt(nBatch);
+  mj = GetWorkSpaceInt(nBatch);
+  ri = GetWorkSpaceInt(nBatch);
+  rj = GetWorkSpaceInt(nBatch);
+  s  = GetWorkSpaceInt(nBatch);
+  rejectFlag = GetWorkSpaceInt(nBatch);
+  projCntNew = GetWorkSpaceInt(nBatch * NProj);
+  rnd   = GetWorkSpaceDouble(nBatch);
+  ip    = GetWorkSpaceDouble(nBatch);
+  ipRdc = GetWorkSpaceDouble(nBatch);
+
+  StartTimer(31);
+  for (batch = 0; batch < nBatch; batch++) {
+    updateType[batch] = getUpdateType(NExUpdatePath);
+    rejectFlag[batch] = 1;
+    ip[batch] = 0.0;
+    projCnt = projCntNew + batch * NProj;
+
+    if (updateType[batch] == HOPPING) {
+      makeCandidate_hopping(mi + batch, ri + batch, rj + batch, s + batch, rejectFlag + batch,
+                            TmpEleIdx, TmpEleCfg);
+      if (rejectFlag[batch]) continue;
+
+      updateEleConfig(mi[batch], ri[batch], rj[batch], s[batch], TmpEleIdx, TmpEleCfg, TmpEleNum);
+      UpdateProjCnt(ri[batch], rj[batch], s[batch], projCnt, TmpEleProjCnt, TmpEleNum);
+      CalculateNewPfM2_real(mi[batch], s[batch], pfMNew_real, TmpEleIdx, qpStart, qpEnd);
+      revertEleConfig(mi[batch], ri[batch], rj[batch], s[batch], TmpEleIdx, TmpEleCfg, TmpEleNum);
+
+    } else if (updateType[batch] == EXCHANGE) {
+      makeCandidate_exchange(mi + batch, ri + batch, rj + batch, s + batch, rejectFlag + batch,
+                             TmpEleIdx, TmpEleCfg, TmpEleNum);
+      if (rejectFlag[batch]) continue;
+
+      t = 1 - s[batch];
+      mj[batch] = TmpEleCfg[rj[batch] + t * Nsite];
+      updateEleConfig(mi[batch], ri[batch], rj[batch], s[batch], TmpEleIdx, TmpEleCfg, TmpEleNum);
+      UpdateProjCnt(ri[batch], rj[batch], s[batch], projCnt, TmpEleProjCnt, TmpEleNum);
+      updateEleConfig(mj[batch], rj[batch], ri[batch], t, TmpEleIdx, TmpEleCfg, TmpEleNum);
+      UpdateProjCnt(rj[batch], ri[batch], t, projCnt, projCnt, TmpEleNum);
+      CalculateNewPfMTwo2_real(mi[batch], s[batch], mj[batch], t, pfMNew_real, TmpEleIdx, qpStart, qpEnd);
+      revertEleConfig(mj[batch], rj[batch], ri[batch], t, TmpEleIdx, TmpEleCfg, TmpEleNum);
+      revertEleConfig(mi[batch], ri[batch], rj[batch], s[batch], TmpEleIdx, TmpEleCfg, TmpEleNum);
+
+    } else {
+      continue;
+    }
+
+    for (qpidx = 0; qpidx < qpNum; qpidx++) {
+      ip[batch] += creal(QPFullWeight[qpidx + qpStart]) * pfMNew_real[qpidx];
+    }
+    rnd[batch] = genrand_real2();
+  }
+  StopTimer(31);
+
+  StartTimer(62);
+  MPI_Allreduce(ip, ipRdc, nBatch, MPI_DOUBLE, MPI_SUM, comm);
+  StopTimer(62);
+
+  for (batch = 0; batch < nBatch; batch++) {
+    if (updateType[batch] == HOPPING) Counter[0]++;
+    else if (updateType[batch] == EXCHANGE) Counter[2]++;
+    if (rejectFlag[batch]) continue;
+
+    /* Metroplis */
+    projCnt = projCntNew + batch * NProj;
+    logIpNew = log(fabs(ipRdc[batch]));
+    x = LogProjRatio(projCnt, TmpEleProjCnt);
+    w = exp(2.0 * (x + (logIpNew - *logIpOld)));
+    if (!isfinite(w)) w = -1.0; /* should be rejected */
+    if (w <= rnd[batch]) continue; /* reject */
+
+    /* accept */
+    StartTimer(63);
+    updateEleConfig(mi[batch], ri[batch], rj[batch], s[batch], TmpEleIdx, TmpEleCfg, TmpEleNum);
+    if (updateType[batch] == HOPPING) {
+      UpdateMAll_real(mi[batch], s[batch], TmpEleIdx, qpStart, qpEnd);
+      Counter[1]++;
+    } else {
+      t = 1 - s[batch];
+      updateEleConfig(mj[batch], rj[batch], ri[batch], t, TmpEleIdx, TmpEleCfg, TmpEleNum);
+      UpdateMAllTwo_real(mi[batch], s[batch], mj[batch], t, ri[batch], rj[batch], TmpEleIdx, qpStart, qpEnd);
+      Counter[3]++;
+    }
+    StopTimer(63);
+
+    for (i = 0; i < NProj; i++) TmpEleProjCnt[i] = projCnt[i];
+    *logIpOld = logIpNew;
+    (*nAccept)++;
+
+    if (*nAccept > Nsite) {
+      // Recalculate PfM and InvM.
+      StartTimer(34);
+      CalculateMAll_real(TmpEleIdx, qpStart, qpEnd);
+      *logIpOld = CalculateLogIP_real(PfM_real, qpStart, qpEnd, comm);
+      StopTimer(34);
+      *nAccept = 0;
+    }
+    nStep = batch + 1;
+    break;
+  }
+
+  ReleaseWorkSpaceInt();
+  ReleaseWorkSpaceDouble();
+  return nStep;
+}
+
 int makeInitialSample_real(int *eleIdx, int *eleCfg, int *eleNum, int *eleProjCnt,
                            const int qpStart, const int qpEnd, MPI_Comm comm) {
   const int nsize = Nsize;
@@ -682,7 +956,7 @@ void VMC_BF_MakeSample_real(MPI_Comm comm) {
     copyFromBurnSampleBF(TmpEleIdx);
     MakeSlaterElmBF_fcmp(TmpEleNum, TmpEleProjBFCnt);
 #pragma omp parallel for default(shared) private(tmp_i)
-    for(tmp_i=0;tmp_i<NQPFull*(2*Nsite)*(2*Nsite);tmp_i++) SlaterElm_real[tmp_i]= creal(SlaterElm[tmp_i]);
+    for(tmp_i=0;tmp_i<NQPFull*Nsite2*NSlaterElmCol;tmp_i++) SlaterElm_real[tmp_i]= creal(SlaterElm[tmp_i]);
   }
 
   CalculateMAll_BF_real(TmpEleIdx, qpStart, qpEnd);
@@ -736,7 +1010,7 @@ void VMC_BF_MakeSample_real(MPI_Comm comm) {
         UpdateSlaterElmBF_fcmp(mi, ri, rj, s, TmpEleCfg, TmpEleNum, projBFCntNew, msaTmp, icount,
                                SlaterElmBF);
 #pragma omp parallel for default(shared) private(tmp_i)
-        for(tmp_i=0;tmp_i<NQPFull*(2*Nsite)*(2*Nsite);tmp_i++) SlaterElm_real[tmp_i]= creal(SlaterElm[tmp_i]);
+        for(tmp_i=0;tmp_i<NQPFull*Nsite2*NSlaterElmCol;tmp_i++) SlaterElm_real[tmp_i]= creal(SlaterElm[tmp_i]);
 
         StartTimer(61);
         //CalculateNewPfM2(mi,s,pfMNew,TmpEleIdx,qpStart,qpEnd);
@@ -778,7 +1052,7 @@ void VMC_BF_MakeSample_real(MPI_Comm comm) {
           UpdateSlaterElmBF_fcmp(mi, rj, ri, s, TmpEleCfg, TmpEleNum, TmpEleProjBFCnt, msaTmp, icount,
                                  SlaterElmBF);
 #pragma omp parallel for default(shared) private(tmp_i)
-          for(tmp_i=0;tmp_i<NQPFull*(2*Nsite)*(2*Nsite);tmp_i++) SlaterElm_real[tmp_i]= creal(SlaterElm[tmp_i]);
+          for(tmp_i=0;tmp_i<NQPFull*Nsite2*NSlaterElmCol;tmp_i++) SlaterElm_real[tmp_i]= creal(SlaterElm[tmp_i]);
         }
         StopTimer(32);
 
@@ -928,7 +1202,7 @@ int makeInitialSampleBF_real(int *eleIdx, int *eleCfg, int *eleNum, int *eleProj
 
     MakeSlaterElmBF_fcmp(eleNum, eleProjBFCnt);
 #pragma omp parallel for default(shared) private(tmp_i)
-    for(tmp_i=0;tmp_i<NQPFull*(2*Nsite)*(2*Nsite);tmp_i++) SlaterElm_real[tmp_i]= creal(SlaterElm[tmp_i]);
+    for(tmp_i=0;tmp_i<NQPFull*Nsite2*NSlaterElmCol;tmp_i++) SlaterElm_real[tmp_i]= creal(SlaterElm[tmp_i]);
 
     flag = CalculateMAll_BF_real(eleIdx, qpStart, qpEnd);
     //printf("DEBUG: maker4: PfM=%lf\n",creal(PfM[0]));
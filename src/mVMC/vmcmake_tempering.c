@@ -0,0 +1,139 @@
+/*
+mVMC - A numerical solver package for a wide range of quantum lattice models based on many-variable Variational Monte Carlo method
+Copyright (C) 2016 The University of Tokyo, All rights reserved.
+
+This program is developed based on the mVMC-mini program
+(https://github.com/fiber-miniapp/mVMC-mini)
+which follows "The BSD 3-Clause License".
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details. 
+
+You should have received a copy of the GNU General Public License 
+along with this program. If not, see http://www.gnu.org/licenses/. 
+*/
+/*-------------------------------------------------------------
+ * Variational Monte Carlo
+ * replica exchange of the Markov chains of the processes
+ *-------------------------------------------------------------*/
+#include "global.h"
+#include "vmcmake_tempering.h"
+#ifndef _SRC_VMCMAKE_TEMPERING
+#define _SRC_VMCMAKE_TEMPERING
+#include "projection.h"
+
+/* The processes are divided into ladders of NVMCTempering consecutive processes.
+   The replica of the rung-th process samples |<phi|L|x>|^{2 beta} with
+   beta = DVMCTemperingBeta^{rung/(NVMCTempering-1)}, and only the replica
+   with beta=1 (rung 0) stores samples.
+   The neighboring replicas try to exchange their configurations after
+   every sampling interval: the pairs (0,1),(2,3),... at even steps and
+   (1,2),(3,4),... at odd steps. */
+
+double temperingBeta(const int rung);
+int exchangeReplica(const int outStep, const double logWeight);
+
+double temperingBeta(const int rung) {
+  return pow(DVMCTemperingBeta, (double)rung/(double)(NVMCTempering-1));
+}
+
+/* comm: the processes which have independent Markov chains (comm_child2) */
+void InitTempering(MPI_Comm comm) {
+  int rank=0,size=1;
+
+  TemperingRung = 0;
+  TemperingBeta = 1.0;
+  CommTempering = comm;
+  if(NVMCTempering<2) return;
+
+#ifdef _mpi_use
+  MPI_Comm_rank(comm,&rank);
+  MPI_Comm_size(comm,&size);
+#endif /* _mpi_use */
+  if(size%NVMCTempering!=0) {
+    if(rank==0) {
+      fprintf(stdout, "Warning: the number of processes (%d) must be a multiple of NVMCTempering (%d).\n",
+              size, NVMCTempering);
+      fprintf(stdout, "         NVMCTempering set as 1.\n");
+    }
+    NVMCTempering = 1;
+    return;
+  }
+
+  TemperingRung = rank%NVMCTempering;
+  TemperingBeta = temperingBeta(TemperingRung);
+  return;
+}
+
+/* Decide whether the configurations are exchanged with the neighboring replica
+   and exchange TmpEleIdx, TmpEleCfg, TmpEleNum and TmpEleProjCnt.
+   logWeight is log|<phi|P|x>| of the current configuration.
+   Return 1 if the configurations are exchanged. */
+int exchangeReplica(const int outStep, const double logWeight) {
+  int accept=0;
+#ifdef _mpi_use
+  const int tag=100;
+  const int n=Nsize+2*Nsite+2*Nsite+NProj;
+  int rank,partnerRung,partner;
+  double partnerLogWeight,w;
+
+  if(NVMCTempering<2) return 0;
+
+  partnerRung = (TemperingRung%2==outStep%2) ? TemperingRung+1 : TemperingRung-1;
+  if(partnerRung<0 || partnerRung>=NVMCTempering) return 0;
+
+  MPI_Comm_rank(CommTempering,&rank);
+  partner = rank - TemperingRung + partnerRung;
+
+  MPI_Sendrecv(&logWeight, 1, MPI_DOUBLE, partner, tag,
+               &partnerLogWeight, 1, MPI_DOUBLE, partner, tag,
+               CommTempering, MPI_STATUS_IGNORE);
+
+  /* the replica with the larger beta draws the random number */
+  if(TemperingRung<partnerRung) {
+    w = exp(2.0*(TemperingBeta-temperingBeta(partnerRung))*(partnerLogWeight-logWeight));
+    if( !isfinite(w) ) w = (partnerLogWeight > logWeight) ? 2.0 : -1.0;
+    accept = (w > genrand_real2()) ? 1 : 0;
+    MPI_Send(&accept, 1, MPI_INT, partner, tag, CommTempering);
+  } else {
+    MPI_Recv(&accept, 1, MPI_INT, partner, tag, CommTempering, MPI_STATUS_IGNORE);
+  }
+
+  if(accept==1) {
+    MPI_Sendrecv_replace(TmpEleIdx, n, MPI_INT, partner, tag, partner, tag,
+                         CommTempering, MPI_STATUS_IGNORE);
+  }
+#endif /* _mpi_use */
+  return accept;
+}
+
+int ExchangeReplica_fcmp(const int outStep, double complex *logIpOld,
+                         const int qpStart, const int qpEnd, MPI_Comm comm) {
+  const double logWeight = LogProjVal(TmpEleProjCnt) + creal(*logIpOld);
+
+  if(exchangeReplica(outStep, logWeight)==0) return 0;
+
+  CalculateMAll_fcmp(TmpEleIdx,qpStart,qpEnd);
+  *logIpOld = CalculateLogIP_fcmp(PfM,qpStart,qpEnd,comm);
+  return 1;
+}
+
+int ExchangeReplica_real(const int outStep, double *logIpOld,
+                         const int qpStart, const int qpEnd, MPI_Comm comm) {
+  const double logWeight = LogProjVal(TmpEleProjCnt) + *logIpOld;
+
+  if(exchangeReplica(outStep, logWeight)==0) return 0;
+
+  CalculateMAll_real(TmpEleIdx,qpStart,qpEnd);
+  *logIpOld = CalculateLogIP_real(PfM_real,qpStart,qpEnd,comm);
+  return 1;
+}
+
+#endif
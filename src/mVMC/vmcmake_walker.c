@@ -0,0 +1,568 @@
+/*
+mVMC - A numerical solver package for a wide range of quantum lattice models based on many-variable Variational Monte Carlo method
+Copyright (C) 2016 The University of Tokyo, All rights reserved.
+
+This program is developed based on the mVMC-mini program
+(https://github.com/fiber-miniapp/mVMC-mini)
+which follows "The BSD 3-Clause License".
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details. 
+
+You should have received a copy of the GNU General Public License 
+along with this program. If not, see http://www.gnu.org/licenses/. 
+*/
+/*-------------------------------------------------------------
+ * Variational Monte Carlo
+ * make sample with several Markov chains in each process
+ *-------------------------------------------------------------*/
+#include "global.h"
+#include "vmcmake_walker.h"
+#ifndef _SRC_VMCMAKE_WALKER
+#define _SRC_VMCMAKE_WALKER
+#include "vmcmake.h"
+#include "vmcmake_real.h"
+#include "projection.h"
+#include "pfupdate.h"
+#include "pfupdate_real.h"
+#include "splitloop.h"
+
+/* Each walker owns an electron configuration (WalkerEleIdx) and
+   InvM/PfM for all the quantum projections (WalkerInvM(_real)).
+   Walkers are distributed over OpenMP threads and the samples
+   [0,NVMCSample) are split among them.
+   Each thread draws random numbers from its own SFMT state. */
+
+void makeSampleWalker(const int walker, int *eleIdx, double complex *invM, int *counter,
+                      double complex *bufM, int *iwork, double complex *work, double *rwork,
+                      double complex *vec);
+void makeInitialSampleWalker(int *eleIdx, int *eleCfg, int *eleNum, int *eleProjCnt,
+                             double complex *pfM, double complex *invM,
+                             double complex *bufM, int *iwork, double complex *work, double *rwork);
+int calculateMAllWalker(const int *eleIdx, double complex *pfM, double complex *invM,
+                        double complex *bufM, int *iwork, double complex *work, double *rwork);
+double complex calculateLogIPWalker(const double complex *pfM);
+
+void makeSampleWalker_real(const int walker, int *eleIdx, double *invM, int *counter,
+                           double *bufM, int *iwork, double *work, double *vec);
+void makeInitialSampleWalker_real(int *eleIdx, int *eleCfg, int *eleNum, int *eleProjCnt,
+                                  double *pfM, double *invM,
+                                  double *bufM, int *iwork, double *work);
+int calculateMAllWalker_real(const int *eleIdx, double *pfM, double *invM,
+                             double *bufM, int *iwork, double *work);
+double calculateLogIPWalker_real(const double *pfM);
+
+/* Seed the random number generators of the threads other than the master thread. 
+   The master thread keeps the sequence initialized by init_gen_rand().
+   This is called for every run, since the SFMT state is threadprivate. */
+void InitWalkerRandom(const int seed) {
+  #pragma omp parallel default(shared)
+  {
+    const int thread = omp_get_thread_num();
+    uint32_t key[2];
+    if(thread>0) {
+      key[0] = (uint32_t)seed;
+      key[1] = (uint32_t)thread;
+      init_by_array(key,2);
+    }
+  }
+  return;
+}
+
+void VMCMakeSampleWalker() {
+  const int nWalker = NVMCWalker;
+  const int nEle = Nsize+2*Nsite+2*Nsite+NProj;
+  const int nInvM = NQPFull*(Nsize*Nsize+1);
+  int walker,i;
+  int *counter;
+
+  double complex *myBufM, *myWork, *myVec;
+  int *myIWork;
+  double *myRWork;
+
+  RequestWorkSpaceInt(nWalker*Counter_max);
+  counter = GetWorkSpaceInt(nWalker*Counter_max);
+  for(i=0;i<nWalker*Counter_max;i++) counter[i]=0;
+
+  RequestWorkSpaceThreadInt(Nsize);
+  RequestWorkSpaceThreadComplex(Nsize*Nsize+LapackLWork+4*Nsize);
+  RequestWorkSpaceThreadDouble(LapackLWork);
+
+  #pragma omp parallel default(shared)                \
+    private(myIWork,myBufM,myWork,myVec,myRWork,walker)
+  {
+    myIWork = GetWorkSpaceThreadInt(Nsize);
+    myBufM  = GetWorkSpaceThreadComplex(Nsize*Nsize);
+    myWork  = GetWorkSpaceThreadComplex(LapackLWork);
+    myVec   = GetWorkSpaceThreadComplex(4*Nsize);
+    myRWork = GetWorkSpaceThreadDouble(LapackLWork);
+
+    #pragma omp for schedule(static)
+    for(walker=0;walker<nWalker;walker++) {
+      makeSampleWalker(walker, WalkerEleIdx+walker*nEle, WalkerInvM+walker*nInvM,
+                       counter+walker*Counter_max, myBufM, myIWork, myWork, myRWork, myVec);
+    }
+  }
+
+  ReleaseWorkSpaceThreadInt();
+  ReleaseWorkSpaceThreadComplex();
+  ReleaseWorkSpaceThreadDouble();
+
+  for(i=0;i<Counter_max;i++) {
+    Counter[i] = 0;
+    for(walker=0;walker<nWalker;walker++) Counter[i] += counter[walker*Counter_max+i];
+  }
+  ReleaseWorkSpaceInt();
+  BurnFlag=1;
+
+  return;
+}
+
+void makeSampleWalker(const int walker, int *eleIdx, double complex *invM, int *counter,
+                      double complex *bufM, int *iwork, double complex *work, double *rwork,
+                      double complex *vec) {
+  int *eleCfg = eleIdx + Nsize;
+  int *eleNum = eleCfg + 2*Nsite;
+  int *eleProjCnt = eleNum + 2*Nsite;
+  double complex *pfM = invM + NQPFull*Nsize*Nsize;
+  double complex *vec1 = vec;
+  double complex *vec2 = vec + Nsize;
+  double complex *vec3 = vec + 2*Nsize;
+  double complex *vec4 = vec + 3*Nsize;
+
+  int outStep,nOutStep;
+  int inStep,nInStep;
+  UpdateType updateType;
+  int mi,mj,ri,rj,s,t,i,qpidx;
+  int nAccept=0;
+  int sample,sampleStart,sampleEnd,nSample;
+  int burnFlag=BurnFlag;
+
+  double complex logIpOld,logIpNew; /* logarithm of inner product <phi|L|x> */
+  int projCntNew[NProj];
+  double complex pfMNew[NQPFull];
+  double x,w;
+  int rejectFlag;
+
+  SplitLoop(&sampleStart,&sampleEnd,NVMCSample,walker,NVMCWalker);
+  nSample = sampleEnd-sampleStart;
+
+  if(burnFlag==0) {
+    makeInitialSampleWalker(eleIdx,eleCfg,eleNum,eleProjCnt,pfM,invM,bufM,iwork,work,rwork);
+  } else {
+    calculateMAllWalker(eleIdx,pfM,invM,bufM,iwork,work,rwork);
+  }
+  logIpOld = calculateLogIPWalker(pfM);
+
+  if( !isfinite(creal(logIpOld) + cimag(logIpOld)) ) {
+    fprintf(stderr,"warning: VMCMakeSampleWalker remakeSample walker=%d logIpOld=%e\n",walker,creal(logIpOld));
+    makeInitialSampleWalker(eleIdx,eleCfg,eleNum,eleProjCnt,pfM,invM,bufM,iwork,work,rwork);
+    logIpOld = calculateLogIPWalker(pfM);
+    burnFlag = 0;
+  }
+
+  nOutStep = (burnFlag==0) ? NVMCWarmUp+nSample : nSample+1;
+  nInStep = NVMCInterval * Nsite;
+
+  for(outStep=0;outStep<nOutStep;outStep++) {
+    for(inStep=0;inStep<nInStep;inStep++) {
+
+      updateType = getUpdateType(NExUpdatePath);
+
+      if(updateType==HOPPING) { /* hopping */
+        counter[0]++;
+
+        makeCandidate_hopping(&mi, &ri, &rj, &s, &rejectFlag, eleIdx, eleCfg);
+        if(rejectFlag) continue;
+
+        /* The mi-th electron with spin s hops to site rj */
+        updateEleConfig(mi,ri,rj,s,eleIdx,eleCfg,eleNum);
+        UpdateProjCnt(ri,rj,s,projCntNew,eleProjCnt,eleNum);
+
+        for(qpidx=0;qpidx<NQPFull;qpidx++) {
+          calculateNewPfM_child(mi,s,pfMNew,eleIdx,0,NQPFull,qpidx,pfM,invM);
+        }
+
+        /* calculate inner product <phi|L|x> */
+        logIpNew = calculateLogIPWalker(pfMNew);
+
+        /* Metroplis */
+        x = LogProjRatio(projCntNew,eleProjCnt);
+        w = exp(2.0*(x+creal(logIpNew-logIpOld)));
+        if( !isfinite(w) ) w = -1.0; /* should be rejected */
+
+        if(w > genrand_real2()) { /* accept */
+          for(qpidx=0;qpidx<NQPFull;qpidx++) {
+            updateMAll_child(mi,s,eleIdx,0,NQPFull,qpidx,vec1,vec2,pfM,invM);
+          }
+
+          for(i=0;i<NProj;i++) eleProjCnt[i] = projCntNew[i];
+          logIpOld = logIpNew;
+          nAccept++;
+          counter[1]++;
+        } else { /* reject */
+          revertEleConfig(mi,ri,rj,s,eleIdx,eleCfg,eleNum);
+        }
+
+      } else if(updateType==EXCHANGE) { /* exchange */
+        counter[2]++;
+
+        makeCandidate_exchange(&mi, &ri, &rj, &s, &rejectFlag, eleIdx, eleCfg, eleNum);
+        if(rejectFlag) continue;
+
+        /* The mi-th electron with spin s exchanges with the electron on site rj with spin 1-s */
+        t = 1-s;
+        mj = eleCfg[rj+t*Nsite];
+
+        /* The mi-th electron with spin s hops to rj */
+        updateEleConfig(mi,ri,rj,s,eleIdx,eleCfg,eleNum);
+        UpdateProjCnt(ri,rj,s,projCntNew,eleProjCnt,eleNum);
+        /* The mj-th electron with spin t hops to ri */
+        updateEleConfig(mj,rj,ri,t,eleIdx,eleCfg,eleNum);
+        UpdateProjCnt(rj,ri,t,projCntNew,projCntNew,eleNum);
+
+        for(qpidx=0;qpidx<NQPFull;qpidx++) {
+          calculateNewPfMTwo_child_fcmp(mi,s,mj,t,pfMNew,eleIdx,0,NQPFull,qpidx,
+                                        vec1,vec2,pfM,invM);
+        }
+
+        /* calculate inner product <phi|L|x> */
+        logIpNew = calculateLogIPWalker(pfMNew);
+
+        /* Metroplis */
+        x = LogProjRatio(projCntNew,eleProjCnt);
+        w = exp(2.0*(x+creal(logIpNew-logIpOld)));
+        if( !isfinite(w) ) w = -1.0; /* should be rejected */
+
+        if(w > genrand_real2()) { /* accept */
+          for(qpidx=0;qpidx<NQPFull;qpidx++) {
+            updateMAllTwo_child_fcmp(mi,s,mj,t,ri,rj,eleIdx,0,NQPFull,qpidx,
+                                     vec1,vec2,vec3,vec4,pfM,invM);
+          }
+
+          for(i=0;i<NProj;i++) eleProjCnt[i] = projCntNew[i];
+          logIpOld = logIpNew;
+          nAccept++;
+          counter[3]++;
+        } else { /* reject */
+          revertEleConfig(mj,rj,ri,t,eleIdx,eleCfg,eleNum);
+          revertEleConfig(mi,ri,rj,s,eleIdx,eleCfg,eleNum);
+        }
+      }
+
+      if(nAccept>Nsite) {
+        /* recalculate PfM and InvM */
+        calculateMAllWalker(eleIdx,pfM,invM,bufM,iwork,work,rwork);
+        logIpOld = calculateLogIPWalker(pfM);
+        nAccept=0;
+      }
+    } /* end of instep */
+
+    /* save Electron Configuration */
+    if(outStep >= nOutStep-nSample) {
+      sample = sampleStart + outStep-(nOutStep-nSample);
+      saveEleConfig(sample,logIpOld,eleIdx,eleCfg,eleNum,eleProjCnt);
+    }
+  } /* end of outstep */
+
+  return;
+}
+
+void makeInitialSampleWalker(int *eleIdx, int *eleCfg, int *eleNum, int *eleProjCnt,
+                             double complex *pfM, double complex *invM,
+                             double complex *bufM, int *iwork, double complex *work, double *rwork) {
+  int flag=1,loop=0;
+
+  do {
+    makeRandomEleConfig(eleIdx,eleCfg,eleNum,eleProjCnt);
+    flag = calculateMAllWalker(eleIdx,pfM,invM,bufM,iwork,work,rwork);
+
+    loop++;
+    if(loop>100) {
+      fprintf(stderr, "error: makeInitialSampleWalker: Too many loops\n");
+      MPI_Abort(MPI_COMM_WORLD,EXIT_FAILURE);
+    }
+  } while (flag>0);
+
+  return;
+}
+
+/* Calculate PfM and InvM of a walker for all the quantum projections */
+int calculateMAllWalker(const int *eleIdx, double complex *pfM, double complex *invM,
+                        double complex *bufM, int *iwork, double complex *work, double *rwork) {
+  int qpidx,info=0;
+
+  for(qpidx=0;qpidx<NQPFull;qpidx++) {
+    info = calculateMAll_child_fcmp(eleIdx, 0, NQPFull, qpidx,
+                                    bufM, iwork, work, LapackLWork, rwork, pfM, invM);
+    if(info!=0) break;
+  }
+
+  return info;
+}
+
+/* Calculate logarithm of inner product <phi|L|x> without MPI communication */
+double complex calculateLogIPWalker(const double complex *pfM) {
+  double complex ip=0.0;
+  int qpidx;
+
+  for(qpidx=0;qpidx<NQPFull;qpidx++) {
+    ip += QPFullWeight[qpidx] * pfM[qpidx];
+  }
+
+  return clog(ip);
+}
+
+void VMCMakeSampleWalker_real(MPI_Comm comm) {
+  const int nWalker = NVMCWalker;
+  const int nEle = Nsize+2*Nsite+2*Nsite+NProj;
+  const int nInvM = NQPFull*(Nsize*Nsize+1);
+  int walker,i;
+  int *counter;
+
+  double *myBufM, *myWork, *myVec;
+  int *myIWork;
+
+  /* wave function extraction is handled only by the single-walker sampler */
+  if(getenv("EXTRACT_WAVEFUNCTION") != NULL) {
+    VMCMakeSample_real(comm);
+    return;
+  }
+
+  RequestWorkSpaceInt(nWalker*Counter_max);
+  counter = GetWorkSpaceInt(nWalker*Counter_max);
+  for(i=0;i<nWalker*Counter_max;i++) counter[i]=0;
+
+  RequestWorkSpaceThreadInt(Nsize);
+  RequestWorkSpaceThreadDouble(Nsize*Nsize+LapackLWork+4*Nsize);
+
+  #pragma omp parallel default(shared)                \
+    private(myIWork,myBufM,myWork,myVec,walker)
+  {
+    myIWork = GetWorkSpaceThreadInt(Nsize);
+    myBufM  = GetWorkSpaceThreadDouble(Nsize*Nsize);
+    myWork  = GetWorkSpaceThreadDouble(LapackLWork);
+    myVec   = GetWorkSpaceThreadDouble(4*Nsize);
+
+    #pragma omp for schedule(static)
+    for(walker=0;walker<nWalker;walker++) {
+      makeSampleWalker_real(walker, WalkerEleIdx+walker*nEle, WalkerInvM_real+walker*nInvM,
+                            counter+walker*Counter_max, myBufM, myIWork, myWork, myVec);
+    }
+  }
+
+  ReleaseWorkSpaceThreadInt();
+  ReleaseWorkSpaceThreadDouble();
+
+  for(i=0;i<Counter_max;i++) {
+    Counter[i] = 0;
+    for(walker=0;walker<nWalker;walker++) Counter[i] += counter[walker*Counter_max+i];
+  }
+  ReleaseWorkSpaceInt();
+  BurnFlag=1;
+
+  return;
+}
+
+void makeSampleWalker_real(const int walker, int *eleIdx, double *invM, int *counter,
+                           double *bufM, int *iwork, double *work, double *vec) {
+  int *eleCfg = eleIdx + Nsize;
+  int *eleNum = eleCfg + 2*Nsite;
+  int *eleProjCnt = eleNum + 2*Nsite;
+  double *pfM = invM + NQPFull*Nsize*Nsize;
+  double *vec1 = vec;
+  double *vec2 = vec + Nsize;
+  double *vec3 = vec + 2*Nsize;
+  double *vec4 = vec + 3*Nsize;
+
+  int outStep,nOutStep;
+  int inStep,nInStep;
+  UpdateType updateType;
+  int mi,mj,ri,rj,s,t,i,qpidx;
+  int nAccept=0;
+  int sample,sampleStart,sampleEnd,nSample;
+  int burnFlag=BurnFlag;
+
+  double logIpOld,logIpNew; /* logarithm of inner product <phi|L|x> */
+  int projCntNew[NProj];
+  double pfMNew_real[NQPFull];
+  double x,w;
+  int rejectFlag;
+
+  SplitLoop(&sampleStart,&sampleEnd,NVMCSample,walker,NVMCWalker);
+  nSample = sampleEnd-sampleStart;
+
+  if(burnFlag==0) {
+    makeInitialSampleWalker_real(eleIdx,eleCfg,eleNum,eleProjCnt,pfM,invM,bufM,iwork,work);
+  } else {
+    calculateMAllWalker_real(eleIdx,pfM,invM,bufM,iwork,work);
+  }
+  logIpOld = calculateLogIPWalker_real(pfM);
+
+  if( !isfinite(logIpOld) ) {
+    fprintf(stderr,"warning: VMCMakeSampleWalker_real remakeSample walker=%d logIpOld=%e\n",walker,logIpOld);
+    makeInitialSampleWalker_real(eleIdx,eleCfg,eleNum,eleProjCnt,pfM,invM,bufM,iwork,work);
+    logIpOld = calculateLogIPWalker_real(pfM);
+    burnFlag = 0;
+  }
+
+  nOutStep = (burnFlag==0) ? NVMCWarmUp+nSample : nSample+1;
+  nInStep = NVMCInterval * Nsite;
+
+  for(outStep=0;outStep<nOutStep;outStep++) {
+    for(inStep=0;inStep<nInStep;inStep++) {
+
+      updateType = getUpdateType(NExUpdatePath);
+
+      if(updateType==HOPPING) { /* hopping */
+        counter[0]++;
+
+        makeCandidate_hopping(&mi, &ri, &rj, &s, &rejectFlag, eleIdx, eleCfg);
+        if(rejectFlag) continue;
+
+        /* The mi-th electron with spin s hops to site rj */
+        updateEleConfig(mi,ri,rj,s,eleIdx,eleCfg,eleNum);
+        UpdateProjCnt(ri,rj,s,projCntNew,eleProjCnt,eleNum);
+
+        for(qpidx=0;qpidx<NQPFull;qpidx++) {
+          calculateNewPfM_child_real(mi,s,pfMNew_real,eleIdx,0,NQPFull,qpidx,pfM,invM);
+        }
+
+        /* calculate inner product <phi|L|x> */
+        logIpNew = calculateLogIPWalker_real(pfMNew_real);
+
+        /* Metroplis */
+        x = LogProjRatio(projCntNew,eleProjCnt);
+        w = exp(2.0*(x+(logIpNew-logIpOld)));
+        if( !isfinite(w) ) w = -1.0; /* should be rejected */
+
+        if(w > genrand_real2()) { /* accept */
+          for(qpidx=0;qpidx<NQPFull;qpidx++) {
+            updateMAll_child_real(mi,s,eleIdx,0,NQPFull,qpidx,vec1,vec2,pfM,invM);
+          }
+
+          for(i=0;i<NProj;i++) eleProjCnt[i] = projCntNew[i];
+          logIpOld = logIpNew;
+          nAccept++;
+          counter[1]++;
+        } else { /* reject */
+          revertEleConfig(mi,ri,rj,s,eleIdx,eleCfg,eleNum);
+        }
+
+      } else if(updateType==EXCHANGE) { /* exchange */
+        counter[2]++;
+
+        makeCandidate_exchange(&mi, &ri, &rj, &s, &rejectFlag, eleIdx, eleCfg, eleNum);
+        if(rejectFlag) continue;
+
+        /* The mi-th electron with spin s exchanges with the electron on site rj with spin 1-s */
+        t = 1-s;
+        mj = eleCfg[rj+t*Nsite];
+
+        /* The mi-th electron with spin s hops to rj */
+        updateEleConfig(mi,ri,rj,s,eleIdx,eleCfg,eleNum);
+        UpdateProjCnt(ri,rj,s,projCntNew,eleProjCnt,eleNum);
+        /* The mj-th electron with spin t hops to ri */
+        updateEleConfig(mj,rj,ri,t,eleIdx,eleCfg,eleNum);
+        UpdateProjCnt(rj,ri,t,projCntNew,projCntNew,eleNum);
+
+        for(qpidx=0;qpidx<NQPFull;qpidx++) {
+          calculateNewPfMTwo_child_real(mi,s,mj,t,pfMNew_real,eleIdx,0,NQPFull,qpidx,
+                                        vec1,vec2,pfM,invM);
+        }
+
+        /* calculate inner product <phi|L|x> */
+        logIpNew = calculateLogIPWalker_real(pfMNew_real);
+
+        /* Metroplis */
+        x = LogProjRatio(projCntNew,eleProjCnt);
+        w = exp(2.0*(x+(logIpNew-logIpOld)));
+        if( !isfinite(w) ) w = -1.0; /* should be rejected */
+
+        if(w > genrand_real2()) { /* accept */
+          for(qpidx=0;qpidx<NQPFull;qpidx++) {
+            updateMAllTwo_child_real(mi,s,mj,t,ri,rj,eleIdx,0,NQPFull,qpidx,
+                                     vec1,vec2,vec3,vec4,pfM,invM);
+          }
+
+          for(i=0;i<NProj;i++) eleProjCnt[i] = projCntNew[i];
+          logIpOld = logIpNew;
+          nAccept++;
+          counter[3]++;
+        } else { /* reject */
+          revertEleConfig(mj,rj,ri,t,eleIdx,eleCfg,eleNum);
+          revertEleConfig(mi,ri,rj,s,eleIdx,eleCfg,eleNum);
+        }
+      }
+
+      if(nAccept>Nsite) {
+        /* recalculate PfM and InvM */
+        calculateMAllWalker_real(eleIdx,pfM,invM,bufM,iwork,work);
+        logIpOld = calculateLogIPWalker_real(pfM);
+        nAccept=0;
+      }
+    } /* end of instep */
+
+    /* save Electron Configuration */
+    if(outStep >= nOutStep-nSample) {
+      sample = sampleStart + outStep-(nOutStep-nSample);
+      saveEleConfig(sample,logIpOld,eleIdx,eleCfg,eleNum,eleProjCnt);
+    }
+  } /* end of outstep */
+
+  return;
+}
+
+void makeInitialSampleWalker_real(int *eleIdx, int *eleCfg, int *eleNum, int *eleProjCnt,
+                                  double *pfM, double *invM,
+                                  double *bufM, int *iwork, double *work) {
+  int flag=1,loop=0;
+
+  do {
+    makeRandomEleConfig(eleIdx,eleCfg,eleNum,eleProjCnt);
+    flag = calculateMAllWalker_real(eleIdx,pfM,invM,bufM,iwork,work);
+
+    loop++;
+    if(loop>100) {
+      fprintf(stderr, "error: makeInitialSampleWalker_real: Too many loops\n");
+      MPI_Abort(MPI_COMM_WORLD,EXIT_FAILURE);
+    }
+  } while (flag>0);
+
+  return;
+}
+
+/* Calculate PfM and InvM of a walker for all the quantum projections */
+int calculateMAllWalker_real(const int *eleIdx, double *pfM, double *invM,
+                             double *bufM, int *iwork, double *work) {
+  int qpidx,info=0;
+
+  for(qpidx=0;qpidx<NQPFull;qpidx++) {
+    info = calculateMAll_child_real(eleIdx, 0, NQPFull, qpidx,
+                                    bufM, iwork, work, LapackLWork, pfM, invM);
+    if(info!=0) break;
+  }
+
+  return info;
+}
+
+/* Calculate logarithm of inner product <phi|L|x> without MPI communication */
+double calculateLogIPWalker_real(const double *pfM) {
+  double ip=0.0;
+  int qpidx;
+
+  for(qpidx=0;qpidx<NQPFull;qpidx++) {
+    ip += creal(QPFullWeight[qpidx]) * pfM[qpidx];
+  }
+
+  return log(fabs(ip));
+}
+
+#endif
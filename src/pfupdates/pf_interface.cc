@@ -7,15 +7,61 @@
 // In implementation, this should appear AFTER blis.h.
 #include "pf_interface.h"
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 // Non-# Pragma support differs from compiler to compiler
 #if defined(__INTEL_COMPILER)
-#define OMP_PARALLEL_FOR_SHARED __pragma(omp parallel for default(shared))
+#define OMP_PARALLEL_FOR_QP __pragma(omp parallel for default(shared) num_threads(qpt.outer) if(qpt.outer > 1))
 #elif defined(__GNUC__)
-#define OMP_PARALLEL_FOR_SHARED _Pragma("omp parallel for default(shared)")
+#define OMP_PARALLEL_FOR_QP _Pragma("omp parallel for default(shared) num_threads(qpt.outer) if(qpt.outer > 1)")
 #else
 #error "Valid non-preprocessor _pragma() not found."
 #endif
 
+/**
+ * Two-level parallelism over quantum projections.
+ * The outer level distributes the updated_tdi objects among threads.
+ * When num_qp is smaller than the number of threads, the rest of them
+ * are left to the level-3 BLAS calls inside each object (nested OpenMP).
+ */
+struct qp_threads {
+  int outer;
+  int inner;
+  int levels;
+
+  qp_threads(uint64_t num_qp) {
+#ifdef _OPENMP
+    int nthreads = omp_get_max_threads();
+    outer = num_qp < (uint64_t)nthreads ? (int)num_qp : nthreads;
+    if (outer < 1)
+      outer = 1;
+    inner = nthreads / outer;
+    levels = omp_get_max_active_levels();
+    if (inner > 1 && levels < 2)
+      omp_set_max_active_levels(2);
+#else
+    outer = inner = levels = 1;
+#endif
+  }
+
+  ~qp_threads() {
+#ifdef _OPENMP
+    if (inner > 1 && levels < 2)
+      omp_set_max_active_levels(levels);
+#endif
+  }
+
+  // Call at the beginning of each outer iteration.
+  void set_inner() const {
+#ifdef _OPENMP
+    if (outer > 1)
+      omp_set_num_threads(inner);
+#endif
+  }
+};
+
 #define orbv( i, ctype ) ( (orbital_mat<ctype> *)orbv[i] )
 #define objv( i, ctype ) ( (updated_tdi<ctype> *)objv[i] )
 
@@ -37,8 +83,10 @@
       void     *objv[], \
       void     *orbv[] ) \
 { \
-  OMP_PARALLEL_FOR_SHARED \
+  qp_threads qpt(num_qp); \
+  OMP_PARALLEL_FOR_QP \
   for (int iqp = 0; iqp < num_qp; ++iqp) { \
+    qpt.set_inner(); \
     orbv[iqp] = new orbital_mat<ctype>( \
         BLIS_UPPER, norbs, orbmat_base + iqp * orbmat_stride, norbs); \
     objv[iqp] = new updated_tdi<ctype>( \
@@ -98,9 +146,12 @@ GENIMPL( ccdcmplx, z )
       int64_t   cal_pfa, \
       void     *objv[] ) \
 { \
-  OMP_PARALLEL_FOR_SHARED \
-  for (int iqp = 0; iqp < num_qp; ++iqp) \
+  qp_threads qpt(num_qp); \
+  OMP_PARALLEL_FOR_QP \
+  for (int iqp = 0; iqp < num_qp; ++iqp) { \
+    qpt.set_inner(); \
     objv(iqp, ctype)->push_update_safe(osi, msj, cal_pfa!=0); \
+  } \
 }
 GENIMPL( float,    s )
 GENIMPL( double,   d )
@@ -118,8 +169,10 @@ GENIMPL( ccdcmplx, z )
       int64_t   cal_pfa, \
       void     *objv[] ) \
 { \
-  OMP_PARALLEL_FOR_SHARED \
+  qp_threads qpt(num_qp); \
+  OMP_PARALLEL_FOR_QP \
   for (int iqp = 0; iqp < num_qp; ++iqp) { \
+    qpt.set_inner(); \
     auto &from_i = objv(iqp, ctype)->from_idx; \
     if (from_i.size() > objv(iqp, ctype)->mmax - 2) \
       objv(iqp, ctype)->merge_updates(); \
@@ -146,7 +199,10 @@ GENIMPL( ccdcmplx, z )
       int64_t   cal_pfa, \
       void     *objv[] ) \
 { \
+  qp_threads qpt(num_qp); \
+  OMP_PARALLEL_FOR_QP \
   for (int iqp = 0; iqp < num_qp; ++iqp) { \
+    qpt.set_inner(); \
     objv(iqp, ctype)->pop_update(cal_pfa!=0); \
   } \
 }
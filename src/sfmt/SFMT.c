@@ -71,16 +71,22 @@ typedef struct W128_T w128_t;
 /** the 128-bit internal state array */
 static w128_t sfmt[N];
 /** the 32bit integer pointer to the 128-bit internal state array */
-static uint32_t *psfmt32 = &sfmt[0].u[0];
+#define psfmt32 (&sfmt[0].u[0])
 #if !defined(BIG_ENDIAN64) || defined(ONLY64)
 /** the 64bit integer pointer to the 128-bit internal state array */
-static uint64_t *psfmt64 = (uint64_t *)&sfmt[0].u[0];
+#define psfmt64 ((uint64_t *)&sfmt[0].u[0])
 #endif
 /** index counter to the 32-bit internal state array */
 static int idx;
 /** a flag: it is 0 if and only if the internal state is not yet
  * initialized. */
 static int initialized = 0;
+#ifdef _OPENMP
+/* Each OpenMP thread owns an independent generator state, so that
+ * several Markov chains can be driven concurrently. The master thread
+ * keeps the state seeded by init_gen_rand() outside parallel regions. */
+#pragma omp threadprivate(sfmt, idx, initialized)
+#endif
 /** a parity check vector which certificate the period of 2^{MEXP} */
 static uint32_t parity[4] = {PARITY1, PARITY2, PARITY3, PARITY4};
 
@@ -0,0 +1,69 @@
+from __future__ import print_function
+
+import ctypes
+import math
+import os
+import shutil
+import subprocess
+import sys
+
+# Load a real-valued wave function into libmvmc and evaluate a few amplitudes.
+
+if len(sys.argv) == 1:
+    print("usage: {} <model name>".format(sys.argv[0]))
+    sys.exit(-1)
+
+rootdir = os.getcwd()
+refdir = os.path.join(rootdir, "data", sys.argv[1])
+workdir = os.path.join(rootdir, "work", "libmvmc_" + sys.argv[1])
+if os.path.exists(workdir):
+    shutil.rmtree(workdir)
+os.makedirs(workdir)
+os.chdir(workdir)
+
+bindir = os.path.join(rootdir, "..", "..", "src", "mVMC")
+libname = "libmvmc.dylib" if sys.platform == "darwin" else "libmvmc.so"
+
+# generate namelist.def and the other *def files only
+result = subprocess.call([os.path.join(bindir, "vmcdry.out"), "%s/StdFace.def" % refdir])
+if result != 0:
+    sys.exit(result)
+
+lib = ctypes.CDLL(os.path.join(bindir, libname))
+lib.mvmc_initialize.argtypes = [ctypes.c_char_p, ctypes.c_char_p]
+lib.evaluate_log_amplitudes.argtypes = [ctypes.POINTER(ctypes.c_int), ctypes.c_int,
+                                        ctypes.POINTER(ctypes.c_double)]
+
+if lib.mvmc_initialize(b"namelist.def", ("%s/initial.def" % refdir).encode()) != 0:
+    print("mvmc_initialize failed")
+    sys.exit(-1)
+
+nsite = lib.mvmc_num_sites()
+ne = lib.mvmc_num_electrons()
+
+# two valid configurations and one with a missing electron
+configs = []
+up = [1 if i % 2 == 0 else 0 for i in range(nsite)]
+configs.append(up + [1 - n for n in up])
+configs.append([1 if i < ne else 0 for i in range(nsite)] + [1 if i >= nsite - ne else 0 for i in range(nsite)])
+configs.append([0] * nsite + configs[0][nsite:])
+
+n = len(configs)
+c_configs = (ctypes.c_int * (2 * nsite * n))(*[x for c in configs for x in c])
+c_out = (ctypes.c_double * (2 * n))()
+nfail = lib.evaluate_log_amplitudes(c_configs, n, c_out)
+lib.mvmc_finalize()
+
+result = 0
+if nfail != 1:
+    print("number of failures: {} (expected 1)".format(nfail))
+    result = -1
+for i in range(2):
+    if not (math.isfinite(c_out[2 * i]) and math.isfinite(c_out[2 * i + 1])):
+        print("log amplitude {} is not finite: {} {}".format(i, c_out[2 * i], c_out[2 * i + 1]))
+        result = -1
+if not (math.isinf(c_out[4]) and c_out[4] < 0):
+    print("invalid configuration gives {}".format(c_out[4]))
+    result = -1
+
+sys.exit(result)
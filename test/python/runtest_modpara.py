@@ -0,0 +1,164 @@
+from __future__ import print_function
+
+import argparse
+import os
+import shutil
+import subprocess
+import sys
+
+import numpy as np
+
+# Run a model of data/ with extra keywords appended to modpara.def and compare
+# the result with the results of the model without them.
+#
+# NVMCCalMode = 0: the energy in zqp_opt.dat is compared with ref/ref_mean.dat.
+#   The keywords change the Markov chain (or the precision of the stored O),
+#   so that the run is not a reproduction of the reference runs. A difference
+#   smaller than <tol> times ref/ref_std.dat is accepted.
+# NVMCCalMode = 1 (--mode1): the model is sampled from zqp_opt.dat with and
+#   without the keywords. The energies must agree within <etol> (1e-10 for
+#   keywords that must not change the samples) and the one-body Green
+#   functions within <tol> (an absolute tolerance).
+#   With --momentum, the wave vectors 2pi*k/Nsite (k = 0, ..., Nsite-1) of a
+#   chain are given and sum_k n_s(k) = N_s is checked against the diagonal
+#   Green functions.
+
+
+def read_out(filename):
+    array = np.loadtxt(filename, dtype="float").astype("float")
+    return array
+
+
+def append_modpara(keywords):
+    with open("modpara.def", "a") as f:
+        for key, value in zip(keywords[0::2], keywords[1::2]):
+            f.write("{:<18} {}\n".format(key, value))
+
+
+def write_momentum(nsite):
+    with open("momentum.def", "w") as f:
+        f.write("=============================================\n")
+        f.write("NMomentum {:10d}\n".format(nsite))
+        f.write("=============================================\n")
+        f.write("========== q.r_i/2pi ========================\n")
+        f.write("=============================================\n")
+        for k in range(nsite):
+            for i in range(nsite):
+                f.write("{:5d} {:5d} {:20.15f}\n".format(k, i, float(k * i) / nsite))
+    with open("namelist.def", "a") as f:
+        f.write("  Momentum  momentum.def\n")
+
+
+def read_nsite():
+    with open("modpara.def") as f:
+        for line in f:
+            words = line.split()
+            if len(words) > 1 and words[0] == "Nsite":
+                return int(words[1])
+    return 0
+
+
+def run(workdir, keywords, args):
+    if os.path.exists(workdir):
+        shutil.rmtree(workdir)
+    os.makedirs(workdir)
+    os.chdir(workdir)
+
+    # generate namelist.def and the other *def files only
+    result = subprocess.call([os.path.join(bindir, "vmcdry.out"), "%s/StdFace.def" % refdir])
+    if result != 0:
+        return result
+    if args.mode1:
+        append_modpara(["NVMCCalMode", "1", "NVMCSample", str(args.nsample)])
+    append_modpara(keywords)
+    if args.momentum:
+        write_momentum(read_nsite())
+
+    initial = "zqp_opt.dat" if args.mode1 else "initial.def"
+    command = [os.path.join(bindir, "vmc.out"), "namelist.def", "%s/%s" % (refdir, initial)]
+    if args.np > 1:
+        command = [args.mpiexec, "-np", str(args.np)] + command
+    return subprocess.call(command)
+
+
+parser = argparse.ArgumentParser()
+parser.add_argument("name", help="test name")
+parser.add_argument("model", help="model name in data/")
+parser.add_argument("keywords", nargs="*", help="pairs of a keyword and its value")
+parser.add_argument("--tol", type=float, default=5.0)
+parser.add_argument("--np", type=int, default=1)
+parser.add_argument("--mpiexec", default="mpiexec")
+parser.add_argument("--mode1", action="store_true")
+parser.add_argument("--nsample", type=int, default=5000)
+parser.add_argument("--etol", type=float, default=1e-10)
+parser.add_argument("--momentum", action="store_true")
+args = parser.parse_args()
+
+if len(args.keywords) % 2 != 0:
+    print("keywords must be given as pairs of a keyword and its value")
+    sys.exit(-1)
+
+rootdir = os.getcwd()
+refdir = os.path.join(rootdir, "data", args.model)
+workdir = os.path.join(rootdir, "work", args.name)
+bindir = os.path.join(rootdir, "..", "..", "src", "mVMC")
+
+result = 0
+if not args.mode1:
+    result = run(workdir, args.keywords, args)
+    if result != 0:
+        sys.exit(result)
+
+    array_calc = read_out("./output/zqp_opt.dat")[0:2]
+    ref_ave = read_out("%s/ref/ref_mean.dat" % refdir)[0:2]
+    ref_std = read_out("%s/ref/ref_std.dat" % refdir)[0:2]
+
+    for diff, s in zip(array_calc - ref_ave, ref_std):
+        diff = abs(diff)
+        if diff >= args.tol * s and diff >= 1e-8:
+            print("energy: difference {} >= {} * {}".format(diff, args.tol, s))
+            result = -1
+    sys.exit(result)
+
+# NVMCCalMode = 1: the baseline and the run with the keywords
+result = run(workdir + "_base", [], argparse.Namespace(**dict(vars(args), momentum=False)))
+if result != 0:
+    sys.exit(result)
+out_base = read_out("./output/zvo_out_001.dat")
+green_base = read_out("./output/zvo_cisajs_001.dat")
+
+result = run(workdir, args.keywords, args)
+if result != 0:
+    sys.exit(result)
+out_calc = read_out("./output/zvo_out_001.dat")
+green_calc = read_out("./output/zvo_cisajs_001.dat")
+
+result = 0
+diff = np.max(np.abs(out_calc[0:2] - out_base[0:2]))
+if diff >= args.etol:
+    print("energy: {} != {} (difference {} >= {})".format(out_calc[0:2], out_base[0:2], diff, args.etol))
+    result = -1
+if not np.array_equal(green_calc[:, 0:4], green_base[:, 0:4]):
+    print("the indices of the Green functions differ")
+    result = -1
+else:
+    diff = np.max(np.abs(green_calc[:, 4:6] - green_base[:, 4:6]))
+    if diff >= args.tol:
+        print("Green functions: max difference {} >= {}".format(diff, args.tol))
+        result = -1
+
+if args.momentum:
+    # sum_k n_s(k) = sum_i <c_is^+ c_is> = N_s holds for every sample
+    nsite = read_nsite()
+    mom = read_out("./output/zvo_momentum_001.dat").reshape(-1, nsite, 9)
+    green = green_calc.reshape(mom.shape[0], -1, 6)
+    for block, g in zip(mom, green):
+        for spin, col in ((0, 5), (1, 7)):
+            diag = (g[:, 0] == g[:, 2]) & (g[:, 1] == spin) & (g[:, 3] == spin)
+            nk = np.sum(block[:, col])
+            ns = np.sum(g[diag, 4])
+            if abs(nk - ns) >= 1e-8:
+                print("spin {}: sum_k n(k) = {} != {}".format(spin, nk, ns))
+                result = -1
+
+sys.exit(result)